@@ -3,35 +3,78 @@
 #include <isl/DirectLogger.hxx>
 #include <isl/StreamLogTarget.hxx>
 #include <isl/AbstractMessageBrokerService.hxx>
+#include <isl/DnsResolver.hxx>
 #include <isl/AbstractMessageBrokerConnection.hxx>
 #include <isl/AbstractMessageBrokerListeningConnection.hxx>
+#include <isl/BufferedIODevice.hxx>
+#include <isl/SharedBuffer.hxx>
 #include <iostream>
+#include <memory>
+#include <string.h>
 
 #define MAX_CLIENTS 10
 #define SERVICE_LISTEN_PORT 8888
 #define CONNECTION_LISTEN_PORT 8889
 #define CONNECT_PORT 8890
 
-typedef std::string Message;
+// Message payload is shared by the output queues of all clients, so the broadcast does not copy it
+typedef isl::SharedBuffer Message;
 
-Message * parseMessage(std::string& buffer)
+// Receives LF or CRLF terminated message, the message is parsed in place in the read buffer of the device
+Message * receiveMessage(isl::BufferedIODevice& device, std::string& messageBuffer, const isl::Timestamp& limit)
 {
-	if (buffer.empty()) {
-		return 0;
+	while (true) {
+		isl::AbstractIODevice::ConstBuffer span = device.peek();
+		if (span.size > 0) {
+			const char * lfPtr = static_cast<const char *>(memchr(span.data, '\n', span.size));
+			if (lfPtr) {
+				messageBuffer.append(span.data, lfPtr - span.data);
+				device.consume(lfPtr - span.data + 1);
+				if (!messageBuffer.empty() && messageBuffer[messageBuffer.size() - 1] == '\r') {
+					messageBuffer.resize(messageBuffer.size() - 1);
+				}
+				Message * msgPtr = new Message(messageBuffer);
+				messageBuffer.clear();
+				return msgPtr;
+			}
+			messageBuffer.append(span.data, span.size);
+			device.consume(span.size);
+		} else if (isl::Timestamp::now() >= limit || device.fill(limit.leftTo()) <= 0) {
+			return 0;
+		}
 	}
-	size_t crlfPos = buffer.find("\r\n");
-	if (crlfPos != std::string::npos) {
-		Message * msgPtr = new Message(buffer.substr(0, crlfPos));
-		buffer = buffer.substr(crlfPos + 2);
-		return msgPtr;
+}
+
+// Sends CRLF terminated message, bytesSent keeps the amount of the message bytes accepted by the device between the calls
+bool sendMessage(isl::TcpSocket& socket, isl::BufferedIODevice& device, const Message& msg, size_t& bytesSent, const isl::Timestamp& limit)
+{
+	static const char crlf[] = "\r\n";
+	// Payload is sent right from the shared buffer if the zero-copy send is enabled on the socket
+	while (socket.isZeroCopy() && bytesSent < msg.size()) {
+		if (isl::Timestamp::now() >= limit) {
+			return false;
+		}
+		bytesSent += socket.sendShared(msg, bytesSent, limit.leftTo());
 	}
-	size_t lfPos = buffer.find("\n");
-	if (lfPos == std::string::npos) {
-		return 0;
+	while (bytesSent < msg.size() + 2) {
+		if (isl::Timestamp::now() >= limit) {
+			return false;
+		}
+		isl::AbstractIODevice::ConstBuffer buffers[2];
+		size_t buffersAmount = 0;
+		if (bytesSent < msg.size()) {
+			buffers[buffersAmount++] = isl::AbstractIODevice::ConstBuffer(msg.data() + bytesSent, msg.size() - bytesSent);
+			buffers[buffersAmount++] = isl::AbstractIODevice::ConstBuffer(crlf, 2);
+		} else {
+			buffers[buffersAmount++] = isl::AbstractIODevice::ConstBuffer(crlf + bytesSent - msg.size(), msg.size() + 2 - bytesSent);
+		}
+		bytesSent += device.writeVector(buffers, buffersAmount, limit.leftTo());
+	}
+	if (!device.flush(limit.leftTo())) {
+		return false;
 	}
-	Message * msgPtr = new Message(buffer.substr(0, lfPos));
-	buffer = buffer.substr(lfPos + 1);
-	return msgPtr;
+	bytesSent = 0;
+	return true;
 }
 
 class MessageBrokerService : public isl::AbstractMessageBrokerService<Message>
@@ -46,18 +89,19 @@ private:
 	public:
 		Task(MessageBrokerService& service, isl::TcpSocket& socket) :
 			AbstractTask(service, socket),
-			_receiveBuffer(),
-			_sendBuffer(),
+			_receiveDevice(socket, 4096, 0),
+			_sendDevice(socket, 0, 4096),
+			_messageBuffer(),
 			_bytesSent(0)
 		{}
 	private:
 		virtual void beforeExecuteReceive()
 		{
-			inputQueue().push(MessageType("Hello from broadcast message broker service! Type \"bye\" to close session."));
+			inputQueue().push(MessageType(std::string("Hello from broadcast message broker service! Type \"bye\" to close session.")));
 		}
 		virtual bool onReceiveMessage(const MessageType& msg)
 		{
-			if (msg == "bye") {
+			if (std::string(msg.data(), msg.size()) == "bye") {
 				appointTermination();
 				return false;
 			} else {
@@ -66,44 +110,17 @@ private:
 		}
 		virtual MessageType * receiveMessage(const isl::Timestamp& limit)
 		{
-			MessageType * msgPtr = parseMessage(_receiveBuffer);
-			if (msgPtr) {
-				return msgPtr;
-			}
-			while (isl::Timestamp::now() < limit) {
-				char buf[4096];
-				size_t bytesReceived = socket().read(buf, sizeof(buf), limit.leftTo());
-				if (bytesReceived <= 0) {
-					break;
-				}
-				_receiveBuffer.append(buf, bytesReceived);
-				msgPtr = parseMessage(_receiveBuffer);
-				if (msgPtr) {
-					return msgPtr;
-				}
-			}
-			return 0;
+			return ::receiveMessage(_receiveDevice, _messageBuffer, limit);
 		}
 		virtual bool sendMessage(const MessageType& msg, const isl::Timestamp& limit)
 		{
-			if (_sendBuffer.empty()) {
-				_sendBuffer = msg;
-				_sendBuffer += "\r\n";
-			}
-			while (isl::Timestamp::now() < limit) {
-				size_t curBytesSent = socket().write(_sendBuffer.c_str() + _bytesSent, _sendBuffer.size() - _bytesSent, limit.leftTo());
-				_bytesSent += curBytesSent;
-				if (_bytesSent >= _sendBuffer.size()) {
-					_sendBuffer.clear();
-					_bytesSent = 0;
-					return true;
-				}
-			}
-			return false;
+			return ::sendMessage(socket(), _sendDevice, msg, _bytesSent, limit);
 		}
 
-		std::string _receiveBuffer;
-		std::string _sendBuffer;
+		// Receiver and sender threads are using their own buffered devices
+		isl::BufferedIODevice _receiveDevice;
+		isl::BufferedIODevice _sendDevice;
+		std::string _messageBuffer;
 		size_t _bytesSent;
 	};
 
@@ -118,14 +135,17 @@ class MessageBrokerConnection : public isl::AbstractMessageBrokerConnection<Mess
 public:
 	MessageBrokerConnection(isl::Subsystem * owner, const isl::TcpAddrInfo& remoteAddr) :
 		isl::AbstractMessageBrokerConnection<Message>(owner, remoteAddr),
-		_receiveBuffer(),
-		_sendBuffer(),
+		_receiveDeviceAutoPtr(),
+		_sendDeviceAutoPtr(),
+		_messageBuffer(),
 		_bytesSent(0)
 	{}
 private:
 	virtual void onReceiverConnected(isl::TcpSocket& socket)
 	{
 		isl::Log::debug().log(isl::LogMessage(SOURCE_LOCATION_ARGS, "Connection established in the receiver thread"));
+		_receiveDeviceAutoPtr.reset(new isl::BufferedIODevice(socket, 4096, 0));
+		_messageBuffer.clear();
 	}
 	virtual void onReceiverDisconnected(bool isConnectionAborted)
 	{
@@ -142,6 +162,8 @@ private:
 	virtual void onSenderConnected(isl::TcpSocket& socket)
 	{
 		isl::Log::debug().log(isl::LogMessage(SOURCE_LOCATION_ARGS, "Connection established in the sender thread"));
+		_sendDeviceAutoPtr.reset(new isl::BufferedIODevice(socket, 0, 4096));
+		_bytesSent = 0;
 	}
 	virtual void onSenderDisconnected(bool isConnectionAborted)
 	{
@@ -152,46 +174,19 @@ private:
 		}
 	}
 
-	virtual MessageType * receiveMessage(isl::TcpSocket& socket, const isl::Timestamp& limit)
+	virtual MessageType * receiveMessage(isl::TcpSocket& /*socket*/, const isl::Timestamp& limit)
 	{
-		MessageType * msgPtr = parseMessage(_receiveBuffer);
-		if (msgPtr) {
-			return msgPtr;
-		}
-		while (isl::Timestamp::now() < limit) {
-			char buf[4096];
-			size_t bytesReceived = socket.read(buf, sizeof(buf), limit.leftTo());
-			if (bytesReceived <= 0) {
-				break;
-			}
-			_receiveBuffer.append(buf, bytesReceived);
-			msgPtr = parseMessage(_receiveBuffer);
-			if (msgPtr) {
-				return msgPtr;
-			}
-		}
-		return 0;
+		return ::receiveMessage(*_receiveDeviceAutoPtr.get(), _messageBuffer, limit);
 	}
 	virtual bool sendMessage(const MessageType& msg, isl::TcpSocket& socket, const isl::Timestamp& limit)
 	{
-		if (_sendBuffer.empty()) {
-			_sendBuffer = msg;
-			_sendBuffer += "\r\n";
-		}
-		while (isl::Timestamp::now() < limit) {
-			size_t curBytesSent = socket.write(_sendBuffer.c_str() + _bytesSent, _sendBuffer.size() - _bytesSent, limit.leftTo());
-			_bytesSent += curBytesSent;
-			if (_bytesSent >= _sendBuffer.size()) {
-				_sendBuffer.clear();
-				_bytesSent = 0;
-				return true;
-			}
-		}
-		return false;
+		return ::sendMessage(socket, *_sendDeviceAutoPtr.get(), msg, _bytesSent, limit);
 	}
 
-	std::string _receiveBuffer;
-	std::string _sendBuffer;
+	// Buffered devices are created on each connection establishment, cause the socket could be changed
+	std::auto_ptr<isl::BufferedIODevice> _receiveDeviceAutoPtr;
+	std::auto_ptr<isl::BufferedIODevice> _sendDeviceAutoPtr;
+	std::string _messageBuffer;
 	size_t _bytesSent;
 };
 
@@ -200,14 +195,17 @@ class MessageBrokerListeningConnection : public isl::AbstractMessageBrokerListen
 public:
 	MessageBrokerListeningConnection(isl::Subsystem * owner, const isl::TcpAddrInfo& localAddr) :
 		isl::AbstractMessageBrokerListeningConnection<Message>(owner, localAddr),
-		_receiveBuffer(),
-		_sendBuffer(),
+		_receiveDeviceAutoPtr(),
+		_sendDeviceAutoPtr(),
+		_messageBuffer(),
 		_bytesSent(0)
 	{}
 private:
 	virtual void onReceiverConnected(isl::TcpSocket& socket)
 	{
 		isl::Log::debug().log(isl::LogMessage(SOURCE_LOCATION_ARGS, "Connection established in the receiver thread"));
+		_receiveDeviceAutoPtr.reset(new isl::BufferedIODevice(socket, 4096, 0));
+		_messageBuffer.clear();
 	}
 	virtual void onReceiverDisconnected(bool isConnectionAborted)
 	{
@@ -224,6 +222,8 @@ private:
 	virtual void onSenderConnected(isl::TcpSocket& socket)
 	{
 		isl::Log::debug().log(isl::LogMessage(SOURCE_LOCATION_ARGS, "Connection established in the sender thread"));
+		_sendDeviceAutoPtr.reset(new isl::BufferedIODevice(socket, 0, 4096));
+		_bytesSent = 0;
 	}
 	virtual void onSenderDisconnected(bool isConnectionAborted)
 	{
@@ -234,46 +234,19 @@ private:
 		}
 	}
 
-	virtual MessageType * receiveMessage(isl::TcpSocket& socket, const isl::Timestamp& limit)
+	virtual MessageType * receiveMessage(isl::TcpSocket& /*socket*/, const isl::Timestamp& limit)
 	{
-		MessageType * msgPtr = parseMessage(_receiveBuffer);
-		if (msgPtr) {
-			return msgPtr;
-		}
-		while (isl::Timestamp::now() < limit) {
-			char buf[4096];
-			size_t bytesReceived = socket.read(buf, sizeof(buf), limit.leftTo());
-			if (bytesReceived <= 0) {
-				break;
-			}
-			_receiveBuffer.append(buf, bytesReceived);
-			msgPtr = parseMessage(_receiveBuffer);
-			if (msgPtr) {
-				return msgPtr;
-			}
-		}
-		return 0;
+		return ::receiveMessage(*_receiveDeviceAutoPtr.get(), _messageBuffer, limit);
 	}
 	virtual bool sendMessage(const MessageType& msg, isl::TcpSocket& socket, const isl::Timestamp& limit)
 	{
-		if (_sendBuffer.empty()) {
-			_sendBuffer = msg;
-			_sendBuffer += "\r\n";
-		}
-		while (isl::Timestamp::now() < limit) {
-			size_t curBytesSent = socket.write(_sendBuffer.c_str() + _bytesSent, _sendBuffer.size() - _bytesSent, limit.leftTo());
-			_bytesSent += curBytesSent;
-			if (_bytesSent >= _sendBuffer.size()) {
-				_sendBuffer.clear();
-				_bytesSent = 0;
-				return true;
-			}
-		}
-		return false;
+		return ::sendMessage(socket, *_sendDeviceAutoPtr.get(), msg, _bytesSent, limit);
 	}
 
-	std::string _receiveBuffer;
-	std::string _sendBuffer;
+	// Buffered devices are created on each connection establishment, cause the socket could be changed
+	std::auto_ptr<isl::BufferedIODevice> _receiveDeviceAutoPtr;
+	std::auto_ptr<isl::BufferedIODevice> _sendDeviceAutoPtr;
+	std::string _messageBuffer;
 	size_t _bytesSent;
 };
 
@@ -284,13 +257,21 @@ public:
 	BroadcastMessageBrokerServer(int argc, char * argv[]) :
 		isl::Server(argc, argv),
 		_service(this, MAX_CLIENTS),
+		_resolver(this),
 		_connection(this, isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, isl::TcpAddrInfo::LoopbackAddress, CONNECT_PORT)),
 		_listeningConnection(this, isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, isl::TcpAddrInfo::WildcardAddress, CONNECTION_LISTEN_PORT)),
 		_messageBus()
 	{
-		_service.addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, isl::TcpAddrInfo::WildcardAddress, SERVICE_LISTEN_PORT));
+		// Large messages are sent without copying them into the send buffer of each client's socket
+		isl::TcpSocketOptions socketOptions = isl::TcpSocketOptions::lowLatency();
+		socketOptions.setZeroCopy();
+		_service.addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, isl::TcpAddrInfo::WildcardAddress, SERVICE_LISTEN_PORT), 15, 1,
+				socketOptions);
 		_service.addProvider(_messageBus);
 		_service.addConsumer(_messageBus);
+		_connection.setResolver(&_resolver);
+		_connection.setSocketOptions(socketOptions);
+		_listeningConnection.setSocketOptions(socketOptions);
 		_connection.addProvider(_messageBus);
 		_connection.addConsumer(_messageBus);
 		_listeningConnection.addProvider(_messageBus);
@@ -301,6 +282,7 @@ private:
 	BroadcastMessageBrokerServer(const BroadcastMessageBrokerServer&);
 
 	MessageBrokerService _service;
+	isl::DnsResolver _resolver;
 	MessageBrokerConnection _connection;
 	MessageBrokerListeningConnection _listeningConnection;
 	isl::MessageBus<Message> _messageBus;
@@ -20,7 +20,10 @@ public:
 		AbstractSyncTcpService(owner, MAX_CLIENTS)
 	{
 		// Adding a listener to the service
-		addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, isl::TcpAddrInfo::WildcardAddress, LISTEN_PORT));
+		addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, isl::TcpAddrInfo::WildcardAddress, LISTEN_PORT), 15, 1,
+				isl::TcpSocketOptions::bulkTransfer());
+		// Serving accepted connections before the old process exits on upgrade (send SIGUSR2 to upgrade)
+		setDrainOnStop(true);
 	}
 private:
 	// Task class which is returning to client a web-page with properties of the HTTP-request he/she issued
@@ -0,0 +1,100 @@
+#include <isl/Server.hxx>
+#include <isl/PidFile.hxx>
+#include <isl/AbstractReactorTcpService.hxx>
+#include <isl/Exception.hxx>
+#include <isl/DirectLogger.hxx>
+#include <isl/StreamLogTarget.hxx>
+#include <iostream>
+#include <string>
+
+#define LISTEN_PORT 8890			// TCP-port to listen to
+#define WORKERS_AMOUNT 4			// Worker threads amount, which does not depend on clients amount
+#define REACTORS_AMOUNT 2			// Reactor threads amount
+#define BUFFER_SIZE 4096			// I/O-buffer size
+#define IDLE_TIMEOUT 60				// Idle connection timeout in seconds
+#define WRITE_TIMEOUT 10			// Echoed data write timeout in seconds
+
+class EchoService : public isl::AbstractReactorTcpService
+{
+public:
+	EchoService(Subsystem * owner) :
+		AbstractReactorTcpService(owner, WORKERS_AMOUNT, REACTORS_AMOUNT)
+	{
+		// Adding a listener to the service
+		addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, isl::TcpAddrInfo::WildcardAddress, LISTEN_PORT), 1024);
+	}
+private:
+	// Task class which is sending back to client all the data it has received
+	class EchoTask : public AbstractTask
+	{
+	public:
+		EchoTask(isl::TcpSocket& socket) :
+			AbstractTask(socket),
+			_sendBuffer()
+		{
+			setTimeout(isl::Timeout(IDLE_TIMEOUT));
+		}
+	private:
+		EchoTask();
+
+		virtual bool onReadable()
+		{
+			char buf[BUFFER_SIZE];
+			size_t bytesRead = socket().read(buf, sizeof(buf), isl::Timeout());
+			_sendBuffer.append(buf, bytesRead);
+			return flush();
+		}
+		virtual bool onWritable()
+		{
+			return flush();
+		}
+		virtual bool awaitWritable() const
+		{
+			return !_sendBuffer.empty();
+		}
+
+		bool flush()
+		{
+			if (!_sendBuffer.empty()) {
+				size_t bytesWritten = socket().write(_sendBuffer.data(), _sendBuffer.size(), isl::Timeout());
+				_sendBuffer.erase(0, bytesWritten);
+			}
+			// Switching between idle and write deadlines, connection is closed by default onTimeout() handler
+			setTimeout(isl::Timeout(_sendBuffer.empty() ? IDLE_TIMEOUT : WRITE_TIMEOUT));
+			return true;
+		}
+
+		std::string _sendBuffer;
+	};
+	// Task creation factory method definition
+	virtual AbstractTask * createTask(isl::TcpSocket& socket)
+	{
+		return new EchoTask(socket);
+	}
+};
+
+// Our echo server class
+class EchoServer : public isl::Server
+{
+public:
+	EchoServer(int argc, char * argv[]) :
+		isl::Server(argc, argv),
+		_echoService(this)
+	{}
+private:
+	EchoServer();
+	EchoServer(const EchoServer&);
+
+	EchoService _echoService;
+};
+
+int main(int argc, char *argv[])
+{
+	isl::PidFile pidFile("red.pid");					// Writing PID of the server to file
+	isl::DirectLogger logger;						// Logging setup
+	isl::StreamLogTarget coutTarget(logger, std::cout);
+	isl::Log::warning().connect(coutTarget);
+	isl::Log::error().connect(coutTarget);
+	EchoServer server(argc, argv);						// Creating server object
+	server.run();								// Running server
+}
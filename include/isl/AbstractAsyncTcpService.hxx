@@ -5,9 +5,13 @@
 #include <isl/MultiTaskDispatcher.hxx>
 #include <isl/TcpAddrInfo.hxx>
 #include <isl/TcpSocket.hxx>
+#include <isl/TcpSocketOptions.hxx>
+#include <isl/UnixAddrInfo.hxx>
+#include <isl/UnixSocket.hxx>
 #include <isl/LogMessage.hxx>
 #include <isl/ExceptionLogMessage.hxx>
 #include <map>
+#include <vector>
 
 namespace isl
 {
@@ -27,7 +31,8 @@ public:
 		  \param socket Reference to the client connection socket
 		*/
 		AbstractTask(TcpSocket& socket) :
-			_socketAutoPtr(&socket)
+			_socketAutoPtr(&socket),
+			_servicePtr(0)
 		{}
 		// Destructor
 		virtual ~AbstractTask()
@@ -53,6 +58,16 @@ public:
 		{
 			executeSendImpl(taskDispatcher);
 		}
+		//! Admission timeout expiration method, which passes the task to the service's onOverload() event handler
+		/*!
+		  \param taskDispatcher Reference to the task dispatcher subsystem
+		*/
+		inline void executeAdmissionExpired(MultiTaskDispatcherType& taskDispatcher)
+		{
+			if (_servicePtr) {
+				_servicePtr->onOverload(*this);
+			}
+		}
 	protected:
 		//! Receive data task execution abstract virtual method to override in subclasses
 		/*!
@@ -70,6 +85,60 @@ public:
 		virtual void executeSendImpl(MultiTaskDispatcherType& taskDispatcher) = 0;
 	private:
 		std::auto_ptr<TcpSocket> _socketAutoPtr;
+		AbstractAsyncTcpService * _servicePtr;
+
+		friend class AbstractAsyncTcpService;
+	};
+	//! Asynchronous TCP-service full-duplex abstract task
+	/*!
+	  Full-duplex task is handling both directions of the client connection in one worker thread: the worker is
+	  awaiting for the socket to become readable and (optionally) writable and calls a combined I/O-event handler.
+	  In the full-duplex mode of the service such a task occupies one worker thread instead of two.
+
+	  Full-duplex task is working in the default mode of the service too: the receiving worker runs the full-duplex
+	  loop and the sending worker exits immediately.
+
+	  \sa AbstractAsyncTcpService::setDuplexMode()
+	*/
+	class AbstractDuplexTask : public AbstractTask
+	{
+	public:
+		//! Constructor
+		/*!
+		  \param socket Reference to the client connection socket
+		*/
+		AbstractDuplexTask(TcpSocket& socket) :
+			AbstractTask(socket)
+		{}
+	protected:
+		//! On I/O-event handler to override in subclasses
+		/*!
+		  It is called when the client connection socket is ready for reading or writing or when the dispatcher's
+		  clock timeout has been expired (both flags are FALSE then), so the task is able to perform some periodic job.
+
+		  \param taskDispatcher Reference to the task dispatcher subsystem
+		  \param isReadable TRUE if the client connection socket is ready for reading
+		  \param isWritable TRUE if the client connection socket is ready for writing
+		  \return TRUE if the client connection should be kept or FALSE to finish the task
+		*/
+		virtual bool onIOEvent(MultiTaskDispatcherType& taskDispatcher, bool isReadable, bool isWritable) = 0;
+		//! Returns TRUE if the task is awaiting for the client connection socket to be ready for writing
+		/*!
+		  \note Default implementation returns FALSE
+		*/
+		virtual bool awaitWritable() const
+		{
+			return false;
+		}
+	private:
+		AbstractDuplexTask();
+		AbstractDuplexTask(const AbstractDuplexTask&);					// No copy
+
+		AbstractDuplexTask& operator=(const AbstractDuplexTask&);			// No copy
+
+		virtual void executeReceiveImpl(MultiTaskDispatcherType& taskDispatcher);
+		virtual void executeSendImpl(MultiTaskDispatcherType& taskDispatcher)
+		{}
 	};
 	//! Constructor
 	/*!
@@ -84,7 +153,7 @@ public:
 	//! Returns maximum clients amount
 	inline size_t maxClients() const
 	{
-		return _taskDispatcher.workersAmount() / 2;
+		return _maxClients;
 	}
 	//! Sets maximum clients amount
 	/*!
@@ -94,26 +163,129 @@ public:
 	*/
 	inline void setMaxClients(size_t newValue)
 	{
-		_taskDispatcher.setWorkersAmount(newValue * 2);
+		_maxClients = newValue;
+	}
+	//! Returns TRUE if the service is in full-duplex mode
+	inline bool duplexMode() const
+	{
+		return _duplexMode;
+	}
+	//! Switches the service to/from full-duplex mode
+	/*!
+	  In full-duplex mode the service starts one worker thread per client and executes AbstractDuplexTask objects
+	  in one worker thread. Two-method tasks are still supported in full-duplex mode but they are occupying
+	  two worker threads as usual.
+
+	  \param newValue TRUE to switch the service to the full-duplex mode
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setDuplexMode(bool newValue)
+	{
+		_duplexMode = newValue;
+	}
+	//! Returns maximum amount of the clients waiting for the free workers, 0 means that the admission queue is disabled
+	inline size_t maxPendingClients() const
+	{
+		return _maxPendingClients;
+	}
+	//! Sets maximum amount of the clients waiting for the free workers
+	/*!
+	  Without the admission queue the client is rejected (see onOverload()) if there are no free workers to start
+	  it's receiving and sending methods at once. With the admission queue the client is held until enough
+	  workers have been released or the admission timeout expires, so short spikes of the connections do not
+	  turn into rejected clients. The limit is split between the task dispatcher shards like the maximum clients
+	  amount. Clients which admission timeout has been expired are passed to onOverload() too.
+
+	  \param newValue New maximum amount of the clients in the admission queue, 0 disables the admission queue
+	  \param admissionTimeout Maximum time the client is waiting in the admission queue
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxPendingClients(size_t newValue, const Timeout& admissionTimeout = Timeout::defaultTimeout())
+	{
+		_maxPendingClients = newValue;
+		_admissionTimeout = admissionTimeout;
+	}
+	//! Returns maximum time the client is waiting in the admission queue
+	inline const Timeout& admissionTimeout() const
+	{
+		return _admissionTimeout;
+	}
+	//! Returns counters of the task dispatcher shards summed up
+	/*!
+	  \note Thread-safe
+	*/
+	MultiTaskDispatcherType::Counters counters() const;
+	//! Returns worker threads amount of the task dispatcher shards summed up
+	/*!
+	  It is two workers per client or one worker per client in the full-duplex mode after the service has been started.
+	*/
+	size_t workersAmount() const;
+	//! Returns task dispatcher shards amount
+	inline size_t dispatcherShardsAmount() const
+	{
+		return _dispatcherShardsAmount;
+	}
+	//! Sets task dispatcher shards amount
+	/*!
+	  By default all listeners are passing tasks to the one shared task dispatcher. If the shards amount is
+	  more than 1, the service creates this amount of task dispatchers, each of them having it's part of the
+	  maximum clients amount workers, and listener threads are bound to the dispatcher shards in round-robin
+	  manner. Set it to the total amount of listener shards to give each listener thread it's own dispatcher.
+	  The parts sum up to the maximum clients amount exactly, so the shards amount is reduced to the maximum
+	  clients amount if it exceeds it.
+
+	  \param newValue New task dispatcher shards amount
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setDispatcherShardsAmount(size_t newValue)
+	{
+		_dispatcherShardsAmount = newValue;
 	}
 	//! Adds listener to the service
 	/*!
 	  \param addrInfo TCP-address info to bind to
 	  \param backLog Listen backlog
+	  \param shardsAmount Amount of the listening sockets to open with SO_REUSEPORT option, each of them
+	                      is served by it's own listener thread, so the kernel spreads the accept load across cores
+	  \param options Socket tuning profile of the listening socket and the accepted connections
 	  \return Listener id
 
 	  \note Thread-unsafe: call it when subsystem is idling only
 	*/
-	int addListener(const TcpAddrInfo& addrInfo, unsigned int backLog = 15);
+	int addListener(const TcpAddrInfo& addrInfo, unsigned int backLog = 15, size_t shardsAmount = 1,
+			const TcpSocketOptions& options = TcpSocketOptions());
 	//! Updates listener
 	/*!
 	  \param id Listener id
 	  \param addrInfo TCP-address info to bind to
 	  \param backLog Listen backlog
+	  \param shardsAmount Amount of the listening sockets to open with SO_REUSEPORT option
+	  \param options Socket tuning profile of the listening socket and the accepted connections
 
 	  \note Thread-unsafe: call it when subsystem is idling only
 	*/
-	void updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog = 15);
+	void updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog = 15, size_t shardsAmount = 1,
+			const TcpSocketOptions& options = TcpSocketOptions());
+	//! Adds Unix domain socket listener to the service
+	/*!
+	  \param addrInfo Unix domain socket address info to bind to
+	  \param backLog Listen backlog
+	  \return Listener id
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	int addListener(const UnixAddrInfo& addrInfo, unsigned int backLog = 15);
+	//! Updates Unix domain socket listener
+	/*!
+	  \param id Listener id
+	  \param addrInfo Unix domain socket address info to bind to
+	  \param backLog Listen backlog
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	void updateListener(int id, const UnixAddrInfo& addrInfo, unsigned int backLog = 15);
 	//! Removes listener
 	/*!
 	  \param id Id of the listener to remove
@@ -128,6 +300,7 @@ public:
 	inline void resetListeners()
 	{
 		_listenerConfigs.clear();
+		_unixListenerConfigs.clear();
 	}
 	//! Starting service method redefinition
 	virtual void start();
@@ -159,20 +332,41 @@ protected:
 private:
 	struct ListenerConfig
 	{
-		ListenerConfig(const TcpAddrInfo& addrInfo, unsigned int backLog) :
+		ListenerConfig(const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options) :
 			addrInfo(addrInfo),
-			backLog(backLog)
+			backLog(backLog),
+			shardsAmount(shardsAmount),
+			options(options)
 		{}
 
 		TcpAddrInfo addrInfo;
 		unsigned int backLog;
+		size_t shardsAmount;
+		TcpSocketOptions options;
 	};
 	typedef std::map<int, ListenerConfig> ListenerConfigs;
 
+	struct UnixListenerConfig
+	{
+		UnixListenerConfig(const UnixAddrInfo& addrInfo, unsigned int backLog) :
+			addrInfo(addrInfo),
+			backLog(backLog)
+		{}
+
+		UnixAddrInfo addrInfo;
+		unsigned int backLog;
+	};
+	typedef std::map<int, UnixListenerConfig> UnixListenerConfigs;
+
 	class ListenerThread : public OscillatorThread
 	{
 	public:
-		ListenerThread(AbstractAsyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog);
+		ListenerThread(AbstractAsyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog, bool reusePort, const TcpSocketOptions& options,
+				MultiTaskDispatcherType& taskDispatcher);
+		ListenerThread(AbstractAsyncTcpService& service, const UnixAddrInfo& addrInfo, unsigned int backLog,
+				MultiTaskDispatcherType& taskDispatcher);
+		//! Destructor releases the listening socket to the listening socket registry
+		virtual ~ListenerThread();
 	private:
 		ListenerThread();
 		ListenerThread(const ListenerThread&);								// No copy
@@ -183,18 +377,32 @@ private:
 		virtual void doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired);
 
 		AbstractAsyncTcpService& _service;
-		const TcpAddrInfo _addrInfo;
+		const std::auto_ptr<TcpAddrInfo> _addrInfoAutoPtr;
+		const std::auto_ptr<UnixAddrInfo> _unixAddrInfoAutoPtr;
 		const unsigned int _backLog;
+		const bool _reusePort;
+		const TcpSocketOptions _options;
+		MultiTaskDispatcherType& _taskDispatcher;
 		TcpSocket _serverSocket;
+		UnixSocket _unixServerSocket;
 	};
 
 	typedef std::list<ListenerThread *> ListenersContainer;
+	typedef std::vector<MultiTaskDispatcherType *> DispatcherShardsContainer;
 
 	void resetListenerThreads();
+	void resetDispatcherShards();
 
 	MultiTaskDispatcherType _taskDispatcher;
+	size_t _maxClients;
+	size_t _maxPendingClients;
+	Timeout _admissionTimeout;
+	bool _duplexMode;
+	size_t _dispatcherShardsAmount;
+	DispatcherShardsContainer _dispatcherShards;
 	int _lastListenerConfigId;
 	ListenerConfigs _listenerConfigs;
+	UnixListenerConfigs _unixListenerConfigs;
 	ListenersContainer _listeners;
 };
 
@@ -8,6 +8,7 @@
 #include <map>
 #include <list>
 #include <string.h>
+#include <sys/types.h>
 
 namespace isl
 {
@@ -75,7 +76,7 @@ public:
 	//! Returns true if flush() call is needed
 	inline bool needFlush() const
 	{
-		return !_sendBuffer.empty();
+		return !_sendBuffer.empty() || _fileBytesLeft > 0;
 	}
 	//! Sends chunked encoded STL string
 	/*!
@@ -148,6 +149,35 @@ public:
 	  \return TRUE if all data has been send to peer or FALSE if the I/O timeout has been expired and flush() call is needed to complete an operation
 	*/
 	bool writeOnce(AbstractIODevice& device, const char * buffer, size_t bufferSize, const Timestamp& limit, size_t * bytesWrittenToDevice = 0);
+	//! Sends a part of the file as a chunk
+	/*!
+	  File data is sent by the I/O-device's sendFile() method, which is using sendfile(2) for the TCP-socket, so the data is
+	  not copied to the user space. The file descriptor should stay valid until the data is sent completely.
+
+	  If size <= 0 this method does nothing and returns true.
+	  \param device I/O-device for data to send
+	  \param fileDescriptor Descriptor of the file to send
+	  \param offset Offset of the data in the file
+	  \param size Size of the data to send
+	  \param limit Data transfer limit timestamp
+	  \param bytesWrittenToDevice Pointer to memory location where number of bytes have been sent to the device is to be put
+	  \return TRUE if all data has been send to peer or FALSE if the I/O timeout has been expired and flush() call is needed to complete an operation
+	*/
+	bool writeFileChunk(AbstractIODevice& device, int fileDescriptor, off_t offset, size_t size, const Timestamp& limit, size_t * bytesWrittenToDevice = 0);
+	//! Sends a part of the file as an unencoded body with Content-Length header field and finalizes HTTP-message
+	/*!
+	  File data is sent by the I/O-device's sendFile() method, which is using sendfile(2) for the TCP-socket, so the data is
+	  not copied to the user space. The file descriptor should stay valid until the data is sent completely.
+
+	  \param device I/O-device for data to send
+	  \param fileDescriptor Descriptor of the file to send
+	  \param offset Offset of the data in the file
+	  \param size Size of the data to send
+	  \param limit Data transfer limit timestamp
+	  \param bytesWrittenToDevice Pointer to memory location where number of bytes have been sent to the device is to be put
+	  \return TRUE if all data has been send to peer or FALSE if the I/O timeout has been expired and flush() call is needed to complete an operation
+	*/
+	bool writeFile(AbstractIODevice& device, int fileDescriptor, off_t offset, size_t size, const Timestamp& limit, size_t * bytesWrittenToDevice = 0);
 	//! Sends bodyless HTTP-message
 	/*!
 	  \param device I/O-device for data to send
@@ -177,6 +207,9 @@ public:
 	*/
 	bool flush(AbstractIODevice& device, const Timestamp& limit, size_t * bytesWrittenToDevice = 0);
 	//! Resets writer to it's initial state
+	/*!
+	  I/O-device corked by the writer during the file data transmission is uncorked.
+	*/
 	void reset();
 protected:
 	//! HTTP-message first line composition method
@@ -185,7 +218,20 @@ private:
 	typedef std::multimap<std::string, std::pair<std::string, bool> > Header;
 
 	std::string composeHeader();
-	bool flushBuffer(AbstractIODevice& device, const Timestamp& limit, size_t * bytesWrittenToDevice = 0);
+	//! Sends the send buffer followed by the body and the body suffix using vectored write
+	/*!
+	  Body and it's suffix are sent directly from the caller's memory. If the data has not been sent completely, the unsent rest
+	  of it is copied to the send buffer to be sent by the flush() call.
+	*/
+	bool flushBuffer(AbstractIODevice& device, const Timestamp& limit, size_t * bytesWrittenToDevice = 0,
+			const char * body = 0, size_t bodySize = 0, const char * bodySuffix = 0, size_t bodySuffixSize = 0);
+	//! Sends the send buffer, the pending file data and the file data suffix
+	/*!
+	  The device is corked while the header is followed by the file data, so they are sharing full-sized segments.
+	*/
+	bool flushAll(AbstractIODevice& device, const Timestamp& limit, size_t * bytesWrittenToDevice);
+	size_t composeUnsentBuffers(AbstractIODevice::ConstBuffer * buffers, const char * body, size_t bodySize,
+			const char * bodySuffix, size_t bodySuffixSize) const;
 
 	Header _header;
 	bool _transmissionStarted;
@@ -193,6 +239,11 @@ private:
 	bool _isFinalizing;
 	std::string _sendBuffer;
 	size_t _bytesSent;
+	int _fileDescriptor;
+	off_t _fileOffset;
+	size_t _fileBytesLeft;
+	const char * _fileSuffix;
+	AbstractIODevice * _corkedDevicePtr;
 };
 
 } // namespace isl
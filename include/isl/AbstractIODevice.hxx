@@ -2,7 +2,14 @@
 #define ISL__ABSTRACT_IO_DEVICE__HXX
 
 #include <isl/Timeout.hxx>
+#include <isl/Timestamp.hxx>
 #include <isl/AbstractError.hxx>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifndef ISL__IO_DEVICE_SEND_FILE_BUFFER_SIZE
+#define ISL__IO_DEVICE_SEND_FILE_BUFFER_SIZE 16384
+#endif
 
 namespace isl
 {
@@ -38,6 +45,30 @@ public:
 		}
 	};
 
+	//! Constant buffer span for the scatter/gather I/O-operations
+	struct ConstBuffer
+	{
+		//! Constructs an empty buffer span
+		ConstBuffer() :
+			data(0),
+			size(0)
+		{}
+		//! Constructs buffer span
+		/*!
+		  \param data Pointer to the buffer
+		  \param size Buffer size
+		*/
+		ConstBuffer(const char * data, size_t size) :
+			data(data),
+			size(size)
+		{}
+
+		//! Pointer to the buffer
+		const char * data;
+		//! Buffer size
+		size_t size;
+	};
+
 	AbstractIODevice();
 	virtual ~AbstractIODevice();
 
@@ -66,6 +97,31 @@ public:
 	    \return Count of the actually sent bytes
 	*/
 	size_t write(const char * buffer, size_t bufferSize, const Timeout& timeout = Timeout());
+	//! Writes a sequence of the data buffers to the I/O device at once
+	/*!
+	    Buffers are written in the order they are passed, the result is the same as if they were concatenated.
+
+	    \param buffers Pointer to the array of the buffer spans
+	    \param buffersAmount Amount of the buffer spans in the array
+	    \param timeout Write timeout
+	    \return Count of the actually sent bytes
+	*/
+	size_t writeVector(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout = Timeout());
+	//! Writes a part of the file to the I/O device
+	/*!
+	    \param fileDescriptor Descriptor of the file to send
+	    \param offset Offset of the data in the file
+	    \param size Size of the data to send
+	    \param timeout Write timeout
+	    \return Count of the actually sent bytes
+	*/
+	size_t sendFile(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout = Timeout());
+	//! Corks or uncorks the I/O device
+	/*!
+	    Corked device is holding back partial frames of the written data, which are sent when the device is uncorked.
+	    \param newValue TRUE to cork the device or FALSE to uncork it and send pending data
+	*/
+	void setCorked(bool newValue);
 protected:
 	//! Opening I/O device abstract method
 	virtual void openImplementation() = 0;
@@ -75,11 +131,48 @@ protected:
 	virtual size_t readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout) = 0;
 	//! Writing to I/O device abstract method
 	virtual size_t writeImplementation(const char * buffer, size_t bufferSize, const Timeout& timeout) = 0;
+	//! Writing a sequence of the buffers to I/O device virtual method
+	/*!
+	  Default implementation writes the first non-empty buffer only using writeImplementation().
+
+	  \param buffers Pointer to the array of the buffer spans
+	  \param buffersAmount Amount of the buffer spans in the array
+	  \param timeout Write timeout
+	  \return Count of the actually sent bytes
+	*/
+	virtual size_t writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout);
+	//! Writing a part of the file to I/O device virtual method
+	/*!
+	  Default implementation reads the data using pread(2) and writes it using writeImplementation().
+
+	  \param fileDescriptor Descriptor of the file to send
+	  \param offset Offset of the data in the file
+	  \param size Size of the data to send
+	  \param timeout Write timeout
+	  \return Count of the actually sent bytes
+	*/
+	virtual size_t sendFileImplementation(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout);
+	//! Corking/uncorking I/O device virtual method
+	/*!
+	  Default implementation does nothing.
+
+	  \param newValue TRUE to cork the device or FALSE to uncork it
+	*/
+	virtual void setCorkedImplementation(bool newValue);
 	//! Sets is open flag to the new value
 	inline void setIsOpen(bool newValue)
 	{
 		_isOpen = newValue;
 	}
+	//! Awaits for the descriptor events using poll(2) for the rest of the timeout
+	/*!
+	  \param descriptor Descriptor to wait the events on
+	  \param events poll(2) events to wait for
+	  \param timeout Timeout of the whole I/O-operation
+	  \param limit Reference to the I/O-operation's limit timestamp, which is calculated on the first call if zero
+	  \return Returned poll(2) events, 0 if the wait has been interrupted by a signal or -1 if the timeout has been expired
+	*/
+	static short pollDescriptor(int descriptor, short events, const Timeout& timeout, Timestamp& limit);
 private:
 	AbstractIODevice(const AbstractIODevice&);							// No copy
 
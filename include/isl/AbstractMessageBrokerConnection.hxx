@@ -4,6 +4,7 @@
 #include <isl/Subsystem.hxx>
 #include <isl/TcpSocket.hxx>
 #include <isl/TcpAddrInfo.hxx>
+#include <isl/DnsResolver.hxx>
 #include <isl/IOError.hxx>
 #include <isl/MessageQueue.hxx>
 #include <isl/MessageBuffer.hxx>
@@ -15,6 +16,10 @@
 #include <isl/ExceptionLogMessage.hxx>
 #include <memory>
 
+#ifndef ISL__MESSAGE_BROKER_CONNECTION_DEFAULT_CONNECT_TIMEOUT
+#define ISL__MESSAGE_BROKER_CONNECTION_DEFAULT_CONNECT_TIMEOUT 5		// Seconds
+#endif
+
 namespace isl
 {
 
@@ -30,6 +35,8 @@ namespace isl
   - AbstractMessageBrokerConnection::sendMessage() - sends message to the transport.
 
   TCP-connection control is provided by message receiver thread, which is automatically re-establishes it if aborted.
+  Connection attempts are raced across all addresses of the message broker and are limited by the connect timeout,
+  so a dead address does not stall the receiver thread for the kernel's SYN timeout.
   A thrown Exception with TcpSocket::ConnectionAbortedError error from the receiveMessage()/sendMessage()
   method is used as signal for reopening TCP-connection socket.
 
@@ -46,6 +53,11 @@ public:
 	typedef MessageBuffer<MessageType, Cloner> MessageBufferType;			//!< Message buffer type
 	typedef MessageBus<MessageType> MessageBusType;					//!< Message bus type
 
+	enum Constants {
+		//! Default connection establishing timeout in seconds
+		DefaultConnectTimeout = ISL__MESSAGE_BROKER_CONNECTION_DEFAULT_CONNECT_TIMEOUT
+	};
+
 	//! Input message queue factory base class
 	class InputQueueFactory
 	{
@@ -93,7 +105,10 @@ public:
 		_senderThread(*this),
 		_socket(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_resolverPtr(0),
+		_connectTimeout(static_cast<double>(DefaultConnectTimeout)),
+		_socketOptions()
 	{}
 	//! Constructor with user provided input message queue
 	/*!
@@ -115,7 +130,10 @@ public:
 		_senderThread(*this),
 		_socket(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_resolverPtr(0),
+		_connectTimeout(static_cast<double>(DefaultConnectTimeout)),
+		_socketOptions()
 	{}
 	//! Constructor with user provided output message bus
 	/*!
@@ -137,7 +155,10 @@ public:
 		_senderThread(*this),
 		_socket(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_resolverPtr(0),
+		_connectTimeout(static_cast<double>(DefaultConnectTimeout)),
+		_socketOptions()
 	{}
 	//! Constructor with user provided input message queue and output message bus
 	/*!
@@ -159,7 +180,10 @@ public:
 		_senderThread(*this),
 		_socket(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_resolverPtr(0),
+		_connectTimeout(static_cast<double>(DefaultConnectTimeout)),
+		_socketOptions()
 	{}
 	//! Returns a reference to the input message queue
 	inline MessageQueueType& inputQueue()
@@ -198,6 +222,54 @@ public:
 	{
 		_remoteAddr = newValue;
 	}
+	//! Returns message broker connection establishing timeout
+	inline const Timeout& connectTimeout() const
+	{
+		return _connectTimeout;
+	}
+	//! Sets message broker connection establishing timeout
+	/*!
+	  \param newValue New connection establishing timeout
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setConnectTimeout(const Timeout& newValue)
+	{
+		_connectTimeout = newValue;
+	}
+	//! Returns tuning profile of the message broker connection socket
+	inline const TcpSocketOptions& socketOptions() const
+	{
+		return _socketOptions;
+	}
+	//! Sets tuning profile of the message broker connection socket, e.g. TcpSocketOptions::lowLatency()
+	/*!
+	  \param newValue New socket tuning profile, which is applied to the socket before each connection attempt
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setSocketOptions(const TcpSocketOptions& newValue)
+	{
+		_socketOptions = newValue;
+	}
+	//! Returns a pointer to the resolver to re-resolve message broker address on each connection attempt or 0 if not set
+	inline DnsResolver * resolver() const
+	{
+		return _resolverPtr;
+	}
+	//! Sets the resolver to re-resolve message broker address on each connection attempt
+	/*!
+	  Message broker address is resolved asynchronously using the resolver's cache, so the receiver thread
+	  is not blocked by the resolver latency. Message broker address should be defined by the port number.
+
+	  \param newValue Pointer to the resolver or 0 to use the message broker address as is
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setResolver(DnsResolver * newValue)
+	{
+		_resolverPtr = newValue;
+	}
 	//! Adds message provider to subscribe input queue to while running
 	/*!
 	  \param provider Reference to provider to add
@@ -321,7 +393,9 @@ protected:
 			OscillatorThread(connection),
 			_connection(connection),
 			_connected(false),
-			_connectionAttempts(0)
+			_connectionAttempts(0),
+			_resolutionFuture(),
+			_resolvedAddrAutoPtr()
 		{}
 	private:
 		//! On start event handler
@@ -332,6 +406,8 @@ protected:
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Socket has been opened"));
 			_connected = false;
 			_connectionAttempts = 0;
+			_resolutionFuture = DnsResolver::Future();
+			_resolvedAddrAutoPtr.reset();
 		}
 		//! Doing the work virtual method
 		/*!
@@ -395,8 +471,30 @@ protected:
 					}
 				} else {
 					// Establishing connection if not connected
+					if (_connection._resolverPtr && _connection._remoteAddr.service().empty()) {
+						// Re-resolving message broker address without blocking on the resolver latency
+						if (!_resolutionFuture.isValid()) {
+							_resolutionFuture = _connection._resolverPtr->resolveAsync(_connection._remoteAddr.family(),
+									_connection._remoteAddr.host(), _connection._remoteAddr.port());
+						}
+						if (!_resolutionFuture.await(nextTickTimestamp)) {
+							break;
+						}
+						if (_resolutionFuture.succeeded()) {
+							_resolvedAddrAutoPtr.reset(new TcpAddrInfo(_resolutionFuture.addrInfo()));
+						} else {
+							Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Message broker address resolution failed: ") <<
+									_resolutionFuture.errorMessage());
+						}
+						_resolutionFuture = DnsResolver::Future();
+					}
 					try {
-						_connection._socket.connect(_connection._remoteAddr);
+						// Buffer sizes should be set before the connection is established to affect the TCP window scale
+						_connection._socket.applyOptions(_connection._socketOptions);
+						if (!_connection._socket.connectRacing(_resolvedAddrAutoPtr.get() ? *_resolvedAddrAutoPtr.get() : _connection._remoteAddr,
+									_connection._connectTimeout)) {
+							throw Exception(Error(SOURCE_LOCATION_ARGS, "Message broker connection timeout expired"));
+						}
 						Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Connection to message exchange peer has been established"));
 						_connected = true;
                                                 _connection.onReceiverConnected(_connection._socket);
@@ -446,6 +544,8 @@ protected:
 		AbstractMessageBrokerConnection& _connection;
 		bool _connected;
 		size_t _connectionAttempts;
+		DnsResolver::Future _resolutionFuture;
+		std::auto_ptr<TcpAddrInfo> _resolvedAddrAutoPtr;
 	};
 
 	//! Message sender thread class
@@ -706,6 +806,9 @@ private:
 	TcpSocket _socket;
 	ProvidersContainer _providers;
 	ConsumersContainer _consumers;
+	DnsResolver * _resolverPtr;
+	Timeout _connectTimeout;
+	TcpSocketOptions _socketOptions;
 };
 
 } // namespace isl
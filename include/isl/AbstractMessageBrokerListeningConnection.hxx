@@ -94,7 +94,8 @@ public:
 		_socket(),
 		_transferSocketAutoPtr(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_socketOptions()
 	{}
 	//! Constructor with user provided input message queue
 	/*!
@@ -117,7 +118,8 @@ public:
 		_socket(),
 		_transferSocketAutoPtr(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_socketOptions()
 	{}
 	//! Constructor with user provided output message bus
 	/*!
@@ -140,7 +142,8 @@ public:
 		_socket(),
 		_transferSocketAutoPtr(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_socketOptions()
 	{}
 	//! Constructor with user provided input message queue and output message bus
 	/*!
@@ -163,7 +166,8 @@ public:
 		_socket(),
 		_transferSocketAutoPtr(),
 		_providers(),
-		_consumers()
+		_consumers(),
+		_socketOptions()
 	{}
 	//! Returns a reference to the input message queue
 	inline MessageQueueType& inputQueue()
@@ -202,6 +206,21 @@ public:
 	{
 		_localAddr = newValue;
 	}
+	//! Returns tuning profile of the listening socket and the accepted connection
+	inline const TcpSocketOptions& socketOptions() const
+	{
+		return _socketOptions;
+	}
+	//! Sets tuning profile of the listening socket and the accepted connection, e.g. TcpSocketOptions::lowLatency()
+	/*!
+	  \param newValue New socket tuning profile
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setSocketOptions(const TcpSocketOptions& newValue)
+	{
+		_socketOptions = newValue;
+	}
 	//! Adds message provider to subscribe input queue to while running
 	/*!
 	  \param provider Reference to provider to add
@@ -336,6 +355,7 @@ protected:
 			_connection._socket.open();
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Socket has been opened"));
 			_connection._socket.bind(_connection._localAddr);
+			_connection._socket.applyListenerOptions(_connection._socketOptions);
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Socket has been binded"));
 			_connection._socket.listen(1);
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Socket has been switched to the listening state"));
@@ -713,6 +733,7 @@ private:
 	std::auto_ptr<TcpSocket> _transferSocketAutoPtr;
 	ProvidersContainer _providers;
 	ConsumersContainer _consumers;
+	TcpSocketOptions _socketOptions;
 };
 
 } // namespace isl
@@ -32,6 +32,12 @@ namespace isl
   client connection task implicitly by calling
   AbstractMessageBrokerService::AbstractTask::appointTermination() method.
 
+  Large broadcast payloads should be wrapped into the SharedBuffer, so the message cloning for each client is a
+  reference count increment, and sent using TcpSocket::sendShared() with the zero-copy send enabled in the
+  listener's socket options (see TcpSocketOptions::setZeroCopy()): the same buffer's pages are transmitted to all
+  clients without copying them into each socket's send buffer. The sender thread reaps zero-copy send completions
+  on each clock tick.
+
   \tparam Msg Message class
   \tparam Cloner Message cloner class with static <tt>Msg * Cloner::clone(const Msg& msg)</tt> method for cloning the message
 */
@@ -427,6 +433,10 @@ protected:
 						}
 					}
 				}
+				// Releasing the buffers of the completed zero-copy sends, if any (see TcpSocket::sendShared())
+				if (socket().pendingZeroCopySends() > 0) {
+					socket().reapZeroCopyCompletions();
+				}
 				// Checking termination
 				if (shouldTerminate()) {
 					isl::Log::debug().log(isl::LogMessage(SOURCE_LOCATION_ARGS, "Task termination has been detected -> exiting from the sender thread execution"));
@@ -2,11 +2,16 @@
 #define ISL__ABSTRACT_POSIX_IO_DEVICE__HXX
 
 #include <isl/AbstractIODevice.hxx>
+#include <isl/Timestamp.hxx>
 
 namespace isl
 {
 
 //! POSIX I/O-device abstraction
+/*!
+  The device handle is switched to non-blocking mode. Each I/O-operation tries the respective system call first and
+  waits for the handle readiness using poll(2) for the rest of the timeout only if the system call reports EAGAIN.
+*/
 class AbstractPosixIODevice : public AbstractIODevice_NEW
 {
 public:
@@ -76,12 +81,21 @@ protected:
 	  \return POSIX I/O device descriptor
 	*/
 	virtual int openImpl() = 0;
+	//! Awaits for the handle events using poll(2) for the rest of the timeout
+	/*!
+	  \param events poll(2) events to wait for
+	  \param timeout Timeout of the whole I/O-operation
+	  \param limit Reference to the I/O-operation's limit timestamp, which is calculated on the first call if zero
+	  \return Returned poll(2) events or -1 if the timeout has been expired
+	*/
+	short awaitHandle(short events, const Timeout& timeout, Timestamp& limit);
 	virtual void onReadException() = 0;
 	virtual void onReadEndOfFile() = 0;
 	virtual void onWriteException() = 0;
 	virtual void onWriteEndOfFile() = 0;
 private:
 	void close(bool raiseExceptionOnError);
+	void setNonBlocking();
 
 	int _handle;
 	bool _isOpen;
@@ -0,0 +1,426 @@
+#ifndef ISL__ABSTRACT_REACTOR_TCP_SERVICE__HXX
+#define ISL__ABSTRACT_REACTOR_TCP_SERVICE__HXX
+
+#include <isl/Subsystem.hxx>
+#include <isl/TaskDispatcher.hxx>
+#include <isl/TcpAddrInfo.hxx>
+#include <isl/TcpSocket.hxx>
+#include <isl/TcpSocketOptions.hxx>
+#include <isl/IoUringAcceptor.hxx>
+#include <isl/Mutex.hxx>
+#include <isl/TimingWheel.hxx>
+#include <isl/LogMessage.hxx>
+#include <isl/ExceptionLogMessage.hxx>
+#include <sys/epoll.h>
+#include <map>
+#include <set>
+#include <vector>
+
+#ifndef ISL__REACTOR_TCP_SERVICE_DEFAULT_MAX_EVENTS
+#define ISL__REACTOR_TCP_SERVICE_DEFAULT_MAX_EVENTS 256
+#endif
+
+namespace isl
+{
+
+//! Base class for reactor TCP-service, which multiplexes client connections using epoll(7)
+/*!
+  Unlike AbstractSyncTcpService and AbstractAsyncTcpService the client connection does not occupy a worker thread
+  for it's lifetime. Client connection sockets are registered in one of the reactor threads, which are waiting
+  for the I/O-readiness events using epoll(7) and are passing the readiness events to the fixed pool of the worker
+  threads. So the amount of threads does not depend on the amount of the clients connected.
+
+  Each connection is registered in the reactor in the one-shot mode, so exactly one worker is handling the
+  connection's event at the same time and the connection is re-armed after the event has been handled.
+
+  Per-connection read, write and keep-alive deadlines are kept in the hashed timing wheel of the reactor thread
+  (see AbstractTask::setTimeout()), so arming and cancelling a deadline on each I/O-event is O(1) and the reactor
+  does work on each wheel tick only for the deadlines which are expired.
+
+  If the io_uring(7) engine is enabled (see IoUring::setEnabled()), listener threads accept the connections in
+  batches using IoUringAcceptor, so the burst of the incoming connections costs less than one system call per
+  connection. Otherwise or if the kernel does not support it, the connections are accepted by TcpSocket::accept().
+
+  \note Task event handlers should not block - use zero or small timeouts on socket I/O operations.
+  \note Raise the open files limit (RLIMIT_NOFILE) of the process to serve tens of thousands of connections.
+*/
+class AbstractReactorTcpService : public Subsystem
+{
+private:
+	class ReactorThread;
+public:
+	enum Constants {
+		DefaultMaxEvents = ISL__REACTOR_TCP_SERVICE_DEFAULT_MAX_EVENTS
+	};
+	//! Reactor TCP-service abstract task
+	class AbstractTask
+	{
+	public:
+		//! Constructor
+		/*!
+		  \param socket Reference to the client connection socket
+		*/
+		AbstractTask(TcpSocket& socket) :
+			_socketAutoPtr(&socket),
+			_reactorPtr(0),
+			_timeout(),
+			_deadlineTimer(*this),
+			_isRegistered(false)
+		{}
+		// Destructor
+		virtual ~AbstractTask()
+		{}
+		//! Returns a reference to the client connection socket
+		inline TcpSocket& socket()
+		{
+			return *_socketAutoPtr.get();
+		}
+		//! On client connection socket is ready to be read event handler
+		/*!
+		  \return TRUE if the connection should be kept or FALSE if it should be closed
+		*/
+		virtual bool onReadable() = 0;
+		//! On client connection socket is ready to be written event handler
+		/*!
+		  \return TRUE if the connection should be kept or FALSE if it should be closed
+		  \note Default implementation does nothing and returns TRUE
+		*/
+		virtual bool onWritable()
+		{
+			return true;
+		}
+		//! Returns TRUE if the task is awaiting for the client connection socket to be ready for writing
+		/*!
+		  The method is called on each re-arming of the connection in the reactor.
+		  \note Default implementation returns FALSE
+		*/
+		virtual bool awaitWritable() const
+		{
+			return false;
+		}
+		//! Returns I/O-readiness timeout of the connection
+		inline const Timeout& timeout() const
+		{
+			return _timeout;
+		}
+		//! Sets I/O-readiness timeout of the connection
+		/*!
+		  Timeout is armed each time the connection is (re)armed in the reactor and is cancelled when the next
+		  I/O-readiness event arrives, so it limits the time to wait for the client's data or for the socket's send
+		  buffer space. Set it from the event handlers to switch between read, write and keep-alive timeouts.
+		  onTimeout() is called if the timeout expires.
+
+		  \param newValue New I/O-readiness timeout, zero timeout (default) disables the deadline
+		*/
+		inline void setTimeout(const Timeout& newValue)
+		{
+			_timeout = newValue;
+		}
+		//! On I/O-readiness timeout expired event handler
+		/*!
+		  \return TRUE if the connection should be kept or FALSE if it should be closed
+		  \note Default implementation does nothing and returns FALSE
+		*/
+		virtual bool onTimeout()
+		{
+			return false;
+		}
+	private:
+		AbstractTask();
+		AbstractTask(const AbstractTask&);						// No copy
+
+		AbstractTask& operator=(const AbstractTask&);					// No copy
+
+		//! Connection deadline timer of the reactor's timing wheel
+		class DeadlineTimer : public TimingWheel::AbstractTimer
+		{
+		public:
+			DeadlineTimer(AbstractTask& task) :
+				TimingWheel::AbstractTimer(),
+				_task(task)
+			{}
+
+			virtual void onExpired();
+		private:
+			AbstractTask& _task;
+		};
+
+		std::auto_ptr<TcpSocket> _socketAutoPtr;
+		ReactorThread * _reactorPtr;
+		Timeout _timeout;
+		DeadlineTimer _deadlineTimer;
+		bool _isRegistered;
+
+		friend class AbstractReactorTcpService;
+	};
+	//! Constructor
+	/*!
+	  \param owner Pointer to the owner subsystem
+	  \param workersAmount Amount of worker threads which are handling I/O-readiness events
+	  \param reactorsAmount Amount of reactor threads
+	  \param clockTimeout Subsystem's clock timeout
+	*/
+	AbstractReactorTcpService(Subsystem * owner, size_t workersAmount, size_t reactorsAmount = 1, const Timeout& clockTimeout = Timeout::defaultTimeout());
+	//! Destructor
+	virtual ~AbstractReactorTcpService();
+
+	//! Returns worker threads amount
+	inline size_t workersAmount() const
+	{
+		return _taskDispatcher.workersAmount();
+	}
+	//! Sets worker threads amount
+	/*!
+	  \param newValue New worker threads amount
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setWorkersAmount(size_t newValue)
+	{
+		_taskDispatcher.setWorkersAmount(newValue);
+	}
+	//! Returns reactor threads amount
+	inline size_t reactorsAmount() const
+	{
+		return _reactorsAmount;
+	}
+	//! Sets reactor threads amount
+	/*!
+	  \param newValue New reactor threads amount
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setReactorsAmount(size_t newValue)
+	{
+		_reactorsAmount = newValue;
+	}
+	//! Returns maximum amount of the events to fetch by the reactor thread at once
+	inline size_t maxEvents() const
+	{
+		return _maxEvents;
+	}
+	//! Sets maximum amount of the events to fetch by the reactor thread at once
+	/*!
+	  \param newValue New maximum amount of the events to fetch at once
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxEvents(size_t newValue)
+	{
+		_maxEvents = newValue;
+	}
+	//! Returns timing wheel resolution of the reactor threads
+	inline const Timeout& timerResolution() const
+	{
+		return _timerResolution;
+	}
+	//! Sets timing wheel resolution of the reactor threads
+	/*!
+	  Connection deadlines are expired with the resolution accuracy.
+
+	  \param newValue New timing wheel resolution
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setTimerResolution(const Timeout& newValue)
+	{
+		_timerResolution = newValue;
+	}
+	//! Returns current amount of the client connections
+	/*!
+	  \note Thread-safe
+	*/
+	size_t connectionsAmount() const;
+	//! Adds listener to the service
+	/*!
+	  \param addrInfo TCP-address info to bind to
+	  \param backLog Listen backlog
+	  \param shardsAmount Amount of the listening sockets to open with SO_REUSEPORT option, each of them
+	                      is served by it's own listener thread, so the kernel spreads the accept load across cores
+	  \param options Socket tuning profile of the listening socket and the accepted connections
+	  \return Listener id
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	int addListener(const TcpAddrInfo& addrInfo, unsigned int backLog = 15, size_t shardsAmount = 1,
+			const TcpSocketOptions& options = TcpSocketOptions());
+	//! Updates listener
+	/*!
+	  \param id Listener id
+	  \param addrInfo TCP-address info to bind to
+	  \param backLog Listen backlog
+	  \param shardsAmount Amount of the listening sockets to open with SO_REUSEPORT option
+	  \param options Socket tuning profile of the listening socket and the accepted connections
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	void updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog = 15, size_t shardsAmount = 1,
+			const TcpSocketOptions& options = TcpSocketOptions());
+	//! Removes listener
+	/*!
+	  \param id Id of the listener to remove
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	void removeListener(int id);
+	//! Resets all listeners
+	/*!
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void resetListeners()
+	{
+		_listenerConfigs.clear();
+	}
+	//! Starting service method redefinition
+	virtual void start();
+	//! Stopping service method redefinition
+	virtual void stop();
+protected:
+	//! On overload event handler
+	/*!
+	  Reactors are stopped before the workers, so the handler is not called while the service is stopping.
+
+	  \param task Reference to the task which event has not been handled - the connection is to be closed after the call
+	*/
+	virtual void onOverload(AbstractTask& task)
+	{}
+	//! On client connection event handler
+	/*!
+	  \param socket Reference to client connection socket
+	  \return TRUE if to accept connection or FALSE otherwise
+	  \note Default implementation does nothing and returns TRUE
+	*/
+	virtual bool onConnected(TcpSocket& socket)
+	{
+		return true;
+	}
+	//! Task creation abstract virtual method to override in subclasses
+	/*!
+	  \param socket Reference to the client connection socket
+	*/
+	virtual AbstractTask * createTask(TcpSocket& socket) = 0;
+private:
+	AbstractReactorTcpService();
+	AbstractReactorTcpService(const AbstractReactorTcpService&);				// No copy
+
+	AbstractReactorTcpService& operator=(const AbstractReactorTcpService&);			// No copy
+
+	//! I/O-readiness event to be handled by the worker thread
+	class Event
+	{
+	public:
+		Event(AbstractTask& task, uint32_t events, bool isTimedOut = false) :
+			_task(task),
+			_events(events),
+			_isTimedOut(isTimedOut)
+		{}
+
+		void execute(TaskDispatcher<Event>& taskDispatcher);
+	private:
+		Event();
+		Event(const Event&);								// No copy
+
+		Event& operator=(const Event&);							// No copy
+
+		AbstractTask& _task;
+		const uint32_t _events;
+		const bool _isTimedOut;
+	};
+
+	typedef TaskDispatcher<Event> TaskDispatcherType;
+
+	class ReactorThread : public OscillatorThread
+	{
+	public:
+		ReactorThread(AbstractReactorTcpService& service);
+		virtual ~ReactorThread();
+
+		size_t connectionsAmount() const;
+		void addTask(std::auto_ptr<AbstractTask>& taskAutoPtr);
+		void rearmTask(AbstractTask& task);
+		void removeTask(AbstractTask& task);
+		void onTaskExpired(AbstractTask& task);
+	private:
+		ReactorThread();
+		ReactorThread(const ReactorThread&);						// No copy
+
+		ReactorThread& operator=(const ReactorThread&);					// No copy
+
+		typedef std::set<AbstractTask *> TasksContainer;
+		typedef std::vector<AbstractTask *> ExpiredTasksContainer;
+
+		static uint32_t eventsMask(const AbstractTask& task);
+
+		void dispatch(AbstractTask& task, uint32_t events, bool isTimedOut);
+		virtual void doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired);
+
+		AbstractReactorTcpService& _service;
+		int _epollDescriptor;
+		mutable Mutex _tasksMutex;
+		TimingWheel _timingWheel;
+		TasksContainer _tasks;
+		ExpiredTasksContainer _expiredTasks;
+		std::vector<struct epoll_event> _events;
+	};
+
+	class ListenerThread : public OscillatorThread
+	{
+	public:
+		ListenerThread(AbstractReactorTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog, bool reusePort, const TcpSocketOptions& options);
+		//! Destructor releases the listening socket to the listening socket registry
+		virtual ~ListenerThread();
+	private:
+		ListenerThread();
+		ListenerThread(const ListenerThread&);						// No copy
+
+		ListenerThread& operator=(const ListenerThread&);				// No copy
+
+		virtual void onStart();
+		virtual void doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired);
+		virtual void onStop();
+
+		AbstractReactorTcpService& _service;
+		const TcpAddrInfo _addrInfo;
+		const unsigned int _backLog;
+		const bool _reusePort;
+		const TcpSocketOptions _options;
+		TcpSocket _serverSocket;
+		std::auto_ptr<IoUringAcceptor> _acceptorAutoPtr;
+		size_t _nextReactorIndex;
+	};
+
+	struct ListenerConfig
+	{
+		ListenerConfig(const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options) :
+			addrInfo(addrInfo),
+			backLog(backLog),
+			shardsAmount(shardsAmount),
+			options(options)
+		{}
+
+		TcpAddrInfo addrInfo;
+		unsigned int backLog;
+		size_t shardsAmount;
+		TcpSocketOptions options;
+	};
+	typedef std::map<int, ListenerConfig> ListenerConfigs;
+
+	typedef std::list<ListenerThread *> ListenersContainer;
+	typedef std::vector<ReactorThread *> ReactorsContainer;
+
+	void resetListenerThreads();
+	void resetReactorThreads();
+
+	TaskDispatcherType _taskDispatcher;
+	size_t _reactorsAmount;
+	size_t _maxEvents;
+	Timeout _timerResolution;
+	int _lastListenerConfigId;
+	ListenerConfigs _listenerConfigs;
+	ListenersContainer _listeners;
+	ReactorsContainer _reactors;
+};
+
+} // namespace isl
+
+#endif
@@ -5,9 +5,13 @@
 #include <isl/TaskDispatcher.hxx>
 #include <isl/TcpAddrInfo.hxx>
 #include <isl/TcpSocket.hxx>
+#include <isl/TcpSocketOptions.hxx>
+#include <isl/UnixAddrInfo.hxx>
+#include <isl/UnixSocket.hxx>
 #include <isl/LogMessage.hxx>
 #include <isl/ExceptionLogMessage.hxx>
 #include <map>
+#include <vector>
 
 namespace isl
 {
@@ -67,36 +71,234 @@ public:
 	//! Returns maximum clients amount
 	inline size_t maxClients() const
 	{
-		return _taskDispatcher.workersAmount();
+		return _maxClients;
 	}
 	//! Sets maximum clients amount
 	/*!
+	  Maximum clients amount is split between the task dispatcher shards as their workers amount, which is
+	  the maximum workers amount in the elastic mode (see setElasticWorkers()).
+
 	  \param newValue New maximum clients amount
 
 	  \note Thread-unsafe: call it when subsystem is idling only
 	*/
 	inline void setMaxClients(size_t newValue)
 	{
-		_taskDispatcher.setWorkersAmount(newValue);
+		_maxClients = newValue;
+	}
+	//! Returns maximum amount of the accepted connections waiting for the free worker, 0 means unlimited
+	inline size_t maxPendingClients() const
+	{
+		return _maxPendingClients;
+	}
+	//! Sets maximum amount of the accepted connections waiting for the free worker
+	/*!
+	  The limit is split between the task dispatcher shards like the maximum clients amount. Connections which do not
+	  fit the limit are handled according to the overload policy, rejected ones are passed to onOverload().
+
+	  \param newValue New maximum amount of the pending connections, 0 means unlimited
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxPendingClients(size_t newValue)
+	{
+		_maxPendingClients = newValue;
+	}
+	//! Returns pending connections overflow policy
+	inline TaskDispatcherType::OverloadPolicy overloadPolicy() const
+	{
+		return _overloadPolicy;
+	}
+	//! Sets pending connections overflow policy
+	/*!
+	  \param newValue New pending connections overflow policy
+	  \param overloadTimeout Maximum time to block the listener thread for the block policy
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setOverloadPolicy(TaskDispatcherType::OverloadPolicy newValue, const Timeout& overloadTimeout = Timeout::defaultTimeout())
+	{
+		_overloadPolicy = newValue;
+		_overloadTimeout = overloadTimeout;
+	}
+	//! Returns maximum queue waiting time estimate to accept new connections at, zero timeout means no limit
+	inline const Timeout& maxQueueWait() const
+	{
+		return _maxQueueWait;
+	}
+	//! Sets maximum queue waiting time estimate to accept new connections at
+	/*!
+	  Listener thread stops accepting connections until the next clock tick if the new connection is estimated
+	  to wait for the free worker longer than this timeout (see TaskDispatcher::queueWaitEstimate()), so the
+	  connections are kept in the listen backlog by the kernel instead of the pending tasks queue.
+
+	  \param newValue New maximum queue waiting time estimate, zero timeout means no limit
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxQueueWait(const Timeout& newValue)
+	{
+		_maxQueueWait = newValue;
+	}
+	//! Returns TRUE if the accepted connections waiting for the free worker are served on stop
+	inline bool drainOnStop() const
+	{
+		return _drainOnStop;
+	}
+	//! Sets serving of the accepted connections waiting for the free worker on stop
+	/*!
+	  Listeners are stopped before the task dispatchers, so if it is set, no accepted connection is dropped
+	  on restart, upgrade or termination (see TaskDispatcher::setDrainOnStop()).
+
+	  \param newValue TRUE if to serve pending connections on stop or FALSE if to drop them
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setDrainOnStop(bool newValue)
+	{
+		_drainOnStop = newValue;
+	}
+	//! Returns TRUE if the task dispatcher shards are in the work-stealing mode
+	inline bool workStealing() const
+	{
+		return _workStealing;
+	}
+	//! Sets the work-stealing mode of the task dispatcher shards
+	/*!
+	  \param newValue TRUE if to turn the work-stealing mode on (see TaskDispatcher::setWorkStealing())
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setWorkStealing(bool newValue)
+	{
+		_workStealing = newValue;
+	}
+	//! Returns TRUE if the task dispatcher shards are in the elastic mode
+	inline bool elasticWorkers() const
+	{
+		return _elasticWorkers;
+	}
+	//! Returns minimum clients amount to keep the workers running for in the elastic mode
+	inline size_t minClients() const
+	{
+		return _minClients;
+	}
+	//! Sets the elastic mode of the task dispatcher shards
+	/*!
+	  The amount of the workers varies between the minimum and the maximum clients amount (see TaskDispatcher::setElastic()),
+	  both of them are split between the task dispatcher shards.
+
+	  \param newValue TRUE if to turn the elastic mode on
+	  \param minClients Minimum clients amount to keep the workers running for
+	  \param growThreshold The time the oldest accepted connection should wait with no idling worker to spawn a new worker
+	  \param keepAlive The time of idling to retire a worker after
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setElasticWorkers(bool newValue, size_t minClients = TaskDispatcherType::DefaultMinWorkers,
+			const Timeout& growThreshold = Timeout(static_cast<double>(TaskDispatcherType::DefaultGrowThreshold) / 1000.0),
+			const Timeout& keepAlive = Timeout(static_cast<double>(TaskDispatcherType::DefaultKeepAlive)))
+	{
+		_elasticWorkers = newValue;
+		_minClients = minClients;
+		_growThreshold = growThreshold;
+		_keepAlive = keepAlive;
+	}
+	//! Returns placement policy of the workers of the task dispatcher shards
+	inline const ThreadPlacementPolicy& workersPlacementPolicy() const
+	{
+		return _workersPlacementPolicy;
+	}
+	//! Sets placement policy of the workers of the task dispatcher shards
+	/*!
+	  Listeners are placed according to the service's thread placement policy (see Subsystem::setThreadPlacementPolicy()),
+	  so N-th listener is bound to the N-th CPU in the pin mode, while the workers could be spread over another CPU set.
+	  Workers of the task dispatcher shards are numbered through, so the first worker of the shard gets the placement
+	  next to the last worker of the previous shard.
+
+	  \param newValue New placement policy of the workers
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setWorkersPlacementPolicy(const ThreadPlacementPolicy& newValue)
+	{
+		_workersPlacementPolicy = newValue;
+	}
+	//! Returns current amount of the running workers of the task dispatcher shards
+	/*!
+	  \note Thread-safe
+	*/
+	size_t runningWorkersAmount() const;
+	//! Returns counters of the task dispatcher shards summed up
+	/*!
+	  \note Thread-safe
+	*/
+	TaskDispatcherType::Counters counters() const;
+	//! Returns task dispatcher shards amount
+	inline size_t dispatcherShardsAmount() const
+	{
+		return _dispatcherShardsAmount;
+	}
+	//! Sets task dispatcher shards amount
+	/*!
+	  By default all listeners are passing tasks to the one shared task dispatcher. If the shards amount is
+	  more than 1, the service creates this amount of task dispatchers, each of them having it's part of the
+	  maximum clients amount workers, and listener threads are bound to the dispatcher shards in round-robin
+	  manner. Set it to the total amount of listener shards to give each listener thread it's own dispatcher.
+	  The parts sum up to the maximum clients amount exactly, so the shards amount is reduced to the maximum
+	  clients amount if it exceeds it.
+
+	  \param newValue New task dispatcher shards amount
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setDispatcherShardsAmount(size_t newValue)
+	{
+		_dispatcherShardsAmount = newValue;
 	}
 	//! Adds listener to the service
 	/*!
 	  \param addrInfo TCP-address info to bind to
 	  \param backLog Listen backlog
+	  \param shardsAmount Amount of the listening sockets to open with SO_REUSEPORT option, each of them
+	                      is served by it's own listener thread, so the kernel spreads the accept load across cores
+	  \param options Socket tuning profile of the listening socket and the accepted connections
 	  \return Listener id
 
 	  \note Thread-unsafe: call it when subsystem is idling only
 	*/
-	int addListener(const TcpAddrInfo& addrInfo, unsigned int backLog = 15);
+	int addListener(const TcpAddrInfo& addrInfo, unsigned int backLog = 15, size_t shardsAmount = 1,
+			const TcpSocketOptions& options = TcpSocketOptions());
 	//! Updates listener
 	/*!
 	  \param id Listener id
 	  \param addrInfo TCP-address info to bind to
 	  \param backLog Listen backlog
+	  \param shardsAmount Amount of the listening sockets to open with SO_REUSEPORT option
+	  \param options Socket tuning profile of the listening socket and the accepted connections
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	void updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog = 15, size_t shardsAmount = 1,
+			const TcpSocketOptions& options = TcpSocketOptions());
+	//! Adds Unix domain socket listener to the service
+	/*!
+	  \param addrInfo Unix domain socket address info to bind to
+	  \param backLog Listen backlog
+	  \return Listener id
 
 	  \note Thread-unsafe: call it when subsystem is idling only
 	*/
-	void updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog = 15);
+	int addListener(const UnixAddrInfo& addrInfo, unsigned int backLog = 15);
+	//! Updates Unix domain socket listener
+	/*!
+	  \param id Listener id
+	  \param addrInfo Unix domain socket address info to bind to
+	  \param backLog Listen backlog
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	void updateListener(int id, const UnixAddrInfo& addrInfo, unsigned int backLog = 15);
 	//! Removes listener
 	/*!
 	  \param id Id of the listener to remove
@@ -111,6 +313,7 @@ public:
 	inline void resetListeners()
 	{
 		_listenerConfigs.clear();
+		_unixListenerConfigs.clear();
 	}
 	//! Starting service method redefinition
 	virtual void start();
@@ -125,8 +328,23 @@ protected:
 		 * \param service Reference to synchronous TCP-service object
 		 * \param addrInfo TCP-address info to bind to
 		 * \param backLog Listen backlog
+		 * \param reusePort Set SO_REUSEPORT option on the listening socket
+		 * \param options Socket tuning profile of the listening socket and the accepted connections
+		 * \param taskDispatcher Reference to the task dispatcher to pass the tasks to
 		 */
-		ListenerThread(AbstractSyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog);
+		ListenerThread(AbstractSyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog, bool reusePort, const TcpSocketOptions& options,
+				TaskDispatcherType& taskDispatcher);
+		//! Constructs a Unix domain socket listener
+		/*!
+		 * \param service Reference to synchronous TCP-service object
+		 * \param addrInfo Unix domain socket address info to bind to
+		 * \param backLog Listen backlog
+		 * \param taskDispatcher Reference to the task dispatcher to pass the tasks to
+		 */
+		ListenerThread(AbstractSyncTcpService& service, const UnixAddrInfo& addrInfo, unsigned int backLog,
+				TaskDispatcherType& taskDispatcher);
+		//! Destructor releases the listening socket to the listening socket registry
+		virtual ~ListenerThread();
 	private:
 		ListenerThread();
 		ListenerThread(const ListenerThread&);								// No copy
@@ -137,20 +355,54 @@ protected:
 		virtual void doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired);
 
 		AbstractSyncTcpService& _service;
-		const TcpAddrInfo _addrInfo;
+		const std::auto_ptr<TcpAddrInfo> _addrInfoAutoPtr;
+		const std::auto_ptr<UnixAddrInfo> _unixAddrInfoAutoPtr;
 		const unsigned int _backLog;
+		const bool _reusePort;
+		const TcpSocketOptions _options;
+		TaskDispatcherType& _taskDispatcher;
 		TcpSocket _serverSocket;
+		UnixSocket _unixServerSocket;
 	};
 
 	//! Creating listener thread virtual factory method
 	/*!
+	 * \param addrInfo TCP-address info to bind to
+	 * \param backLog Listen backlog
+	 * \param reusePort Set SO_REUSEPORT option on the listening socket
+	 * \param options Socket tuning profile of the listening socket and the accepted connections
+	 * \param taskDispatcher Reference to the task dispatcher to pass the tasks to
+	 * \return Pointer to new listener thread
+	 */
+	virtual ListenerThread * createListener(const TcpAddrInfo& addrInfo, unsigned int backLog, bool reusePort, const TcpSocketOptions& options,
+			TaskDispatcherType& taskDispatcher)
+	{
+		return new ListenerThread(*this, addrInfo, backLog, reusePort, options, taskDispatcher);
+	}
+	//! Creating listener thread virtual factory method of the previous versions
+	/*!
+	 * Forwards to the createListener() above with no SO_REUSEPORT, the default socket tuning profile and the first
+	 * task dispatcher shard.
+	 *
 	 * \param addrInfo TCP-address info to bind to
 	 * \param backLog Listen backlog
 	 * \return Pointer to new listener thread
+	 * \deprecated The service creates it's listeners using the createListener() above, so override that one instead
 	 */
 	virtual ListenerThread * createListener(const TcpAddrInfo& addrInfo, unsigned int backLog)
 	{
-		return new ListenerThread(*this, addrInfo, backLog);
+		return createListener(addrInfo, backLog, false, TcpSocketOptions(), _taskDispatcher);
+	}
+	//! Creating Unix domain socket listener thread virtual factory method
+	/*!
+	 * \param addrInfo Unix domain socket address info to bind to
+	 * \param backLog Listen backlog
+	 * \param taskDispatcher Reference to the task dispatcher to pass the tasks to
+	 * \return Pointer to new listener thread
+	 */
+	virtual ListenerThread * createListener(const UnixAddrInfo& addrInfo, unsigned int backLog, TaskDispatcherType& taskDispatcher)
+	{
+		return new ListenerThread(*this, addrInfo, backLog, taskDispatcher);
 	}
 	//! On overload event handler
 	/*!
@@ -177,23 +429,56 @@ protected:
 private:
 	struct ListenerConfig
 	{
-		ListenerConfig(const TcpAddrInfo& addrInfo, unsigned int backLog) :
+		ListenerConfig(const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options) :
 			addrInfo(addrInfo),
-			backLog(backLog)
+			backLog(backLog),
+			shardsAmount(shardsAmount),
+			options(options)
 		{}
 
 		TcpAddrInfo addrInfo;
 		unsigned int backLog;
+		size_t shardsAmount;
+		TcpSocketOptions options;
 	};
 	typedef std::map<int, ListenerConfig> ListenerConfigs;
 
+	struct UnixListenerConfig
+	{
+		UnixListenerConfig(const UnixAddrInfo& addrInfo, unsigned int backLog) :
+			addrInfo(addrInfo),
+			backLog(backLog)
+		{}
+
+		UnixAddrInfo addrInfo;
+		unsigned int backLog;
+	};
+	typedef std::map<int, UnixListenerConfig> UnixListenerConfigs;
+
 	typedef std::list<ListenerThread *> ListenersContainer;
+	typedef std::vector<TaskDispatcherType *> DispatcherShardsContainer;
 
 	void resetListenerThreads();
+	void resetDispatcherShards();
 
 	TaskDispatcherType _taskDispatcher;
+	size_t _maxClients;
+	size_t _maxPendingClients;
+	TaskDispatcherType::OverloadPolicy _overloadPolicy;
+	Timeout _overloadTimeout;
+	Timeout _maxQueueWait;
+	bool _drainOnStop;
+	bool _workStealing;
+	bool _elasticWorkers;
+	size_t _minClients;
+	Timeout _growThreshold;
+	Timeout _keepAlive;
+	ThreadPlacementPolicy _workersPlacementPolicy;
+	size_t _dispatcherShardsAmount;
+	DispatcherShardsContainer _dispatcherShards;
 	int _lastListenerConfigId;
 	ListenerConfigs _listenerConfigs;
+	UnixListenerConfigs _unixListenerConfigs;
 	ListenersContainer _listeners;
 };
 
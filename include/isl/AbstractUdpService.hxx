@@ -0,0 +1,207 @@
+#ifndef ISL__ABSTRACT_UDP_SERVICE__HXX
+#define ISL__ABSTRACT_UDP_SERVICE__HXX
+
+#include <isl/Subsystem.hxx>
+#include <isl/TcpAddrInfo.hxx>
+#include <isl/UdpSocket.hxx>
+#include <isl/LogMessage.hxx>
+#include <isl/ExceptionLogMessage.hxx>
+#include <list>
+#include <map>
+
+#ifndef ISL__UDP_SERVICE_DEFAULT_BATCH_SIZE
+#define ISL__UDP_SERVICE_DEFAULT_BATCH_SIZE 64
+#endif
+#ifndef ISL__UDP_SERVICE_DEFAULT_MAX_DATAGRAM_SIZE
+#define ISL__UDP_SERVICE_DEFAULT_MAX_DATAGRAM_SIZE 2048
+#endif
+
+namespace isl
+{
+
+//! Base class for UDP-service, which receives and replies to the datagrams in batches
+/*!
+  Each listener is served by the receiver threads, which are pulling batches of the datagrams using one
+  recvmmsg(2) call into the preallocated buffers and passing them to the onReceive() event handler. Replies which
+  have been collected by the handler are sent using one sendmmsg(2) call. If the listener has more than one
+  shard, each receiver thread has it's own socket bound to the same address with SO_REUSEPORT option, so the
+  kernel spreads the datagrams among receiver threads by the peer address hash.
+
+  Datagrams which are longer than the maximum datagram size are truncated (see UdpSocket::Batch::isTruncated())
+  and are logged with a warning.
+*/
+class AbstractUdpService : public Subsystem
+{
+public:
+	enum Constants {
+		//! Default maximum amount of the datagrams to receive using one system call
+		DefaultBatchSize = ISL__UDP_SERVICE_DEFAULT_BATCH_SIZE,
+		//! Default datagram buffer size
+		DefaultMaxDatagramSize = ISL__UDP_SERVICE_DEFAULT_MAX_DATAGRAM_SIZE
+	};
+	//! Constructor
+	/*!
+	  \param owner Pointer to the owner subsystem
+	  \param clockTimeout Subsystem's clock timeout
+	*/
+	AbstractUdpService(Subsystem * owner, const Timeout& clockTimeout = Timeout::defaultTimeout());
+	//! Destructor
+	virtual ~AbstractUdpService();
+
+	//! Returns maximum amount of the datagrams to receive using one system call
+	inline size_t batchSize() const
+	{
+		return _batchSize;
+	}
+	//! Sets maximum amount of the datagrams to receive using one system call
+	/*!
+	  \param newValue New batch size, it is the maximum amount of the replies to one batch too
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setBatchSize(size_t newValue)
+	{
+		_batchSize = newValue;
+	}
+	//! Returns datagram buffer size
+	inline size_t maxDatagramSize() const
+	{
+		return _maxDatagramSize;
+	}
+	//! Sets datagram buffer size
+	/*!
+	  \param newValue New datagram buffer size
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxDatagramSize(size_t newValue)
+	{
+		_maxDatagramSize = newValue;
+	}
+	//! Returns SO_RCVBUF option value of the receiver sockets or -1 if system default is used
+	inline int receiveBufferSize() const
+	{
+		return _receiveBufferSize;
+	}
+	//! Sets SO_RCVBUF option value of the receiver sockets
+	/*!
+	  \param newValue Receive buffer size in bytes or -1 to use system default
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setReceiveBufferSize(int newValue)
+	{
+		_receiveBufferSize = newValue;
+	}
+	//! Adds listener to the service
+	/*!
+	  \param addrInfo UDP-address info to bind to
+	  \param shardsAmount Amount of the sockets to open with SO_REUSEPORT option, each of them is served by
+	                      it's own receiver thread
+	  \return Listener id
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	int addListener(const TcpAddrInfo& addrInfo, size_t shardsAmount = 1);
+	//! Updates listener
+	/*!
+	  \param id Listener id
+	  \param addrInfo UDP-address info to bind to
+	  \param shardsAmount Amount of the sockets to open with SO_REUSEPORT option
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	void updateListener(int id, const TcpAddrInfo& addrInfo, size_t shardsAmount = 1);
+	//! Removes listener
+	/*!
+	  \param id Id of the listener to remove
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	void removeListener(int id);
+	//! Resets all listeners
+	/*!
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void resetListeners()
+	{
+		_listenerConfigs.clear();
+	}
+	//! Starting service method redefinition
+	virtual void start();
+	//! Stopping service method redefinition
+	virtual void stop();
+protected:
+	class ReceiverThread : public OscillatorThread
+	{
+	public:
+		//! Constructs a receiver
+		/*!
+		 * \param service Reference to UDP-service object
+		 * \param addrInfo UDP-address info to bind to
+		 * \param reusePort Set SO_REUSEPORT option on the socket
+		 */
+		ReceiverThread(AbstractUdpService& service, const TcpAddrInfo& addrInfo, bool reusePort);
+	private:
+		ReceiverThread();
+		ReceiverThread(const ReceiverThread&);						// No copy
+
+		ReceiverThread& operator=(const ReceiverThread&);				// No copy
+
+		virtual void onStart();
+		virtual void doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired);
+
+		AbstractUdpService& _service;
+		const TcpAddrInfo _addrInfo;
+		const bool _reusePort;
+		UdpSocket _socket;
+		UdpSocket::Batch _datagrams;
+		UdpSocket::Batch _replies;
+	};
+
+	//! Creating receiver thread virtual factory method
+	/*!
+	 * \param addrInfo UDP-address info to bind to
+	 * \param reusePort Set SO_REUSEPORT option on the socket
+	 * \return Pointer to new receiver thread
+	 */
+	virtual ReceiverThread * createReceiver(const TcpAddrInfo& addrInfo, bool reusePort)
+	{
+		return new ReceiverThread(*this, addrInfo, reusePort);
+	}
+	//! On datagrams receive event handler
+	/*!
+	  Called from the receiver threads concurrently, so the handler should be thread-safe.
+
+	  \param datagrams Constant reference to the batch of the received datagrams, which are valid until the handler returns
+	  \param replies Reference to the empty batch to append replies to (see UdpSocket::Batch::appendReply()),
+	                 which are sent after the handler returns
+	*/
+	virtual void onReceive(const UdpSocket::Batch& datagrams, UdpSocket::Batch& replies) = 0;
+private:
+	struct ListenerConfig
+	{
+		ListenerConfig(const TcpAddrInfo& addrInfo, size_t shardsAmount) :
+			addrInfo(addrInfo),
+			shardsAmount(shardsAmount)
+		{}
+
+		TcpAddrInfo addrInfo;
+		size_t shardsAmount;
+	};
+	typedef std::map<int, ListenerConfig> ListenerConfigs;
+	typedef std::list<ReceiverThread *> ReceiversContainer;
+
+	void resetReceiverThreads();
+
+	size_t _batchSize;
+	size_t _maxDatagramSize;
+	int _receiveBufferSize;
+	int _lastListenerConfigId;
+	ListenerConfigs _listenerConfigs;
+	ReceiversContainer _receivers;
+};
+
+} // namespace isl
+
+#endif
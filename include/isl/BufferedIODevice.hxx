@@ -0,0 +1,167 @@
+#ifndef ISL__BUFFERED_IO_DEVICE__HXX
+#define ISL__BUFFERED_IO_DEVICE__HXX
+
+#include <isl/AbstractIODevice.hxx>
+#include <vector>
+
+#ifndef ISL__BUFFERED_IO_DEVICE_DEFAULT_READ_BUFFER_SIZE
+#define ISL__BUFFERED_IO_DEVICE_DEFAULT_READ_BUFFER_SIZE 16384		// 16 Kb
+#endif
+#ifndef ISL__BUFFERED_IO_DEVICE_DEFAULT_WRITE_BUFFER_SIZE
+#define ISL__BUFFERED_IO_DEVICE_DEFAULT_WRITE_BUFFER_SIZE 16384		// 16 Kb
+#endif
+
+namespace isl
+{
+
+//! Ring-buffered I/O-device decorator
+/*!
+  Wraps another I/O-device (e.g. TcpSocket) with the read and write ring buffers.
+
+  Buffered data could be inspected in place: peek() returns a contiguous span of the read buffer, which is
+  to be released by consume(), and fill() reads the next portion of data from the underlying device into the
+  read buffer. So parsers could work directly on the memory the data has been received to.
+
+  Written data is batched in the write buffer until it is full or flush() is called explicitly. Data which does
+  not fit the write buffer is sent together with the buffered one using one vectored write.
+
+  The decorator is open if the underlying device is open at the construction time or if it has been opened using
+  the decorator. Closing the decorator closes the underlying device and discards buffered data.
+
+  \note Buffered data is not flushed on destruction - call flush() explicitly.
+  \note Thread-unsafe: use read and write buffers of one instance in one thread only, create two decorators with
+        read buffer only and with write buffer only to read and to write the device in different threads.
+*/
+class BufferedIODevice : public AbstractIODevice
+{
+public:
+	enum Constants {
+		DefaultReadBufferSize = ISL__BUFFERED_IO_DEVICE_DEFAULT_READ_BUFFER_SIZE,
+		DefaultWriteBufferSize = ISL__BUFFERED_IO_DEVICE_DEFAULT_WRITE_BUFFER_SIZE
+	};
+	//! Constructor
+	/*!
+	  \param device Reference to the I/O-device to wrap, which should live longer than the decorator
+	  \param readBufferSize Read buffer size, reads are passed through to the device if it is 0
+	  \param writeBufferSize Write buffer size, writes are passed through to the device if it is 0
+	*/
+	BufferedIODevice(AbstractIODevice& device, size_t readBufferSize = DefaultReadBufferSize,
+			size_t writeBufferSize = DefaultWriteBufferSize);
+	//! Returns a reference to the underlying I/O-device
+	inline AbstractIODevice& device() const
+	{
+		return _device;
+	}
+	//! Returns amount of the buffered data which has not been consumed yet
+	inline size_t bytesAvailable() const
+	{
+		return _readBuffer.size();
+	}
+	//! Returns a contiguous span of the buffered data which has not been consumed yet
+	/*!
+	  The span could be a part of the buffered data if it wraps around the end of the ring buffer, the rest of it
+	  is returned after the span has been consumed. Returned span is empty if there is no buffered data.
+	*/
+	inline ConstBuffer peek() const
+	{
+		return _readBuffer.firstDataSpan();
+	}
+	//! Releases the data at the beginning of the read buffer
+	/*!
+	  \param bytes Amount of the bytes to release, which should not exceed bytesAvailable()
+	*/
+	void consume(size_t bytes);
+	//! Reads the next portion of data from the underlying device into the read buffer
+	/*!
+	  \param timeout Read timeout
+	  \return Amount of the bytes read or 0 if the timeout has been expired or there is no space in the read buffer
+	*/
+	size_t fill(const Timeout& timeout = Timeout());
+	//! Returns amount of the written data which has not been sent to the underlying device yet
+	inline size_t bytesPending() const
+	{
+		return _writeBuffer.size();
+	}
+	//! Sends the write buffer contents to the underlying device
+	/*!
+	  \param timeout Write timeout
+	  \return TRUE if all buffered data has been sent or FALSE if the timeout has been expired
+	*/
+	bool flush(const Timeout& timeout = Timeout());
+protected:
+	virtual void openImplementation();
+	virtual void closeImplementation();
+	virtual size_t readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout);
+	virtual size_t writeImplementation(const char * buffer, size_t bufferSize, const Timeout& timeout);
+	virtual size_t writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout);
+	virtual size_t sendFileImplementation(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout);
+	virtual void setCorkedImplementation(bool newValue);
+private:
+	BufferedIODevice();
+	BufferedIODevice(const BufferedIODevice&);						// No copy
+
+	BufferedIODevice& operator=(const BufferedIODevice&);					// No copy
+
+	//! Fixed size ring buffer
+	class RingBuffer
+	{
+	public:
+		RingBuffer(size_t capacity) :
+			_data(capacity),
+			_head(0),
+			_size(0)
+		{}
+
+		inline size_t capacity() const
+		{
+			return _data.size();
+		}
+		inline size_t size() const
+		{
+			return _size;
+		}
+		inline size_t freeSize() const
+		{
+			return _data.size() - _size;
+		}
+		//! Returns the data span from the head to the end of the data or of the buffer
+		inline ConstBuffer firstDataSpan() const
+		{
+			size_t spanSize = (_head + _size <= _data.size()) ? _size : _data.size() - _head;
+			return spanSize > 0 ? ConstBuffer(&_data[_head], spanSize) : ConstBuffer();
+		}
+		//! Returns the wrapped around data span
+		inline ConstBuffer secondDataSpan() const
+		{
+			size_t spanSize = (_head + _size <= _data.size()) ? 0 : _head + _size - _data.size();
+			return spanSize > 0 ? ConstBuffer(&_data[0], spanSize) : ConstBuffer();
+		}
+		//! Returns a pointer to the contiguous free space after the data and it's size
+		char * freeSpan(size_t& spanSize);
+		//! Appends data which has been put to the free span
+		void produce(size_t bytes);
+		//! Copies data to the buffer
+		size_t append(const char * buffer, size_t bufferSize);
+		//! Copies data from the buffer and consumes it
+		size_t extract(char * buffer, size_t bufferSize);
+		//! Releases data at the head of the buffer
+		void consume(size_t bytes);
+		inline void clear()
+		{
+			_head = 0;
+			_size = 0;
+		}
+	private:
+		std::vector<char> _data;
+		size_t _head;
+		size_t _size;
+	};
+
+	AbstractIODevice& _device;
+	RingBuffer _readBuffer;
+	RingBuffer _writeBuffer;
+};
+
+} // namespace isl
+
+#endif
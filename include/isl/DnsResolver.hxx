@@ -0,0 +1,328 @@
+#ifndef ISL__DNS_RESOLVER__HXX
+#define ISL__DNS_RESOLVER__HXX
+
+#include <isl/Subsystem.hxx>
+#include <isl/TaskDispatcher.hxx>
+#include <isl/TcpAddrInfo.hxx>
+#include <isl/WaitCondition.hxx>
+#include <isl/Mutex.hxx>
+#include <isl/Timestamp.hxx>
+#include <map>
+#include <list>
+#include <string>
+#include <memory>
+
+#ifndef ISL__DNS_RESOLVER_DEFAULT_WORKERS_AMOUNT
+#define ISL__DNS_RESOLVER_DEFAULT_WORKERS_AMOUNT 2
+#endif
+#ifndef ISL__DNS_RESOLVER_DEFAULT_CACHE_TTL
+#define ISL__DNS_RESOLVER_DEFAULT_CACHE_TTL 60			// Seconds
+#endif
+#ifndef ISL__DNS_RESOLVER_DEFAULT_MAX_CACHE_SIZE
+#define ISL__DNS_RESOLVER_DEFAULT_MAX_CACHE_SIZE 1024
+#endif
+
+namespace isl
+{
+
+//! Asynchronous caching host name resolver subsystem
+/*!
+  Resolves TCP-addresses using getaddrinfo(3) in a small pool of the worker threads, so the threads which are
+  (re)connecting to the remote peers are not blocked by the resolver latency. Resolved TCP-address infos are cached
+  for the cache TTL period using "family/host/port" key. Concurrent resolutions of the same key are coalesced into
+  one getaddrinfo(3) call.
+
+  Resolution result could be delivered to the callback object or via the Future object. Synchronous resolve() method
+  consults the cache first and calls getaddrinfo(3) in the calling thread on cache miss, so it is usable even if the
+  subsystem is not running.
+
+  \note Pending resolutions are completed with the error on subsystem's stop.
+*/
+class DnsResolver : public Subsystem
+{
+private:
+	struct FutureState;
+public:
+	enum Constants {
+		DefaultWorkersAmount = ISL__DNS_RESOLVER_DEFAULT_WORKERS_AMOUNT,
+		DefaultCacheTtl = ISL__DNS_RESOLVER_DEFAULT_CACHE_TTL,
+		DefaultMaxCacheSize = ISL__DNS_RESOLVER_DEFAULT_MAX_CACHE_SIZE
+	};
+	//! Resolution result callback abstract class
+	class AbstractCallback
+	{
+	public:
+		virtual ~AbstractCallback()
+		{}
+		//! On successful resolution event handler
+		/*!
+		  \param addrInfo Resolved TCP-address info
+		*/
+		virtual void onResolved(const TcpAddrInfo& addrInfo) = 0;
+		//! On resolution failure event handler
+		/*!
+		  \param errorMessage Resolution error message
+		*/
+		virtual void onError(const std::string& errorMessage) = 0;
+	};
+	//! Resolution result future
+	/*!
+	  Future is a lightweight reference-counted handle to the resolution result, so it could be freely copied
+	  or destroyed before the resolution has been completed.
+	*/
+	class Future
+	{
+	public:
+		//! Constructs an invalid future
+		Future();
+		//! Copying constructor
+		Future(const Future& other);
+		//! Destructor
+		~Future();
+		//! Assignment operator
+		Future& operator=(const Future& other);
+		//! Returns TRUE if the future is bound to the resolution
+		inline bool isValid() const
+		{
+			return _statePtr;
+		}
+		//! Returns TRUE if the resolution has been completed
+		/*!
+		  \note Thread-safe
+		*/
+		bool isReady() const;
+		//! Awaits for the resolution completion
+		/*!
+		  \param limit Limit timestamp to wait until
+		  \return TRUE if the resolution has been completed
+		  \note Thread-safe
+		*/
+		bool await(const Timestamp& limit) const;
+		//! Awaits for the resolution completion without time limit
+		/*!
+		  \note Thread-safe
+		*/
+		void await() const;
+		//! Returns TRUE if the resolution has been completed successfully
+		/*!
+		  \note Thread-safe
+		*/
+		bool succeeded() const;
+		//! Returns resolution error message
+		/*!
+		  \note Thread-safe
+		*/
+		std::string errorMessage() const;
+		//! Returns resolved TCP-address info
+		/*!
+		  Throws an exception if the resolution has not been completed yet or has failed.
+		  \note Thread-safe
+		*/
+		TcpAddrInfo addrInfo() const;
+	private:
+		explicit Future(FutureState * statePtr);
+
+		void release();
+
+		FutureState * _statePtr;
+
+		friend class DnsResolver;
+	};
+	//! Constructor
+	/*!
+	  \param owner Pointer to the owner subsystem
+	  \param workersAmount Amount of the resolver worker threads
+	  \param cacheTtl Time to keep resolved TCP-address info in the cache
+	  \param maxCacheSize Maximum amount of the cache entries
+	  \param clockTimeout Subsystem's clock timeout
+	*/
+	DnsResolver(Subsystem * owner, size_t workersAmount = DefaultWorkersAmount, const Timeout& cacheTtl = Timeout(DefaultCacheTtl),
+			size_t maxCacheSize = DefaultMaxCacheSize, const Timeout& clockTimeout = Timeout::defaultTimeout());
+	//! Destructor
+	virtual ~DnsResolver();
+
+	//! Returns worker threads amount
+	inline size_t workersAmount() const
+	{
+		return _taskDispatcher.workersAmount();
+	}
+	//! Sets worker threads amount
+	/*!
+	  \param newValue New worker threads amount
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setWorkersAmount(size_t newValue)
+	{
+		_taskDispatcher.setWorkersAmount(newValue);
+	}
+	//! Returns cache TTL
+	inline const Timeout& cacheTtl() const
+	{
+		return _cacheTtl;
+	}
+	//! Sets cache TTL
+	/*!
+	  \param newValue New cache TTL
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setCacheTtl(const Timeout& newValue)
+	{
+		_cacheTtl = newValue;
+	}
+	//! Returns maximum amount of the cache entries
+	inline size_t maxCacheSize() const
+	{
+		return _maxCacheSize;
+	}
+	//! Sets maximum amount of the cache entries
+	/*!
+	  \param newValue New maximum amount of the cache entries
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxCacheSize(size_t newValue)
+	{
+		_maxCacheSize = newValue;
+	}
+	//! Returns current amount of the cache entries
+	/*!
+	  \note Thread-safe
+	*/
+	size_t cacheSize() const;
+	//! Clears the cache
+	/*!
+	  \note Thread-safe
+	*/
+	void clearCache();
+	//! Resolves TCP-address asynchronously and passes the result to the callback object
+	/*!
+	  If the TCP-address info is found in the cache the callback is called immediately in the calling thread,
+	  otherwise it is called by the worker thread.
+
+	  \param family Address family
+	  \param host Host name/address
+	  \param port Port number
+	  \param callback Reference to the callback object, which should live until it is called
+	  \note Thread-safe
+	*/
+	void resolve(TcpAddrInfo::Family family, const std::string& host, unsigned int port, AbstractCallback& callback);
+	//! Resolves TCP-address asynchronously
+	/*!
+	  \param family Address family
+	  \param host Host name/address
+	  \param port Port number
+	  \return Resolution result future, which is ready immediately if the TCP-address info is found in the cache
+	  \note Thread-safe
+	*/
+	Future resolveAsync(TcpAddrInfo::Family family, const std::string& host, unsigned int port);
+	//! Resolves TCP-address synchronously
+	/*!
+	  Cache is consulted first, getaddrinfo(3) is called in the calling thread on cache miss and the result is cached.
+	  Throws an exception on resolution failure.
+
+	  \param family Address family
+	  \param host Host name/address
+	  \param port Port number
+	  \note Thread-safe
+	*/
+	TcpAddrInfo resolve(TcpAddrInfo::Family family, const std::string& host, unsigned int port);
+private:
+	DnsResolver();
+	DnsResolver(const DnsResolver&);						// No copy
+
+	DnsResolver& operator=(const DnsResolver&);					// No copy
+
+	struct CacheKey
+	{
+		CacheKey(TcpAddrInfo::Family family, const std::string& host, unsigned int port) :
+			family(family),
+			host(host),
+			port(port)
+		{}
+
+		bool operator<(const CacheKey& rhs) const
+		{
+			if (family != rhs.family) {
+				return family < rhs.family;
+			} else if (port != rhs.port) {
+				return port < rhs.port;
+			} else {
+				return host < rhs.host;
+			}
+		}
+
+		TcpAddrInfo::Family family;
+		std::string host;
+		unsigned int port;
+	};
+
+	struct CacheEntry
+	{
+		CacheEntry(const TcpAddrInfo& addrInfo, const Timestamp& expiration) :
+			addrInfo(addrInfo),
+			expiration(expiration)
+		{}
+
+		TcpAddrInfo addrInfo;
+		Timestamp expiration;
+	};
+	typedef std::map<CacheKey, CacheEntry> Cache;
+
+	//! Resolution waiter: either callback or future
+	struct Waiter
+	{
+		Waiter(AbstractCallback * callbackPtr, const Future& future) :
+			callbackPtr(callbackPtr),
+			future(future)
+		{}
+
+		AbstractCallback * callbackPtr;
+		Future future;
+	};
+	typedef std::list<Waiter> WaitersContainer;
+	typedef std::map<CacheKey, WaitersContainer> PendingResolutions;
+
+	//! Resolution task to be executed by the worker thread
+	class ResolveTask
+	{
+	public:
+		ResolveTask(DnsResolver& resolver, const CacheKey& key) :
+			_resolver(resolver),
+			_key(key),
+			_completed(false)
+		{}
+		~ResolveTask();
+
+		void execute(TaskDispatcher<ResolveTask>& taskDispatcher);
+	private:
+		ResolveTask();
+		ResolveTask(const ResolveTask&);						// No copy
+
+		ResolveTask& operator=(const ResolveTask&);					// No copy
+
+		DnsResolver& _resolver;
+		const CacheKey _key;
+		bool _completed;
+	};
+
+	typedef TaskDispatcher<ResolveTask> TaskDispatcherType;
+
+	bool fetchFromCache(const CacheKey& key, std::auto_ptr<TcpAddrInfo>& addrInfoAutoPtr);
+	void putToCache(const CacheKey& key, const TcpAddrInfo& addrInfo);
+	void enqueue(const CacheKey& key, const Waiter& waiter);
+	void complete(const CacheKey& key, const TcpAddrInfo * addrInfoPtr, const std::string& errorMessage);
+
+	Timeout _cacheTtl;
+	size_t _maxCacheSize;
+	mutable Mutex _mutex;
+	Cache _cache;
+	PendingResolutions _pendingResolutions;
+	// Task dispatcher should be destroyed first, cause discarded tasks are completing resolutions on destruction
+	TaskDispatcherType _taskDispatcher;
+};
+
+} // namespace isl
+
+#endif
@@ -0,0 +1,464 @@
+#ifndef ISL__FUTURE__HXX
+#define ISL__FUTURE__HXX
+
+#include <isl/WaitCondition.hxx>
+#include <isl/Timestamp.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <isl/ExceptionLogMessage.hxx>
+#include <list>
+#include <vector>
+#include <string>
+#include <memory>
+
+namespace isl
+{
+
+//! Continuation of the future, which is executed once the future is completed
+/*!
+  Continuation is executed by the thread which has completed the future or by the thread which has added it
+  to the future which has been completed already, so it should be short, e.g. it could perform a task.
+*/
+class AbstractFutureContinuation
+{
+public:
+	virtual ~AbstractFutureContinuation()
+	{}
+	//! Executes continuation
+	virtual void execute() = 0;
+};
+
+template <typename R> class Promise;
+
+//! Result of the asynchronous operation
+/*!
+  Future is a lightweight reference-counted handle to the result, which is set by the promise, so it could be freely
+  copied or destroyed before the result is ready. Promise which has been destroyed without setting the result makes
+  the future fail with the "Broken promise" error.
+
+  \tparam R Result class, which should be copy-constructible
+
+  \sa Promise, FutureTaskDispatcher
+*/
+template <typename R> class Future
+{
+private:
+	typedef std::list<AbstractFutureContinuation *> ContinuationsContainer;
+
+	struct State
+	{
+		State() :
+			cond(),
+			refsCount(1),
+			promisesCount(0),
+			ready(false),
+			valueAutoPtr(),
+			errorMessage(),
+			continuations()
+		{}
+		~State()
+		{
+			for (typename ContinuationsContainer::iterator i = continuations.begin(); i != continuations.end(); ++i) {
+				delete (*i);
+			}
+		}
+
+		// Returns FALSE if the state has been completed already
+		bool complete(const R * valuePtr, const std::string& error)
+		{
+			ContinuationsContainer readyContinuations;
+			{
+				MutexLocker locker(cond.mutex());
+				if (ready) {
+					return false;
+				}
+				if (valuePtr) {
+					valueAutoPtr.reset(new R(*valuePtr));
+				} else {
+					errorMessage = error;
+				}
+				ready = true;
+				readyContinuations.swap(continuations);
+				cond.wakeAll();
+			}
+			for (typename ContinuationsContainer::iterator i = readyContinuations.begin(); i != readyContinuations.end(); ++i) {
+				execute(*i);
+			}
+			return true;
+		}
+		void addContinuation(std::auto_ptr<AbstractFutureContinuation> continuationAutoPtr)
+		{
+			{
+				MutexLocker locker(cond.mutex());
+				if (!ready) {
+					continuations.push_back(continuationAutoPtr.get());
+					continuationAutoPtr.release();
+					return;
+				}
+			}
+			execute(continuationAutoPtr.release());
+		}
+		static void execute(AbstractFutureContinuation * continuationPtr)
+		{
+			std::auto_ptr<AbstractFutureContinuation> continuationAutoPtr(continuationPtr);
+			try {
+				continuationAutoPtr->execute();
+			} catch (std::exception& e) {
+				Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Future continuation execution error"));
+			} catch (...) {
+				Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Future continuation execution unknown error"));
+			}
+		}
+
+		mutable WaitCondition cond;
+		int refsCount;
+		int promisesCount;
+		bool ready;
+		std::auto_ptr<R> valueAutoPtr;
+		std::string errorMessage;
+		ContinuationsContainer continuations;
+	};
+public:
+	//! Constructs an invalid future
+	Future() :
+		_statePtr(0)
+	{}
+	//! Copying constructor
+	Future(const Future& other) :
+		_statePtr(other._statePtr)
+	{
+		if (_statePtr) {
+			__sync_add_and_fetch(&_statePtr->refsCount, 1);
+		}
+	}
+	//! Destructor
+	~Future()
+	{
+		release();
+	}
+	//! Assignment operator
+	Future& operator=(const Future& other)
+	{
+		if (other._statePtr == _statePtr) {
+			return *this;
+		}
+		if (other._statePtr) {
+			__sync_add_and_fetch(&other._statePtr->refsCount, 1);
+		}
+		release();
+		_statePtr = other._statePtr;
+		return *this;
+	}
+	//! Returns TRUE if the future is bound to the promise
+	inline bool isValid() const
+	{
+		return _statePtr;
+	}
+	//! Returns TRUE if the result is ready
+	/*!
+	  \note Thread-safe
+	*/
+	bool isReady() const
+	{
+		if (!_statePtr) {
+			return false;
+		}
+		MutexLocker locker(_statePtr->cond.mutex());
+		return _statePtr->ready;
+	}
+	//! Awaits for the result
+	/*!
+	  \param limit Limit timestamp to wait until
+	  \return TRUE if the result is ready
+	  \note Thread-safe
+	*/
+	bool await(const Timestamp& limit) const
+	{
+		MutexLocker locker(state().cond.mutex());
+		while (!_statePtr->ready) {
+			if (!_statePtr->cond.wait(limit)) {
+				return _statePtr->ready;
+			}
+		}
+		return true;
+	}
+	//! Awaits for the result without time limit
+	/*!
+	  \note Thread-safe
+	*/
+	void await() const
+	{
+		MutexLocker locker(state().cond.mutex());
+		while (!_statePtr->ready) {
+			_statePtr->cond.wait();
+		}
+	}
+	//! Returns TRUE if the result is ready and it is not an error
+	/*!
+	  \note Thread-safe
+	*/
+	bool succeeded() const
+	{
+		if (!_statePtr) {
+			return false;
+		}
+		MutexLocker locker(_statePtr->cond.mutex());
+		return _statePtr->ready && _statePtr->valueAutoPtr.get();
+	}
+	//! Returns error message
+	/*!
+	  \note Thread-safe
+	*/
+	std::string errorMessage() const
+	{
+		if (!_statePtr) {
+			return std::string();
+		}
+		MutexLocker locker(_statePtr->cond.mutex());
+		return _statePtr->errorMessage;
+	}
+	//! Returns the result
+	/*!
+	  Throws an exception if the result is not ready yet or it is an error.
+	  \note Thread-safe
+	*/
+	const R& value() const
+	{
+		MutexLocker locker(state().cond.mutex());
+		if (!_statePtr->ready) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Future is not ready"));
+		}
+		if (!_statePtr->valueAutoPtr.get()) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, _statePtr->errorMessage));
+		}
+		// Result is not changed after the completion, so the reference is valid while the future exists
+		return *_statePtr->valueAutoPtr.get();
+	}
+	//! Adds a continuation to be executed once the result is ready
+	/*!
+	  Continuation is executed at once by the calling thread if the result is ready already.
+	  \param continuationAutoPtr Auto-pointer to the continuation, which is released
+	  \note Thread-safe
+	*/
+	void addContinuation(std::auto_ptr<AbstractFutureContinuation> continuationAutoPtr) const
+	{
+		state().addContinuation(continuationAutoPtr);
+	}
+	//! Returns a future which is completed when all the futures are completed
+	/*!
+	  Returned future succeeds with the results of all the futures in the same order or fails with the error
+	  of the first failed future as soon as it fails.
+	  \param futures Futures to wait for
+	  \note Thread-safe
+	*/
+	static Future<std::vector<R> > whenAll(const std::vector<Future>& futures);
+	//! Returns a future which is completed when any of the futures is completed
+	/*!
+	  Returned future succeeds with the index of the first completed future, which could be succeeded or failed.
+	  \param futures Futures to wait for
+	  \note Thread-safe
+	*/
+	static Future<size_t> whenAny(const std::vector<Future>& futures);
+private:
+	class WhenAllAggregator;
+	class WhenAllContinuation;
+	class WhenAnyContinuation;
+
+	explicit Future(State * statePtr) :
+		_statePtr(statePtr)
+	{}
+
+	State& state() const
+	{
+		if (!_statePtr) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Future is not bound to the promise"));
+		}
+		return *_statePtr;
+	}
+	void release()
+	{
+		if (_statePtr && __sync_sub_and_fetch(&_statePtr->refsCount, 1) <= 0) {
+			delete _statePtr;
+		}
+		_statePtr = 0;
+	}
+
+	State * _statePtr;
+
+	friend class Promise<R>;
+};
+
+//! Setter of the future's result
+/*!
+  Promise is a reference-counted handle too, so it could be copied to the task which is to set the result.
+  Only the first result is set, so the promise could be raced by the several producers.
+
+  \tparam R Result class, which should be copy-constructible
+*/
+template <typename R> class Promise
+{
+public:
+	//! Constructs a promise with the new future's state
+	Promise() :
+		_statePtr(new typename Future<R>::State())
+	{
+		_statePtr->promisesCount = 1;
+	}
+	//! Copying constructor
+	Promise(const Promise& other) :
+		_statePtr(other._statePtr)
+	{
+		__sync_add_and_fetch(&_statePtr->refsCount, 1);
+		__sync_add_and_fetch(&_statePtr->promisesCount, 1);
+	}
+	//! Destructor, which breaks the promise if it is the last one and the result has not been set
+	~Promise()
+	{
+		release();
+	}
+	//! Assignment operator
+	Promise& operator=(const Promise& other)
+	{
+		if (other._statePtr == _statePtr) {
+			return *this;
+		}
+		__sync_add_and_fetch(&other._statePtr->refsCount, 1);
+		__sync_add_and_fetch(&other._statePtr->promisesCount, 1);
+		release();
+		_statePtr = other._statePtr;
+		return *this;
+	}
+	//! Returns the future of the promise
+	Future<R> future() const
+	{
+		__sync_add_and_fetch(&_statePtr->refsCount, 1);
+		return Future<R>(_statePtr);
+	}
+	//! Sets the result and executes the continuations
+	/*!
+	  \param value Result value
+	  \return TRUE if the result has been set or FALSE if it has been set already
+	  \note Thread-safe
+	*/
+	bool setValue(const R& value)
+	{
+		return _statePtr->complete(&value, std::string());
+	}
+	//! Sets the error and executes the continuations
+	/*!
+	  \param errorMessage Error message
+	  \return TRUE if the error has been set or FALSE if the result has been set already
+	  \note Thread-safe
+	*/
+	bool setError(const std::string& errorMessage)
+	{
+		return _statePtr->complete(0, errorMessage);
+	}
+private:
+	void release()
+	{
+		if (__sync_sub_and_fetch(&_statePtr->promisesCount, 1) <= 0) {
+			_statePtr->complete(0, "Broken promise");
+		}
+		if (__sync_sub_and_fetch(&_statePtr->refsCount, 1) <= 0) {
+			delete _statePtr;
+		}
+	}
+
+	typename Future<R>::State * _statePtr;
+};
+
+template <typename R> class Future<R>::WhenAllAggregator
+{
+public:
+	WhenAllAggregator(const Promise<std::vector<R> >& promise, const std::vector<Future<R> >& futures) :
+		promise(promise),
+		futures(futures),
+		pendingFuturesCount(futures.size())
+	{}
+
+	Promise<std::vector<R> > promise;
+	const std::vector<Future<R> > futures;
+	int pendingFuturesCount;
+};
+template <typename R> class Future<R>::WhenAllContinuation : public AbstractFutureContinuation
+{
+public:
+	WhenAllContinuation(WhenAllAggregator * aggregatorPtr, size_t index) :
+		_aggregatorPtr(aggregatorPtr),
+		_index(index)
+	{}
+	virtual void execute()
+	{
+		const Future<R>& future = _aggregatorPtr->futures[_index];
+		if (!future.succeeded()) {
+			_aggregatorPtr->promise.setError(future.errorMessage());
+		}
+		if (__sync_sub_and_fetch(&_aggregatorPtr->pendingFuturesCount, 1) > 0) {
+			return;
+		}
+		std::auto_ptr<WhenAllAggregator> aggregatorAutoPtr(_aggregatorPtr);
+		std::vector<R> values;
+		values.reserve(aggregatorAutoPtr->futures.size());
+		for (size_t i = 0; i < aggregatorAutoPtr->futures.size(); ++i) {
+			if (!aggregatorAutoPtr->futures[i].succeeded()) {
+				return;
+			}
+			values.push_back(aggregatorAutoPtr->futures[i].value());
+		}
+		aggregatorAutoPtr->promise.setValue(values);
+	}
+private:
+	WhenAllAggregator * _aggregatorPtr;
+	const size_t _index;
+};
+template <typename R> class Future<R>::WhenAnyContinuation : public AbstractFutureContinuation
+{
+public:
+	WhenAnyContinuation(const Promise<size_t>& promise, size_t index) :
+		_promise(promise),
+		_index(index)
+	{}
+	virtual void execute()
+	{
+		_promise.setValue(_index);
+	}
+private:
+	Promise<size_t> _promise;
+	const size_t _index;
+};
+
+template <typename R> Future<std::vector<R> > Future<R>::whenAll(const std::vector<Future<R> >& futures)
+{
+	Promise<std::vector<R> > promise;
+	Future<std::vector<R> > result = promise.future();
+	if (futures.empty()) {
+		promise.setValue(std::vector<R>());
+		return result;
+	}
+	// Aggregator is deleted by the last continuation
+	WhenAllAggregator * aggregatorPtr = new WhenAllAggregator(promise, futures);
+	for (size_t i = 0; i < futures.size(); ++i) {
+		futures[i].addContinuation(std::auto_ptr<AbstractFutureContinuation>(new WhenAllContinuation(aggregatorPtr, i)));
+	}
+	return result;
+}
+template <typename R> Future<size_t> Future<R>::whenAny(const std::vector<Future<R> >& futures)
+{
+	Promise<size_t> promise;
+	Future<size_t> result = promise.future();
+	if (futures.empty()) {
+		promise.setError("No futures to wait for");
+		return result;
+	}
+	for (size_t i = 0; i < futures.size(); ++i) {
+		futures[i].addContinuation(std::auto_ptr<AbstractFutureContinuation>(new WhenAnyContinuation(promise, i)));
+	}
+	return result;
+}
+
+} // namespace isl
+
+#endif
@@ -0,0 +1,306 @@
+#ifndef ISL__FUTURE_TASK_DISPATCHER__HXX
+#define ISL__FUTURE_TASK_DISPATCHER__HXX
+
+#include <isl/TaskDispatcher.hxx>
+#include <isl/Future.hxx>
+
+namespace isl
+{
+
+//! Abstract task of the future task dispatcher
+class AbstractFutureTask
+{
+public:
+	virtual ~AbstractFutureTask()
+	{}
+	//! Executes the task and sets the result to it's promise
+	virtual void execute(TaskDispatcher<AbstractFutureTask>& dispatcher) = 0;
+};
+
+//! Task dispatcher, which executes functions, functors and methods and returns futures of their results
+/*!
+  Use submit() to execute a function, functor or method with up to two arguments in a separate thread and to get
+  a future of it's result, then() to execute a continuation in a separate thread once the future is completed, and
+  Future::whenAll() or Future::whenAny() to join the futures. Exception thrown by the submitted function or the
+  continuation fails it's future with the exception's message. The future of the task which has been rejected by
+  the task dispatcher (see TaskDispatcher::perform()) fails too.
+
+  \note Awaiting for the future in the worker thread blocks the worker, so prefer continuations to fan out
+        the sub-tasks from the task and to join them.
+
+  \sa Future, Promise
+*/
+class FutureTaskDispatcher : public TaskDispatcher<AbstractFutureTask>
+{
+private:
+	// Argument storage type, which is copied to the task
+	template <typename A> struct Argument
+	{
+		typedef A Type;
+	};
+	template <typename A> struct Argument<const A&>
+	{
+		typedef A Type;
+	};
+	template <typename A> struct Argument<A&>
+	{
+		typedef A Type;
+	};
+public:
+	//! Constructs new future task dispatcher
+	/*!
+	  \param owner Pointer to the owner subsystem
+	  \param workersAmount Worker threads amount
+	  \param clockTimeout Subsystem's clock timeout
+	*/
+	FutureTaskDispatcher(Subsystem * owner, size_t workersAmount, const Timeout& clockTimeout = Timeout::defaultTimeout()) :
+		TaskDispatcher<AbstractFutureTask>(owner, workersAmount, clockTimeout)
+	{}
+
+	//! Submits a functor which <tt>R operator()()</tt> is to be executed in a separate thread
+	/*!
+	  \param functor Functor to copy and to execute
+	  \return Future of the result
+	  \tparam R Result class, which should be set explicitly, e.g. <tt>submit<int>(functor)</tt>
+	  \note Thread-safe
+	*/
+	template <typename R, typename F> Future<R> submit(const F& functor)
+	{
+		return submitCall<R>(functor);
+	}
+	//! Submits a function to be executed in a separate thread
+	/*!
+	  \note Thread-safe
+	*/
+	template <typename R> Future<R> submit(R (*fun)())
+	{
+		return submitCall<R>(FunctionCall0<R>(fun));
+	}
+	//! Submits a function to be executed with the argument in a separate thread
+	/*!
+	  \note Thread-safe
+	*/
+	template <typename R, typename A1> Future<R> submit(R (*fun)(A1), const typename Argument<A1>::Type& a1)
+	{
+		return submitCall<R>(FunctionCall1<R, A1>(fun, a1));
+	}
+	//! Submits a function to be executed with the arguments in a separate thread
+	/*!
+	  \note Thread-safe
+	*/
+	template <typename R, typename A1, typename A2> Future<R> submit(R (*fun)(A1, A2), const typename Argument<A1>::Type& a1,
+			const typename Argument<A2>::Type& a2)
+	{
+		return submitCall<R>(FunctionCall2<R, A1, A2>(fun, a1, a2));
+	}
+	//! Submits an object's method to be executed in a separate thread
+	/*!
+	  \note Thread-safe
+	*/
+	template <typename R, typename C> Future<R> submit(C& obj, R (C::*method)())
+	{
+		return submitCall<R>(MethodCall0<R, C>(obj, method));
+	}
+	//! Submits an object's method to be executed with the argument in a separate thread
+	/*!
+	  \note Thread-safe
+	*/
+	template <typename R, typename C, typename A1> Future<R> submit(C& obj, R (C::*method)(A1), const typename Argument<A1>::Type& a1)
+	{
+		return submitCall<R>(MethodCall1<R, C, A1>(obj, method, a1));
+	}
+	//! Submits an object's method to be executed with the arguments in a separate thread
+	/*!
+	  \note Thread-safe
+	*/
+	template <typename R, typename C, typename A1, typename A2> Future<R> submit(C& obj, R (C::*method)(A1, A2),
+			const typename Argument<A1>::Type& a1, const typename Argument<A2>::Type& a2)
+	{
+		return submitCall<R>(MethodCall2<R, C, A1, A2>(obj, method, a1, a2));
+	}
+	//! Submits a function to be executed with the completed future in a separate thread once the future is completed
+	/*!
+	  \param future Future to continue
+	  \param fun Continuation function, which is called for the succeeded and for the failed future
+	  \return Future of the continuation's result
+	  \note Thread-safe
+	*/
+	template <typename R2, typename R> Future<R2> then(const Future<R>& future, R2 (*fun)(const Future<R>&))
+	{
+		return thenCall<R2>(future, FunctionCall1<R2, const Future<R>&>(fun, future));
+	}
+	//! Submits an object's method to be executed with the completed future in a separate thread once the future is completed
+	/*!
+	  \param future Future to continue
+	  \param obj Object to call the method of
+	  \param method Continuation method, which is called for the succeeded and for the failed future
+	  \return Future of the continuation's result
+	  \note Thread-safe
+	*/
+	template <typename R2, typename R, typename C> Future<R2> then(const Future<R>& future, C& obj, R2 (C::*method)(const Future<R>&))
+	{
+		return thenCall<R2>(future, MethodCall1<R2, C, const Future<R>&>(obj, method, future));
+	}
+private:
+	template <typename R> class FunctionCall0
+	{
+	public:
+		FunctionCall0(R (*fun)()) :
+			_fun(fun)
+		{}
+		R operator()()
+		{
+			return _fun();
+		}
+	private:
+		R (*_fun)();
+	};
+	template <typename R, typename A1> class FunctionCall1
+	{
+	public:
+		FunctionCall1(R (*fun)(A1), const typename Argument<A1>::Type& a1) :
+			_fun(fun),
+			_a1(a1)
+		{}
+		R operator()()
+		{
+			return _fun(_a1);
+		}
+	private:
+		R (*_fun)(A1);
+		typename Argument<A1>::Type _a1;
+	};
+	template <typename R, typename A1, typename A2> class FunctionCall2
+	{
+	public:
+		FunctionCall2(R (*fun)(A1, A2), const typename Argument<A1>::Type& a1, const typename Argument<A2>::Type& a2) :
+			_fun(fun),
+			_a1(a1),
+			_a2(a2)
+		{}
+		R operator()()
+		{
+			return _fun(_a1, _a2);
+		}
+	private:
+		R (*_fun)(A1, A2);
+		typename Argument<A1>::Type _a1;
+		typename Argument<A2>::Type _a2;
+	};
+	template <typename R, typename C> class MethodCall0
+	{
+	public:
+		MethodCall0(C& obj, R (C::*method)()) :
+			_obj(&obj),
+			_method(method)
+		{}
+		R operator()()
+		{
+			return (_obj->*_method)();
+		}
+	private:
+		C * _obj;
+		R (C::*_method)();
+	};
+	template <typename R, typename C, typename A1> class MethodCall1
+	{
+	public:
+		MethodCall1(C& obj, R (C::*method)(A1), const typename Argument<A1>::Type& a1) :
+			_obj(&obj),
+			_method(method),
+			_a1(a1)
+		{}
+		R operator()()
+		{
+			return (_obj->*_method)(_a1);
+		}
+	private:
+		C * _obj;
+		R (C::*_method)(A1);
+		typename Argument<A1>::Type _a1;
+	};
+	template <typename R, typename C, typename A1, typename A2> class MethodCall2
+	{
+	public:
+		MethodCall2(C& obj, R (C::*method)(A1, A2), const typename Argument<A1>::Type& a1, const typename Argument<A2>::Type& a2) :
+			_obj(&obj),
+			_method(method),
+			_a1(a1),
+			_a2(a2)
+		{}
+		R operator()()
+		{
+			return (_obj->*_method)(_a1, _a2);
+		}
+	private:
+		C * _obj;
+		R (C::*_method)(A1, A2);
+		typename Argument<A1>::Type _a1;
+		typename Argument<A2>::Type _a2;
+	};
+
+	template <typename R, typename F> class Task : public AbstractFutureTask
+	{
+	public:
+		Task(const F& call, const Promise<R>& promise) :
+			_call(call),
+			_promise(promise)
+		{}
+		virtual void execute(TaskDispatcher<AbstractFutureTask>& dispatcher)
+		{
+			try {
+				_promise.setValue(_call());
+			} catch (std::exception& e) {
+				_promise.setError(e.what());
+			} catch (...) {
+				_promise.setError("Unknown error");
+			}
+		}
+	private:
+		F _call;
+		Promise<R> _promise;
+	};
+	template <typename R, typename F> class Continuation : public AbstractFutureContinuation
+	{
+	public:
+		Continuation(FutureTaskDispatcher& dispatcher, const F& call, const Promise<R>& promise) :
+			_dispatcher(dispatcher),
+			_call(call),
+			_promise(promise)
+		{}
+		virtual void execute()
+		{
+			_dispatcher.performCall(_call, _promise);
+		}
+	private:
+		FutureTaskDispatcher& _dispatcher;
+		F _call;
+		Promise<R> _promise;
+	};
+
+	template <typename R, typename F> void performCall(const F& call, Promise<R>& promise)
+	{
+		std::auto_ptr<AbstractFutureTask> taskAutoPtr(new Task<R, F>(call, promise));
+		if (!perform(taskAutoPtr, &AbstractFutureTask::execute)) {
+			promise.setError("Task has been rejected by the task dispatcher");
+		}
+	}
+	template <typename R, typename F> Future<R> submitCall(const F& call)
+	{
+		Promise<R> promise;
+		Future<R> result = promise.future();
+		performCall(call, promise);
+		return result;
+	}
+	template <typename R2, typename R, typename F> Future<R2> thenCall(const Future<R>& future, const F& call)
+	{
+		Promise<R2> promise;
+		Future<R2> result = promise.future();
+		future.addContinuation(std::auto_ptr<AbstractFutureContinuation>(new Continuation<R2, F>(*this, call, promise)));
+		return result;
+	}
+};
+
+} // namespace isl
+
+#endif
@@ -3,8 +3,10 @@
 
 #include <isl/HttpMessageParser.hxx>
 #include <isl/AbstractIODevice.hxx>
+#include <isl/BufferedIODevice.hxx>
 #include <isl/Timestamp.hxx>
 #include <vector>
+#include <memory>
 
 #ifndef ISL__HTTP_MESSAGE_READER_DEFAULT_MAX_BODY_SIZE
 #define ISL__HTTP_MESSAGE_READER_DEFAULT_MAX_BODY_SIZE 102400		// 100 Kb
@@ -18,6 +20,11 @@ namespace isl
 {
 
 //! HTTP-message reader
+/*!
+  Parser works directly on the read buffer of the BufferedIODevice. If the device passed to the read() method is not
+  a BufferedIODevice, the reader wraps it with it's own one, which buffered data is discarded on reset() call or
+  when the other device is passed to the read() method.
+*/
 class HttpMessageReader
 {
 public:
@@ -30,7 +37,7 @@ public:
 	/*!
 	  \param parser Reference to the HTTP-message parser
 	  \param maxBodySize Maximum body size
-	  \param bufferSize Read data buffer size
+	  \param bufferSize Read data buffer size of the reader's own buffered device and the body buffer size
 	*/
 	HttpMessageReader(HttpMessageParser& parser, size_t maxBodySize = DefaultMaxBodySize, size_t bufferSize = DefaultBufferSize);
 	virtual ~HttpMessageReader();
@@ -62,12 +69,12 @@ protected:
 	virtual void onCompleteMessage()
 	{}
 private:
+	BufferedIODevice& bufferedDevice(AbstractIODevice& device);
+
 	HttpMessageParser& _parser;
 	const size_t _maxBodySize;
 	const size_t _bufferSize;
-	std::vector<char> _readBuffer;
-	size_t _bytesRead;
-	size_t _bytesParsed;
+	std::auto_ptr<BufferedIODevice> _bufferedDeviceAutoPtr;
 	std::vector<char> _bodyBuffer;
 	std::string _body;
 };
@@ -2,9 +2,10 @@
 #define ISL__HTTP_MESSAGE_STREAM_READER__HXX
 
 #include <isl/AbstractIODevice.hxx>
+#include <isl/BufferedIODevice.hxx>
 #include <isl/HttpMessageParser.hxx>
 #include <isl/Timestamp.hxx>
-#include <vector>
+#include <memory>
 
 #ifndef ISL__HTTP_MESSAGE_STREAM_READER_DEFAULT_BUFFER_SIZE
 #define ISL__HTTP_MESSAGE_STREAM_READER_DEFAULT_BUFFER_SIZE 4096	// 4 Kb
@@ -14,6 +15,12 @@ namespace isl
 {
 
 //! HTTP-message reader
+/*!
+  Parser works directly on the read buffer of the BufferedIODevice. If the device passed to the read() method is not
+  a BufferedIODevice, the reader wraps it with it's own one, which buffered data is discarded on reset() call or
+  when the other device is passed to the read() method. Pass the BufferedIODevice to keep the data received after the
+  end of the HTTP-message (e.g. pipelined requests) between the readers.
+*/
 class HttpMessageStreamReader
 {
 public:
@@ -24,7 +31,7 @@ public:
 	//! Constructs an HTTP-message reader
 	/*!
 	  \param parser Reference to the HTTP-message parser
-	  \param bufferSize Read data buffer size
+	  \param bufferSize Read data buffer size of the reader's own buffered device
 	*/
 	HttpMessageStreamReader(HttpMessageParser& parser, size_t bufferSize = DefaultBufferSize);
 	virtual ~HttpMessageStreamReader();
@@ -49,11 +56,11 @@ public:
 	*/
 	virtual std::pair<bool, size_t> read(AbstractIODevice& device, const Timestamp& limit, char * bodyBuffer, size_t bodyBufferSize, size_t * bytesReadFromDevice = 0);
 private:
+	BufferedIODevice& bufferedDevice(AbstractIODevice& device);
+
 	HttpMessageParser& _parser;
 	const size_t _bufferSize;
-	std::vector<char> _readBuffer;
-	size_t _bytesRead;
-	size_t _bytesParsed;
+	std::auto_ptr<BufferedIODevice> _bufferedDeviceAutoPtr;
 };
 
 } // namespace isl
@@ -0,0 +1,209 @@
+#ifndef ISL__IO_URING__HXX
+#define ISL__IO_URING__HXX
+
+#include <isl/Timeout.hxx>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <stdint.h>
+#include <vector>
+
+#ifndef ISL__IO_URING_DEFAULT_ENTRIES
+#define ISL__IO_URING_DEFAULT_ENTRIES 4
+#endif
+
+namespace isl
+{
+
+//! io_uring(7) I/O-engine
+/*!
+  The class is a thin wrapper around io_uring_setup(2)/io_uring_enter(2) system calls, which does not depend on liburing.
+
+  Synchronous operations (recv(), send(), read(), write(), accept()) are submitting an operation with the linked timeout
+  and are waiting for it's completion using exactly one io_uring_enter(2) call. TcpSocket and AbstractPosixIODevice
+  are trying the non-blocking system call first and are using them instead of the poll(2) + I/O system call pair when
+  the descriptor is not ready (EAGAIN), so the ready descriptor costs one system call as before.
+
+  Batched operations are queued by the <tt>prepare...()</tt> methods and are submitted to the kernel together with
+  the wait for the completions by one submitAndWait() call, completions are reaped by reapCompletions() from the
+  user-space without any system call (see IoUringAcceptor). Do not mix batched and synchronous operations on the same
+  instance: a synchronous operation reaps the completions of the pending batched ones.
+
+  The engine is compiled in if the library is built with <tt>ISL__USE_IO_URING</tt> macro defined (see
+  <tt>--with-io-uring</tt> SConstruct option). If the kernel lacks io_uring(7) support, isSupported() returns FALSE and
+  I/O-devices fall back to the poll(2) path.
+
+  \note Thread-unsafe: use an instance in one thread only, threadInstance() returns the calling thread's one
+*/
+class IoUring
+{
+public:
+	enum Constants {
+		DefaultEntries = ISL__IO_URING_DEFAULT_ENTRIES
+	};
+	//! Operation completion
+	struct Completion
+	{
+		//! User data of the operation
+		uint64_t userData;
+		//! Operation result: the same as the respective system call's result or -errno on error
+		int result;
+	};
+	//! Constructor
+	/*!
+	  \param entries Submission queue size, each synchronous operation takes two entries including the linked timeout
+	*/
+	IoUring(unsigned int entries = DefaultEntries);
+	//! Destructor
+	~IoUring();
+	//! Returns submission queue size
+	inline unsigned int entries() const
+	{
+		return _entries;
+	}
+	//! Returns TRUE if the kernel supports the timeout of the wait for the completions (Linux 5.11+)
+	inline bool isWaitTimeoutSupported() const
+	{
+		return _isWaitTimeoutSupported;
+	}
+	//! Returns amount of the queued but not submitted operations
+	inline size_t pendingSubmissions() const
+	{
+		return _sqeTail - _sqeSubmitted;
+	}
+	//! Queues accept4(2) operation
+	/*!
+	  \param fd Listening socket descriptor
+	  \param addr Pointer to the peer's address buffer, which should be valid until the operation completion
+	  \param addrLen Pointer to the peer's address buffer length, which should be valid until the operation completion
+	  \param flags accept4(2) flags
+	  \param userData User data to return in the operation's completion
+	  \return FALSE if the submission queue is full
+	*/
+	bool prepareAccept(int fd, struct sockaddr * addr, socklen_t * addrLen, int flags, uint64_t userData);
+	//! Queues cancellation of the submitted operation
+	/*!
+	  Cancelled operation completes with -ECANCELED result unless it has been completed before.
+
+	  \param targetUserData User data of the operation to cancel
+	  \param userData User data to return in the cancellation's completion
+	  \return FALSE if the submission queue is full
+	*/
+	bool prepareCancel(uint64_t targetUserData, uint64_t userData);
+	//! Submits the queued operations and waits for the completions using one io_uring_enter(2) call
+	/*!
+	  \param minCompletions Minimum amount of the completions to wait for
+	  \param timeout Timeout to wait for the completions, zero timeout means submit only
+	  \return Amount of the submitted operations
+
+	  \note An exception is thrown if the kernel does not support the timeout (see isWaitTimeoutSupported())
+	*/
+	size_t submitAndWait(size_t minCompletions, const Timeout& timeout);
+	//! Reaps available completions without any system call
+	/*!
+	  \param completions Pointer to the array to put the completions to
+	  \param maxCompletions Array size
+	  \return Amount of the completions reaped
+	*/
+	size_t reapCompletions(Completion * completions, size_t maxCompletions);
+	//! Synchronous read(2) with timeout
+	/*!
+	  \return Bytes read, -ETIME if the timeout has been expired or -errno on error
+	*/
+	int read(int fd, char * buffer, size_t bufferSize, const Timeout& timeout);
+	//! Synchronous write(2) with timeout
+	/*!
+	  \return Bytes written, -ETIME if the timeout has been expired or -errno on error
+	*/
+	int write(int fd, const char * buffer, size_t bufferSize, const Timeout& timeout);
+	//! Synchronous recv(2) with timeout
+	/*!
+	  \return Bytes received, -ETIME if the timeout has been expired or -errno on error
+	*/
+	int recv(int fd, char * buffer, size_t bufferSize, int flags, const Timeout& timeout);
+	//! Synchronous send(2) with timeout
+	/*!
+	  \return Bytes sent, -ETIME if the timeout has been expired or -errno on error
+	*/
+	int send(int fd, const char * buffer, size_t bufferSize, int flags, const Timeout& timeout);
+	//! Synchronous accept4(2) with timeout
+	/*!
+	  \return Accepted socket descriptor, -ETIME if the timeout has been expired or -errno on error
+	*/
+	int accept(int fd, struct sockaddr * addr, socklen_t * addrLen, int flags, const Timeout& timeout);
+
+	//! Returns TRUE if io_uring(7) engine is compiled in and is supported by the kernel
+	static bool isSupported();
+	//! Returns TRUE if the engine is used by I/O-devices
+	static bool isEnabled();
+	//! Enables or disables the engine usage by I/O-devices
+	/*!
+	  Engine is enabled by default if it is supported.
+	  \note Thread-safe
+	*/
+	static void setEnabled(bool newValue);
+	//! Returns a pointer to the calling thread's engine instance or 0 if the engine is not supported or disabled
+	/*!
+	  An instance is created on the first call in the thread and is destroyed on the thread's exit.
+	*/
+	static IoUring * threadInstance();
+private:
+	IoUring(const IoUring&);							// No copy
+
+	IoUring& operator=(const IoUring&);						// No copy
+
+	//! Queues read(2) operation
+	/*!
+	  \return FALSE if the submission queue is full
+	*/
+	bool prepareRead(int fd, char * buffer, size_t bufferSize, uint64_t userData);
+	//! Queues write(2) operation
+	/*!
+	  \return FALSE if the submission queue is full
+	*/
+	bool prepareWrite(int fd, const char * buffer, size_t bufferSize, uint64_t userData);
+	//! Queues recv(2) operation
+	/*!
+	  \return FALSE if the submission queue is full
+	*/
+	bool prepareRecv(int fd, char * buffer, size_t bufferSize, int flags, uint64_t userData);
+	//! Queues send(2) operation
+	/*!
+	  \return FALSE if the submission queue is full
+	*/
+	bool prepareSend(int fd, const char * buffer, size_t bufferSize, int flags, uint64_t userData);
+	//! Queues a timeout, which is cancelling the previously queued operation if it has not been completed in time
+	/*!
+	  \return FALSE if the submission queue is full
+	*/
+	bool prepareLinkTimeout(const Timeout& timeout, uint64_t userData);
+	void * nextSqe();
+	//! Publishes queued operations to the kernel and waits for the completions
+	size_t enter(size_t submitAmount, size_t completionsAmount, const Timeout * timeoutPtr = 0);
+	//! Submits the operation with it's linked timeout and waits for both completions
+	int perform(size_t completionsAmount);
+
+	unsigned int _entries;
+	bool _isWaitTimeoutSupported;
+	int _ringDescriptor;
+	void * _sqRingPtr;
+	size_t _sqRingSize;
+	void * _cqRingPtr;
+	size_t _cqRingSize;
+	void * _sqesPtr;
+	size_t _sqesSize;
+	unsigned int * _sqHeadPtr;
+	unsigned int * _sqTailPtr;
+	unsigned int _sqMask;
+	unsigned int * _sqArrayPtr;
+	unsigned int * _cqHeadPtr;
+	unsigned int * _cqTailPtr;
+	unsigned int _cqMask;
+	void * _cqesPtr;
+	unsigned int _sqeTail;
+	unsigned int _sqeSubmitted;
+	std::vector<char> _timeSpecs;
+};
+
+} // namespace isl
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef ISL__IO_URING_ACCEPTOR__HXX
+#define ISL__IO_URING_ACCEPTOR__HXX
+
+#include <isl/IoUring.hxx>
+#include <isl/TcpSocket.hxx>
+#include <sys/socket.h>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#ifndef ISL__IO_URING_ACCEPTOR_DEFAULT_MAX_PENDING_ACCEPTS
+#define ISL__IO_URING_ACCEPTOR_DEFAULT_MAX_PENDING_ACCEPTS 16
+#endif
+
+namespace isl
+{
+
+//! Accepts TCP-connections in batches using io_uring(7)
+/*!
+  Acceptor keeps the amount of the accept operations pending on the listening socket in it's own ring. Operations
+  which have been completed are re-armed together with the wait for the next completions by one io_uring_enter(2)
+  call, and all connections which have been accepted meanwhile are reaped at once, so the burst of the incoming
+  connections costs less than one system call per connection instead of one accept4(2) call per connection plus
+  the one which reports EAGAIN.
+
+  Pending accept operations are cancelled on destruction, the connections which have been accepted but not
+  returned by accept() are closed.
+
+  \note Thread-unsafe: use an instance in one thread only
+*/
+class IoUringAcceptor
+{
+public:
+	enum Constants {
+		DefaultMaxPendingAccepts = ISL__IO_URING_ACCEPTOR_DEFAULT_MAX_PENDING_ACCEPTS
+	};
+	//! Constructor
+	/*!
+	  \param serverSocket Reference to the listening socket, which should be kept open during the acceptor's lifetime
+	  \param maxPendingAccepts Amount of the accept operations to keep pending on the listening socket
+
+	  \note An exception is thrown if io_uring(7) or the timeout of the wait for the completions is not supported
+	*/
+	IoUringAcceptor(TcpSocket& serverSocket, size_t maxPendingAccepts = DefaultMaxPendingAccepts);
+	//! Destructor
+	~IoUringAcceptor();
+	//! Returns amount of the accept operations to keep pending on the listening socket
+	inline size_t maxPendingAccepts() const
+	{
+		return _slots.size();
+	}
+	//! Returns amount of the connections which have been accepted but have not been returned by accept() yet
+	inline size_t acceptedConnectionsAmount() const
+	{
+		return _acceptedSockets.size();
+	}
+	//! Accepts TCP-connection
+	/*!
+	  Returns the connection which has been accepted before if any, otherwise re-arms completed accept operations
+	  and waits for the completions using one io_uring_enter(2) call.
+
+	  \param timeout Timeout to wait for the connection
+	  \return Auto-pointer to the accepted connection socket or to 0 if the timeout has been expired
+	*/
+	std::auto_ptr<TcpSocket> accept(const Timeout& timeout = Timeout());
+private:
+	IoUringAcceptor();
+	IoUringAcceptor(const IoUringAcceptor&);					// No copy
+
+	IoUringAcceptor& operator=(const IoUringAcceptor&);				// No copy
+
+	//! Accept operation's peer address buffer
+	struct Slot
+	{
+		Slot() :
+			remoteSockAddr(),
+			remoteSockAddrLen(0),
+			isPending(false)
+		{}
+
+		struct sockaddr_storage remoteSockAddr;
+		socklen_t remoteSockAddrLen;
+		bool isPending;
+	};
+	typedef std::vector<Slot> SlotsContainer;
+	typedef std::deque<TcpSocket *> AcceptedSocketsContainer;
+
+	//! Reaps available completions, returns amount of the accept operations completed
+	size_t reapCompletions();
+
+	TcpSocket& _serverSocket;
+	IoUring _ioUring;
+	SlotsContainer _slots;
+	size_t _pendingAcceptsCount;
+	AcceptedSocketsContainer _acceptedSockets;
+};
+
+} // namespace isl
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef ISL__LISTENING_SOCKET_REGISTRY__HXX
+#define ISL__LISTENING_SOCKET_REGISTRY__HXX
+
+#include <isl/TcpSocket.hxx>
+#include <isl/Mutex.hxx>
+#include <sys/socket.h>
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifndef ISL__LISTENING_SOCKET_REGISTRY_ENVIRONMENT_VARIABLE
+#define ISL__LISTENING_SOCKET_REGISTRY_ENVIRONMENT_VARIABLE "ISL_LISTEN_FDS"
+#endif
+
+namespace isl
+{
+
+//! Process-wide registry of the listening sockets
+/*!
+  Keeps the listening sockets alive across the restarts, so the clients are not refused while the listeners are
+  being re-created - the kernel keeps queueing incoming connections in the listen backlog of the socket.
+
+  Listener threads of the services are taking the sockets bound to their addresses out of the registry using
+  adopt() instead of binding the new ones, register the sockets they have opened themselves using add() and
+  give the sockets back using release(). Released sockets are parked in the registry if it is retaining
+  them (e.g. during the in-process restart, see Server::appointRestart()) or closed otherwise.
+
+  Listening socket descriptors inherited from the parent process (see Server::appointUpgrade()) are listed in the
+  environment variable (<tt>ISL_LISTEN_FDS</tt> by default) as comma-separated numbers. They are loaded by the
+  first call to instance().
+
+  \note Thread-safe
+*/
+class ListeningSocketRegistry
+{
+public:
+	//! Returns a reference to the process-wide registry
+	static ListeningSocketRegistry& instance();
+
+	//! Returns environment variable name to pass the inherited listening socket descriptors in
+	static const char * environmentVariable()
+	{
+		return ISL__LISTENING_SOCKET_REGISTRY_ENVIRONMENT_VARIABLE;
+	}
+	//! Opens the socket object on the available listening socket descriptor bound to the address if any
+	/*!
+	  \param socket Reference to the closed socket object to open
+	  \param addr Pointer to the socket address to look up the listening socket by
+	  \param addrLen Socket address length
+	  \return TRUE if the socket has been adopted or FALSE if there is no available listening socket bound to
+	          the address
+	*/
+	bool adopt(TcpSocket& socket, const struct sockaddr * addr, socklen_t addrLen);
+	//! Registers the listening socket which has been bound by the process
+	/*!
+	  \param socket Constant reference to the listening socket
+	*/
+	void add(const TcpSocket& socket);
+	//! Withdraws the listening socket from the registry
+	/*!
+	  Socket descriptor is detached from the socket object and parked in the registry if it is retaining the sockets,
+	  otherwise the socket is closed.
+
+	  \param socket Reference to the listening socket to release
+	*/
+	void release(TcpSocket& socket);
+	//! Returns TRUE if released sockets are parked in the registry
+	bool isRetaining() const;
+	//! Sets the retaining of the released sockets
+	/*!
+	  \param newValue TRUE if to park the released sockets in the registry or FALSE if to close them
+	*/
+	void setRetaining(bool newValue);
+	//! Returns amount of the parked and inherited sockets which have not been adopted yet
+	size_t availableAmount() const;
+	//! Closes parked and inherited sockets which have not been adopted
+	/*!
+	  Call it after all services have been started to release the addresses nobody listens to anymore.
+	  \return Amount of the closed sockets
+	*/
+	size_t closeAvailable();
+	//! Returns descriptors of the listening sockets in use to pass to the child process
+	std::vector<int> descriptors() const;
+	//! Composes the environment variable assignment to pass the listening socket descriptors in
+	/*!
+	  \param descriptors Listening socket descriptors to pass
+	  \return "NAME=fd1,fd2,..." string for the execve(2) environment
+	*/
+	static std::string composeEnvironment(const std::vector<int>& descriptors);
+private:
+	ListeningSocketRegistry();
+	ListeningSocketRegistry(const ListeningSocketRegistry&);				// No copy
+
+	ListeningSocketRegistry& operator=(const ListeningSocketRegistry&);			// No copy
+
+	typedef std::list<int> AvailableDescriptorsContainer;
+	typedef std::set<int> DescriptorsContainer;
+
+	void loadInherited();
+
+	static bool isListeningSocket(int descriptor);
+	static bool isBoundTo(int descriptor, const struct sockaddr * addr, socklen_t addrLen);
+
+	mutable Mutex _mutex;
+	AvailableDescriptorsContainer _availableDescriptors;
+	DescriptorsContainer _descriptors;
+	bool _isRetaining;
+};
+
+} // namespace isl
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef ISL__LOCK_FREE_QUEUE__HXX
+#define ISL__LOCK_FREE_QUEUE__HXX
+
+#include <stddef.h>
+
+namespace isl
+{
+
+//! Unbounded intrusive lock-free FIFO queue of pointers (Vyukov's multi-producer queue)
+/*!
+  Producers push the items using one atomic exchange without any loop, so they never wait for each other or for the
+  consumer. Items are popped by one consumer at a time: a thread which tries to pop the items while another one is
+  popping them gets nothing at once instead of waiting, so any thread could consume the queue.
+
+  Item is linked to the queue using it's own Node base class, so the queue does not allocate any memory. Pushed item
+  could be invisible to the consumer for a moment, while the producer has not linked it yet.
+
+  \note Thread-safe: push() and pop() could be called by any thread
+
+  \tparam T Item class, which should be derived from LockFreeQueue<T>::Node, the queue does not own the items
+
+  \sa <a href="http://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue">Intrusive MPSC node-based queue</a>
+*/
+template <typename T> class LockFreeQueue
+{
+public:
+	//! Base class of the queue items
+	class Node
+	{
+	public:
+		Node() :
+			_nextPtr(0)
+		{}
+	private:
+		Node * _nextPtr;
+
+		friend class LockFreeQueue<T>;
+	};
+
+	//! Constructs an empty queue
+	LockFreeQueue() :
+		_stub(),
+		_headPtr(&_stub),
+		_isPopping(false),
+		_tailPtr(&_stub)
+	{}
+
+	//! Pushes an item to the tail of the queue
+	/*!
+	  \param itemPtr Pointer to the item to push, which should not be in any queue
+	*/
+	void push(T * itemPtr)
+	{
+		pushNode(itemPtr);
+	}
+	//! Pops the items from the head of the queue
+	/*!
+	  \param items Array to put the pointers to the popped items to in the push order
+	  \param maxAmount Maximum amount of the items to pop
+	  \return Amount of the popped items, which is 0 if the queue is empty or another thread is popping the items
+	*/
+	size_t pop(T ** items, size_t maxAmount)
+	{
+		if (isEmpty() || __atomic_exchange_n(&_isPopping, true, __ATOMIC_ACQUIRE)) {
+			return 0;
+		}
+		size_t amount = 0;
+		while (amount < maxAmount) {
+			Node * nodePtr = popNode();
+			if (!nodePtr) {
+				break;
+			}
+			items[amount++] = static_cast<T *>(nodePtr);
+		}
+		__atomic_store_n(&_isPopping, false, __ATOMIC_RELEASE);
+		return amount;
+	}
+	//! Returns TRUE if the queue is empty or the only item has not been linked yet
+	inline bool isEmpty() const
+	{
+		const Node * headPtr = __atomic_load_n(&_headPtr, __ATOMIC_ACQUIRE);
+		return headPtr == &_stub && !__atomic_load_n(&_stub._nextPtr, __ATOMIC_ACQUIRE);
+	}
+private:
+	LockFreeQueue(const LockFreeQueue&);							// No copy
+
+	LockFreeQueue& operator=(const LockFreeQueue&);						// No copy
+
+	void pushNode(Node * nodePtr)
+	{
+		__atomic_store_n(&nodePtr->_nextPtr, static_cast<Node *>(0), __ATOMIC_RELAXED);
+		Node * prevPtr = __atomic_exchange_n(&_tailPtr, nodePtr, __ATOMIC_ACQ_REL);
+		// Node is visible to the consumer after it has been linked to the previous one
+		__atomic_store_n(&prevPtr->_nextPtr, nodePtr, __ATOMIC_RELEASE);
+	}
+	// Should be called by the popping thread only, returns 0 if the queue is empty or the next node has not been linked yet
+	Node * popNode()
+	{
+		Node * headPtr = __atomic_load_n(&_headPtr, __ATOMIC_RELAXED);
+		Node * nextPtr = __atomic_load_n(&headPtr->_nextPtr, __ATOMIC_ACQUIRE);
+		if (headPtr == &_stub) {
+			if (!nextPtr) {
+				return 0;
+			}
+			headPtr = nextPtr;
+			__atomic_store_n(&_headPtr, headPtr, __ATOMIC_RELEASE);
+			nextPtr = __atomic_load_n(&headPtr->_nextPtr, __ATOMIC_ACQUIRE);
+		}
+		if (nextPtr) {
+			__atomic_store_n(&_headPtr, nextPtr, __ATOMIC_RELEASE);
+			return headPtr;
+		}
+		if (headPtr != __atomic_load_n(&_tailPtr, __ATOMIC_ACQUIRE)) {
+			// Producer has not linked the next node yet
+			return 0;
+		}
+		// The last node is popped after the stub node has been pushed behind it, so the queue is never empty
+		pushNode(&_stub);
+		nextPtr = __atomic_load_n(&headPtr->_nextPtr, __ATOMIC_ACQUIRE);
+		if (!nextPtr) {
+			return 0;
+		}
+		__atomic_store_n(&_headPtr, nextPtr, __ATOMIC_RELEASE);
+		return headPtr;
+	}
+
+	Node _stub;
+	Node * _headPtr;
+	bool _isPopping;
+	// Tail is updated by the producers, so it is placed on the other cache line than the consumer's head
+	char _tailPadding[64];
+	Node * _tailPtr;
+};
+
+} // namespace isl
+
+#endif
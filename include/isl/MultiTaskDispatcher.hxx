@@ -19,6 +19,14 @@ namespace isl
   If your task object has only one such method you should use TaskDispatcher class instead, cause it does
   not need additional mutex per each task object which is used for correct task object disposal.
 
+  All methods of the task are started together (gang scheduling), so the task is accepted only if there are enough
+  idling workers to execute all of them. If the admission queue is enabled using setMaxAdmissionQueueSize(), the task
+  which does not fit the idling workers is held in the admission queue until enough workers have been released or
+  the admission timeout expires, so a short spike of the tasks does not turn into the rejections. Admission queue
+  is served in FIFO order. Expired task is discarded after the admission expired method (if any) has been called.
+  Admission timeouts are checked on each subsystem's clock tick too, so the expired task is not waiting for a worker
+  to be released while all of them are busy with the long-running tasks.
+
   \note Task dispatcher will automatically dispose all pending tasks on stop() operation without execution.
 
   \tparam T Task object class
@@ -34,6 +42,31 @@ public:
 	typedef void (T::*Method)(MultiTaskDispatcher<T>&);
 	//! Task object's methods container type definition
 	typedef std::list<Method> MethodsContainer;
+	//! Task dispatcher counters
+	struct Counters
+	{
+		Counters() :
+			acceptedTasks(0),
+			queuedTasks(0),
+			rejectedTasks(0),
+			expiredTasks(0),
+			totalAdmissionTime(),
+			maxAdmissionTime()
+		{}
+
+		//! Amount of the tasks which methods have been started immediately or after the admission queue waiting
+		size_t acceptedTasks;
+		//! Amount of the tasks which have been put to the admission queue
+		size_t queuedTasks;
+		//! Amount of the tasks which have been rejected
+		size_t rejectedTasks;
+		//! Amount of the tasks which have been discarded from the admission queue due to the admission timeout expiration
+		size_t expiredTasks;
+		//! Total time the admitted tasks have been waiting in the admission queue
+		Timeout totalAdmissionTime;
+		//! Maximum time the admitted task has been waiting in the admission queue
+		Timeout maxAdmissionTime;
+	};
 private:
 	class TaskDisposer
 	{
@@ -97,6 +130,72 @@ private:
 		Method _method;
 	};
 	typedef std::deque<PendingTask *> PendingTasksQueue;
+
+	//! Task waiting in the admission queue for all it's methods to be started together
+	class AdmissionTask
+	{
+	public:
+		AdmissionTask(T * taskPtr, const MethodsContainer& methods, const Timestamp& limit) :
+			_taskAutoPtr(taskPtr),
+			_methods(methods),
+			_enqueueTimestamp(Timestamp::now()),
+			_limit(limit)
+		{}
+		inline std::auto_ptr<T>& taskAutoPtr()
+		{
+			return _taskAutoPtr;
+		}
+		inline const MethodsContainer& methods() const
+		{
+			return _methods;
+		}
+		inline const Timestamp& enqueueTimestamp() const
+		{
+			return _enqueueTimestamp;
+		}
+		inline const Timestamp& limit() const
+		{
+			return _limit;
+		}
+	private:
+		AdmissionTask();
+		AdmissionTask(const AdmissionTask&);							// No copy
+		AdmissionTask& operator=(const AdmissionTask&);						// No copy
+
+		std::auto_ptr<T> _taskAutoPtr;
+		const MethodsContainer _methods;
+		const Timestamp _enqueueTimestamp;
+		const Timestamp _limit;
+	};
+	typedef std::deque<AdmissionTask *> AdmissionQueue;
+	typedef std::list<AdmissionTask *> AdmissionTasksContainer;
+
+	//! Discards the expired tasks from the admission queue on each clock tick
+	class SupervisorThread : public OscillatorThread
+	{
+	public:
+		SupervisorThread(MultiTaskDispatcher<T>& taskDispatcher) :
+			OscillatorThread(taskDispatcher),
+			_taskDispatcher(taskDispatcher)
+		{}
+	private:
+		SupervisorThread();
+		SupervisorThread(const SupervisorThread&);						// No copy
+
+		SupervisorThread& operator=(const SupervisorThread&);					// No copy
+
+		virtual void doLoad(const Timestamp& prevTick, const Timestamp& nextTick, size_t ticksExpired)
+		{
+			AdmissionTasksContainer expiredTasks;
+			{
+				MutexLocker locker(_taskDispatcher._cond.mutex());
+				_taskDispatcher.fetchExpiredAdmissionTasks(expiredTasks);
+			}
+			_taskDispatcher.disposeExpiredAdmissionTasks(expiredTasks);
+		}
+
+		MultiTaskDispatcher<T>& _taskDispatcher;
+	};
 public:
 	//! Constructs new task dispatcher
 	/*!
@@ -106,16 +205,23 @@ public:
 	MultiTaskDispatcher(Subsystem * owner, size_t workersAmount, const Timeout& clockTimeout = Timeout::defaultTimeout()) :
 		Subsystem(owner, clockTimeout),
 		_workersAmount(workersAmount),
+		_maxAdmissionQueueSize(0),
+		_admissionTimeout(Timeout::defaultTimeout()),
+		_admissionExpiredMethod(0),
 		_cond(),
 		_shouldTerminate(false),
+		_supervisorAutoPtr(),
 		_workers(),
 		_awaitingWorkersCount(0),
-		_pendingTasksQueue()
+		_pendingTasksQueue(),
+		_admissionQueue(),
+		_counters()
 	{}
 	virtual ~MultiTaskDispatcher()
 	{
 		resetWorkers();
 		resetPendingTasksQueue();
+		resetAdmissionQueue();
 	}
 	//! Returns workers amount
 	inline size_t workersAmount() const
@@ -132,6 +238,76 @@ public:
 	{
 		_workersAmount = newValue;
 	}
+	//! Returns maximum amount of the tasks in the admission queue, 0 means the admission queue is disabled
+	inline size_t maxAdmissionQueueSize() const
+	{
+		return _maxAdmissionQueueSize;
+	}
+	//! Sets maximum amount of the tasks in the admission queue
+	/*!
+	  \param newValue New maximum amount of the tasks in the admission queue, 0 disables the admission queue
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxAdmissionQueueSize(size_t newValue)
+	{
+		_maxAdmissionQueueSize = newValue;
+	}
+	//! Returns maximum time the task is waiting in the admission queue
+	inline const Timeout& admissionTimeout() const
+	{
+		return _admissionTimeout;
+	}
+	//! Sets maximum time the task is waiting in the admission queue
+	/*!
+	  \param newValue New admission timeout
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setAdmissionTimeout(const Timeout& newValue)
+	{
+		_admissionTimeout = newValue;
+	}
+	//! Sets task's method to call before the task is discarded due to the admission timeout expiration
+	/*!
+	  The method is called by the thread which has detected the expiration: a producer thread in the perform()
+	  call, a worker thread which has been released or the dispatcher's supervisor thread on the clock tick.
+
+	  \param newValue Pointer to the task's method or 0 to discard expired tasks silently
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setAdmissionExpiredMethod(Method newValue)
+	{
+		_admissionExpiredMethod = newValue;
+	}
+	//! Returns current amount of the tasks in the admission queue
+	/*!
+	  \note Thread-safe
+	*/
+	inline size_t admissionQueueSize() const
+	{
+		MutexLocker locker(_cond.mutex());
+		return _admissionQueue.size();
+	}
+	//! Returns task dispatcher counters
+	/*!
+	  \note Thread-safe
+	*/
+	inline Counters counters() const
+	{
+		MutexLocker locker(_cond.mutex());
+		return _counters;
+	}
+	//! Resets task dispatcher counters
+	/*!
+	  \note Thread-safe
+	*/
+	inline void resetCounters()
+	{
+		MutexLocker locker(_cond.mutex());
+		_counters = Counters();
+	}
 	//! Returns if the task dispatcher should be terminated
 	/*!
 	  Call this method periodically during long-live tasks execution for correct subsystem's termination.
@@ -161,7 +337,7 @@ public:
 	/*!
 	  \param taskAutoPtr Reference to the auto-pointer to task object, which is automatically released if the task has been successfully accepted.
 	  \param methods Reference to method(s) of the task to be executed in the separate thread(s)
-	  \return TRUE if the task has been successfully accepted
+	  \return TRUE if the task has been successfully accepted or has been put to the admission queue
 
 	  \note Thread-safe
 	*/
@@ -178,16 +354,21 @@ public:
 			return true;
 		}
 		bool taskPerformed = false;
+		AdmissionTasksContainer expiredTasks;
 		{
 			MutexLocker locker(_cond.mutex());
-			if (_pendingTasksQueue.size() + methods.size() <= _awaitingWorkersCount) {
-				std::auto_ptr<TaskDisposer> taskDisposerAutoPtr(new TaskDisposer(taskAutoPtr.get()));
-				for (typename MethodsContainer::const_iterator i = methods.begin(); i != methods.end(); ++i) {
-					_pendingTasksQueue.push_front(new PendingTask(*this, taskDisposerAutoPtr.get(), (*i)));
-				}
-				taskDisposerAutoPtr.release();
+			fetchExpiredAdmissionTasks(expiredTasks);
+			if (_admissionQueue.empty() && (_pendingTasksQueue.size() + methods.size() <= _awaitingWorkersCount)) {
+				startMethods(taskAutoPtr.get(), methods);
+				++_counters.acceptedTasks;
 				taskPerformed = true;
-				_cond.wakeAll();
+			} else if ((_admissionQueue.size() < _maxAdmissionQueueSize) && (methods.size() <= _workersAmount)) {
+				// Holding the task until enough workers have been released
+				_admissionQueue.push_back(new AdmissionTask(taskAutoPtr.get(), methods, Timestamp::limit(_admissionTimeout)));
+				++_counters.queuedTasks;
+				taskPerformed = true;
+			} else {
+				++_counters.rejectedTasks;
 			}
 		}
 		if (taskPerformed) {
@@ -195,6 +376,7 @@ public:
 		} else {
 			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "No enough workers available"));
 		}
+		disposeExpiredAdmissionTasks(expiredTasks);
 		return taskPerformed;
 	}
 	//! Accepts task for it's single method execution in separate thread
@@ -263,8 +445,6 @@ public:
 	//! Starts subsystem
 	virtual void start()
 	{
-		// Calling ancestor's method
-		Subsystem::start();
 		_shouldTerminate = false;
 		_awaitingWorkersCount = 0;
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating and starting workers"));
@@ -276,6 +456,12 @@ public:
 			newWorkerPtr->start(*this, &MultiTaskDispatcher<T>::work);
 		}
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Workers have been created and started"));
+		if (_maxAdmissionQueueSize > 0) {
+			// Supervisor is started by the ancestor's method
+			_supervisorAutoPtr.reset(new SupervisorThread(*this));
+		}
+		// Calling ancestor's method
+		Subsystem::start();
 	}
 	//! Stops subsystem
 	virtual void stop()
@@ -294,10 +480,15 @@ public:
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Workers have been stopped"));
 		// Disposing workers
 		resetWorkers();
-		// Disposing pending tasks queue
-		resetPendingTasksQueue();
-		// Calling ancestor's method
+		// Calling ancestor's method which stops the supervisor before the admission queue is disposed
 		Subsystem::stop();
+		_supervisorAutoPtr.reset();
+		// Disposing pending tasks and admission queues
+		{
+			MutexLocker locker(_cond.mutex());
+			resetPendingTasksQueue();
+			resetAdmissionQueue();
+		}
 	}
 private:
 	MultiTaskDispatcher();
@@ -324,32 +515,105 @@ private:
 		_pendingTasksQueue.clear();
 	}
 
+	void resetAdmissionQueue()
+	{
+		for (typename AdmissionQueue::iterator i = _admissionQueue.begin(); i != _admissionQueue.end(); ++i) {
+			delete (*i);
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Admission queue task has been discarded"));
+		}
+		_admissionQueue.clear();
+	}
+	//! Puts all task's methods to the pending tasks queue and wakes up the workers
+	void startMethods(T * taskPtr, const MethodsContainer& methods)
+	{
+		std::auto_ptr<TaskDisposer> taskDisposerAutoPtr(new TaskDisposer(taskPtr));
+		for (typename MethodsContainer::const_iterator i = methods.begin(); i != methods.end(); ++i) {
+			_pendingTasksQueue.push_front(new PendingTask(*this, taskDisposerAutoPtr.get(), (*i)));
+		}
+		taskDisposerAutoPtr.release();
+		_cond.wakeAll();
+	}
+	//! Moves expired tasks from the head of the admission queue to the container
+	void fetchExpiredAdmissionTasks(AdmissionTasksContainer& expiredTasks)
+	{
+		if (_shouldTerminate || _admissionQueue.empty()) {
+			return;
+		}
+		// All tasks are waiting for the same timeout, so the admission queue is ordered by the limit timestamp
+		Timestamp now = Timestamp::now();
+		while (!_admissionQueue.empty() && _admissionQueue.front()->limit() <= now) {
+			expiredTasks.push_back(_admissionQueue.front());
+			_admissionQueue.pop_front();
+			++_counters.expiredTasks;
+		}
+	}
+	//! Starts tasks from the head of the admission queue while there are enough idling workers
+	void admitTasks()
+	{
+		while (!_admissionQueue.empty() &&
+				(_pendingTasksQueue.size() + _admissionQueue.front()->methods().size() <= _awaitingWorkersCount)) {
+			std::auto_ptr<AdmissionTask> admissionTaskAutoPtr(_admissionQueue.front());
+			_admissionQueue.pop_front();
+			startMethods(admissionTaskAutoPtr->taskAutoPtr().get(), admissionTaskAutoPtr->methods());
+			admissionTaskAutoPtr->taskAutoPtr().release();
+			++_counters.acceptedTasks;
+			Timeout admissionTime = Timestamp::now() - admissionTaskAutoPtr->enqueueTimestamp();
+			_counters.totalAdmissionTime += admissionTime;
+			if (admissionTime > _counters.maxAdmissionTime) {
+				_counters.maxAdmissionTime = admissionTime;
+			}
+		}
+	}
+	//! Calls admission expired method of the expired tasks and disposes them
+	void disposeExpiredAdmissionTasks(AdmissionTasksContainer& expiredTasks)
+	{
+		for (typename AdmissionTasksContainer::iterator i = expiredTasks.begin(); i != expiredTasks.end(); ++i) {
+			std::auto_ptr<AdmissionTask> admissionTaskAutoPtr(*i);
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Admission timeout has been expired -> discarding the task"));
+			if (_admissionExpiredMethod) {
+				try {
+					((admissionTaskAutoPtr->taskAutoPtr().get())->*(_admissionExpiredMethod))(*this);
+				} catch (std::exception& e) {
+					Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Admission expired method execution error"));
+				} catch (...) {
+					Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Admission expired method unknown execution error"));
+				}
+			}
+		}
+		expiredTasks.clear();
+	}
+
 	void work()
 	{
 		while (true) {
 			std::auto_ptr<PendingTask> pendingTaskAutoPtr;
+			AdmissionTasksContainer expiredTasks;
 			{
 				MutexLocker locker(_cond.mutex());
 				if (_shouldTerminate) {
 					return;
 				}
 				if (_pendingTasksQueue.empty()) {
-					// Waiting for the next task if the pending tasks queue is empty
 					++_awaitingWorkersCount;
-					_cond.wait();
+					// Starting the tasks from the admission queue which are fitting the idling workers now
+					fetchExpiredAdmissionTasks(expiredTasks);
+					admitTasks();
+					if (_pendingTasksQueue.empty() && expiredTasks.empty()) {
+						// Waiting for the next task if the pending tasks queue is empty
+						_cond.wait();
+					}
 					--_awaitingWorkersCount;
 					if (_shouldTerminate) {
 						return;
 					}
-					if (!_pendingTasksQueue.empty()) {
-						pendingTaskAutoPtr.reset(_pendingTasksQueue.back());
-						_pendingTasksQueue.pop_back();
-					}
-				} else {
+				}
+				if (!_pendingTasksQueue.empty()) {
 					pendingTaskAutoPtr.reset(_pendingTasksQueue.back());
 					_pendingTasksQueue.pop_back();
 				}
 			}
+			// Expired tasks are disposed outside of the critical section
+			disposeExpiredAdmissionTasks(expiredTasks);
 			if (pendingTaskAutoPtr.get()) {
 				pendingTaskAutoPtr->execute();
 			}
@@ -357,11 +621,17 @@ private:
 	}
 
 	size_t _workersAmount;
+	size_t _maxAdmissionQueueSize;
+	Timeout _admissionTimeout;
+	Method _admissionExpiredMethod;
 	mutable WaitCondition _cond;
 	bool _shouldTerminate;
+	std::auto_ptr<SupervisorThread> _supervisorAutoPtr;
 	WorkersContainer _workers;
 	size_t _awaitingWorkersCount;
 	PendingTasksQueue _pendingTasksQueue;
+	AdmissionQueue _admissionQueue;
+	Counters _counters;
 
 	friend class Thread;
 };
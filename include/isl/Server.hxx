@@ -5,6 +5,13 @@
 #include <isl/SignalSet.hxx>
 #include <vector>
 
+#ifndef ISL__SERVER_DEFAULT_UPGRADE_TIMEOUT
+#define ISL__SERVER_DEFAULT_UPGRADE_TIMEOUT 30				// Seconds
+#endif
+#ifndef ISL__SERVER_UPGRADE_READY_ENVIRONMENT_VARIABLE
+#define ISL__SERVER_UPGRADE_READY_ENVIRONMENT_VARIABLE "ISL_UPGRADE_READY_FD"
+#endif
+
 namespace isl
 {
 
@@ -13,6 +20,9 @@ namespace isl
   Server has a main loop which is to be executed by run() method from the application's main
   thread - this is because UNIX-signals should be blocked in main thread only.
   Main loop is awaits for incoming UNIX-signals or commands and reacts respectively.
+
+  Listening sockets of the services are kept open through the restart and are passed to the new server process
+  on the upgrade (see ListeningSocketRegistry), so the clients are not refused in both cases.
 */
 class Server : public Subsystem
 {
@@ -30,16 +40,34 @@ public:
 			return new RestartRequest(*this);
 		}
 	};
+	//! Upgrade request inter-thread message
+	class UpgradeRequest : public AbstractThreadMessage
+	{
+	public:
+		UpgradeRequest() :
+			AbstractThreadMessage("Upgrade request")
+		{}
+
+		virtual AbstractThreadMessage * clone() const
+		{
+			return new UpgradeRequest(*this);
+		}
+	};
+
+	enum Constants {
+		//! Default timeout to wait for the new server process readiness on upgrade in seconds
+		DefaultUpgradeTimeout = ISL__SERVER_DEFAULT_UPGRADE_TIMEOUT
+	};
 
 	//! Constructor
 	/*!
 	  \note Call this method from the application's main thread only!
 	  \param argc Command-line arguments amount
 	  \param argv Command-line arguments array
-	  \param trackSignals UNIX-signals set to track (default is to track SIGHUP, SIGINT and SIGTERM)
+	  \param trackSignals UNIX-signals set to track (default is to track SIGHUP, SIGINT, SIGTERM and SIGUSR2)
 	  \param clockTimeout Subsystem's clock timeout
 	*/
-	Server(int argc, char * argv[], const SignalSet& trackSignals = SignalSet(3, SIGHUP, SIGINT, SIGTERM),
+	Server(int argc, char * argv[], const SignalSet& trackSignals = SignalSet(4, SIGHUP, SIGINT, SIGTERM, SIGUSR2),
 			const Timeout& clockTimeout = Timeout::defaultTimeout());
 	//! Returns a reference to the thread requester
 	inline ThreadRequesterType& requester()
@@ -66,12 +94,43 @@ public:
 	{
 		return _argv;
 	}
+	//! Returns timeout to wait for the new server process readiness on upgrade
+	inline const Timeout& upgradeTimeout() const
+	{
+		return _upgradeTimeout;
+	}
+	//! Sets timeout to wait for the new server process readiness on upgrade
+	/*!
+	  \param newValue New upgrade timeout
+
+	  \note Thread-unsafe: call it before run() only
+	*/
+	inline void setUpgradeTimeout(const Timeout& newValue)
+	{
+		_upgradeTimeout = newValue;
+	}
 	//! Appoints server restart
 	/*!
+	 * Server stops and starts all subsystems again. Listening sockets are parked in the listening socket registry
+	 * while the services are stopped and are adopted by the new listeners bound to the same addresses, so the
+	 * incoming connections are waiting in the listen backlog instead of being refused.
+	 *
 	 * Could be called from the server's thread or outside.
 	 * \note Thread-safe
 	 */
 	void appointRestart();
+	//! Appoints server upgrade
+	/*!
+	 * Server executes a new server process from the same command-line (the executable is searched in PATH if
+	 * it's name does not contain a slash, like execvp(3) does) passing the listening socket descriptors to it. The old server process keeps serving
+	 * the clients until the new one has started it's subsystems and has reported it's readiness, then it stops
+	 * accepting connections, completes in-flight tasks and terminates. If the new process has not become ready
+	 * for the upgrade timeout, it is killed and the old process continues to serve the clients.
+	 *
+	 * Could be called from the server's thread or outside.
+	 * \note Thread-safe
+	 */
+	void appointUpgrade();
 	//! Appoints a server termination
 	/*!
 	 * Could be called from the server's thread or outside.
@@ -124,7 +183,8 @@ protected:
 	virtual std::auto_ptr<ThreadRequesterType::MessageType> onRequest(const ThreadRequesterType::MessageType& request, bool responseRequired);
 	//! On signal event handler
 	/*!
-	  Default implementation restarts server on SIGHUP signal and terminates it on SIGINT & SIGTERM ones.
+	  Default implementation restarts server on SIGHUP signal, upgrades it on SIGUSR2 signal and terminates it on
+	  SIGINT & SIGTERM ones.
 	  \param signo UNIX-signal number
 	*/
 	virtual void onSignal(int signo);
@@ -149,6 +209,21 @@ private:
 
 	bool hasPendingSignals() const;
 	int extractPendingSignal() const;
+	//! Executes new server process and awaits for it's readiness
+	/*!
+	  \return TRUE if the new server process has become ready
+	*/
+	bool upgrade();
+	//! Returns path to the executable of the command searching it in PATH if the command does not contain a slash
+	/*!
+	  Throws an exception if the executable has not been found.
+
+	  \param command Command to resolve the executable path of, e.g. argv[0]
+	  \return Path to the executable
+	*/
+	static std::string executablePath(const std::string& command);
+	//! Reports readiness to the old server process if this one has been executed on upgrade
+	void notifyUpgradeReadiness();
 
 	std::vector<std::string> _argv;
 	Thread::Handle _threadHandle;
@@ -156,7 +231,9 @@ private:
 	SignalSet _trackSignals;
 	sigset_t _initialSignalMask;
 	bool _shouldRestart;
+	bool _shouldUpgrade;
 	bool _shouldTerminate;
+	Timeout _upgradeTimeout;
 };
 
 } // namespace isl
@@ -0,0 +1,81 @@
+#ifndef ISL__SHARED_BUFFER__HXX
+#define ISL__SHARED_BUFFER__HXX
+
+#include <string>
+#include <stddef.h>
+
+namespace isl
+{
+
+//! Immutable reference-counted byte buffer
+/*!
+  Data is copied once on construction and is shared by all copies of the buffer object, so the message which is
+  fanned out to many consumers (e.g. broadcast message broker clients) is cloned by the reference count increment
+  only. It is freed when the last copy is destroyed. Buffer is also used to keep the payload alive while the kernel
+  is sending it from the user memory, see TcpSocket::sendShared().
+
+  \note Thread-safe: copies of the same buffer could be created and destroyed in different threads
+*/
+class SharedBuffer
+{
+public:
+	//! Constructs an empty buffer
+	SharedBuffer();
+	//! Constructs a buffer with the copy of the data
+	/*!
+	  \param data Pointer to the data to copy
+	  \param size Data size
+	*/
+	SharedBuffer(const char * data, size_t size);
+	//! Constructs a buffer with the copy of the string
+	/*!
+	  \param str String to copy
+	*/
+	explicit SharedBuffer(const std::string& str);
+	//! Copying constructor, which shares the data with the other buffer
+	SharedBuffer(const SharedBuffer& other);
+	//! Destructor
+	~SharedBuffer();
+	//! Assignment operator, which shares the data with the other buffer
+	SharedBuffer& operator=(const SharedBuffer& other);
+
+	//! Returns a pointer to the data or 0 if the buffer is empty
+	inline const char * data() const
+	{
+		return _statePtr ? _statePtr->data : 0;
+	}
+	//! Returns data size
+	inline size_t size() const
+	{
+		return _statePtr ? _statePtr->size : 0;
+	}
+	//! Returns TRUE if the buffer is empty
+	inline bool isEmpty() const
+	{
+		return size() <= 0;
+	}
+	//! Returns TRUE if the buffers are sharing the same data
+	inline bool isSharedWith(const SharedBuffer& other) const
+	{
+		return _statePtr == other._statePtr;
+	}
+private:
+	struct State
+	{
+		State(const char * data, size_t size);
+		~State();
+
+		char * data;
+		size_t size;
+		int refsCount;
+	};
+
+	void init(const char * data, size_t size);
+	void release();
+
+	State * _statePtr;
+};
+
+} // namespace isl
+
+#endif
@@ -438,6 +438,24 @@ public:
 	{
 		_awaitResponseTicksAmount = newValue;
 	}
+	//! Returns placement policy of the subsystem's threads
+	inline const ThreadPlacementPolicy& threadPlacementPolicy() const
+	{
+		return _threadPlacementPolicy;
+	}
+	//! Sets placement policy of the subsystem's threads
+	/*!
+	  N-th thread of the subsystem in the order of the registration is placed according to the N-th placement
+	  of the policy on start, e.g. N-th listener of the TCP-service is bound to the N-th CPU in the pin mode.
+
+	  \param newValue New placement policy
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setThreadPlacementPolicy(const ThreadPlacementPolicy& newValue)
+	{
+		_threadPlacementPolicy = newValue;
+	}
 	//! Starting subsystem virtual method
 	/*!
 	  Default implementation starts all children subsystems and subsystem's threads
@@ -459,6 +477,16 @@ protected:
 	void startThreads();
 	//! Stops state set subsystem's threads
 	void stopThreads();
+	//! Returns the shard's part of the amount, which is split between the shards so the parts sum up to the amount
+	/*!
+	  \param amount Amount to split
+	  \param shardsAmount Amount of the shards, which should be positive
+	  \param shardIndex Index of the shard
+	*/
+	static inline size_t shardShare(size_t amount, size_t shardsAmount, size_t shardIndex)
+	{
+		return amount / shardsAmount + ((shardIndex < amount % shardsAmount) ? 1 : 0);
+	}
 private:
 	Subsystem();
 	Subsystem(const Subsystem&);							// No copy
@@ -480,6 +508,7 @@ private:
 	size_t _awaitResponseTicksAmount;
 	Children _children;
 	Threads _threads;
+	ThreadPlacementPolicy _threadPlacementPolicy;
 };
 
 } // namespace isl
@@ -75,6 +75,16 @@ public:
 		ScanDir,
 		Remove,
 		Unlink,
+		Poll,
+		EpollCreate,
+		EpollCtl,
+		EpollWait,
+		SendMsg,
+		PRead,
+		SendFile,
+		IoUringSetup,
+		IoUringEnter,
+		MMap,
 		// Date & time functions
 		Time,
 		GMTimeR,
@@ -87,7 +97,10 @@ public:
 		// System calls
 		Fork,
 		GetPid,
-		SetSid
+		SetSid,
+		Pipe,
+		WaitPid,
+		Kill
 	};
 	//! Constructs an object from recognized function id
 	/*
@@ -253,6 +266,26 @@ protected:
 				return "remove(3)";
 			case Unlink:
 				return "unlink(2)";
+			case Poll:
+				return "poll(2)";
+			case EpollCreate:
+				return "epoll_create(2)";
+			case EpollCtl:
+				return "epoll_ctl(2)";
+			case EpollWait:
+				return "epoll_wait(2)";
+			case SendMsg:
+				return "sendmsg(2)";
+			case PRead:
+				return "pread(2)";
+			case SendFile:
+				return "sendfile(2)";
+			case IoUringSetup:
+				return "io_uring_setup(2)";
+			case IoUringEnter:
+				return "io_uring_enter(2)";
+			case MMap:
+				return "mmap(2)";
 			// Date & time functions
 			case Time:
 				return "time(3)";
@@ -277,6 +310,12 @@ protected:
 				return "getpid(2)";
 			case SetSid:
 				return "setsid(2)";
+			case Pipe:
+				return "pipe(2)";
+			case WaitPid:
+				return "waitpid(2)";
+			case Kill:
+				return "kill(2)";
 			default:
 				return "[UNKNOWN FUNCTION]";
 		}
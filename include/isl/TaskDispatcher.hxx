@@ -7,12 +7,33 @@
 #include <isl/Thread.hxx>
 #include <isl/LogMessage.hxx>
 #include <isl/ExceptionLogMessage.hxx>
+#include <isl/WorkStealingDeque.hxx>
+#include <isl/LockFreeQueue.hxx>
+#include <sched.h>
 #include <deque>
 #include <list>
+#include <map>
+#include <vector>
 #include <exception>
 #include <sstream>
 #include <memory>
 
+#ifndef ISL__TASK_DISPATCHER_DEFAULT_LOCAL_QUEUE_CAPACITY
+#define ISL__TASK_DISPATCHER_DEFAULT_LOCAL_QUEUE_CAPACITY 256
+#endif
+#ifndef ISL__TASK_DISPATCHER_DEFAULT_MAX_FETCH_BATCH
+#define ISL__TASK_DISPATCHER_DEFAULT_MAX_FETCH_BATCH 32
+#endif
+#ifndef ISL__TASK_DISPATCHER_DEFAULT_MIN_WORKERS
+#define ISL__TASK_DISPATCHER_DEFAULT_MIN_WORKERS 1
+#endif
+#ifndef ISL__TASK_DISPATCHER_DEFAULT_GROW_THRESHOLD
+#define ISL__TASK_DISPATCHER_DEFAULT_GROW_THRESHOLD 10		// Milliseconds
+#endif
+#ifndef ISL__TASK_DISPATCHER_DEFAULT_KEEP_ALIVE
+#define ISL__TASK_DISPATCHER_DEFAULT_KEEP_ALIVE 60		// Seconds
+#endif
+
 namespace isl
 {
 
@@ -22,9 +43,38 @@ namespace isl
   which is one of the prestarted threads pool. If your task object has 2 or more such methods to execute take a
   look at the MultiTaskDispatcher class instead.
 
-  TODO: Add 'max overload' parameter and respective check on task performing operation
+  Pending tasks queue could be limited using setMaxPendingTasks(), so a tasks flood does not increase the latency
+  for everyone. When the queue is full a new task is rejected, or the oldest pending task is discarded to make
+  room for it, or the producer is blocked until the room is available or the overload timeout expires, depending
+  on the overload policy. Use queueWaitEstimate() to stop producing tasks before the queue grows.
 
-  \note Task dispatcher will automatically dispose all pending tasks on stop() operation without execution.
+  In the work-stealing mode (see setWorkStealing()) each worker owns a local deque of tasks. An idle worker fetches
+  a batch of the pending tasks under the lock, so the lock is taken once per batch instead of once per task, and
+  executes them from its local deque, while other idle workers steal the tasks from the local deques of the busy
+  ones without locking. Workers which have found no task anywhere are parked until a new task arrives. Unless the
+  pending tasks queue is limited or the workers are elastic, normal priority tasks without a deadline are not put to
+  the pending tasks queue at all: producers push them to the lock-free injection queues of the workers, so
+  the lock is taken by the producer only to wake up a parked worker.
+
+  In the elastic mode (see setElastic()) the task dispatcher starts the minimum amount of workers only. A new worker
+  is spawned up to the workers amount if the oldest pending task has been waiting longer than the grow threshold
+  with no idling worker, which is checked when a task is performed or fetched by a worker and on each subsystem's
+  clock tick, so the pending task is not waiting for the busy workers to finish their long-running tasks. A worker
+  which has been idling for the keep-alive period is retired unless the minimum amount of workers is running.
+
+  Task could be performed with a priority class and a deadline. Pending tasks of the higher priority class are
+  fetched first, the tasks of the same priority class are fetched in the earliest deadline first order, tasks with
+  no deadline are fetched after them in FIFO order. Task which deadline has passed before the execution is dropped
+  and passed to onTaskExpired(). In the work-stealing mode priorities are applied on fetching the tasks to the
+  workers' local deques.
+
+  Workers are placed according to the workers placement policy (see setWorkersPlacementPolicy()), while the
+  subsystem's thread placement policy is applied to the elastic mode supervisor thread only. N-th worker slot gets
+  N-th placement and is reused by the worker which is spawned after the retirement. In the work-stealing mode local
+  deque is allocated by it's worker, so it is placed on the worker's local NUMA node.
+
+  \note Task dispatcher will automatically dispose all pending tasks on stop() operation without execution unless
+        draining on stop has been enabled using setDrainOnStop().
 
   \tparam T Task object class
 
@@ -35,21 +85,102 @@ namespace isl
 template <typename T> class TaskDispatcher : public Subsystem
 {
 public:
+	enum Constants {
+		DefaultLocalQueueCapacity = ISL__TASK_DISPATCHER_DEFAULT_LOCAL_QUEUE_CAPACITY,
+		DefaultMaxFetchBatch = ISL__TASK_DISPATCHER_DEFAULT_MAX_FETCH_BATCH,
+		DefaultMinWorkers = ISL__TASK_DISPATCHER_DEFAULT_MIN_WORKERS,
+		DefaultGrowThreshold = ISL__TASK_DISPATCHER_DEFAULT_GROW_THRESHOLD,
+		DefaultKeepAlive = ISL__TASK_DISPATCHER_DEFAULT_KEEP_ALIVE
+	};
 	//! Task object's method type definition
 	typedef void (T::*Method)(TaskDispatcher<T>&);
+	//! Task priority class
+	enum Priority {
+		HighPriority,			//!< Latency-sensitive tasks, e.g. health checks or administrative requests
+		NormalPriority,			//!< Default priority class
+		LowPriority,			//!< Bulk tasks
+		PrioritiesAmount		//!< Amount of the priority classes
+	};
+	//! Pending tasks queue overflow policy
+	enum OverloadPolicy {
+		RejectPolicy,			//!< New task is rejected and perform() returns FALSE
+		DropOldestPolicy,		//!< The oldest pending task is discarded without execution to make room for the new one
+		BlockPolicy			//!< Producer is blocked until the room is available or the overload timeout expires
+	};
+	//! Task dispatcher counters
+	struct Counters
+	{
+		Counters() :
+			acceptedTasks(0),
+			rejectedTasks(0),
+			droppedTasks(0),
+			executedTasks(0),
+			totalQueueTime(),
+			maxQueueTime(),
+			spawnedWorkers(0),
+			retiredWorkers(0),
+			maxWorkers(0),
+			expiredTasks(0)
+		{}
+
+		//! Amount of the tasks which have been put to the pending tasks queue
+		size_t acceptedTasks;
+		//! Amount of the tasks which have been rejected due to the pending tasks queue overflow
+		size_t rejectedTasks;
+		//! Amount of the pending tasks which have been discarded by the drop oldest overload policy
+		size_t droppedTasks;
+		//! Amount of the tasks which have been fetched by the workers
+		size_t executedTasks;
+		//! Total time the executed tasks have been waiting in the pending tasks queue
+		Timeout totalQueueTime;
+		//! Maximum time the task has been waiting in the pending tasks queue
+		Timeout maxQueueTime;
+		//! Amount of the workers which have been started
+		size_t spawnedWorkers;
+		//! Amount of the workers which have been retired after the keep-alive period of idling
+		size_t retiredWorkers;
+		//! Maximum amount of the workers which have been running at the same time
+		size_t maxWorkers;
+		//! Amount of the fetched tasks which have been dropped due to the deadline expiration
+		size_t expiredTasks;
+	};
 private:
-	class PendingTask
+	class PendingTask : public LockFreeQueue<PendingTask>::Node
 	{
 	public:
-		PendingTask(TaskDispatcher<T>& dispatcher, T * taskPtr, const Method method) :
+		PendingTask(TaskDispatcher<T>& dispatcher, T * taskPtr, const Method method, Priority priority, const Timestamp& deadline) :
+			LockFreeQueue<PendingTask>::Node(),
 			_dispatcher(dispatcher),
 			_taskAutoPtr(taskPtr),
-			_method(method)
+			_method(method),
+			_priority(priority),
+			_deadline(deadline),
+			_enqueueTimestamp(Timestamp::now())
 		{}
 		inline void execute()
 		{
 			((_taskAutoPtr.get())->*(_method))(_dispatcher);
 		}
+		inline T& task()
+		{
+			return *_taskAutoPtr.get();
+		}
+		inline Priority priority() const
+		{
+			return _priority;
+		}
+		inline const Timestamp& deadline() const
+		{
+			return _deadline;
+		}
+		inline bool isExpired(const Timestamp& now) const
+		{
+			return !_deadline.isZero() && _deadline < now;
+		}
+		inline const Timestamp& enqueueTimestamp() const
+		{
+			return _enqueueTimestamp;
+		}
 	private:
 		PendingTask();
 		PendingTask(const PendingTask&);							// No copy
@@ -58,8 +189,162 @@ private:
 		TaskDispatcher<T>& _dispatcher;
 		std::auto_ptr<T> _taskAutoPtr;
 		Method _method;
+		const Priority _priority;
+		const Timestamp _deadline;
+		const Timestamp _enqueueTimestamp;
+	};
+	// Pending tasks queue of the priority classes, which tasks are ordered by the deadline and then by the enqueue time
+	class PendingTasksQueue
+	{
+	public:
+		PendingTasksQueue() :
+			_size(0),
+			_urgentSize(0)
+		{}
+		inline size_t size() const
+		{
+			return _size;
+		}
+		inline bool empty() const
+		{
+			return _size <= 0;
+		}
+		// Returns the amount of the tasks to be fetched before the normal priority tasks without a deadline, could be called without the lock
+		inline size_t urgentSize() const
+		{
+			return __atomic_load_n(&_urgentSize, __ATOMIC_RELAXED);
+		}
+		void push(PendingTask * pendingTaskPtr)
+		{
+			PriorityClass& priorityClass = _priorityClasses[pendingTaskPtr->priority()];
+			if (pendingTaskPtr->deadline().isZero()) {
+				priorityClass.fifoQueue.push_front(pendingTaskPtr);
+			} else {
+				priorityClass.edfQueue.insert(typename EdfQueue::value_type(pendingTaskPtr->deadline(), pendingTaskPtr));
+			}
+			++_size;
+			if (isUrgent(*pendingTaskPtr)) {
+				__atomic_store_n(&_urgentSize, _urgentSize + 1, __ATOMIC_RELAXED);
+			}
+		}
+		// Returns the most urgent task or 0 if the queue is empty
+		PendingTask * pop()
+		{
+			for (size_t i = 0; i < PrioritiesAmount; ++i) {
+				PriorityClass& priorityClass = _priorityClasses[i];
+				if (!priorityClass.edfQueue.empty()) {
+					PendingTask * pendingTaskPtr = priorityClass.edfQueue.begin()->second;
+					priorityClass.edfQueue.erase(priorityClass.edfQueue.begin());
+					--_size;
+					onPopped(*pendingTaskPtr);
+					return pendingTaskPtr;
+				} else if (!priorityClass.fifoQueue.empty()) {
+					PendingTask * pendingTaskPtr = priorityClass.fifoQueue.back();
+					priorityClass.fifoQueue.pop_back();
+					--_size;
+					onPopped(*pendingTaskPtr);
+					return pendingTaskPtr;
+				}
+			}
+			return 0;
+		}
+		// Returns the oldest task of the lowest priority class or 0 if the queue is empty
+		PendingTask * popLeastUrgent()
+		{
+			for (size_t i = PrioritiesAmount; i > 0; --i) {
+				PriorityClass& priorityClass = _priorityClasses[i - 1];
+				if (!priorityClass.fifoQueue.empty()) {
+					PendingTask * pendingTaskPtr = priorityClass.fifoQueue.back();
+					priorityClass.fifoQueue.pop_back();
+					--_size;
+					onPopped(*pendingTaskPtr);
+					return pendingTaskPtr;
+				} else if (!priorityClass.edfQueue.empty()) {
+					typename EdfQueue::iterator pos = priorityClass.edfQueue.end();
+					PendingTask * pendingTaskPtr = (--pos)->second;
+					priorityClass.edfQueue.erase(pos);
+					--_size;
+					onPopped(*pendingTaskPtr);
+					return pendingTaskPtr;
+				}
+			}
+			return 0;
+		}
+		// Returns the earliest enqueue timestamp of the tasks to be fetched next from each priority class
+		Timestamp oldestEnqueueTimestamp() const
+		{
+			Timestamp result;
+			for (size_t i = 0; i < PrioritiesAmount; ++i) {
+				const PriorityClass& priorityClass = _priorityClasses[i];
+				if (!priorityClass.edfQueue.empty()) {
+					updateOldest(result, priorityClass.edfQueue.begin()->second->enqueueTimestamp());
+				}
+				if (!priorityClass.fifoQueue.empty()) {
+					updateOldest(result, priorityClass.fifoQueue.back()->enqueueTimestamp());
+				}
+			}
+			return result;
+		}
+	private:
+		PendingTasksQueue(const PendingTasksQueue&);						// No copy
+		PendingTasksQueue& operator=(const PendingTasksQueue&);					// No copy
+
+		typedef std::deque<PendingTask *> FifoQueue;
+		typedef std::multimap<Timestamp, PendingTask *> EdfQueue;
+		struct PriorityClass
+		{
+			FifoQueue fifoQueue;
+			EdfQueue edfQueue;
+		};
+
+		static bool isUrgent(const PendingTask& pendingTask)
+		{
+			return pendingTask.priority() < NormalPriority || (pendingTask.priority() == NormalPriority && !pendingTask.deadline().isZero());
+		}
+		void onPopped(const PendingTask& pendingTask)
+		{
+			if (isUrgent(pendingTask)) {
+				__atomic_store_n(&_urgentSize, _urgentSize - 1, __ATOMIC_RELAXED);
+			}
+		}
+		static void updateOldest(Timestamp& oldest, const Timestamp& timestamp)
+		{
+			if (oldest.isZero() || timestamp < oldest) {
+				oldest = timestamp;
+			}
+		}
+
+		PriorityClass _priorityClasses[PrioritiesAmount];
+		size_t _size;
+		size_t _urgentSize;
+	};
+	typedef WorkStealingDeque<PendingTask> LocalQueue;
+	typedef std::vector<LocalQueue *> LocalQueuesContainer;
+	typedef LockFreeQueue<PendingTask> InjectionQueue;
+	typedef std::vector<InjectionQueue *> InjectionQueuesContainer;
+
+	// Checks the need to spawn a worker on each clock tick in the elastic mode
+	class SupervisorThread : public OscillatorThread
+	{
+	public:
+		SupervisorThread(TaskDispatcher<T>& taskDispatcher) :
+			OscillatorThread(taskDispatcher),
+			_taskDispatcher(taskDispatcher)
+		{}
+	private:
+		SupervisorThread();
+		SupervisorThread(const SupervisorThread&);						// No copy
+
+		SupervisorThread& operator=(const SupervisorThread&);					// No copy
+
+		virtual void doLoad(const Timestamp& prevTick, const Timestamp& nextTick, size_t ticksExpired)
+		{
+			MutexLocker locker(_taskDispatcher._cond.mutex());
+			_taskDispatcher.growIfNeeded();
+		}
+
+		TaskDispatcher<T>& _taskDispatcher;
 	};
-	typedef std::deque<PendingTask *> PendingTasksQueue;
 public:
 	//! Constructs new task dispatcher
 	/*!
@@ -70,25 +355,55 @@ public:
 	TaskDispatcher(Subsystem * owner, size_t workersAmount, const Timeout& clockTimeout = Timeout::defaultTimeout()) :
 		Subsystem(owner, clockTimeout),
 		_workersAmount(workersAmount),
+		_maxPendingTasks(0),
+		_overloadPolicy(RejectPolicy),
+		_overloadTimeout(Timeout::defaultTimeout()),
 		_cond(),
+		_roomCond(_cond.mutex()),
+		_parkCond(_cond.mutex()),
 		_shouldTerminate(false),
+		_drainOnStop(false),
+		_workStealing(false),
+		_elastic(false),
+		_minWorkersAmount(DefaultMinWorkers),
+		_growThreshold(static_cast<double>(DefaultGrowThreshold) / 1000.0),
+		_keepAlive(static_cast<double>(DefaultKeepAlive)),
+		_workersPlacementPolicy(ThreadPlacementPolicy::FloatMode, ThreadPlacement::CpusContainer(), "worker"),
+		_supervisorAutoPtr(),
 		_workers(),
+		_retiredWorkers(),
+		_runningWorkersCount(0),
 		_awaitingWorkersCount(0),
-		_pendingTasksQueue()
-	{}
+		_blockedProducersCount(0),
+		_pendingTasksQueue(),
+		_localQueues(),
+		_injectionQueues(),
+		_injectionEnabled(false),
+		_injectedTasksCount(0),
+		_injectedTasksAccepted(0),
+		_nextInjectionQueue(0),
+		_freeWorkerIndexes(),
+		_workerIndexes(),
+		_counters(),
+		_averageQueueTime(0.0)
+	{
+		setThreadPlacementPolicy(ThreadPlacementPolicy(ThreadPlacementPolicy::FloatMode, ThreadPlacement::CpusContainer(), "supervisor"));
+	}
 	virtual ~TaskDispatcher()
 	{
 		resetWorkers();
 		resetPendingTasksQueue();
+		resetLocalQueues();
+		resetInjectionQueues();
 	}
-	//! Returns workers amount
+	//! Returns workers amount, which is the maximum workers amount in the elastic mode
 	inline size_t workersAmount() const
 	{
 		return _workersAmount;
 	}
 	//! Sets workers amount
 	/*!
-	  \param newValue New workers amount
+	  \param newValue New workers amount, which is the maximum workers amount in the elastic mode
 
 	  \note Thread-unsafe: call it when subsystem is idling only
 	*/
@@ -96,6 +411,214 @@ public:
 	{
 		_workersAmount = newValue;
 	}
+	//! Returns maximum amount of the pending tasks, 0 means unlimited
+	inline size_t maxPendingTasks() const
+	{
+		return _maxPendingTasks;
+	}
+	//! Sets maximum amount of the pending tasks
+	/*!
+	  \param newValue New maximum amount of the pending tasks, 0 means unlimited
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxPendingTasks(size_t newValue)
+	{
+		_maxPendingTasks = newValue;
+	}
+	//! Returns pending tasks queue overflow policy
+	inline OverloadPolicy overloadPolicy() const
+	{
+		return _overloadPolicy;
+	}
+	//! Sets pending tasks queue overflow policy
+	/*!
+	  \param newValue New pending tasks queue overflow policy
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setOverloadPolicy(OverloadPolicy newValue)
+	{
+		_overloadPolicy = newValue;
+	}
+	//! Returns maximum time to block the producer for the block overload policy
+	inline const Timeout& overloadTimeout() const
+	{
+		return _overloadTimeout;
+	}
+	//! Sets maximum time to block the producer for the block overload policy
+	/*!
+	  \param newValue New maximum time to wait for the room in the pending tasks queue
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setOverloadTimeout(const Timeout& newValue)
+	{
+		_overloadTimeout = newValue;
+	}
+	//! Returns TRUE if pending tasks are executed on stop
+	inline bool drainOnStop() const
+	{
+		return _drainOnStop;
+	}
+	//! Sets draining of the pending tasks queue on stop
+	/*!
+	  If set, stop() rejects new tasks but does not return until the workers have executed all pending tasks.
+
+	  \param newValue TRUE if to execute pending tasks on stop or FALSE if to dispose them
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setDrainOnStop(bool newValue)
+	{
+		_drainOnStop = newValue;
+	}
+	//! Returns TRUE if the work-stealing mode is on
+	inline bool workStealing() const
+	{
+		return _workStealing;
+	}
+	//! Sets the work-stealing mode
+	/*!
+	  Work-stealing mode reduces the pending tasks queue lock contention when many short tasks are performed
+	  by many workers. Pending tasks limit, overload policy and draining on stop are applied to the tasks which
+	  have not been fetched by the workers yet.
+
+	  If the pending tasks queue is not limited and the elastic mode is off, normal priority tasks without a deadline
+	  bypass the pending tasks queue and it's lock, so they are fetched after the tasks of the higher priority classes
+	  and the tasks with a deadline, but before the low priority tasks.
+
+	  \param newValue TRUE if workers are to fetch the pending tasks by batches to the local deques and to steal them from each other
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setWorkStealing(bool newValue)
+	{
+		_workStealing = newValue;
+	}
+	//! Returns TRUE if the elastic mode is on
+	inline bool elastic() const
+	{
+		return _elastic;
+	}
+	//! Returns minimum workers amount in the elastic mode
+	inline size_t minWorkersAmount() const
+	{
+		return _minWorkersAmount;
+	}
+	//! Returns the time the oldest pending task should wait to spawn a new worker in the elastic mode
+	inline const Timeout& growThreshold() const
+	{
+		return _growThreshold;
+	}
+	//! Returns the time of idling to retire a worker after in the elastic mode
+	inline const Timeout& keepAlive() const
+	{
+		return _keepAlive;
+	}
+	//! Sets the elastic mode
+	/*!
+	  \param newValue TRUE if the workers amount is to vary between the minimum workers amount and the workers amount
+	  \param minWorkersAmount Amount of the workers to start with and to keep running when idling
+	  \param growThreshold The time the oldest pending task should wait with no idling worker to spawn a new worker
+	  \param keepAlive The time of idling to retire a worker after
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setElastic(bool newValue, size_t minWorkersAmount = DefaultMinWorkers,
+			const Timeout& growThreshold = Timeout(static_cast<double>(DefaultGrowThreshold) / 1000.0),
+			const Timeout& keepAlive = Timeout(static_cast<double>(DefaultKeepAlive)))
+	{
+		_elastic = newValue;
+		_minWorkersAmount = minWorkersAmount;
+		_growThreshold = growThreshold;
+		_keepAlive = keepAlive;
+	}
+	//! Returns placement policy of the workers
+	inline const ThreadPlacementPolicy& workersPlacementPolicy() const
+	{
+		return _workersPlacementPolicy;
+	}
+	//! Sets placement policy of the workers
+	/*!
+	  N-th worker slot gets N-th placement of the policy, so the workers of the task dispatchers which are sharing
+	  the CPU set should be given the disjoint thread indexes (see ThreadPlacementPolicy::setFirstThreadIndex()).
+
+	  \param newValue New placement policy of the workers
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setWorkersPlacementPolicy(const ThreadPlacementPolicy& newValue)
+	{
+		_workersPlacementPolicy = newValue;
+	}
+	//! Returns current amount of the running workers
+	/*!
+	  \note Thread-safe
+	*/
+	inline size_t runningWorkersAmount() const
+	{
+		MutexLocker locker(_cond.mutex());
+		return _runningWorkersCount;
+	}
+	//! Returns current amount of the pending tasks including the tasks fetched to the workers' local deques
+	/*!
+	  \note Thread-safe
+	*/
+	inline size_t pendingTasksAmount() const
+	{
+		MutexLocker locker(_cond.mutex());
+		size_t result = _pendingTasksQueue.size() + __atomic_load_n(&_injectedTasksCount, __ATOMIC_ACQUIRE);
+		for (typename LocalQueuesContainer::const_iterator i = _localQueues.begin(); i != _localQueues.end(); ++i) {
+			if (LocalQueue * localQueuePtr = __atomic_load_n(&(*i), __ATOMIC_ACQUIRE)) {
+				result += localQueuePtr->size();
+			}
+		}
+		return result;
+	}
+	//! Returns an estimate of the time the new task is to wait in the pending tasks queue
+	/*!
+	  Estimate is zero if there are idling workers to fetch the new task, otherwise it is the maximum of the time
+	  the oldest pending task has been waiting and the moving average of the recent tasks waiting time.
+	  \note Thread-safe
+	*/
+	Timeout queueWaitEstimate() const
+	{
+		MutexLocker locker(_cond.mutex());
+		if (_pendingTasksQueue.size() + __atomic_load_n(&_injectedTasksCount, __ATOMIC_ACQUIRE) < _awaitingWorkersCount) {
+			return Timeout();
+		}
+		Timeout result(_averageQueueTime);
+		if (!_pendingTasksQueue.empty()) {
+			Timeout oldestTaskQueueTime = Timestamp::now() - _pendingTasksQueue.oldestEnqueueTimestamp();
+			if (oldestTaskQueueTime > result) {
+				result = oldestTaskQueueTime;
+			}
+		}
+		return result;
+	}
+	//! Returns task dispatcher counters
+	/*!
+	  \note Thread-safe
+	*/
+	inline Counters counters() const
+	{
+		MutexLocker locker(_cond.mutex());
+		Counters result(_counters);
+		result.acceptedTasks += __atomic_load_n(&_injectedTasksAccepted, __ATOMIC_RELAXED);
+		return result;
+	}
+	//! Resets task dispatcher counters
+	/*!
+	  \note Thread-safe
+	*/
+	inline void resetCounters()
+	{
+		MutexLocker locker(_cond.mutex());
+		_counters = Counters();
+		_counters.maxWorkers = _runningWorkersCount;
+		__atomic_store_n(&_injectedTasksAccepted, 0, __ATOMIC_RELAXED);
+	}
 	//! Returns if the task dispatcher should be terminated
 	/*!
 	  Call this method periodically during long-live tasks execution for correct subsystem's termination.
@@ -103,8 +626,7 @@ public:
 	*/
 	inline bool shouldTerminate() const
 	{
-		MutexLocker locker(_cond.mutex());
-		return _shouldTerminate;
+		return __atomic_load_n(&_shouldTerminate, __ATOMIC_ACQUIRE);
 	}
 	//! Awaits for task dispatcher termination
 	/*!
@@ -125,11 +647,25 @@ public:
 	/*!
 	  \param taskAutoPtr Reference to the auto-pointer to task object, which is automatically released if the task has been successfully accepted.
 	  \param method Pointer to method of the task to be executed in a separate thread
-	  \return TRUE if the task has been successfully accepted
+	  \return TRUE if the task has been successfully accepted or FALSE if the pending tasks queue is full
 
 	  \note Thread-safe
 	*/
 	inline bool perform(std::auto_ptr<T>& taskAutoPtr, Method method)
+	{
+		return perform(taskAutoPtr, method, NormalPriority);
+	}
+	//! Accepts task for execution it's single method in a separate thread with a priority class and a deadline
+	/*!
+	  \param taskAutoPtr Reference to the auto-pointer to task object, which is automatically released if the task has been successfully accepted.
+	  \param method Pointer to method of the task to be executed in a separate thread
+	  \param priority Priority class of the task
+	  \param deadline Timestamp to start the task execution until, zero timestamp means no deadline
+	  \return TRUE if the task has been successfully accepted or FALSE if the pending tasks queue is full
+
+	  \note Thread-safe
+	*/
+	bool perform(std::auto_ptr<T>& taskAutoPtr, Method method, Priority priority, const Timestamp& deadline = Timestamp())
 	{
 		//return perform(taskAutoPtr, MethodsContainer(1, method));
 		//return true;
@@ -138,58 +674,130 @@ public:
 			Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Empty pointer to task to execute"));
 			return true;
 		}
+		if (priority == NormalPriority && deadline.isZero() && inject(taskAutoPtr.get(), method)) {
+			taskAutoPtr.release();
+			return true;
+		}
 		bool taskPerformed = false;
+		// Dropped task is to be destroyed outside of the critical section
+		std::auto_ptr<PendingTask> droppedTaskAutoPtr;
 		{
 			MutexLocker locker(_cond.mutex());
-			_pendingTasksQueue.push_front(new PendingTask(*this, taskAutoPtr.get(), method));
-			taskPerformed = true;
-			_cond.wakeOne();
+			if (!_shouldTerminate && _maxPendingTasks > 0 && _pendingTasksQueue.size() >= _maxPendingTasks) {
+				if (_overloadPolicy == DropOldestPolicy) {
+					droppedTaskAutoPtr.reset(_pendingTasksQueue.popLeastUrgent());
+					++_counters.droppedTasks;
+				} else if (_overloadPolicy == BlockPolicy) {
+					Timestamp limit = Timestamp::limit(_overloadTimeout);
+					++_blockedProducersCount;
+					while (!_shouldTerminate && _pendingTasksQueue.size() >= _maxPendingTasks) {
+						if (!_roomCond.wait(limit)) {
+							break;
+						}
+					}
+					--_blockedProducersCount;
+				}
+			}
+			if (!_shouldTerminate && (_maxPendingTasks <= 0 || _pendingTasksQueue.size() < _maxPendingTasks)) {
+				_pendingTasksQueue.push(new PendingTask(*this, taskAutoPtr.get(), method, priority, deadline));
+				++_counters.acceptedTasks;
+				growIfNeeded();
+				taskPerformed = true;
+				if (!_workStealing) {
+					_cond.wakeOne();
+				} else if (_awaitingWorkersCount > 0) {
+					_parkCond.wakeOne();
+				}
+			} else {
+				++_counters.rejectedTasks;
+			}
 		}
 		if (taskPerformed) {
 			taskAutoPtr.release();
 		} else {
 			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "No enough workers available"));
 		}
+		if (droppedTaskAutoPtr.get()) {
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "The oldest pending task has been discarded due to the pending tasks queue overflow"));
+		}
 		return taskPerformed;
 	}
 	//! Starts subsystem
 	virtual void start()
 	{
-		// Calling ancestor's method
-		Subsystem::start();
 		_shouldTerminate = false;
 		_awaitingWorkersCount = 0;
-		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating and starting workers"));
+		_runningWorkersCount = 0;
 		for (size_t i = 0; i < _workersAmount; ++i) {
-			std::auto_ptr<Thread> newWorkerAutoPtr(new Thread());
-			Thread * newWorkerPtr = newWorkerAutoPtr.get();
-			_workers.push_back(newWorkerPtr);
-			newWorkerAutoPtr.release();
-			newWorkerPtr->start(*this, &TaskDispatcher<T>::work);
+			_freeWorkerIndexes.push_back(_workersAmount - i - 1);
+		}
+		if (_workStealing) {
+			// Local deques are allocated by the workers
+			_localQueues.assign(_workersAmount, static_cast<LocalQueue *>(0));
+			if (!_elastic && _maxPendingTasks <= 0) {
+				for (size_t i = 0; i < _workersAmount; ++i) {
+					_injectionQueues.push_back(new InjectionQueue());
+				}
+			}
+		}
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating and starting workers"));
+		bool isElastic = _elastic && _minWorkersAmount < _workersAmount;
+		{
+			MutexLocker locker(_cond.mutex());
+			for (size_t i = 0, workersToStart = isElastic ? _minWorkersAmount : _workersAmount; i < workersToStart; ++i) {
+				spawnWorker();
+			}
 		}
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Workers have been created and started"));
+		if (isElastic) {
+			// Supervisor is started by the ancestor's method
+			_supervisorAutoPtr.reset(new SupervisorThread(*this));
+		}
+		// Calling ancestor's method
+		Subsystem::start();
+		__atomic_store_n(&_injectionEnabled, !_injectionQueues.empty(), __ATOMIC_SEQ_CST);
 	}
 	//! Stops subsystem
 	virtual void stop()
 	{
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Stopping workers"));
+		// Producers which have not seen the injection disabled are awaited by the workers on draining or discarded below
+		__atomic_store_n(&_injectionEnabled, false, __ATOMIC_SEQ_CST);
 		// Waking up all workers
 		{
 			MutexLocker locker(_cond.mutex());
-			_shouldTerminate = true;
+			__atomic_store_n(&_shouldTerminate, true, __ATOMIC_RELEASE);
 			_cond.wakeAll();
+			_roomCond.wakeAll();
+			_parkCond.wakeAll();
 		}
 		// Waiting for all workers to terminate
+		// Workers are not spawned or retired after the termination flag has been set
 		for (typename WorkersContainer::iterator i = _workers.begin(); i != _workers.end(); ++i) {
 			(*i)->join();
 		}
+		reapRetiredWorkers();
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Workers have been stopped"));
 		// Disposing workers
 		resetWorkers();
 		// Disposing pending tasks queue
 		resetPendingTasksQueue();
+		resetLocalQueues();
+		resetInjectionQueues();
 		// Calling ancestor's method
 		Subsystem::stop();
+		_supervisorAutoPtr.reset();
+	}
+protected:
+	//! On task deadline expiration event handler, which is called by the worker instead of the task execution
+	/*!
+	  \param task Reference to the task which has not been executed
+	  \param deadline Task's deadline
+	*/
+	virtual void onTaskExpired(T& task, const Timestamp& deadline)
+	{
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Task has been dropped due to the deadline expiration ") <<
+				(Timestamp::now() - deadline).secondsDouble() << " seconds ago");
 	}
 private:
 	TaskDispatcher();
@@ -198,6 +806,7 @@ private:
 	TaskDispatcher& operator=(const TaskDispatcher&);				// No copy
 
 	typedef std::list<Thread *> WorkersContainer;
+	typedef std::map<Thread *, size_t> WorkerIndexesContainer;
 
 	void resetWorkers()
 	{
@@ -205,57 +814,461 @@ private:
 			delete (*i);
 		}
 		_workers.clear();
+		for (typename WorkersContainer::iterator i = _retiredWorkers.begin(); i != _retiredWorkers.end(); ++i) {
+			delete (*i);
+		}
+		_retiredWorkers.clear();
+		_runningWorkersCount = 0;
+		_freeWorkerIndexes.clear();
+		_workerIndexes.clear();
+	}
+	// Should be called with the mutex locked
+	void spawnWorker()
+	{
+		reapRetiredWorkers();
+		if (_freeWorkerIndexes.empty()) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "No free worker slot"));
+		}
+		size_t workerIndex = _freeWorkerIndexes.back();
+		std::auto_ptr<Thread> newWorkerAutoPtr(new Thread());
+		Thread * newWorkerPtr = newWorkerAutoPtr.get();
+		newWorkerPtr->setPlacement(_workersPlacementPolicy.placement(workerIndex));
+		_workers.push_back(newWorkerPtr);
+		newWorkerAutoPtr.release();
+		_workerIndexes[newWorkerPtr] = workerIndex;
+		try {
+			newWorkerPtr->start(*this, &TaskDispatcher<T>::work);
+		} catch (...) {
+			_workerIndexes.erase(newWorkerPtr);
+			_workers.pop_back();
+			delete newWorkerPtr;
+			throw;
+		}
+		_freeWorkerIndexes.pop_back();
+		++_runningWorkersCount;
+		++_counters.spawnedWorkers;
+		if (_runningWorkersCount > _counters.maxWorkers) {
+			_counters.maxWorkers = _runningWorkersCount;
+		}
+	}
+	// Should be called with the mutex locked
+	void growIfNeeded()
+	{
+		if (!_elastic || _shouldTerminate || _runningWorkersCount >= _workersAmount || _awaitingWorkersCount > 0 ||
+				_pendingTasksQueue.empty() || Timestamp::now() - _pendingTasksQueue.oldestEnqueueTimestamp() < _growThreshold) {
+			return;
+		}
+		try {
+			spawnWorker();
+		} catch (std::exception& e) {
+			Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Spawning worker error"));
+			return;
+		}
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Worker has been spawned, ") << _runningWorkersCount << " worker(s) are running");
+	}
+	// Should be called with the mutex locked, returns TRUE if the worker is to exit
+	bool retire(Thread& worker)
+	{
+		if (_shouldTerminate || _runningWorkersCount <= _minWorkersAmount) {
+			return false;
+		}
+		// Retired workers are exiting without the mutex, so they are joined here at once
+		reapRetiredWorkers();
+		for (typename WorkersContainer::iterator i = _workers.begin(); i != _workers.end(); ++i) {
+			if (*i == &worker) {
+				_workers.erase(i);
+				break;
+			}
+		}
+		_retiredWorkers.push_back(&worker);
+		// Worker slot is reused by the next spawned worker
+		typename WorkerIndexesContainer::iterator pos = _workerIndexes.find(&worker);
+		if (pos != _workerIndexes.end()) {
+			_freeWorkerIndexes.push_back(pos->second);
+			_workerIndexes.erase(pos);
+		}
+		--_runningWorkersCount;
+		++_counters.retiredWorkers;
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Worker has been retired, ") << _runningWorkersCount << " worker(s) are running");
+		return true;
+	}
+	void reapRetiredWorkers()
+	{
+		for (typename WorkersContainer::iterator i = _retiredWorkers.begin(); i != _retiredWorkers.end(); ++i) {
+			(*i)->join();
+			delete (*i);
+		}
+		_retiredWorkers.clear();
+	}
+	// Waits for the condition for the keep-alive period in the elastic mode, returns FALSE on timeout
+	bool awaitWork(WaitCondition& cond)
+	{
+		// Awaiting workers counter is read by the producers without the lock after they have injected a task, so
+		// either the producer wakes up the worker or the worker sees the injected task here and does not wait
+		__atomic_add_fetch(&_awaitingWorkersCount, 1, __ATOMIC_SEQ_CST);
+		bool awaken = true;
+		if (__atomic_load_n(&_injectedTasksCount, __ATOMIC_SEQ_CST) > 0) {
+			// Not waiting
+		} else if (_elastic) {
+			awaken = cond.wait(Timestamp::limit(_keepAlive));
+		} else {
+			cond.wait();
+		}
+		__atomic_sub_fetch(&_awaitingWorkersCount, 1, __ATOMIC_SEQ_CST);
+		return awaken;
+	}
+	// Pushes the task to the injection queue, returns FALSE if the task is to be put to the pending tasks queue
+	bool inject(T * taskPtr, Method method)
+	{
+		if (!__atomic_load_n(&_injectionEnabled, __ATOMIC_ACQUIRE)) {
+			return false;
+		}
+		// Injected tasks counter is incremented before the termination check, so the task is seen by the workers on
+		// draining or by stop() on disposal
+		__atomic_add_fetch(&_injectedTasksCount, 1, __ATOMIC_SEQ_CST);
+		if (!__atomic_load_n(&_injectionEnabled, __ATOMIC_SEQ_CST)) {
+			__atomic_sub_fetch(&_injectedTasksCount, 1, __ATOMIC_SEQ_CST);
+			return false;
+		}
+		size_t queueIndex = __atomic_fetch_add(&_nextInjectionQueue, 1, __ATOMIC_RELAXED) % _injectionQueues.size();
+		_injectionQueues[queueIndex]->push(new PendingTask(*this, taskPtr, method, NormalPriority, Timestamp()));
+		__atomic_add_fetch(&_injectedTasksAccepted, 1, __ATOMIC_RELAXED);
+		if (__atomic_load_n(&_awaitingWorkersCount, __ATOMIC_SEQ_CST) > 0) {
+			MutexLocker locker(_cond.mutex());
+			_parkCond.wakeOne();
+		}
+		return true;
 	}
 
 	void resetPendingTasksQueue()
 	{
-		for (typename PendingTasksQueue::iterator i = _pendingTasksQueue.begin(); i != _pendingTasksQueue.end(); ++i) {
-			delete (*i);
+		while (PendingTask * pendingTaskPtr = _pendingTasksQueue.pop()) {
+			delete pendingTaskPtr;
 			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Pending task has been discarded"));
 		}
-		_pendingTasksQueue.clear();
+		for (typename LocalQueuesContainer::iterator i = _localQueues.begin(); i != _localQueues.end(); ++i) {
+			while (PendingTask * pendingTaskPtr = (*i) ? (*i)->steal() : 0) {
+				delete pendingTaskPtr;
+				Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Pending task has been discarded"));
+			}
+		}
+	}
+
+	// Should be called when the workers have been stopped
+	void resetInjectionQueues()
+	{
+		// Waiting for the producers which have incremented the injected tasks counter to push their tasks
+		while (__atomic_load_n(&_injectedTasksCount, __ATOMIC_ACQUIRE) > 0) {
+			bool taskPopped = false;
+			for (typename InjectionQueuesContainer::iterator i = _injectionQueues.begin(); i != _injectionQueues.end(); ++i) {
+				PendingTask * pendingTaskPtr;
+				while ((*i)->pop(&pendingTaskPtr, 1) > 0) {
+					__atomic_sub_fetch(&_injectedTasksCount, 1, __ATOMIC_SEQ_CST);
+					delete pendingTaskPtr;
+					Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Pending task has been discarded"));
+					taskPopped = true;
+				}
+			}
+			if (!taskPopped) {
+				sched_yield();
+			}
+		}
+		for (typename InjectionQueuesContainer::iterator i = _injectionQueues.begin(); i != _injectionQueues.end(); ++i) {
+			delete (*i);
+		}
+		_injectionQueues.clear();
+	}
+
+	void resetLocalQueues()
+	{
+		for (typename LocalQueuesContainer::iterator i = _localQueues.begin(); i != _localQueues.end(); ++i) {
+			delete (*i);
+		}
+		_localQueues.clear();
+	}
+
+	bool localQueuesEmpty() const
+	{
+		for (typename LocalQueuesContainer::const_iterator i = _localQueues.begin(); i != _localQueues.end(); ++i) {
+			LocalQueue * localQueuePtr = __atomic_load_n(&(*i), __ATOMIC_ACQUIRE);
+			if (localQueuePtr && localQueuePtr->size() > 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void updateQueueTime(const Timeout& queueTime)
+	{
+		++_counters.executedTasks;
+		_counters.totalQueueTime += queueTime;
+		if (queueTime > _counters.maxQueueTime) {
+			_counters.maxQueueTime = queueTime;
+		}
+		// Exponentially weighted moving average of the queue time with 0.2 smoothing factor
+		_averageQueueTime += (queueTime.secondsDouble() - _averageQueueTime) * 0.2;
+	}
+
+	void execute(PendingTask& pendingTask)
+	{
+		if (!pendingTask.isExpired(Timestamp::now())) {
+			pendingTask.execute();
+			return;
+		}
+		{
+			MutexLocker locker(_cond.mutex());
+			++_counters.expiredTasks;
+		}
+		onTaskExpired(pendingTask.task(), pendingTask.deadline());
 	}
 
-	void work()
+	void work(Thread& worker)
 	{
+		if (_workStealing) {
+			workStealing(worker);
+			return;
+		}
 		while (true) {
 			std::auto_ptr<PendingTask> pendingTaskAutoPtr;
 			{
 				MutexLocker locker(_cond.mutex());
-				if (_shouldTerminate) {
+				if (_shouldTerminate && (!_drainOnStop || _pendingTasksQueue.empty())) {
 					return;
 				}
-				if (_pendingTasksQueue.empty()) {
-					// Waiting for the next task if the pending tasks queue is empty
-					++_awaitingWorkersCount;
-					_cond.wait();
-					--_awaitingWorkersCount;
-					if (_shouldTerminate) {
+				while (_pendingTasksQueue.empty()) {
+					// Waiting for the next task if the pending tasks queue is empty, the task could be
+					// taken by another worker which has not been waiting, so the wait is repeated
+					bool awaken = awaitWork(_cond);
+					if (_shouldTerminate && (!_drainOnStop || _pendingTasksQueue.empty())) {
 						return;
 					}
-					if (!_pendingTasksQueue.empty()) {
-						pendingTaskAutoPtr.reset(_pendingTasksQueue.back());
-						_pendingTasksQueue.pop_back();
+					if (!awaken && _pendingTasksQueue.empty() && retire(worker)) {
+						return;
 					}
-				} else {
-					pendingTaskAutoPtr.reset(_pendingTasksQueue.back());
-					_pendingTasksQueue.pop_back();
 				}
+				pendingTaskAutoPtr.reset(_pendingTasksQueue.pop());
+				updateQueueTime(Timestamp::now() - pendingTaskAutoPtr->enqueueTimestamp());
+				if (_blockedProducersCount > 0) {
+					_roomCond.wakeOne();
+				}
+				growIfNeeded();
+			}
+			execute(*pendingTaskAutoPtr.get());
+		}
+	}
+
+	void workStealing(Thread& worker)
+	{
+		size_t workerIndex;
+		{
+			MutexLocker locker(_cond.mutex());
+			workerIndex = _workerIndexes[&worker];
+			if (!_localQueues[workerIndex]) {
+				// Local deque is allocated and first touched by the placed worker, so it is on the worker's local NUMA node
+				__atomic_store_n(&_localQueues[workerIndex], new LocalQueue(DefaultLocalQueueCapacity), __ATOMIC_RELEASE);
+			}
+		}
+		LocalQueue& localQueue = *_localQueues[workerIndex];
+		// Xorshift random generator state to pick the victim to steal from
+		unsigned int seed = workerIndex + 1;
+		while (true) {
+			if (__atomic_load_n(&_shouldTerminate, __ATOMIC_ACQUIRE) && !_drainOnStop) {
+				return;
+			}
+			PendingTask * pendingTaskPtr = localQueue.pop();
+			if (!pendingTaskPtr && _pendingTasksQueue.urgentSize() <= 0) {
+				// More urgent pending tasks are fetched before the injected ones
+				pendingTaskPtr = fetchInjected(workerIndex);
 			}
-			if (pendingTaskAutoPtr.get()) {
-				pendingTaskAutoPtr->execute();
+			if (!pendingTaskPtr) {
+				pendingTaskPtr = steal(workerIndex, seed);
+			}
+			if (!pendingTaskPtr && !fetch(worker, workerIndex, pendingTaskPtr)) {
+				return;
+			}
+			if (pendingTaskPtr) {
+				std::auto_ptr<PendingTask> pendingTaskAutoPtr(pendingTaskPtr);
+				execute(*pendingTaskAutoPtr.get());
 			} else {
-				Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "No pending task for worker"));
+				// Tasks are being fetched or injected by the other threads at the moment, giving them the CPU to finish
+				sched_yield();
+			}
+		}
+	}
+
+	PendingTask * steal(size_t workerIndex, unsigned int& seed)
+	{
+		size_t queuesAmount = _localQueues.size();
+		if (queuesAmount <= 1) {
+			return 0;
+		}
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		size_t victimIndex = seed % queuesAmount;
+		for (size_t i = 0; i < queuesAmount; ++i, victimIndex = (victimIndex + 1) % queuesAmount) {
+			if (victimIndex == workerIndex) {
+				continue;
+			}
+			LocalQueue * victimQueuePtr = __atomic_load_n(&_localQueues[victimIndex], __ATOMIC_ACQUIRE);
+			if (!victimQueuePtr) {
+				continue;
+			}
+			if (PendingTask * pendingTaskPtr = victimQueuePtr->steal()) {
+				return pendingTaskPtr;
+			}
+		}
+		return 0;
+	}
+
+	// Fetches a batch of the injected tasks from the injection queues starting from the worker's own one: the first one
+	// is returned, the rest are pushed to the local deque. Returns 0 if there are no injected tasks to fetch.
+	PendingTask * fetchInjected(size_t workerIndex)
+	{
+		size_t queuesAmount = _injectionQueues.size();
+		if (queuesAmount <= 0 || __atomic_load_n(&_injectedTasksCount, __ATOMIC_ACQUIRE) <= 0) {
+			return 0;
+		}
+		LocalQueue& localQueue = *_localQueues[workerIndex];
+		size_t batchSize = localQueue.room() + 1;
+		if (batchSize > DefaultMaxFetchBatch) {
+			batchSize = DefaultMaxFetchBatch;
+		}
+		PendingTask * fetchedTasks[DefaultMaxFetchBatch];
+		size_t fetchedTasksAmount = 0;
+		for (size_t i = 0; i < queuesAmount && fetchedTasksAmount < batchSize; ++i) {
+			fetchedTasksAmount += _injectionQueues[(workerIndex + i) % queuesAmount]->pop(fetchedTasks + fetchedTasksAmount,
+					batchSize - fetchedTasksAmount);
+		}
+		if (fetchedTasksAmount <= 0) {
+			return 0;
+		}
+		__atomic_sub_fetch(&_injectedTasksCount, fetchedTasksAmount, __ATOMIC_SEQ_CST);
+		MutexLocker locker(_cond.mutex());
+		// Queue time is updated before the tasks are pushed to the local deque, where they could be stolen and destroyed
+		Timestamp now = Timestamp::now();
+		for (size_t i = 0; i < fetchedTasksAmount; ++i) {
+			updateQueueTime(now - fetchedTasks[i]->enqueueTimestamp());
+		}
+		// Local deque is filled under the lock, so the parking workers do not miss the tasks to steal
+		for (size_t i = fetchedTasksAmount; i > 1; --i) {
+			localQueue.push(fetchedTasks[i - 1]);
+		}
+		wakeParkedWorkers(fetchedTasksAmount - 1);
+		return fetchedTasks[0];
+	}
+
+	// Should be called with the mutex locked, wakes up the parked workers to steal the tasks from the local deque
+	void wakeParkedWorkers(size_t tasksAmount)
+	{
+		if (tasksAmount <= 0 || _awaitingWorkersCount <= 0) {
+			return;
+		}
+		if (tasksAmount >= _awaitingWorkersCount) {
+			_parkCond.wakeAll();
+		} else {
+			for (size_t i = 0; i < tasksAmount; ++i) {
+				_parkCond.wakeOne();
+			}
+		}
+	}
+
+	// Fetches a batch of the pending tasks: the oldest one is returned, the rest are pushed to the local deque.
+	// Parks the worker if there are no tasks to fetch or to steal. Returns FALSE if the worker should exit.
+	bool fetch(Thread& worker, size_t workerIndex, PendingTask *& pendingTaskPtr)
+	{
+		LocalQueue& localQueue = *_localQueues[workerIndex];
+		MutexLocker locker(_cond.mutex());
+		while (true) {
+			size_t injectedTasksCount = __atomic_load_n(&_injectedTasksCount, __ATOMIC_SEQ_CST);
+			if (injectedTasksCount > 0 && _pendingTasksQueue.urgentSize() <= 0) {
+				// Injected tasks are fetched before the low priority ones
+				return true;
+			}
+			if (!_pendingTasksQueue.empty()) {
+				// Fair share of the pending tasks
+				size_t batchSize = (_pendingTasksQueue.size() + _workersAmount - 1) / _workersAmount;
+				if (injectedTasksCount > 0 && batchSize > _pendingTasksQueue.urgentSize()) {
+					batchSize = _pendingTasksQueue.urgentSize();
+				}
+				if (batchSize > DefaultMaxFetchBatch) {
+					batchSize = DefaultMaxFetchBatch;
+				}
+				if (batchSize > localQueue.room() + 1) {
+					batchSize = localQueue.room() + 1;
+				}
+				Timestamp now = Timestamp::now();
+				PendingTask * fetchedTasks[DefaultMaxFetchBatch];
+				for (size_t i = 0; i < batchSize; ++i) {
+					fetchedTasks[i] = _pendingTasksQueue.pop();
+					updateQueueTime(now - fetchedTasks[i]->enqueueTimestamp());
+				}
+				// The most urgent task is executed at once, the rest are pushed in the reverse order, so the owner pops
+				// them in the order of urgency, while the least urgent ones are stolen first
+				pendingTaskPtr = fetchedTasks[0];
+				for (size_t i = batchSize; i > 1; --i) {
+					localQueue.push(fetchedTasks[i - 1]);
+				}
+				// Waking up parked workers to steal the rest of the batch
+				wakeParkedWorkers(batchSize - 1);
+				if (_blockedProducersCount > 0) {
+					if (batchSize > 1) {
+						_roomCond.wakeAll();
+					} else {
+						_roomCond.wakeOne();
+					}
+				}
+				growIfNeeded();
+				return true;
+			}
+			// Local deques are filled under the lock, so the tasks to steal are not missed here, while the injected tasks
+			// are counted before they are pushed to the injection queues
+			bool nothingToSteal = localQueuesEmpty() && injectedTasksCount <= 0;
+			if (_shouldTerminate && (!_drainOnStop || nothingToSteal)) {
+				return false;
+			}
+			if (!nothingToSteal) {
+				return true;
+			}
+			if (!awaitWork(_parkCond) && _pendingTasksQueue.empty() && localQueuesEmpty() && retire(worker)) {
+				// Local deque of the retired worker is empty, so it is owned by the next worker in the same slot
+				return false;
 			}
 		}
 	}
 
 	size_t _workersAmount;
+	size_t _maxPendingTasks;
+	OverloadPolicy _overloadPolicy;
+	Timeout _overloadTimeout;
 	mutable WaitCondition _cond;
+	WaitCondition _roomCond;
+	WaitCondition _parkCond;
 	bool _shouldTerminate;
+	bool _drainOnStop;
+	bool _workStealing;
+	bool _elastic;
+	size_t _minWorkersAmount;
+	Timeout _growThreshold;
+	Timeout _keepAlive;
+	ThreadPlacementPolicy _workersPlacementPolicy;
+	std::auto_ptr<SupervisorThread> _supervisorAutoPtr;
 	WorkersContainer _workers;
+	WorkersContainer _retiredWorkers;
+	size_t _runningWorkersCount;
 	size_t _awaitingWorkersCount;
+	size_t _blockedProducersCount;
 	PendingTasksQueue _pendingTasksQueue;
+	LocalQueuesContainer _localQueues;
+	InjectionQueuesContainer _injectionQueues;
+	bool _injectionEnabled;
+	size_t _injectedTasksCount;
+	size_t _injectedTasksAccepted;
+	size_t _nextInjectionQueue;
+	std::vector<size_t> _freeWorkerIndexes;
+	WorkerIndexesContainer _workerIndexes;
+	Counters _counters;
+	double _averageQueueTime;
 
 	friend class Thread;
 };
@@ -64,6 +64,7 @@ public:
 		_port(0),
 		_hostAsAddress(false),
 		_addrinfo(0),
+		_addrinfoCopied(false),
 		_endpoints(),
 		_canonicalName()
 	{
@@ -82,6 +83,7 @@ public:
 		_port(port),
 		_hostAsAddress(false),
 		_addrinfo(0),
+		_addrinfoCopied(false),
 		_endpoints(),
 		_canonicalName()
 	{
@@ -94,6 +96,7 @@ public:
 		_port(0),
 		_hostAsAddress(hostAsAddress),
 		_addrinfo(0),
+		_addrinfoCopied(false),
 		_endpoints(),
 		_canonicalName()
 	{
@@ -106,6 +109,7 @@ public:
 		_port(port),
 		_hostAsAddress(false),
 		_addrinfo(0),
+		_addrinfoCopied(false),
 		_endpoints(),
 		_canonicalName()
 	{
@@ -118,6 +122,7 @@ public:
 		_port(port),
 		_hostAsAddress(hostAsAddress),
 		_addrinfo(0),
+		_addrinfoCopied(false),
 		_endpoints(),
 		_canonicalName()
 	{
@@ -136,11 +141,34 @@ public:
 		_port(0),
 		_hostAsAddress(false),
 		_addrinfo(0),
+		_addrinfoCopied(false),
 		_endpoints(),
 		_canonicalName()
 	{
 		init();
 	}
+	//! Constructs TCP-address info from the socket address structure
+	/*!
+	  Host is passed to getaddrinfo(3) in the numeric form, so no name resolution is performed.
+
+	  \param addr Pointer to the socket address structure of AF_INET or AF_INET6 family
+	*/
+	explicit TcpAddrInfo(const struct sockaddr * addr) :
+		_family(addr->sa_family == AF_INET6 ? IpV6 : IpV4),
+		_host(),
+		_service(),
+		_port(0),
+		_hostAsAddress(true),
+		_addrinfo(0),
+		_addrinfoCopied(false),
+		_endpoints(),
+		_canonicalName()
+	{
+		Endpoint ep = endpoint(addr);
+		_host = ep.host;
+		_port = ep.port;
+		init();
+	}
 	/*TcpAddrInfo(Family family, const std::string& host, const std::string& service, bool hostAsAddress) :
 		_family(family),
 		_host(host),
@@ -148,6 +176,7 @@ public:
 		_port(0),
 		_hostAsAddress(hostAsAddress),
 		_addrinfo(0),
+		_addrinfoCopied(false),
 		_endpoints(),
 		_canonicalName()
 	{
@@ -155,6 +184,8 @@ public:
 	}*/
 	//! Copying constructor
 	/*!
+	  Resolved addresses are copied from the other instance, so no name resolution is performed.
+
 	  \param other Other TCP-address info instance to copy from
 	*/
 	TcpAddrInfo(const TcpAddrInfo& other) :
@@ -163,12 +194,11 @@ public:
 		_service(other._service),
 		_port(other._port),
 		_hostAsAddress(other._hostAsAddress),
-		_addrinfo(0),
-		_endpoints(),
-		_canonicalName()
-	{
-		init();
-	}
+		_addrinfo(copyAddrInfo(other._addrinfo)),
+		_addrinfoCopied(true),
+		_endpoints(other._endpoints),
+		_canonicalName(other._canonicalName)
+	{}
 	//! Destructor
 	~TcpAddrInfo()
 	{
@@ -176,6 +206,8 @@ public:
 	}
 	//! Assignment operator
 	/*!
+	  Resolved addresses are copied from the other instance, so no name resolution is performed.
+
 	  \param other Other TCP-address info instance to assign from
 	*/
 	TcpAddrInfo& operator=(const TcpAddrInfo& other)
@@ -183,17 +215,24 @@ public:
 		if (&other == this) {
 			return *this;
 		}
+		struct addrinfo * newAddrInfo = copyAddrInfo(other._addrinfo);
 		_family = other._family;
 		_host = other._host;
 		_service = other._service;
 		_port = other._port;
 		_hostAsAddress = other._hostAsAddress;
 		resetAddrInfo();
-		_endpoints.clear();
-		_canonicalName.clear();
-		init();
+		_addrinfo = newAddrInfo;
+		_addrinfoCopied = true;
+		_endpoints = other._endpoints;
+		_canonicalName = other._canonicalName;
 		return *this;
 	}
+	//! Returns address family
+	inline Family family() const
+	{
+		return _family;
+	}
 	//! Returns initial hostname/address
 	inline const std::string& host() const
 	{
@@ -229,6 +268,30 @@ public:
 	{
 		return _addrinfo;
 	}
+	//! Returns an endpoint of the socket address structure
+	/*!
+	  \param addr Pointer to the socket address structure of AF_INET or AF_INET6 family
+	*/
+	static Endpoint endpoint(const struct sockaddr * addr)
+	{
+		if (addr->sa_family == AF_INET) {
+			const struct sockaddr_in * addrPtr = reinterpret_cast<const struct sockaddr_in *>(addr);
+			char buf[INET_ADDRSTRLEN];
+			if (!inet_ntop(AF_INET, &(addrPtr->sin_addr), buf, INET_ADDRSTRLEN)) {
+				throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::InetNToP, errno));
+			}
+			return Endpoint(buf, ntohs(addrPtr->sin_port));
+		} else if (addr->sa_family == AF_INET6) {
+			const struct sockaddr_in6 * addrPtr = reinterpret_cast<const struct sockaddr_in6 *>(addr);
+			char buf[INET6_ADDRSTRLEN];
+			if (!inet_ntop(AF_INET6, &(addrPtr->sin6_addr), buf, INET6_ADDRSTRLEN)) {
+				throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::InetNToP, errno));
+			}
+			return Endpoint(buf, ntohs(addrPtr->sin6_port));
+		} else {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Invalid address family"));
+		}
+	}
 	//! Loopback interface address predefined value
 	static const char LoopbackAddress[];
 	//! Wildcard interface address predefined value
@@ -255,9 +318,10 @@ private:
 			hints.ai_flags |= AI_PASSIVE;
 		}
 		if ((_host != WildcardAddress) && (_host != LoopbackAddress)) {
-			hints.ai_flags |= AI_CANONNAME;
 			if (_hostAsAddress) {
 				hints.ai_flags |= AI_NUMERICHOST;
+			} else {
+				hints.ai_flags |= AI_CANONNAME;
 			}
 		}
 		int status = getaddrinfo((_host == LoopbackAddress) || (_host == WildcardAddress) ? 0 : _host.c_str(), serviceStr.empty() ? 0 : serviceStr.c_str(), &hints, &_addrinfo);
@@ -274,7 +338,7 @@ private:
 				_endpoints.push_back(Endpoint(addr, ntohs(reinterpret_cast<sockaddr_in *>(curAddrInfo->ai_addr)->sin_port)));
 			} else if (curAddrInfo->ai_family == AF_INET6) {
 				char addr[INET6_ADDRSTRLEN];
-				if (!inet_ntop(AF_INET, &(reinterpret_cast<sockaddr_in6 *>(curAddrInfo->ai_addr)->sin6_addr), addr, INET_ADDRSTRLEN)) {
+				if (!inet_ntop(AF_INET6, &(reinterpret_cast<sockaddr_in6 *>(curAddrInfo->ai_addr)->sin6_addr), addr, INET6_ADDRSTRLEN)) {
 					throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::InetNToP, errno));
 				}
 				_endpoints.push_back(Endpoint(addr, ntohs(reinterpret_cast<sockaddr_in6 *>(curAddrInfo->ai_addr)->sin6_port)));
@@ -289,10 +353,20 @@ private:
 	}
 	inline void resetAddrInfo()
 	{
-		if (_addrinfo) {
+		if (!_addrinfo) {
+			return;
+		}
+		if (_addrinfoCopied) {
+			freeAddrInfoCopy(_addrinfo);
+		} else {
 			freeaddrinfo(_addrinfo);
 		}
+		_addrinfo = 0;
 	}
+	//! Makes a deep copy of the getaddrinfo(3) result, which should be disposed by freeAddrInfoCopy()
+	static struct addrinfo * copyAddrInfo(const struct addrinfo * addrInfo);
+	//! Disposes a copy of the getaddrinfo(3) result
+	static void freeAddrInfoCopy(struct addrinfo * addrInfo);
 
 	Family _family;
 	std::string _host;
@@ -300,6 +374,7 @@ private:
 	unsigned int _port;
 	bool _hostAsAddress;
 	struct addrinfo * _addrinfo;
+	bool _addrinfoCopied;
 	EndpointList _endpoints;
 	std::string _canonicalName;
 };
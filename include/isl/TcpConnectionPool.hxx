@@ -0,0 +1,335 @@
+#ifndef ISL__TCP_CONNECTION_POOL__HXX
+#define ISL__TCP_CONNECTION_POOL__HXX
+
+#include <isl/Subsystem.hxx>
+#include <isl/TcpSocket.hxx>
+#include <isl/TcpAddrInfo.hxx>
+#include <isl/TcpSocketOptions.hxx>
+#include <isl/HttpResponseParser.hxx>
+#include <isl/WaitCondition.hxx>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#ifndef ISL__TCP_CONNECTION_POOL_DEFAULT_MIN_IDLE_CONNECTIONS
+#define ISL__TCP_CONNECTION_POOL_DEFAULT_MIN_IDLE_CONNECTIONS 0
+#endif
+#ifndef ISL__TCP_CONNECTION_POOL_DEFAULT_MAX_IDLE_CONNECTIONS
+#define ISL__TCP_CONNECTION_POOL_DEFAULT_MAX_IDLE_CONNECTIONS 8
+#endif
+#ifndef ISL__TCP_CONNECTION_POOL_DEFAULT_MAX_CONNECTIONS
+#define ISL__TCP_CONNECTION_POOL_DEFAULT_MAX_CONNECTIONS 32
+#endif
+#ifndef ISL__TCP_CONNECTION_POOL_DEFAULT_IDLE_TIMEOUT
+#define ISL__TCP_CONNECTION_POOL_DEFAULT_IDLE_TIMEOUT 30			// Seconds
+#endif
+#ifndef ISL__TCP_CONNECTION_POOL_DEFAULT_CONNECT_TIMEOUT
+#define ISL__TCP_CONNECTION_POOL_DEFAULT_CONNECT_TIMEOUT 5			// Seconds
+#endif
+
+namespace isl
+{
+
+//! Pool of the outbound TCP-connections
+/*!
+  Keeps established connections to the upstreams per endpoint (the first endpoint of the address info), so the
+  client-side request/response exchanges do not pay for the connection establishing and teardown each time.
+
+  Connection is borrowed from the pool using borrow() and given back using giveBack() after the exchange has
+  been completed, or using the Lease RAII-helper, which closes the connection if it has not been given back
+  explicitly (e.g. the exchange has been interrupted by an exception). Most recently given back connection is
+  borrowed first, so the rarely used ones are expiring.
+
+  Each idle connection is checked on checkout: it is discarded if it has been idling longer than the idle
+  timeout or if the peer has closed it or has sent unsolicited data (peeking the socket with MSG_PEEK).
+  The check is made out of the pool's lock, so the system calls are not serializing the borrowers of all
+  endpoints. If the maximum amount of connections to the endpoint has been reached, borrow() waits for the
+  connection to be given back for the timeout.
+
+  Evictor thread of the running pool closes expired and dead idle connections on each clock tick and
+  establishes connections up to the minimum idle amount to each known endpoint.
+
+  \note Thread-safe
+*/
+class TcpConnectionPool : public Subsystem
+{
+public:
+	enum Constants {
+		//! Default minimum amount of the idle connections per endpoint
+		DefaultMinIdleConnections = ISL__TCP_CONNECTION_POOL_DEFAULT_MIN_IDLE_CONNECTIONS,
+		//! Default maximum amount of the idle connections per endpoint
+		DefaultMaxIdleConnections = ISL__TCP_CONNECTION_POOL_DEFAULT_MAX_IDLE_CONNECTIONS,
+		//! Default maximum amount of the connections per endpoint
+		DefaultMaxConnections = ISL__TCP_CONNECTION_POOL_DEFAULT_MAX_CONNECTIONS,
+		//! Default idle connection timeout in seconds
+		DefaultIdleTimeout = ISL__TCP_CONNECTION_POOL_DEFAULT_IDLE_TIMEOUT,
+		//! Default connection establishing timeout in seconds
+		DefaultConnectTimeout = ISL__TCP_CONNECTION_POOL_DEFAULT_CONNECT_TIMEOUT
+	};
+
+	//! Borrowed connection RAII-helper
+	/*!
+	  Borrows the connection on construction and closes it on destruction if it has not been given back.
+	*/
+	class Lease
+	{
+	public:
+		//! Borrows the connection
+		/*!
+		  \param pool Reference to the connection pool
+		  \param addrInfo Upstream address info
+		  \param timeout Timeout to wait for the connection if the maximum amount of connections has been reached
+		*/
+		Lease(TcpConnectionPool& pool, const TcpAddrInfo& addrInfo, const Timeout& timeout = Timeout::defaultTimeout());
+		//! Closes the connection if it has not been given back
+		~Lease();
+
+		//! Returns TRUE if the connection has been borrowed
+		inline bool isValid() const
+		{
+			return _socketAutoPtr.get();
+		}
+		//! Returns a reference to the borrowed connection socket
+		TcpSocket& socket();
+		//! Gives the connection back to the pool
+		/*!
+		  \param reusable Keep the connection in the pool or close it otherwise
+		*/
+		void giveBack(bool reusable = true);
+		//! Gives the connection back to the pool after the HTTP-exchange
+		/*!
+		  \param parser Constant reference to the parser of the response, which has been read from the connection
+		*/
+		inline void giveBack(const HttpResponseParser& parser)
+		{
+			giveBack(TcpConnectionPool::isReusable(parser));
+		}
+	private:
+		Lease();
+		Lease(const Lease&);								// No copy
+
+		Lease& operator=(const Lease&);							// No copy
+
+		TcpConnectionPool& _pool;
+		const TcpAddrInfo _addrInfo;
+		std::auto_ptr<TcpSocket> _socketAutoPtr;
+	};
+
+	//! Constructor
+	/*!
+	  \param owner Pointer to the owner subsystem
+	  \param clockTimeout Subsystem's clock timeout, which is an idle connections eviction interval
+	*/
+	TcpConnectionPool(Subsystem * owner, const Timeout& clockTimeout = Timeout::defaultTimeout());
+	//! Destructor
+	virtual ~TcpConnectionPool();
+
+	//! Returns minimum amount of the idle connections per endpoint
+	inline size_t minIdleConnections() const
+	{
+		return _minIdleConnections;
+	}
+	//! Sets minimum amount of the idle connections per endpoint
+	/*!
+	  \param newValue New minimum amount of the idle connections, which are established by the evictor thread
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMinIdleConnections(size_t newValue)
+	{
+		_minIdleConnections = newValue;
+	}
+	//! Returns maximum amount of the idle connections per endpoint
+	inline size_t maxIdleConnections() const
+	{
+		return _maxIdleConnections;
+	}
+	//! Sets maximum amount of the idle connections per endpoint
+	/*!
+	  \param newValue New maximum amount of the idle connections, connections given back over it are closed
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxIdleConnections(size_t newValue)
+	{
+		_maxIdleConnections = newValue;
+	}
+	//! Returns maximum amount of the idle and borrowed connections per endpoint
+	inline size_t maxConnections() const
+	{
+		return _maxConnections;
+	}
+	//! Sets maximum amount of the idle and borrowed connections per endpoint
+	/*!
+	  \param newValue New maximum amount of the connections
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setMaxConnections(size_t newValue)
+	{
+		_maxConnections = newValue;
+	}
+	//! Returns idle connection timeout
+	inline const Timeout& idleTimeout() const
+	{
+		return _idleTimeout;
+	}
+	//! Sets idle connection timeout
+	/*!
+	  Should be less than the upstream's keep-alive timeout, so the connection is not closed by the peer
+	  while the request is being sent.
+
+	  \param newValue New idle connection timeout
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setIdleTimeout(const Timeout& newValue)
+	{
+		_idleTimeout = newValue;
+	}
+	//! Returns connection establishing timeout
+	inline const Timeout& connectTimeout() const
+	{
+		return _connectTimeout;
+	}
+	//! Sets connection establishing timeout
+	/*!
+	  \param newValue New connection establishing timeout
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setConnectTimeout(const Timeout& newValue)
+	{
+		_connectTimeout = newValue;
+	}
+	//! Returns tuning profile of the connection sockets
+	inline const TcpSocketOptions& socketOptions() const
+	{
+		return _socketOptions;
+	}
+	//! Sets tuning profile of the connection sockets, e.g. TcpSocketOptions::lowLatency()
+	/*!
+	  \param newValue New socket tuning profile, which is applied to the socket before the connection is established
+
+	  \note Thread-unsafe: call it when subsystem is idling only
+	*/
+	inline void setSocketOptions(const TcpSocketOptions& newValue)
+	{
+		_socketOptions = newValue;
+	}
+	//! Borrows a connection to the upstream
+	/*!
+	  Returns healthy idle connection if any or establishes a new one if the maximum amount of the connections has
+	  not been reached, otherwise waits for the connection to be given back. Throws an exception if the connection
+	  could not be established.
+
+	  \param addrInfo Upstream address info
+	  \param timeout Timeout to wait for the connection if the maximum amount of connections has been reached
+	  \return Auto-pointer to the connected socket or to 0 if the timeout has been expired
+	*/
+	std::auto_ptr<TcpSocket> borrow(const TcpAddrInfo& addrInfo, const Timeout& timeout = Timeout::defaultTimeout());
+	//! Gives the borrowed connection back to the pool
+	/*!
+	  \param addrInfo Upstream address info the connection has been borrowed for
+	  \param socketAutoPtr Auto-pointer to the borrowed socket
+	  \param reusable Keep the connection in the pool or close it otherwise, pass FALSE if the exchange has not been
+	                  completed or the peer is going to close the connection
+	*/
+	void giveBack(const TcpAddrInfo& addrInfo, std::auto_ptr<TcpSocket> socketAutoPtr, bool reusable = true);
+	//! Returns amount of the idle connections to the upstream
+	/*!
+	  \param addrInfo Upstream address info
+	*/
+	size_t idleAmount(const TcpAddrInfo& addrInfo) const;
+	//! Returns amount of the borrowed connections to the upstream
+	/*!
+	  \param addrInfo Upstream address info
+	*/
+	size_t borrowedAmount(const TcpAddrInfo& addrInfo) const;
+	//! Closes all idle connections
+	void closeIdle();
+	//! Inspects if the connection could be reused after the HTTP-exchange
+	/*!
+	  \param parser Constant reference to the parser of the response, which has been read from the connection
+	  \return TRUE if the response has been completely read, it's version is HTTP/1.1 and it has no
+	          "Connection: close" header
+	*/
+	static bool isReusable(const HttpResponseParser& parser);
+	//! Stopping subsystem method redefinition
+	virtual void stop();
+private:
+	TcpConnectionPool();
+	TcpConnectionPool(const TcpConnectionPool&);						// No copy
+
+	TcpConnectionPool& operator=(const TcpConnectionPool&);					// No copy
+
+	struct IdleConnection
+	{
+		IdleConnection(TcpSocket * socketPtr, const Timestamp& since) :
+			socketPtr(socketPtr),
+			since(since)
+		{}
+
+		TcpSocket * socketPtr;
+		Timestamp since;
+	};
+	typedef std::list<IdleConnection> IdleConnectionsContainer;
+	struct Slot
+	{
+		Slot(const TcpAddrInfo& addrInfo) :
+			addrInfo(addrInfo),
+			idleConnections(),
+			borrowedAmount(0)
+		{}
+
+		TcpAddrInfo addrInfo;
+		IdleConnectionsContainer idleConnections;
+		size_t borrowedAmount;
+	};
+	typedef std::map<std::string, Slot> SlotsContainer;
+	typedef std::list<TcpSocket *> SocketsContainer;
+	typedef std::list<TcpAddrInfo> AddrInfosContainer;
+	typedef std::list<std::pair<std::string, IdleConnection> > KeyedIdleConnectionsContainer;
+
+	class EvictorThread : public OscillatorThread
+	{
+	public:
+		EvictorThread(TcpConnectionPool& pool);
+	private:
+		EvictorThread();
+		EvictorThread(const EvictorThread&);						// No copy
+
+		EvictorThread& operator=(const EvictorThread&);					// No copy
+
+		virtual void doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired);
+
+		TcpConnectionPool& _pool;
+	};
+
+	//! Establishes a new connection to the upstream
+	std::auto_ptr<TcpSocket> connect(const TcpAddrInfo& addrInfo);
+	//! Returns TRUE if the connection has been idling longer than the idle timeout
+	bool isExpired(const IdleConnection& connection, const Timestamp& now) const;
+	//! Closes expired and dead idle connections and establishes connections up to the minimum idle amount
+	void evict();
+
+	//! Returns pool key of the upstream address info
+	static std::string composeKey(const TcpAddrInfo& addrInfo);
+	//! Peeks the idle socket to inspect it is neither closed by the peer nor has unsolicited data
+	static bool isAlive(const TcpSocket& socket);
+
+	size_t _minIdleConnections;
+	size_t _maxIdleConnections;
+	size_t _maxConnections;
+	Timeout _idleTimeout;
+	Timeout _connectTimeout;
+	TcpSocketOptions _socketOptions;
+	mutable WaitCondition _cond;
+	SlotsContainer _slots;
+	EvictorThread _evictorThread;
+};
+
+} // namespace isl
+
+#endif
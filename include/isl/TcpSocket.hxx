@@ -4,16 +4,33 @@
 #include <isl/AbstractIODevice.hxx>
 #include <isl/AbstractPosixIODevice.hxx>
 #include <isl/TcpAddrInfo.hxx>
+#include <isl/TcpSocketOptions.hxx>
+#include <isl/SharedBuffer.hxx>
+#include <isl/Timestamp.hxx>
+#include <isl/Mutex.hxx>
+#include <sys/socket.h>
+#include <stdint.h>
 #include <list>
 #include <string>
 #include <memory>
 
+#ifndef ISL__TCP_SOCKET_DEFAULT_CONNECT_STAGGER
+#define ISL__TCP_SOCKET_DEFAULT_CONNECT_STAGGER 250			// Milliseconds
+#endif
+#ifndef ISL__TCP_SOCKET_DEFAULT_ZERO_COPY_LINGER
+#define ISL__TCP_SOCKET_DEFAULT_ZERO_COPY_LINGER 1000			// Milliseconds
+#endif
+
 namespace isl
 {
 
 //! TCP-socket implementation
 /*!
   This is an asynchronous I/O-device - you can read from it in one thread and write to it in another one.
+
+  The socket is non-blocking: each I/O-operation tries the respective system call first and waits for the socket
+  readiness using poll(2) for the rest of the timeout only if the system call reports EAGAIN, so there is no
+  FD_SETSIZE limitation on the socket descriptor.
 */
 class TcpSocket : public AbstractIODevice
 {
@@ -44,6 +61,13 @@ public:
 		}
 	};
 
+	enum Constants {
+		//! Default delay before the next endpoint's connection attempt in milliseconds
+		DefaultConnectStagger = ISL__TCP_SOCKET_DEFAULT_CONNECT_STAGGER,
+		//! Maximum time to wait for the zero-copy send completions on close in milliseconds
+		DefaultZeroCopyLinger = ISL__TCP_SOCKET_DEFAULT_ZERO_COPY_LINGER
+	};
+
 	//! Constructor
 	TcpSocket();
 	//! Destructor
@@ -53,20 +77,74 @@ public:
 	{
 		return _descriptor;
 	}
-	//! Returns a constant reference to local address info if socket has been connected or throws an exception otherwise
-	const TcpAddrInfo& localAddr() const;
-	//! Returns a constant reference to remote address info if socket has been connected or throws an exception otherwise
-	const TcpAddrInfo& remoteAddr() const;
+	//! Returns local address info if socket has been connected or throws an exception otherwise
+	/*!
+	  Address info is built on the first call only, so the accepting of the connection does not pay for it.
+	  It is returned by value, because the cached one is discarded on reconnection.
+	  Throws an exception for the Unix domain socket, use localEndpoint() or UnixSocket::localAddr() instead.
+	*/
+	TcpAddrInfo localAddr() const;
+	//! Returns remote address info if socket has been connected or throws an exception otherwise
+	/*!
+	  Address info is built on the first call only, so the accepting of the connection does not pay for it.
+	  It is returned by value, because the cached one is discarded on reconnection.
+	  Throws an exception for the Unix domain socket, use remoteEndpoint() or UnixSocket::remoteAddr() instead.
+	*/
+	TcpAddrInfo remoteAddr() const;
+	//! Returns local endpoint of the connected socket without building an address info
+	/*!
+	  Unix domain socket's endpoint host is it's human-readable address (see UnixAddrInfo::str()) and port is 0.
+	*/
+	TcpAddrInfo::Endpoint localEndpoint() const;
+	//! Returns remote endpoint of the connected socket without building an address info
+	/*!
+	  Unix domain socket's endpoint host is it's human-readable address (see UnixAddrInfo::str()) and port is 0.
+	*/
+	TcpAddrInfo::Endpoint remoteEndpoint() const;
 	//! Binds socket to an interface
 	/*!
+	  Throws an exception for the Unix domain socket, use UnixSocket::bind() instead.
+
 	  \param addrInfo Address info to bind to
+	  \param reusePort Set SO_REUSEPORT option on the socket, so the several sockets could be bound to the same
+	                   address and the kernel is distributing incoming connections among them
 	*/
-	void bind(const TcpAddrInfo& addrInfo);
+	void bind(const TcpAddrInfo& addrInfo, bool reusePort = false);
+	//! Applies the tuning profile to the connection socket
+	/*!
+	  Throws an exception if the option could not be set. TCP-level options are skipped for the Unix domain socket.
+	  The profile is saved and is applied to the connection established by connectRacing() too.
+
+	  \param options Socket tuning profile to apply
+	*/
+	void applyOptions(const TcpSocketOptions& options);
+	//! Applies the tuning profile to the listening socket
+	/*!
+	  Buffer sizes, TCP_DEFER_ACCEPT and TCP_FASTOPEN options are set on the socket itself. The profile is saved and
+	  is applied to each socket returned by accept() automatically, the failure to do it is logged as a warning.
+	  Call it before listen().
+
+	  \param options Socket tuning profile to apply
+	*/
+	void applyListenerOptions(const TcpSocketOptions& options);
 	//! Switching socket to the listening state
 	/*!
 	  \param backLog Listen backlog
 	*/
 	void listen(unsigned int backLog);
+	//! Opens the socket object on the existing socket descriptor (e.g. inherited from the parent process)
+	/*!
+	  Descriptor is switched to the non-blocking mode and the close-on-exec flag is set on it.
+	  Socket object takes the ownership of the descriptor.
+
+	  \param descriptor Socket descriptor to adopt
+	*/
+	void adopt(int descriptor);
+	//! Closes the socket object without closing the socket descriptor
+	/*!
+	  \return Socket descriptor which ownership is passed to the caller
+	*/
+	int detach();
 	//! Accepting TCP-connection
 	/*!
 	  \param timeout Timeout to wait for incoming connection
@@ -74,26 +152,178 @@ public:
 	std::auto_ptr<TcpSocket> accept(const Timeout& timeout = Timeout());
 	//! Connects to an inteface
 	/*!
+	  Throws an exception for the Unix domain socket, use UnixSocket::connect() instead.
+
 	  \param addrInfo Interface address info to connect to
 	*/
 	void connect(const TcpAddrInfo& addrInfo);
+	//! Connects to an inteface with timeout
+	/*!
+	  Connection is initiated in the non-blocking mode and the socket's writability is awaited for the timeout.
+	  Throws an exception if the connection has been refused or for the Unix domain socket.
+
+	  \param addrInfo Interface address info to connect to (the first address is used)
+	  \param timeout Timeout to wait for the connection to be established
+	  \return TRUE if the connection has been established or FALSE if the timeout has been expired
+	  \note The connection is still in progress on timeout - reopen the socket before the next attempt
+	*/
+	bool connect(const TcpAddrInfo& addrInfo, const Timeout& timeout);
+	//! Races connections to all addresses of the address info and keeps the first established one ("Happy Eyeballs")
+	/*!
+	  Connection attempts are started in the address info order with a stagger delay between them or immediately
+	  after the previous attempt has failed (see RFC 8305). The first established connection replaces the socket's
+	  descriptor, others are closed. So a dead address costs the stagger delay instead of the kernel's SYN timeout.
+	  The profile set by applyOptions() and the zero-copy send setting are carried over to the winner's descriptor.
+	  Throws an exception if all connection attempts have failed.
+
+	  \param addrInfo Interface address info to connect to
+	  \param timeout Timeout to wait for the connection to be established
+	  \param stagger Delay before the next address connection attempt
+	  \return TRUE if the connection has been established or FALSE if the timeout has been expired
+	*/
+	bool connectRacing(const TcpAddrInfo& addrInfo, const Timeout& timeout,
+			const Timeout& stagger = Timeout(0, DefaultConnectStagger * 1000000L));
+	//! Returns TRUE if zero-copy send of the shared buffers has been enabled
+	inline bool isZeroCopy() const
+	{
+		MutexLocker locker(_zeroCopyMutex);
+		return _zeroCopyThreshold >= 0;
+	}
+	//! Enables zero-copy send of the shared buffers (SO_ZEROCOPY option)
+	/*!
+	  Throws an exception if the kernel does not support SO_ZEROCOPY option.
+
+	  \param threshold Minimum size of the payload to send with MSG_ZEROCOPY flag
+	*/
+	void enableZeroCopy(size_t threshold = TcpSocketOptions::DefaultZeroCopyThreshold);
+	//! Sends the shared buffer's data
+	/*!
+	  If zero-copy send is enabled and the rest of the data is not less than the threshold, the data is sent
+	  with MSG_ZEROCOPY flag: the kernel transmits it right from the buffer's pages, so the socket keeps a copy of the
+	  buffer object until the kernel reports the completion via the socket error queue. So the same immutable
+	  buffer could be fanned out to many sockets without copying it into each socket's send buffer. Otherwise the
+	  data is copied as usual. Completions are reaped on each call.
+
+	  If the kernel reports it has copied the data anyway (e.g. on the loopback interface), subsequent sends
+	  are falling back to the copy send.
+
+	  \param buffer Shared buffer to send the data of
+	  \param offset Offset of the data to send, e.g. the amount of the bytes sent by the previous calls
+	  \param timeout Timeout to wait for the send buffer room
+	  \return Amount of the sent bytes or 0 if the timeout has been expired
+	*/
+	size_t sendShared(const SharedBuffer& buffer, size_t offset = 0, const Timeout& timeout = Timeout());
+	//! Returns amount of the zero-copy sends which completions have not been reaped yet
+	inline size_t pendingZeroCopySends() const
+	{
+		MutexLocker locker(_zeroCopyMutex);
+		return _pendingZeroCopySends.size();
+	}
+	//! Reaps zero-copy send completions from the socket error queue and releases the sent buffers
+	/*!
+	  Does not block. Completions are reaped by the I/O-operations waiting on the socket too, because the socket is
+	  reporting POLLERR event until the error queue is drained.
+
+	  \return Amount of the released buffers
+	*/
+	size_t reapZeroCopyCompletions();
+	//! Waits for all pending zero-copy sends to be completed
+	/*!
+	  \param timeout Timeout to wait for the completions
+	  \return TRUE if all completions have been reaped or FALSE if the timeout has been expired
+	*/
+	bool awaitZeroCopyCompletions(const Timeout& timeout);
+protected:
+	//! Constructs a stream socket of the protocol family
+	/*!
+	  \param domain Protocol family to create the socket of, e.g. AF_UNIX
+	*/
+	explicit TcpSocket(int domain);
+	//! Connects to the socket address
+	/*!
+	  \param addr Pointer to the socket address structure to connect to
+	  \param addrLen Socket address structure length
+	  \param timeoutPtr Pointer to the timeout to wait for the connection to be established or 0 to wait infinitely
+	  \return TRUE if the connection has been established or FALSE if the timeout has been expired
+	*/
+	bool connectSockAddr(const struct sockaddr * addr, socklen_t addrLen, const Timeout * timeoutPtr);
 private:
+	//! Zero-copy send which completion has not been reaped yet
+	struct PendingZeroCopySend
+	{
+		PendingZeroCopySend(uint32_t sequence, const SharedBuffer& buffer) :
+			sequence(sequence),
+			buffer(buffer)
+		{}
+
+		uint32_t sequence;
+		SharedBuffer buffer;
+	};
+	typedef std::list<PendingZeroCopySend> PendingZeroCopySendsContainer;
+
 	TcpSocket(const TcpSocket&);								// No copy
-	TcpSocket(int descriptor);
+	TcpSocket(int descriptor, const struct sockaddr_storage& remoteSockAddr, socklen_t remoteSockAddrLen);
 
 	TcpSocket& operator=(const TcpSocket&);							// No copy
 
 	void closeSocket();
-	void fetchPeersData();
+	void resetPeersData();
+	const struct sockaddr * localSockAddr() const;
+	const struct sockaddr * remoteSockAddr() const;
+	//! Awaits for the socket events using poll(2) for the rest of the timeout
+	/*!
+	  \param events poll(2) events to wait for
+	  \param timeout Timeout of the whole I/O-operation
+	  \param limit Reference to the I/O-operation's limit timestamp, which is calculated on the first call if zero
+	  \return TRUE if the I/O-operation should be retried or FALSE if the timeout has been expired
+	*/
+	bool awaitDescriptor(short events, const Timeout& timeout, Timestamp& limit);
+	//! Reaps zero-copy send completions, should be called with the zero-copy mutex locked
+	size_t reapZeroCopyCompletionsUnlocked();
+	//! Returns pending socket error (SO_ERROR socket option)
+	static int socketError(int descriptor);
+	//! Returns poll(2) timeout in milliseconds to wait until the limit timestamp
+	static int pollTimeout(const Timestamp& now, const Timestamp& limit);
+	ssize_t sendFileNoSignal(int fileDescriptor, off_t offset, size_t size);
+	//! Throws an exception if the socket is of the Unix domain, so it could not be connected to the TCP address
+	void ensureInetDomain() const;
+	//! Sets integer socket option if the value is not negative
+	void setSocketOption(int level, int optionName, int value);
+	//! Sets integer option on the socket descriptor if the value is not negative
+	static void setSocketOption(int descriptor, int level, int optionName, int value);
+	void setConnectionOptions(const TcpSocketOptions& options, bool setBufferSizes);
+	//! Applies saved listener's profile to the accepted socket
+	void setAcceptedOptions(TcpSocket& socket) const;
+	//! Releases pending zero-copy buffers with the sequence numbers in the range
+	size_t releaseZeroCopySends(uint32_t first, uint32_t last);
 
 	virtual void openImplementation();
 	virtual void closeImplementation();
 	virtual size_t readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout);
 	virtual size_t writeImplementation(const char * buffer, size_t bufferSize, const Timeout& timeout);
+	virtual size_t writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout);
+	virtual size_t sendFileImplementation(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout);
+	virtual void setCorkedImplementation(bool newValue);
 
+	int _domain;
 	int _descriptor;
-	std::auto_ptr<TcpAddrInfo> _localAddrAutoPtr;
-	std::auto_ptr<TcpAddrInfo> _remoteAddrAutoPtr;
+	TcpSocketOptions _acceptedOptions;
+	TcpSocketOptions _connectionOptions;
+	bool _corkWrites;
+	mutable Mutex _peersDataMutex;
+	mutable struct sockaddr_storage _localSockAddr;
+	mutable socklen_t _localSockAddrLen;
+	mutable struct sockaddr_storage _remoteSockAddr;
+	mutable socklen_t _remoteSockAddrLen;
+	mutable std::auto_ptr<TcpAddrInfo> _localAddrAutoPtr;
+	mutable std::auto_ptr<TcpAddrInfo> _remoteAddrAutoPtr;
+	mutable Mutex _zeroCopyMutex;
+	int _zeroCopyThreshold;
+	bool _zeroCopyFallback;
+	uint32_t _zeroCopySequence;
+	PendingZeroCopySendsContainer _pendingZeroCopySends;
+
+	friend class IoUringAcceptor;
 };
 
 //------------------------------------------------------------------------------
@@ -139,6 +369,8 @@ public:
 	const TcpAddrInfo& remoteAddr() const;
 	//! Binds socket to an interface
 	/*!
+	  Throws an exception for the Unix domain socket, use UnixSocket::bind() instead.
+
 	  \param addrInfo Address info to bind to
 	*/
 	void bind(const TcpAddrInfo& addrInfo);
@@ -154,6 +386,8 @@ public:
 	std::auto_ptr<TcpSocket_NEW> accept(const Timeout& timeout = Timeout());
 	//! Connects to an inteface
 	/*!
+	  Throws an exception for the Unix domain socket, use UnixSocket::connect() instead.
+
 	  \param addrInfo Interface address info to connect to
 	*/
 	void connect(const TcpAddrInfo& addrInfo);
@@ -0,0 +1,211 @@
+#ifndef ISL__TCP_SOCKET_OPTIONS__HXX
+#define ISL__TCP_SOCKET_OPTIONS__HXX
+
+#include <isl/Timeout.hxx>
+
+#ifndef ISL__TCP_SOCKET_OPTIONS_DEFAULT_ZERO_COPY_THRESHOLD
+#define ISL__TCP_SOCKET_OPTIONS_DEFAULT_ZERO_COPY_THRESHOLD 16384	// Bytes
+#endif
+
+namespace isl
+{
+
+//! TCP-socket tuning profile
+/*!
+  Set of the socket options to be applied to the listening socket and to the connection sockets, see
+  TcpSocket::applyOptions() and TcpSocket::applyListenerOptions(). Options which have not been set are left
+  with the system defaults, so an empty profile does not issue any setsockopt(2) call.
+
+  Low-latency links (e.g. message broker connections) usually need lowLatency() profile, while bulk transfer
+  listeners (e.g. HTTP-service serving files) need bulkTransfer() one.
+*/
+class TcpSocketOptions
+{
+public:
+	enum Constants {
+		//! Default minimum size of the payload to send with MSG_ZEROCOPY flag
+		DefaultZeroCopyThreshold = ISL__TCP_SOCKET_OPTIONS_DEFAULT_ZERO_COPY_THRESHOLD
+	};
+
+	//! Constructs an empty profile
+	TcpSocketOptions() :
+		_noDelay(-1),
+		_cork(false),
+		_sendBufferSize(-1),
+		_receiveBufferSize(-1),
+		_deferAccept(-1),
+		_fastOpen(-1),
+		_busyPoll(-1),
+		_userTimeout(-1),
+		_zeroCopyThreshold(-1)
+	{}
+
+	//! Returns TRUE if no option has been set
+	inline bool isEmpty() const
+	{
+		return _noDelay < 0 && !_cork && _sendBufferSize < 0 && _receiveBufferSize < 0 && _deferAccept < 0 &&
+			_fastOpen < 0 && _busyPoll < 0 && _userTimeout < 0 && _zeroCopyThreshold < 0;
+	}
+	//! Returns TCP_NODELAY option value: 1 - Nagle's algorithm is disabled, 0 - enabled, -1 - system default
+	inline int noDelay() const
+	{
+		return _noDelay;
+	}
+	//! Sets TCP_NODELAY option
+	/*!
+	  \param newValue TRUE to send small segments immediately (disable Nagle's algorithm)
+	*/
+	inline void setNoDelay(bool newValue)
+	{
+		_noDelay = newValue ? 1 : 0;
+	}
+	//! Returns TRUE if the socket should be corked while HTTP-message header and file body are being sent
+	inline bool cork() const
+	{
+		return _cork;
+	}
+	//! Sets TCP_CORK usage
+	/*!
+	  If set, the socket is corked by the HTTP-message writers before sending the header followed by the file body
+	  and is uncorked after the body has been sent, so the header and the first part of the body are sharing
+	  full-sized segments (see AbstractIODevice::setCorked()).
+
+	  \param newValue TRUE to cork the socket around the header and body writes
+	*/
+	inline void setCork(bool newValue)
+	{
+		_cork = newValue;
+	}
+	//! Returns SO_SNDBUF option value in bytes or -1 if system default is used
+	inline int sendBufferSize() const
+	{
+		return _sendBufferSize;
+	}
+	//! Sets SO_SNDBUF option (disables send buffer autotuning)
+	/*!
+	  \param newValue Send buffer size in bytes
+	*/
+	inline void setSendBufferSize(int newValue)
+	{
+		_sendBufferSize = newValue;
+	}
+	//! Returns SO_RCVBUF option value in bytes or -1 if system default is used
+	inline int receiveBufferSize() const
+	{
+		return _receiveBufferSize;
+	}
+	//! Sets SO_RCVBUF option (disables receive buffer autotuning)
+	/*!
+	  Set it on the listening socket to make accepted connections negotiate the respective window scale.
+
+	  \param newValue Receive buffer size in bytes
+	*/
+	inline void setReceiveBufferSize(int newValue)
+	{
+		_receiveBufferSize = newValue;
+	}
+	//! Returns TCP_DEFER_ACCEPT option value in seconds or -1 if system default is used
+	inline int deferAccept() const
+	{
+		return _deferAccept;
+	}
+	//! Sets TCP_DEFER_ACCEPT option of the listening socket
+	/*!
+	  Connection is not reported to the accept(2) until the client has sent some data or the timeout has been expired.
+
+	  \param newValue Timeout to wait for the client's data, rounded to seconds
+	*/
+	inline void setDeferAccept(const Timeout& newValue)
+	{
+		_deferAccept = newValue.seconds();
+	}
+	//! Returns TCP_FASTOPEN option value (pending TFO requests queue length) or -1 if system default is used
+	inline int fastOpen() const
+	{
+		return _fastOpen;
+	}
+	//! Sets TCP_FASTOPEN option of the listening socket
+	/*!
+	  \param newValue Maximum length of the pending TCP Fast Open requests queue
+	*/
+	inline void setFastOpen(int newValue)
+	{
+		_fastOpen = newValue;
+	}
+	//! Returns SO_BUSY_POLL option value in microseconds or -1 if system default is used
+	inline int busyPoll() const
+	{
+		return _busyPoll;
+	}
+	//! Sets SO_BUSY_POLL option
+	/*!
+	  Values above <tt>net.core.busy_read</tt> sysctl setting require CAP_NET_ADMIN capability.
+
+	  \param newValue Time to busy poll the device queue on blocking receive
+	*/
+	inline void setBusyPoll(const Timeout& newValue)
+	{
+		_busyPoll = newValue.seconds() * 1000000 + newValue.nanoSeconds() / 1000;
+	}
+	//! Returns TCP_USER_TIMEOUT option value in milliseconds or -1 if system default is used
+	inline int userTimeout() const
+	{
+		return _userTimeout;
+	}
+	//! Sets TCP_USER_TIMEOUT option
+	/*!
+	  \param newValue Maximum time the transmitted data may remain unacknowledged before the connection is dropped
+	*/
+	inline void setUserTimeout(const Timeout& newValue)
+	{
+		_userTimeout = newValue.seconds() * 1000 + newValue.nanoSeconds() / 1000000;
+	}
+	//! Returns minimum size of the payload to send with MSG_ZEROCOPY flag or -1 if zero-copy send is disabled
+	inline int zeroCopyThreshold() const
+	{
+		return _zeroCopyThreshold;
+	}
+	//! Enables zero-copy send of the shared buffers (SO_ZEROCOPY option, see TcpSocket::sendShared())
+	/*!
+	  Pinning the pages and reaping the completion costs more than copying the small payloads, so the payloads
+	  below the threshold are copied as usual. The socket falls back to the copy send if the kernel does not
+	  support SO_ZEROCOPY option.
+
+	  \param threshold Minimum size of the payload to send with MSG_ZEROCOPY flag
+	*/
+	inline void setZeroCopy(size_t threshold = DefaultZeroCopyThreshold)
+	{
+		_zeroCopyThreshold = threshold;
+	}
+
+	//! Returns low-latency profile: TCP_NODELAY is set
+	static TcpSocketOptions lowLatency()
+	{
+		TcpSocketOptions result;
+		result.setNoDelay(true);
+		return result;
+	}
+	//! Returns bulk transfer profile: TCP_CORK is used around HTTP-message writes, TCP_DEFER_ACCEPT is one second
+	static TcpSocketOptions bulkTransfer()
+	{
+		TcpSocketOptions result;
+		result.setNoDelay(true);
+		result.setCork(true);
+		result.setDeferAccept(Timeout(1));
+		return result;
+	}
+private:
+	int _noDelay;
+	bool _cork;
+	int _sendBufferSize;
+	int _receiveBufferSize;
+	int _deferAccept;
+	int _fastOpen;
+	int _busyPoll;
+	int _userTimeout;
+	int _zeroCopyThreshold;
+};
+
+} // namespace isl
+
+#endif
@@ -8,6 +8,7 @@
 #include <isl/SystemCallError.hxx>
 #include <isl/LogMessage.hxx>
 #include <isl/ExceptionLogMessage.hxx>
+#include <isl/ThreadPlacement.hxx>
 #include <new>
 #include <pthread.h>
 #ifdef __FreeBSD__
@@ -80,7 +81,8 @@ public:
 		_awaitStartup(awaitStartup),
 		_isRunning(false),
 		_isRunningRWLockAutoPtr(isTrackable ? new ReadWriteLock() : 0),
-		_awaitStartupCondAutoPtr(awaitStartup ? new WaitCondition() : 0)
+		_awaitStartupCondAutoPtr(awaitStartup ? new WaitCondition() : 0),
+		_placement()
 	{}
 	//! Virtual destructor
 	virtual ~Thread()
@@ -111,6 +113,21 @@ public:
 	{
 		return _awaitStartup;
 	}
+	//! Returns thread placement
+	inline const ThreadPlacement& placement() const
+	{
+		return _placement;
+	}
+	//! Sets thread placement, which is applied by the new thread to itself on startup
+	/*!
+	  \param newValue New thread placement
+
+	  \note Thread-unsafe: call it before the thread is started
+	*/
+	inline void setPlacement(const ThreadPlacement& newValue)
+	{
+		_placement = newValue;
+	}
 	//! Starts function or functor's <tt>void operator(void)</tt> execution in a new thread
 	/*!
 	  \param fun Function/functor to execute
@@ -282,6 +299,9 @@ private:
 	template <typename T> static void * executeFunction(void * arg)
 	{
 		Thread * threadPtr = reinterpret_cast<Thread *>(arg);
+		if (!threadPtr->_placement.isEmpty()) {
+			threadPtr->_placement.apply();
+		}
 		if (threadPtr->_awaitStartup) {
 			MutexLocker locker(threadPtr->_awaitStartupCondAutoPtr->mutex());
 			threadPtr->_awaitStartupCondAutoPtr->wakeOne();
@@ -299,6 +319,9 @@ private:
 	template <typename T> static void * executeFunctor(void * arg)
 	{
 		Thread * threadPtr = reinterpret_cast<Thread *>(arg);
+		if (!threadPtr->_placement.isEmpty()) {
+			threadPtr->_placement.apply();
+		}
 		if (threadPtr->_awaitStartup) {
 			MutexLocker locker(threadPtr->_awaitStartupCondAutoPtr->mutex());
 			threadPtr->_awaitStartupCondAutoPtr->wakeOne();
@@ -324,6 +347,7 @@ private:
 	bool _isRunning;
 	mutable std::auto_ptr<ReadWriteLock> _isRunningRWLockAutoPtr;
 	std::auto_ptr<WaitCondition> _awaitStartupCondAutoPtr;
+	ThreadPlacement _placement;
 };
 
 } // namespace isl
@@ -0,0 +1,221 @@
+#ifndef ISL__THREAD_PLACEMENT__HXX
+#define ISL__THREAD_PLACEMENT__HXX
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+namespace isl
+{
+
+//! Thread placement: name, CPU affinity, NUMA node and scheduling policy
+/*!
+  Placement is applied by the thread to itself on startup (see Thread::setPlacement()). Placement errors, e.g.
+  real-time scheduling policy without the privileges or CPU which is not in the process' cpuset, are logged and
+  do not prevent the thread from running.
+
+  \note Thread name is truncated to 15 characters by the kernel.
+*/
+class ThreadPlacement
+{
+public:
+	//! CPU numbers container
+	typedef std::vector<int> CpusContainer;
+	//! NUMA node numbers container
+	typedef std::vector<int> NumaNodesContainer;
+	//! Thread scheduling policy
+	enum SchedulingPolicy {
+		InheritedPolicy,		//!< Scheduling policy of the launching thread is kept
+		OtherPolicy,			//!< Default time-sharing policy (SCHED_OTHER)
+		BatchPolicy,			//!< Time-sharing policy for the CPU-intensive threads (SCHED_BATCH)
+		IdlePolicy,			//!< Very low priority background threads (SCHED_IDLE)
+		FifoPolicy,			//!< Real-time first-in first-out policy (SCHED_FIFO)
+		RoundRobinPolicy		//!< Real-time round-robin policy (SCHED_RR)
+	};
+
+	//! Constructs an empty placement, which does not change anything
+	ThreadPlacement();
+
+	//! Returns thread name
+	inline const std::string& name() const
+	{
+		return _name;
+	}
+	//! Sets thread name, which is shown by ps(1), top(1), perf(1) and gdb(1)
+	inline void setName(const std::string& newValue)
+	{
+		_name = newValue;
+	}
+	//! Returns CPUs to bind the thread to, empty container means no CPU affinity
+	inline const CpusContainer& cpus() const
+	{
+		return _cpus;
+	}
+	//! Sets CPUs to bind the thread to
+	/*!
+	  \param newValue CPUs to bind the thread to, empty container means the CPUs of the NUMA node if it is set
+	*/
+	inline void setCpus(const CpusContainer& newValue)
+	{
+		_cpus = newValue;
+	}
+	//! Returns NUMA node to place the thread on or -1 if none
+	inline int numaNode() const
+	{
+		return _numaNode;
+	}
+	//! Sets NUMA node to place the thread on
+	/*!
+	  Thread prefers the memory of the NUMA node, so the data which is allocated and first touched by the thread
+	  is placed on it's local node. Thread is also bound to the CPUs of the node unless the CPUs have been set.
+
+	  \param newValue NUMA node to place the thread on or -1 if none
+	*/
+	inline void setNumaNode(int newValue)
+	{
+		_numaNode = newValue;
+	}
+	//! Returns scheduling policy
+	inline SchedulingPolicy schedulingPolicy() const
+	{
+		return _schedulingPolicy;
+	}
+	//! Returns scheduling priority for the real-time scheduling policies
+	inline int schedulingPriority() const
+	{
+		return _schedulingPriority;
+	}
+	//! Sets scheduling policy
+	/*!
+	  \param newValue New scheduling policy
+	  \param priority Scheduling priority for the real-time scheduling policies (1-99)
+	*/
+	inline void setSchedulingPolicy(SchedulingPolicy newValue, int priority = 0)
+	{
+		_schedulingPolicy = newValue;
+		_schedulingPriority = priority;
+	}
+	//! Returns TRUE if the placement does not change anything
+	inline bool isEmpty() const
+	{
+		return _name.empty() && _cpus.empty() && _numaNode < 0 && _schedulingPolicy == InheritedPolicy;
+	}
+	//! Applies placement to the calling thread
+	void apply() const;
+
+	//! Returns online CPUs
+	static CpusContainer onlineCpus();
+	//! Returns online NUMA nodes, empty container if NUMA is not supported
+	static NumaNodesContainer onlineNumaNodes();
+	//! Returns CPUs of the NUMA node
+	static CpusContainer numaNodeCpus(int node);
+	//! Returns NUMA node of the CPU the calling thread is running on or -1 if unknown
+	static int currentNumaNode();
+	//! Parses the kernel's CPU or NUMA node list, e.g. "0-3,8,10-11"
+	/*!
+	  \param list List to parse
+	  \return Numbers of the list in the order of appearance, malformed ranges are skipped
+	*/
+	static std::vector<int> parseList(const std::string& list);
+private:
+	static std::string readSysFile(const std::string& path);
+
+	std::string _name;
+	CpusContainer _cpus;
+	int _numaNode;
+	SchedulingPolicy _schedulingPolicy;
+	int _schedulingPriority;
+};
+
+//! Placement policy of the group of threads, e.g. subsystem's threads or task dispatcher workers
+/*!
+  Policy composes the placement of the N-th thread of the group. Groups which are sharing the CPU set, e.g. workers of
+  the task dispatcher shards, should be given the disjoint thread indexes using setFirstThreadIndex(), so their threads
+  are not pinned to the same CPUs and are not named alike.
+*/
+class ThreadPlacementPolicy
+{
+public:
+	//! Placement mode
+	enum Mode {
+		FloatMode,			//!< Threads are not bound to the CPUs
+		SpreadMode,			//!< Every thread is bound to the whole CPU set, so the scheduler spreads them over it
+		PinMode,			//!< N-th thread is bound to the N-th CPU of the CPU set (round-robin)
+		NumaMode			//!< N-th thread is placed on the N-th NUMA node (round-robin)
+	};
+
+	//! Constructs a placement policy
+	/*!
+	  \param mode Placement mode
+	  \param cpus CPU set for the spread and pin modes, empty container means all online CPUs
+	  \param namePrefix Thread name prefix, N-th thread is named "<prefix>-<N>", empty prefix means threads are not named
+	*/
+	ThreadPlacementPolicy(Mode mode = FloatMode, const ThreadPlacement::CpusContainer& cpus = ThreadPlacement::CpusContainer(),
+			const std::string& namePrefix = std::string());
+
+	//! Returns placement mode
+	inline Mode mode() const
+	{
+		return _mode;
+	}
+	//! Returns CPU set
+	inline const ThreadPlacement::CpusContainer& cpus() const
+	{
+		return _cpus;
+	}
+	//! Returns thread name prefix
+	inline const std::string& namePrefix() const
+	{
+		return _namePrefix;
+	}
+	//! Sets thread name prefix
+	inline void setNamePrefix(const std::string& newValue)
+	{
+		_namePrefix = newValue;
+	}
+	//! Returns scheduling policy of the threads
+	inline ThreadPlacement::SchedulingPolicy schedulingPolicy() const
+	{
+		return _schedulingPolicy;
+	}
+	//! Returns scheduling priority of the threads
+	inline int schedulingPriority() const
+	{
+		return _schedulingPriority;
+	}
+	//! Sets scheduling policy of the threads
+	inline void setSchedulingPolicy(ThreadPlacement::SchedulingPolicy newValue, int priority = 0)
+	{
+		_schedulingPolicy = newValue;
+		_schedulingPriority = priority;
+	}
+	//! Returns the index of the first thread of the group
+	inline size_t firstThreadIndex() const
+	{
+		return _firstThreadIndex;
+	}
+	//! Sets the index of the first thread of the group
+	/*!
+	  \param newValue Index which is added to the thread index in the group to compose the thread's name and CPU
+	*/
+	inline void setFirstThreadIndex(size_t newValue)
+	{
+		_firstThreadIndex = newValue;
+	}
+	//! Composes a placement of the thread
+	/*!
+	  \param threadIndex Index of the thread in the group
+	*/
+	ThreadPlacement placement(size_t threadIndex) const;
+private:
+	Mode _mode;
+	ThreadPlacement::CpusContainer _cpus;
+	std::string _namePrefix;
+	ThreadPlacement::SchedulingPolicy _schedulingPolicy;
+	int _schedulingPriority;
+	size_t _firstThreadIndex;
+};
+
+} // namespace isl
+
+#endif
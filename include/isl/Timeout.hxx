@@ -2,6 +2,7 @@
 #define ISL__TIMEOUT__HXX
 
 #include <isl/TimeSpec.hxx>
+#include <limits.h>
 
 namespace isl
 {
@@ -48,6 +49,14 @@ public:
         {
                 return static_cast<double>(_ts.tv_sec) + static_cast<double>(_ts.tv_nsec) / 1000000000.0;
         }
+	//! Returns timeout as milliseconds value rounded up, which is suitable for poll(2)/epoll_wait(2) calls
+	inline int milliSeconds() const
+	{
+		if (_ts.tv_sec >= (INT_MAX / 1000 - 1)) {
+			return INT_MAX;
+		}
+		return static_cast<int>(_ts.tv_sec * 1000 + (_ts.tv_nsec + 999999) / 1000000);
+	}
 	//! Returns POSIX.1b representation of the timeout
 	inline const struct timespec& timeSpec() const
 	{
@@ -0,0 +1,149 @@
+#ifndef ISL__TIMING_WHEEL__HXX
+#define ISL__TIMING_WHEEL__HXX
+
+#include <isl/Timestamp.hxx>
+#include <vector>
+#include <stdint.h>
+
+#ifndef ISL__TIMING_WHEEL_DEFAULT_RESOLUTION
+#define ISL__TIMING_WHEEL_DEFAULT_RESOLUTION 10000000		// 10 milliseconds
+#endif
+#ifndef ISL__TIMING_WHEEL_DEFAULT_SLOTS_AMOUNT
+#define ISL__TIMING_WHEEL_DEFAULT_SLOTS_AMOUNT 512
+#endif
+
+namespace isl
+{
+
+//! Hashed timing wheel
+/*!
+  Keeps deadlines of the big amount of timers (e.g. per-connection I/O-deadlines) with O(1) scheduling and
+  cancellation. Wheel consists of the fixed amount of slots, each one is covering one tick of resolution duration.
+  Timer is linked into the slot of it's expiration tick modulo slots amount, so advancing the wheel visits only
+  the slots of the ticks passed and expires only the timers which expiration tick has come. Timers are
+  expired with the resolution accuracy and never earlier than their deadlines.
+
+  Timer object is an intrusive list node which is to be embedded into the owner object, so scheduling
+  and cancellation do not allocate memory.
+
+  \note Thread-unsafe: synchronize access to the wheel and to it's timers externally
+*/
+class TimingWheel
+{
+public:
+	enum Constants {
+		DefaultResolution = ISL__TIMING_WHEEL_DEFAULT_RESOLUTION,	// Nanoseconds
+		DefaultSlotsAmount = ISL__TIMING_WHEEL_DEFAULT_SLOTS_AMOUNT
+	};
+	//! Timing wheel timer abstract class
+	class AbstractTimer
+	{
+	public:
+		AbstractTimer() :
+			_wheelPtr(0),
+			_prevPtr(0),
+			_nextPtr(0),
+			_expirationTick(0),
+			_limit()
+		{}
+		//! Destructor cancels the timer if it is scheduled
+		virtual ~AbstractTimer();
+		//! Returns TRUE if the timer has been scheduled and is not expired yet
+		inline bool isScheduled() const
+		{
+			return _wheelPtr;
+		}
+		//! Returns the deadline the timer has been scheduled to
+		inline const Timestamp& limit() const
+		{
+			return _limit;
+		}
+		//! On timer expiration event handler
+		/*!
+		  Called by the TimingWheel::advance() after the timer has been unlinked from the wheel, so the timer
+		  could be scheduled again from the handler.
+		  \note Handler should not destroy other timers of the wheel
+		*/
+		virtual void onExpired() = 0;
+	private:
+		AbstractTimer(const AbstractTimer&);						// No copy
+
+		AbstractTimer& operator=(const AbstractTimer&);					// No copy
+
+		TimingWheel * _wheelPtr;
+		AbstractTimer * _prevPtr;
+		AbstractTimer * _nextPtr;
+		uint64_t _expirationTick;
+		Timestamp _limit;
+
+		friend class TimingWheel;
+	};
+	//! Constructor
+	/*!
+	  \param resolution Duration of one wheel tick
+	  \param slotsAmount Amount of the wheel slots, timers which are farther than one wheel revolution are sharing
+	                     the slots with the nearer ones
+	*/
+	TimingWheel(const Timeout& resolution = Timeout(0, DefaultResolution), size_t slotsAmount = DefaultSlotsAmount);
+	//! Destructor unlinks all scheduled timers without expiration
+	~TimingWheel();
+
+	//! Returns duration of one wheel tick
+	inline const Timeout& resolution() const
+	{
+		return _resolution;
+	}
+	//! Returns amount of the wheel slots
+	inline size_t slotsAmount() const
+	{
+		return _slots.size();
+	}
+	//! Returns amount of the scheduled timers
+	inline size_t size() const
+	{
+		return _size;
+	}
+	//! Returns TRUE if there are no scheduled timers
+	inline bool isEmpty() const
+	{
+		return _size <= 0;
+	}
+	//! Schedules the timer or re-schedules it if it has been scheduled already
+	/*!
+	  \param timer Reference to the timer to schedule
+	  \param limit Timer deadline
+	*/
+	void schedule(AbstractTimer& timer, const Timestamp& limit);
+	//! Cancels the timer, does nothing if the timer is not scheduled in the wheel
+	/*!
+	  \param timer Reference to the timer to cancel
+	*/
+	void cancel(AbstractTimer& timer);
+	//! Advances the wheel to the timestamp and calls onExpired() of the timers which deadlines have been reached
+	/*!
+	  \param now Timestamp to advance the wheel to
+	  \return Amount of expired timers
+	*/
+	size_t advance(const Timestamp& now = Timestamp::now());
+private:
+	TimingWheel(const TimingWheel&);							// No copy
+
+	TimingWheel& operator=(const TimingWheel&);						// No copy
+
+	typedef std::vector<AbstractTimer *> SlotsContainer;
+
+	uint64_t tick(const Timestamp& timestamp, bool roundUp = false) const;
+	void link(AbstractTimer& timer);
+	void unlink(AbstractTimer& timer);
+
+	const Timeout _resolution;
+	const uint64_t _resolutionNanoSeconds;
+	const Timestamp _startTimestamp;
+	SlotsContainer _slots;
+	uint64_t _currentTick;
+	size_t _size;
+};
+
+} // namespace isl
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef ISL__UDP_SOCKET__HXX
+#define ISL__UDP_SOCKET__HXX
+
+#include <isl/AbstractIODevice.hxx>
+#include <isl/TcpAddrInfo.hxx>
+#include <isl/Timestamp.hxx>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace isl
+{
+
+//! UDP-socket implementation
+/*!
+  The socket is non-blocking like the TcpSocket: each I/O-operation tries the respective system call first and
+  waits for the socket readiness using poll(2) for the rest of the timeout only if the system call reports EAGAIN.
+
+  read() and write() are receiving and sending one datagram from/to the connected peer (see connect()).
+  receiveBatch() and sendBatch() are moving the whole batch of the datagrams using one recvmmsg(2)/sendmmsg(2)
+  system call, so the per-datagram system call overhead is amortized on the high datagram rates.
+*/
+class UdpSocket : public AbstractIODevice
+{
+public:
+	//! Batch of the datagrams with the preallocated buffers
+	/*!
+	  Batch is used to receive the datagrams into using UdpSocket::receiveBatch() and to collect the datagrams to
+	  send using UdpSocket::sendBatch(). Datagram buffers, peer addresses and recvmmsg(2)/sendmmsg(2) headers are
+	  allocated once on construction, so the batched I/O does not allocate memory.
+	*/
+	class Batch
+	{
+	public:
+		//! Constructor
+		/*!
+		  \param capacity Maximum amount of the datagrams in the batch
+		  \param maxDatagramSize Datagram buffer size, received datagrams which are longer are truncated
+		*/
+		Batch(size_t capacity, size_t maxDatagramSize);
+
+		//! Returns maximum amount of the datagrams in the batch
+		inline size_t capacity() const
+		{
+			return _headers.size();
+		}
+		//! Returns datagram buffer size
+		inline size_t maxDatagramSize() const
+		{
+			return _maxDatagramSize;
+		}
+		//! Returns amount of the datagrams in the batch
+		inline size_t size() const
+		{
+			return _size;
+		}
+		//! Returns TRUE if the batch is empty
+		inline bool isEmpty() const
+		{
+			return _size <= 0;
+		}
+		//! Returns TRUE if the batch is full
+		inline bool isFull() const
+		{
+			return _size >= _headers.size();
+		}
+		//! Returns a pointer to the datagram data
+		/*!
+		  \param index Datagram index
+		*/
+		inline const char * data(size_t index) const
+		{
+			return &_buffer[index * _maxDatagramSize];
+		}
+		//! Returns datagram size
+		/*!
+		  \param index Datagram index
+		*/
+		inline size_t dataSize(size_t index) const
+		{
+			return _sizes[index];
+		}
+		//! Returns TRUE if the received datagram has been truncated to the buffer size
+		/*!
+		  \param index Datagram index
+		*/
+		inline bool isTruncated(size_t index) const
+		{
+			return _headers[index].msg_hdr.msg_flags & MSG_TRUNC;
+		}
+		//! Returns a pointer to the datagram's peer address
+		/*!
+		  \param index Datagram index
+		*/
+		inline const struct sockaddr * addr(size_t index) const
+		{
+			return reinterpret_cast<const struct sockaddr *>(&_addrs[index]);
+		}
+		//! Returns datagram's peer address length
+		/*!
+		  \param index Datagram index
+		*/
+		inline socklen_t addrLen(size_t index) const
+		{
+			return _headers[index].msg_hdr.msg_namelen;
+		}
+		//! Returns datagram's peer endpoint
+		/*!
+		  \param index Datagram index
+		*/
+		inline TcpAddrInfo::Endpoint endpoint(size_t index) const
+		{
+			return TcpAddrInfo::endpoint(addr(index));
+		}
+		//! Appends a copy of the datagram to the batch
+		/*!
+		  \param data Pointer to the datagram data
+		  \param dataSize Datagram size which should not exceed the datagram buffer size
+		  \param addr Pointer to the peer address to send the datagram to or 0 for the connected socket
+		  \param addrLen Peer address length
+		  \return TRUE if the datagram has been appended or FALSE if the batch is full
+		*/
+		bool append(const char * data, size_t dataSize, const struct sockaddr * addr = 0, socklen_t addrLen = 0);
+		//! Appends a reply datagram to the peer of the datagram from another batch
+		/*!
+		  \param data Pointer to the reply data
+		  \param dataSize Reply size which should not exceed the datagram buffer size
+		  \param request Constant reference to the batch of the datagram to reply to
+		  \param index Index of the datagram to reply to
+		  \return TRUE if the datagram has been appended or FALSE if the batch is full
+		*/
+		inline bool appendReply(const char * data, size_t dataSize, const Batch& request, size_t index)
+		{
+			return append(data, dataSize, request.addr(index), request.addrLen(index));
+		}
+		//! Removes all datagrams from the batch
+		inline void clear()
+		{
+			_size = 0;
+		}
+	private:
+		Batch();
+		Batch(const Batch&);								// No copy
+
+		Batch& operator=(const Batch&);							// No copy
+
+		//! Prepares the headers to receive the datagrams
+		void prepareReceive();
+
+		const size_t _maxDatagramSize;
+		std::vector<char> _buffer;
+		std::vector<struct sockaddr_storage> _addrs;
+		std::vector<struct iovec> _iovecs;
+		std::vector<struct mmsghdr> _headers;
+		std::vector<size_t> _sizes;
+		size_t _size;
+
+		friend class UdpSocket;
+	};
+
+	//! Constructor
+	/*!
+	  \param family Address family of the socket
+	*/
+	UdpSocket(TcpAddrInfo::Family family = TcpAddrInfo::IpV4);
+	//! Destructor
+	virtual ~UdpSocket();
+	//! Returns a UDP-socket descriptor
+	inline int descriptor() const
+	{
+		return _descriptor;
+	}
+	//! Binds socket to an interface
+	/*!
+	  \param addrInfo Address info to bind to
+	  \param reusePort Set SO_REUSEPORT option on the socket, so the several sockets could be bound to the same
+	                   address and the kernel is distributing incoming datagrams among them by the peer address hash
+	*/
+	void bind(const TcpAddrInfo& addrInfo, bool reusePort = false);
+	//! Sets the default peer to send datagrams to and to receive datagrams from
+	/*!
+	  \param addrInfo Peer address info
+	*/
+	void connect(const TcpAddrInfo& addrInfo);
+	//! Sets SO_RCVBUF option
+	/*!
+	  Bursts of datagrams are dropped by the kernel when the receive buffer is full, so the high-rate receivers
+	  usually need it to be increased.
+
+	  \param newValue Receive buffer size in bytes
+	*/
+	void setReceiveBufferSize(int newValue);
+	//! Sets SO_SNDBUF option
+	/*!
+	  \param newValue Send buffer size in bytes
+	*/
+	void setSendBufferSize(int newValue);
+	//! Receives a batch of datagrams using one recvmmsg(2) system call
+	/*!
+	  Previous batch contents are discarded. Waits for the first datagram for the timeout and receives all
+	  datagrams which are available at that moment up to the batch capacity.
+
+	  \param batch Reference to the batch to receive datagrams into
+	  \param timeout Timeout to wait for the first datagram
+	  \return Amount of the received datagrams or 0 if the timeout has been expired
+	*/
+	size_t receiveBatch(Batch& batch, const Timeout& timeout = Timeout());
+	//! Sends a batch of datagrams using sendmmsg(2) system call
+	/*!
+	  \param batch Reference to the batch of datagrams to send
+	  \param timeout Timeout to wait for the send buffer room
+	  \return Amount of the sent datagrams, which is less than the batch size if the timeout has been expired
+	*/
+	size_t sendBatch(Batch& batch, const Timeout& timeout = Timeout());
+private:
+	UdpSocket(const UdpSocket&);								// No copy
+
+	UdpSocket& operator=(const UdpSocket&);							// No copy
+
+	void setSocketOption(int level, int optionName, int value);
+
+	virtual void openImplementation();
+	virtual void closeImplementation();
+	virtual size_t readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout);
+	virtual size_t writeImplementation(const char * buffer, size_t bufferSize, const Timeout& timeout);
+
+	const TcpAddrInfo::Family _family;
+	int _descriptor;
+};
+
+} // namespace isl
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ISL__UNIX_ADDR_INFO__HXX
+#define ISL__UNIX_ADDR_INFO__HXX
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <string>
+
+namespace isl
+{
+
+//! Unix domain socket address info class
+/*!
+  Wraps the <tt>struct sockaddr_un</tt> of the filesystem or the abstract namespace (see unix(7)) socket address.
+*/
+class UnixAddrInfo
+{
+public:
+	//! Constructor
+	/*!
+	  Throws an exception if the path is too long.
+
+	  \param path Socket file path or socket name in the abstract namespace
+	  \param abstractNamespace TRUE if the socket is to be bound in the Linux abstract namespace
+	*/
+	UnixAddrInfo(const std::string& path, bool abstractNamespace = false);
+	//! Constructs Unix domain socket address info from the socket address structure
+	/*!
+	  \param addr Pointer to the socket address structure of AF_UNIX family
+	  \param addrLen Socket address structure length
+	*/
+	UnixAddrInfo(const struct sockaddr * addr, socklen_t addrLen);
+	//! Returns socket file path or socket name in the abstract namespace
+	inline const std::string& path() const
+	{
+		return _path;
+	}
+	//! Returns TRUE if the socket address is in the abstract namespace
+	inline bool isAbstract() const
+	{
+		return _abstractNamespace;
+	}
+	//! Returns a pointer to the socket address structure
+	inline const struct sockaddr * sockAddr() const
+	{
+		return reinterpret_cast<const struct sockaddr *>(&_sockAddr);
+	}
+	//! Returns socket address structure length
+	inline socklen_t sockAddrLen() const
+	{
+		return _sockAddrLen;
+	}
+	//! Returns human-readable socket address: file path, "@name" for the abstract namespace or "unnamed"
+	std::string str() const;
+	//! Returns human-readable address of the socket address structure of AF_UNIX family
+	/*!
+	  \param addr Pointer to the socket address structure of AF_UNIX family
+	  \param addrLen Socket address structure length
+	*/
+	static std::string str(const struct sockaddr * addr, socklen_t addrLen);
+private:
+	UnixAddrInfo();
+
+	std::string _path;
+	bool _abstractNamespace;
+	struct sockaddr_un _sockAddr;
+	socklen_t _sockAddrLen;
+};
+
+} // namespace isl
+
+#endif
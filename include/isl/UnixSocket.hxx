@@ -0,0 +1,59 @@
+#ifndef ISL__UNIX_SOCKET__HXX
+#define ISL__UNIX_SOCKET__HXX
+
+#include <isl/TcpSocket.hxx>
+#include <isl/UnixAddrInfo.hxx>
+
+namespace isl
+{
+
+//! Unix domain stream socket implementation
+/*!
+  Local IPC counterpart of the TcpSocket: it saves the TCP/IP stack processing on the local connections, so the
+  clients on the same host are getting lower latency and higher throughput. Filesystem and Linux abstract namespace
+  socket addresses are supported (see UnixAddrInfo).
+
+  The class reuses TcpSocket I/O implementation, so it could be passed to all TcpSocket consumers (services, HTTP
+  readers/writers, message broker connections) and accepted connections are returned as TcpSocket objects.
+  TCP address info overloads of the TcpSocket are hidden, they throw an exception if called via the base class
+  on the Unix domain socket. Use TcpSocket::localEndpoint()/TcpSocket::remoteEndpoint() on the accepted connections.
+*/
+class UnixSocket : public TcpSocket
+{
+public:
+	//! Constructor
+	UnixSocket();
+	//! Returns local address info if the socket has been bound or connected or throws an exception otherwise
+	UnixAddrInfo localAddr() const;
+	//! Returns remote address info if the socket has been connected or throws an exception otherwise
+	UnixAddrInfo remoteAddr() const;
+	//! Binds socket to the Unix domain socket address
+	/*!
+	  If the socket file exists and nobody listens on it (stale file of the terminated process) it is removed.
+
+	  \param addrInfo Unix domain socket address info to bind to
+	*/
+	void bind(const UnixAddrInfo& addrInfo);
+	//! Connects to the Unix domain socket address
+	/*!
+	  \param addrInfo Unix domain socket address info to connect to
+	*/
+	void connect(const UnixAddrInfo& addrInfo);
+	//! Connects to the Unix domain socket address with timeout
+	/*!
+	  \param addrInfo Unix domain socket address info to connect to
+	  \param timeout Timeout to wait for the connection to be established
+	  \return TRUE if the connection has been established or FALSE if the timeout has been expired
+	*/
+	bool connect(const UnixAddrInfo& addrInfo, const Timeout& timeout);
+private:
+	UnixSocket(const UnixSocket&);								// No copy
+
+	UnixSocket& operator=(const UnixSocket&);						// No copy
+
+	using TcpSocket::connectRacing;
+};
+
+} // namespace isl
+
+#endif
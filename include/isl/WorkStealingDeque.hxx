@@ -0,0 +1,141 @@
+#ifndef ISL__WORK_STEALING_DEQUE__HXX
+#define ISL__WORK_STEALING_DEQUE__HXX
+
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <vector>
+
+namespace isl
+{
+
+//! Bounded lock-free work-stealing deque of pointers (Chase-Lev deque)
+/*!
+  The owner thread pushes and pops the items at the bottom end in LIFO order, other threads are stealing the
+  items from the top end in FIFO order. Push and pop are not using atomic read-modify-write operations unless
+  the deque holds the last item, steal uses one compare-and-swap, so the owner does not contend with the
+  thieves while it has more than one item.
+
+  Capacity is fixed: the owner should check room() before push().
+
+  \note Thread-safe: push(), pop() and room() are to be called by the owner thread only, steal() and size() by any thread
+
+  \tparam T Item class, the deque holds pointers to the items and does not own them
+
+  \sa <a href="http://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf">Dynamic Circular Work-Stealing Deque</a>
+*/
+template <typename T> class WorkStealingDeque
+{
+public:
+	//! Constructs an empty deque
+	/*!
+	  \param capacity Deque capacity, which is rounded up to the power of two
+	*/
+	WorkStealingDeque(size_t capacity) :
+		_buffer(roundCapacity(capacity), static_cast<T *>(0)),
+		_mask(_buffer.size() - 1),
+		_top(0),
+		_bottom(0)
+	{}
+
+	//! Returns deque capacity
+	inline size_t capacity() const
+	{
+		return _buffer.size();
+	}
+	//! Returns an approximate amount of the items in the deque
+	inline size_t size() const
+	{
+		long bottom = __atomic_load_n(&_bottom, __ATOMIC_ACQUIRE);
+		long top = __atomic_load_n(&_top, __ATOMIC_ACQUIRE);
+		return bottom > top ? bottom - top : 0;
+	}
+	//! Returns amount of the items which could be pushed to the deque
+	inline size_t room() const
+	{
+		return _buffer.size() - size();
+	}
+	//! Pushes an item to the bottom of the deque
+	/*!
+	  \param itemPtr Pointer to the item to push
+	*/
+	void push(T * itemPtr)
+	{
+		long bottom = __atomic_load_n(&_bottom, __ATOMIC_RELAXED);
+		if (bottom - __atomic_load_n(&_top, __ATOMIC_ACQUIRE) >= static_cast<long>(_buffer.size())) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Work-stealing deque overflow"));
+		}
+		__atomic_store_n(&_buffer[bottom & _mask], itemPtr, __ATOMIC_RELAXED);
+		// Item should be visible to the thieves before the bottom index
+		__atomic_store_n(&_bottom, bottom + 1, __ATOMIC_RELEASE);
+	}
+	//! Pops an item from the bottom of the deque
+	/*!
+	  \return Pointer to the item or 0 if the deque is empty
+	*/
+	T * pop()
+	{
+		long bottom = __atomic_load_n(&_bottom, __ATOMIC_RELAXED) - 1;
+		__atomic_store_n(&_bottom, bottom, __ATOMIC_RELAXED);
+		// Bottom index decrement should be visible to the thieves before the top index is read
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		long top = __atomic_load_n(&_top, __ATOMIC_RELAXED);
+		if (top > bottom) {
+			// Deque is empty
+			__atomic_store_n(&_bottom, bottom + 1, __ATOMIC_RELAXED);
+			return 0;
+		}
+		T * itemPtr = __atomic_load_n(&_buffer[bottom & _mask], __ATOMIC_RELAXED);
+		if (top == bottom) {
+			// The last item is raced with the thieves
+			if (!__atomic_compare_exchange_n(&_top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+				itemPtr = 0;
+			}
+			__atomic_store_n(&_bottom, bottom + 1, __ATOMIC_RELAXED);
+		}
+		return itemPtr;
+	}
+	//! Steals an item from the top of the deque
+	/*!
+	  \return Pointer to the item or 0 if the deque is empty or the item has been taken by another thread
+	*/
+	T * steal()
+	{
+		long top = __atomic_load_n(&_top, __ATOMIC_ACQUIRE);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		long bottom = __atomic_load_n(&_bottom, __ATOMIC_ACQUIRE);
+		if (top >= bottom) {
+			return 0;
+		}
+		T * itemPtr = __atomic_load_n(&_buffer[top & _mask], __ATOMIC_RELAXED);
+		if (!__atomic_compare_exchange_n(&_top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+			return 0;
+		}
+		return itemPtr;
+	}
+private:
+	WorkStealingDeque();
+	WorkStealingDeque(const WorkStealingDeque&);						// No copy
+
+	WorkStealingDeque& operator=(const WorkStealingDeque&);					// No copy
+
+	static size_t roundCapacity(size_t capacity)
+	{
+		size_t result = 1;
+		while (result < capacity) {
+			result <<= 1;
+		}
+		return result;
+	}
+
+	std::vector<T *> _buffer;
+	const size_t _mask;
+	// Indexes are updated by the different threads, so they are placed on the different cache lines
+	char _topPadding[64];
+	long _top;
+	char _bottomPadding[64];
+	long _bottom;
+};
+
+} // namespace isl
+
+#endif
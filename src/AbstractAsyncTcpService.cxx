@@ -1,4 +1,8 @@
 #include <isl/AbstractAsyncTcpService.hxx>
+#include <isl/ListeningSocketRegistry.hxx>
+#include <isl/SystemCallError.hxx>
+#include <errno.h>
+#include <poll.h>
 
 namespace isl
 {
@@ -10,24 +14,64 @@ namespace isl
 AbstractAsyncTcpService::AbstractAsyncTcpService(Subsystem * owner, size_t maxClients, const Timeout& clockTimeout) :
 	Subsystem(owner, clockTimeout),
 	_taskDispatcher(this, maxClients * 2),
+	_maxClients(maxClients),
+	_maxPendingClients(0),
+	_admissionTimeout(Timeout::defaultTimeout()),
+	_duplexMode(false),
+	_dispatcherShardsAmount(1),
+	_dispatcherShards(),
 	_lastListenerConfigId(),
 	_listenerConfigs(),
+	_unixListenerConfigs(),
 	_listeners()
 {}
 
 AbstractAsyncTcpService::~AbstractAsyncTcpService()
 {
 	resetListenerThreads();
+	resetDispatcherShards();
 }
 
-int AbstractAsyncTcpService::addListener(const TcpAddrInfo& addrInfo, unsigned int backLog)
+AbstractAsyncTcpService::MultiTaskDispatcherType::Counters AbstractAsyncTcpService::counters() const
 {
-	ListenerConfig newListenerConf(addrInfo, backLog);
+	if (_dispatcherShards.empty()) {
+		return _taskDispatcher.counters();
+	}
+	MultiTaskDispatcherType::Counters result;
+	for (DispatcherShardsContainer::const_iterator i = _dispatcherShards.begin(); i != _dispatcherShards.end(); ++i) {
+		MultiTaskDispatcherType::Counters shardCounters = (*i)->counters();
+		result.acceptedTasks += shardCounters.acceptedTasks;
+		result.queuedTasks += shardCounters.queuedTasks;
+		result.rejectedTasks += shardCounters.rejectedTasks;
+		result.expiredTasks += shardCounters.expiredTasks;
+		result.totalAdmissionTime += shardCounters.totalAdmissionTime;
+		if (shardCounters.maxAdmissionTime > result.maxAdmissionTime) {
+			result.maxAdmissionTime = shardCounters.maxAdmissionTime;
+		}
+	}
+	return result;
+}
+
+size_t AbstractAsyncTcpService::workersAmount() const
+{
+	if (_dispatcherShards.empty()) {
+		return _taskDispatcher.workersAmount();
+	}
+	size_t result = 0;
+	for (DispatcherShardsContainer::const_iterator i = _dispatcherShards.begin(); i != _dispatcherShards.end(); ++i) {
+		result += (*i)->workersAmount();
+	}
+	return result;
+}
+
+int AbstractAsyncTcpService::addListener(const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options)
+{
+	ListenerConfig newListenerConf(addrInfo, backLog, shardsAmount, options);
 	_listenerConfigs.insert(ListenerConfigs::value_type(++_lastListenerConfigId, newListenerConf));
 	return _lastListenerConfigId;
 }
 
-void AbstractAsyncTcpService::updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog)
+void AbstractAsyncTcpService::updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options)
 {
 	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
 	if (pos == _listenerConfigs.end()) {
@@ -36,24 +80,84 @@ void AbstractAsyncTcpService::updateListener(int id, const TcpAddrInfo& addrInfo
 	}
 	pos->second.addrInfo = addrInfo;
 	pos->second.backLog = backLog;
+	pos->second.shardsAmount = shardsAmount;
+	pos->second.options = options;
+}
+
+int AbstractAsyncTcpService::addListener(const UnixAddrInfo& addrInfo, unsigned int backLog)
+{
+	UnixListenerConfig newListenerConf(addrInfo, backLog);
+	_unixListenerConfigs.insert(UnixListenerConfigs::value_type(++_lastListenerConfigId, newListenerConf));
+	return _lastListenerConfigId;
+}
+
+void AbstractAsyncTcpService::updateListener(int id, const UnixAddrInfo& addrInfo, unsigned int backLog)
+{
+	UnixListenerConfigs::iterator pos = _unixListenerConfigs.find(id);
+	if (pos == _unixListenerConfigs.end()) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Unix domain socket listener (id = ") << id << ") not found");
+		return;
+	}
+	pos->second.addrInfo = addrInfo;
+	pos->second.backLog = backLog;
 }
 
 void AbstractAsyncTcpService::removeListener(int id)
 {
 	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
-	if (pos == _listenerConfigs.end()) {
-		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
+	if (pos != _listenerConfigs.end()) {
+		_listenerConfigs.erase(pos);
+		return;
+	}
+	UnixListenerConfigs::iterator unixPos = _unixListenerConfigs.find(id);
+	if (unixPos != _unixListenerConfigs.end()) {
+		_unixListenerConfigs.erase(unixPos);
 		return;
 	}
-	_listenerConfigs.erase(pos);
+	Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
 }
 
 void AbstractAsyncTcpService::start()
 {
+	// Creating task dispatcher shards, the first shard is the service's own task dispatcher
+	size_t dispatcherShardsAmount = (_dispatcherShardsAmount > 0) ? _dispatcherShardsAmount : 1;
+	if (_maxClients > 0 && dispatcherShardsAmount > _maxClients) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Task dispatcher shards amount (") << dispatcherShardsAmount <<
+				") exceeds maximum clients amount -> reducing it to " << _maxClients);
+		dispatcherShardsAmount = _maxClients;
+	}
+	size_t workersPerClient = _duplexMode ? 1 : 2;
+	_taskDispatcher.setWorkersAmount(shardShare(_maxClients, dispatcherShardsAmount, 0) * workersPerClient);
+	_dispatcherShards.push_back(&_taskDispatcher);
+	for (size_t i = 1; i < dispatcherShardsAmount; ++i) {
+		std::auto_ptr<MultiTaskDispatcherType> newDispatcherAutoPtr(new MultiTaskDispatcherType(this,
+					shardShare(_maxClients, dispatcherShardsAmount, i) * workersPerClient, clockTimeout()));
+		_dispatcherShards.push_back(newDispatcherAutoPtr.get());
+		newDispatcherAutoPtr.release();
+	}
+	for (size_t i = 0; i < _dispatcherShards.size(); ++i) {
+		MultiTaskDispatcherType& shard = *_dispatcherShards[i];
+		// Zero admission queue size disables the queue, so each shard of the enabled one gets at least one room
+		size_t shardMaxPendingClients = shardShare(_maxPendingClients, dispatcherShardsAmount, i);
+		shard.setMaxAdmissionQueueSize((_maxPendingClients > 0 && shardMaxPendingClients <= 0) ? 1 : shardMaxPendingClients);
+		shard.setAdmissionTimeout(_admissionTimeout);
+		shard.setAdmissionExpiredMethod(&AbstractTask::executeAdmissionExpired);
+	}
 	// Creating listeners
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating listeners"));
+	size_t listenerIndex = 0;
 	for (ListenerConfigs::const_iterator i = _listenerConfigs.begin(); i != _listenerConfigs.end(); ++i) {
-		std::auto_ptr<ListenerThread> newListenerAutoPtr(new ListenerThread(*this, i->second.addrInfo, i->second.backLog));
+		size_t shardsAmount = (i->second.shardsAmount > 0) ? i->second.shardsAmount : 1;
+		for (size_t j = 0; j < shardsAmount; ++j) {
+			std::auto_ptr<ListenerThread> newListenerAutoPtr(new ListenerThread(*this, i->second.addrInfo, i->second.backLog, shardsAmount > 1, i->second.options,
+						*_dispatcherShards[listenerIndex++ % _dispatcherShards.size()]));
+			_listeners.push_back(newListenerAutoPtr.get());
+			newListenerAutoPtr.release();
+		}
+	}
+	for (UnixListenerConfigs::const_iterator i = _unixListenerConfigs.begin(); i != _unixListenerConfigs.end(); ++i) {
+		std::auto_ptr<ListenerThread> newListenerAutoPtr(new ListenerThread(*this, i->second.addrInfo, i->second.backLog,
+					*_dispatcherShards[listenerIndex++ % _dispatcherShards.size()]));
 		_listeners.push_back(newListenerAutoPtr.get());
 		newListenerAutoPtr.release();
 	}
@@ -64,12 +168,15 @@ void AbstractAsyncTcpService::start()
 
 void AbstractAsyncTcpService::stop()
 {
-	// Calling base class method
-	Subsystem::stop();
+	// Stopping listeners before the task dispatchers, so the accepted connections are not dropped
+	stopThreads();
+	stopChildren();
 	// Diposing listeners
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Disposing listeners"));
 	resetListenerThreads();
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listeners have been disposed"));
+	// Disposing task dispatcher shards
+	resetDispatcherShards();
 }
 
 void AbstractAsyncTcpService::resetListenerThreads()
@@ -80,28 +187,136 @@ void AbstractAsyncTcpService::resetListenerThreads()
 	_listeners.clear();
 }
 
+void AbstractAsyncTcpService::resetDispatcherShards()
+{
+	for (DispatcherShardsContainer::iterator i = _dispatcherShards.begin(); i != _dispatcherShards.end(); ++i) {
+		if ((*i) != &_taskDispatcher) {
+			delete (*i);
+		}
+	}
+	_dispatcherShards.clear();
+}
+
+//------------------------------------------------------------------------------
+// AbstractAsyncTcpService::AbstractDuplexTask
+//------------------------------------------------------------------------------
+
+void AbstractAsyncTcpService::AbstractDuplexTask::executeReceiveImpl(MultiTaskDispatcherType& taskDispatcher)
+{
+	try {
+		while (!taskDispatcher.shouldTerminate()) {
+			struct pollfd fds;
+			fds.fd = socket().descriptor();
+			fds.events = awaitWritable() ? (POLLIN | POLLOUT) : POLLIN;
+			fds.revents = 0;
+			int descriptorsCount = poll(&fds, 1, taskDispatcher.clockTimeout().milliSeconds());
+			if (descriptorsCount < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno));
+			}
+			bool isReadable = fds.revents & (POLLIN | POLLHUP | POLLERR);
+			bool isWritable = fds.revents & POLLOUT;
+			if (!onIOEvent(taskDispatcher, isReadable, isWritable)) {
+				Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Full-duplex task has been finished by I/O-event handler"));
+				return;
+			}
+		}
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Full-duplex task termination has been detected"));
+	} catch (Exception& e) {
+		if (e.error().instanceOf<TcpSocket::ConnectionAbortedError>()) {
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Client connection has been aborted"));
+		} else {
+			Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Full-duplex task execution error"));
+		}
+	} catch (std::exception& e) {
+		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Full-duplex task execution error"));
+	} catch (...) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Full-duplex task unknown execution error"));
+	}
+}
+
 //------------------------------------------------------------------------------
 // AbstractAsyncTcpService::ListenerThread
 //------------------------------------------------------------------------------
 
-AbstractAsyncTcpService::ListenerThread::ListenerThread(AbstractAsyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog) :
+AbstractAsyncTcpService::ListenerThread::ListenerThread(AbstractAsyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog, bool reusePort, const TcpSocketOptions& options,
+		MultiTaskDispatcherType& taskDispatcher) :
 	OscillatorThread(service),
 	_service(service),
-	_addrInfo(addrInfo),
+	_addrInfoAutoPtr(new TcpAddrInfo(addrInfo)),
+	_unixAddrInfoAutoPtr(),
 	_backLog(backLog),
-	_serverSocket()
-{}
+	_reusePort(reusePort),
+	_options(options),
+	_taskDispatcher(taskDispatcher),
+	_serverSocket(),
+	_unixServerSocket()
+{
+	// Taking over the listening socket which has been inherited or kept through the restart if any
+	if (ListeningSocketRegistry::instance().adopt(_serverSocket, addrInfo.addrinfo()->ai_addr, addrInfo.addrinfo()->ai_addrlen)) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listening socket bound to ") << addrInfo.firstEndpoint().host << ':' <<
+				addrInfo.firstEndpoint().port << " endpoint has been adopted");
+	}
+}
+
+AbstractAsyncTcpService::ListenerThread::ListenerThread(AbstractAsyncTcpService& service, const UnixAddrInfo& addrInfo, unsigned int backLog,
+		MultiTaskDispatcherType& taskDispatcher) :
+	OscillatorThread(service),
+	_service(service),
+	_addrInfoAutoPtr(),
+	_unixAddrInfoAutoPtr(new UnixAddrInfo(addrInfo)),
+	_backLog(backLog),
+	_reusePort(false),
+	_options(),
+	_taskDispatcher(taskDispatcher),
+	_serverSocket(),
+	_unixServerSocket()
+{
+	if (ListeningSocketRegistry::instance().adopt(_unixServerSocket, addrInfo.sockAddr(), addrInfo.sockAddrLen())) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listening socket bound to \"") << addrInfo.str() <<
+				"\" Unix domain socket address has been adopted");
+	}
+}
+
+AbstractAsyncTcpService::ListenerThread::~ListenerThread()
+{
+	// Parking the listening socket in the registry if the restart is in progress
+	ListeningSocketRegistry::instance().release(_serverSocket);
+	ListeningSocketRegistry::instance().release(_unixServerSocket);
+}
 
 void AbstractAsyncTcpService::ListenerThread::onStart()
 {
 	try {
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener thread has been started"));
-		_serverSocket.open();
-		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been opened"));
-		_serverSocket.bind(_addrInfo);
-		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been binded to ") <<
-                                _addrInfo.firstEndpoint().host << ':' << _addrInfo.firstEndpoint().port << " endpoint");
-		_serverSocket.listen(_backLog);
+		if (_unixServerSocket.isOpen()) {
+			// Listening socket has been adopted in the listening state already
+			return;
+		} else if (_serverSocket.isOpen()) {
+			// Accepted connections profile should be saved in the adopted listening socket too
+			_serverSocket.applyListenerOptions(_options);
+			return;
+		}
+		if (_unixAddrInfoAutoPtr.get()) {
+			_unixServerSocket.open();
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been opened"));
+			_unixServerSocket.bind(*_unixAddrInfoAutoPtr.get());
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been binded to \"") <<
+					_unixAddrInfoAutoPtr->str() << "\" Unix domain socket address");
+			_unixServerSocket.listen(_backLog);
+			ListeningSocketRegistry::instance().add(_unixServerSocket);
+		} else {
+			_serverSocket.open();
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been opened"));
+			_serverSocket.bind(*_addrInfoAutoPtr.get(), _reusePort);
+			_serverSocket.applyListenerOptions(_options);
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been binded to ") <<
+					_addrInfoAutoPtr->firstEndpoint().host << ':' << _addrInfoAutoPtr->firstEndpoint().port << " endpoint");
+			_serverSocket.listen(_backLog);
+			ListeningSocketRegistry::instance().add(_serverSocket);
+		}
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been switched to the listening state"));
 	} catch (std::exception& e) {
 		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Asynchronous TCP-service listener socket initialization error -> exiting from listener thread"));
@@ -114,9 +329,10 @@ void AbstractAsyncTcpService::ListenerThread::onStart()
 
 void AbstractAsyncTcpService::ListenerThread::doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired)
 {
+	TcpSocket& serverSocket = _unixAddrInfoAutoPtr.get() ? _unixServerSocket : _serverSocket;
 	try {
 		while (Timestamp::now() < nextTickTimestamp) {
-			std::auto_ptr<TcpSocket> socketAutoPtr(_serverSocket.accept(nextTickTimestamp.leftTo()));
+			std::auto_ptr<TcpSocket> socketAutoPtr(serverSocket.accept(nextTickTimestamp.leftTo()));
 			if (!socketAutoPtr.get()) {
 				// Accepting TCP-connection timeout expired
 				return;
@@ -126,15 +342,19 @@ void AbstractAsyncTcpService::ListenerThread::doLoad(const Timestamp& prevTickTi
                                                         "New connection has been rejected by onConnected() event handler -> dropping the client"));
                                 continue;
                         }
+			TcpAddrInfo::Endpoint remoteEndpoint = socketAutoPtr.get()->remoteEndpoint();
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "TCP-connection has been received from ") <<
-					socketAutoPtr.get()->remoteAddr().firstEndpoint().host << ':' <<
-					socketAutoPtr.get()->remoteAddr().firstEndpoint().port);
+					remoteEndpoint.host << ':' << remoteEndpoint.port);
 			std::auto_ptr<AbstractTask> taskAutoPtr(_service.createTask(*socketAutoPtr.get()));
 			if (!taskAutoPtr.get()) {
 				throw Exception(Error(SOURCE_LOCATION_ARGS, "Task creation factory method returned zero pointer"));
 			}
 			socketAutoPtr.release();
-			if (!_service._taskDispatcher.perform(taskAutoPtr, &AbstractTask::executeReceive, &AbstractTask::executeSend)) {
+			taskAutoPtr->_servicePtr = &_service;
+			bool taskPerformed = (_service._duplexMode && dynamic_cast<AbstractDuplexTask *>(taskAutoPtr.get())) ?
+				_taskDispatcher.perform(taskAutoPtr, &AbstractTask::executeReceive) :
+				_taskDispatcher.perform(taskAutoPtr, &AbstractTask::executeReceive, &AbstractTask::executeSend);
+			if (!taskPerformed) {
 				Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Too many TCP-connection requests"));
 				_service.onOverload(*taskAutoPtr.get());
 			}
@@ -1,6 +1,8 @@
 #include <isl/AbstractHttpMessageStreamWriter.hxx>
 #include <isl/Exception.hxx>
 #include <isl/Error.hxx>
+#include <isl/Log.hxx>
+#include <isl/ExceptionLogMessage.hxx>
 #include <sstream>
 
 namespace isl
@@ -12,7 +14,12 @@ AbstractHttpMessageStreamWriter::AbstractHttpMessageStreamWriter() :
 	_chunkedHeaderComposed(false),
 	_isFinalizing(false),
 	_sendBuffer(),
-	_bytesSent(0)
+	_bytesSent(0),
+	_fileDescriptor(-1),
+	_fileOffset(0),
+	_fileBytesLeft(0),
+	_fileSuffix(0),
+	_corkedDevicePtr(0)
 {}
 
 AbstractHttpMessageStreamWriter::~AbstractHttpMessageStreamWriter()
@@ -93,16 +100,14 @@ bool AbstractHttpMessageStreamWriter::writeChunk(AbstractIODevice& device, const
 		_sendBuffer.append("\r\n");
 		_chunkedHeaderComposed = true;
 	}
-	// Composing chunk
+	// Composing chunk size line, the chunk data is sent directly from the caller's buffer
 	std::ostringstream chunkSize;
 	chunkSize << std::hex << bufferSize;
 	_sendBuffer.append(chunkSize.str());
 	_sendBuffer.append("\r\n");
-	_sendBuffer.append(buffer, bufferSize);
-	_sendBuffer.append("\r\n");
 	// Sending the data
 	_bytesSent = 0;
-	return flushBuffer(device, limit, bytesWrittenToDevice);
+	return flushBuffer(device, limit, bytesWrittenToDevice, buffer, bufferSize, "\r\n", 2);
 }
 
 bool AbstractHttpMessageStreamWriter::writeOnce(AbstractIODevice& device, const char * buffer, size_t bufferSize, const Timestamp& limit, size_t * bytesWrittenToDevice)
@@ -124,17 +129,81 @@ bool AbstractHttpMessageStreamWriter::writeOnce(AbstractIODevice& device, const
 	} else {
 		removeHeaderField("Content-Length");
 	}
-	// Composing header
+	// Composing header, the body is sent directly from the caller's buffer
 	_sendBuffer.append(composeFirstLine());
 	_sendBuffer.append(composeHeader());
 	_sendBuffer.append("\r\n");
-	if (bufferSize > 0) {
-		// Composing body
-		_sendBuffer.append(buffer, bufferSize);
+	// Sending the data
+	_bytesSent = 0;
+	if (flushBuffer(device, limit, bytesWrittenToDevice, buffer, bufferSize)) {
+		reset();
+		return true;
+	} else {
+		_isFinalizing = true;
+		return false;
+	}
+}
+
+bool AbstractHttpMessageStreamWriter::writeFileChunk(AbstractIODevice& device, int fileDescriptor, off_t offset, size_t size, const Timestamp& limit, size_t * bytesWrittenToDevice)
+{
+	if (bytesWrittenToDevice) {
+		*bytesWrittenToDevice = 0;
+	}
+	if (needFlush()) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Could not send data - flush needed"));
+	}
+	if (size <= 0) {
+		return true;
+	}
+	// Composing data to send
+	if (!_chunkedHeaderComposed) {
+		// Composing header if not comosed one
+		setHeaderField("Transfer-Encoding", "chunked");
+		_sendBuffer.append(composeFirstLine());
+		_sendBuffer.append(composeHeader());
+		_sendBuffer.append("\r\n");
+		_chunkedHeaderComposed = true;
 	}
+	// Composing chunk size line, the chunk data is sent from the file
+	std::ostringstream chunkSize;
+	chunkSize << std::hex << size;
+	_sendBuffer.append(chunkSize.str());
+	_sendBuffer.append("\r\n");
 	// Sending the data
 	_bytesSent = 0;
-	if (flushBuffer(device, limit, bytesWrittenToDevice)) {
+	_fileDescriptor = fileDescriptor;
+	_fileOffset = offset;
+	_fileBytesLeft = size;
+	_fileSuffix = "\r\n";
+	return flushAll(device, limit, bytesWrittenToDevice);
+}
+
+bool AbstractHttpMessageStreamWriter::writeFile(AbstractIODevice& device, int fileDescriptor, off_t offset, size_t size, const Timestamp& limit, size_t * bytesWrittenToDevice)
+{
+	if (bytesWrittenToDevice) {
+		*bytesWrittenToDevice = 0;
+	}
+	if (_chunkedHeaderComposed) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Could not send unencoded data while chunked encoding"));
+	}
+	if (needFlush()) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Could not send data cause flush is needed"));
+	}
+	removeHeaderField("Transfer-Encoding");
+	std::ostringstream contentLength;
+	contentLength << size;
+	setHeaderField("Content-Length", contentLength.str());
+	// Composing header, the body is sent from the file
+	_sendBuffer.append(composeFirstLine());
+	_sendBuffer.append(composeHeader());
+	_sendBuffer.append("\r\n");
+	// Sending the data
+	_bytesSent = 0;
+	_fileDescriptor = fileDescriptor;
+	_fileOffset = offset;
+	_fileBytesLeft = size;
+	_fileSuffix = 0;
+	if (flushAll(device, limit, bytesWrittenToDevice)) {
 		reset();
 		return true;
 	} else {
@@ -184,7 +253,7 @@ bool AbstractHttpMessageStreamWriter::flush(AbstractIODevice& device, const Time
 	if (!needFlush()) {
 		return true;
 	}
-	bool sendBufferFlushed = flushBuffer(device, limit, bytesWrittenToDevice);
+	bool sendBufferFlushed = flushAll(device, limit, bytesWrittenToDevice);
 	if (sendBufferFlushed && _isFinalizing) {
 		reset();
 	}
@@ -199,6 +268,21 @@ void AbstractHttpMessageStreamWriter::reset()
 	_isFinalizing = false;
 	_sendBuffer.clear();
 	_bytesSent = 0;
+	_fileDescriptor = -1;
+	_fileOffset = 0;
+	_fileBytesLeft = 0;
+	_fileSuffix = 0;
+	if (_corkedDevicePtr) {
+		// Partial frame of the aborted transmission should not be held back until the next message
+		if (_corkedDevicePtr->isOpen()) {
+			try {
+				_corkedDevicePtr->setCorked(false);
+			} catch (std::exception& e) {
+				Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Uncorking the I/O-device on HTTP-message writer reset error"));
+			}
+		}
+		_corkedDevicePtr = 0;
+	}
 }
 
 std::string AbstractHttpMessageStreamWriter::composeHeader()
@@ -217,36 +301,142 @@ std::string AbstractHttpMessageStreamWriter::composeHeader()
 	return result;
 }
 
-bool AbstractHttpMessageStreamWriter::flushBuffer(AbstractIODevice& device, const Timestamp& limit, size_t * bytesWrittenToDevice)
+bool AbstractHttpMessageStreamWriter::flushBuffer(AbstractIODevice& device, const Timestamp& limit, size_t * bytesWrittenToDevice,
+		const char * body, size_t bodySize, const char * bodySuffix, size_t bodySuffixSize)
 {
 	if (bytesWrittenToDevice) {
 		*bytesWrittenToDevice = 0;
 	}
+	AbstractIODevice::ConstBuffer buffers[3];
+	size_t buffersAmount = 0;
 	while (true) {
-		size_t bytesSent = device.write(_sendBuffer.data() + _bytesSent, _sendBuffer.size() - _bytesSent, limit.leftTo());
-		if (bytesSent > 0) {
-			// Some data has been sent
-			if (!_transmissionStarted) {
-				_transmissionStarted = true;
-			}
-			_bytesSent += bytesSent;
-			if (bytesWrittenToDevice) {
-				(*bytesWrittenToDevice) += bytesSent;
-			}
-			if (_bytesSent >= _sendBuffer.size()) {
-				// Buffer has been flushed -> reset buffer
-				_sendBuffer.clear();
-				_bytesSent = 0;
-				return true;
-			}
-			if (Timestamp::now() >= limit) {
-				return false;
-			}
-		} else {
+		buffersAmount = composeUnsentBuffers(buffers, body, bodySize, bodySuffix, bodySuffixSize);
+		if (buffersAmount <= 0) {
+			// Buffer has been flushed -> reset buffer
+			_sendBuffer.clear();
+			_bytesSent = 0;
+			return true;
+		}
+		size_t bytesSent = device.writeVector(buffers, buffersAmount, limit.leftTo());
+		if (bytesSent <= 0) {
 			// No data has been sent -> timeout expired
+			break;
+		}
+		// Some data has been sent
+		if (!_transmissionStarted) {
+			_transmissionStarted = true;
+		}
+		_bytesSent += bytesSent;
+		if (bytesWrittenToDevice) {
+			(*bytesWrittenToDevice) += bytesSent;
+		}
+		if (_bytesSent >= _sendBuffer.size() + bodySize + bodySuffixSize) {
+			// Buffer has been flushed -> reset buffer
+			_sendBuffer.clear();
+			_bytesSent = 0;
+			return true;
+		}
+		if (Timestamp::now() >= limit) {
+			buffersAmount = composeUnsentBuffers(buffers, body, bodySize, bodySuffix, bodySuffixSize);
+			break;
+		}
+	}
+	if (bodySize + bodySuffixSize > 0) {
+		// Copying the unsent rest of the caller's data to the send buffer, cause it could be invalid on flush() call
+		std::string unsentData;
+		for (size_t i = 0; i < buffersAmount; ++i) {
+			unsentData.append(buffers[i].data, buffers[i].size);
+		}
+		_sendBuffer.swap(unsentData);
+		_bytesSent = 0;
+	}
+	return false;
+}
+
+bool AbstractHttpMessageStreamWriter::flushAll(AbstractIODevice& device, const Timestamp& limit, size_t * bytesWrittenToDevice)
+{
+	if (bytesWrittenToDevice) {
+		*bytesWrittenToDevice = 0;
+	}
+	size_t bytesWritten = 0;
+	if (!_corkedDevicePtr && _fileBytesLeft > 0 && !_sendBuffer.empty()) {
+		// Holding back the header's partial frame until the file data follows it
+		device.setCorked(true);
+		_corkedDevicePtr = &device;
+	}
+	// Sending the send buffer
+	if (!_sendBuffer.empty()) {
+		bool sendBufferFlushed = flushBuffer(device, limit, &bytesWritten);
+		if (bytesWrittenToDevice) {
+			(*bytesWrittenToDevice) += bytesWritten;
+		}
+		if (!sendBufferFlushed) {
+			return false;
+		}
+	}
+	// Sending the file data
+	while (_fileBytesLeft > 0) {
+		size_t bytesSent = device.sendFile(_fileDescriptor, _fileOffset, _fileBytesLeft, limit.leftTo());
+		if (bytesSent <= 0) {
+			// No data has been sent -> timeout expired
+			return false;
+		}
+		if (!_transmissionStarted) {
+			_transmissionStarted = true;
+		}
+		_fileOffset += bytesSent;
+		_fileBytesLeft -= bytesSent;
+		if (bytesWrittenToDevice) {
+			(*bytesWrittenToDevice) += bytesSent;
+		}
+		if (_fileBytesLeft > 0 && Timestamp::now() >= limit) {
+			return false;
+		}
+	}
+	_fileDescriptor = -1;
+	// Sending the file data suffix
+	if (_fileSuffix) {
+		_sendBuffer.append(_fileSuffix);
+		_bytesSent = 0;
+		_fileSuffix = 0;
+		bool sendBufferFlushed = flushBuffer(device, limit, &bytesWritten);
+		if (bytesWrittenToDevice) {
+			(*bytesWrittenToDevice) += bytesWritten;
+		}
+		if (!sendBufferFlushed) {
 			return false;
 		}
 	}
+	if (_corkedDevicePtr) {
+		// Sending the rest of the data
+		_corkedDevicePtr->setCorked(false);
+		_corkedDevicePtr = 0;
+	}
+	return true;
+}
+
+size_t AbstractHttpMessageStreamWriter::composeUnsentBuffers(AbstractIODevice::ConstBuffer * buffers, const char * body, size_t bodySize,
+		const char * bodySuffix, size_t bodySuffixSize) const
+{
+	// Data to send is a concatenation of the send buffer, the body and the body suffix, _bytesSent is an offset in it
+	size_t buffersAmount = 0;
+	size_t offset = _bytesSent;
+	if (offset < _sendBuffer.size()) {
+		buffers[buffersAmount++] = AbstractIODevice::ConstBuffer(_sendBuffer.data() + offset, _sendBuffer.size() - offset);
+		offset = 0;
+	} else {
+		offset -= _sendBuffer.size();
+	}
+	if (offset < bodySize) {
+		buffers[buffersAmount++] = AbstractIODevice::ConstBuffer(body + offset, bodySize - offset);
+		offset = 0;
+	} else {
+		offset -= bodySize;
+	}
+	if (offset < bodySuffixSize) {
+		buffers[buffersAmount++] = AbstractIODevice::ConstBuffer(bodySuffix + offset, bodySuffixSize - offset);
+	}
+	return buffersAmount;
 }
 
 } // namespace isl
@@ -3,8 +3,12 @@
 #include <isl/LogMessage.hxx>
 #include <isl/Exception.hxx>
 #include <isl/Error.hxx>
+#include <isl/SystemCallError.hxx>
 //#include <isl/IOError.hxx>
 #include <cstring>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
 
 namespace isl
 {
@@ -60,4 +64,91 @@ size_t AbstractIODevice::write(const char * buffer, size_t bufferSize, const Tim
 	return writeImplementation(buffer, bufferSize, timeout);
 }
 
+size_t AbstractIODevice::writeVector(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout)
+{
+	if (!_isOpen) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	// Skipping leading empty buffers
+	while (buffersAmount > 0 && buffers->size <= 0) {
+		++buffers;
+		--buffersAmount;
+	}
+	if (buffersAmount <= 0) {
+		return 0;
+	}
+	return writeVectorImplementation(buffers, buffersAmount, timeout);
+}
+
+size_t AbstractIODevice::sendFile(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout)
+{
+	if (!_isOpen) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	if (size <= 0) {
+		return 0;
+	}
+	return sendFileImplementation(fileDescriptor, offset, size, timeout);
+}
+
+void AbstractIODevice::setCorked(bool newValue)
+{
+	if (!_isOpen) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	setCorkedImplementation(newValue);
+}
+
+size_t AbstractIODevice::writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout)
+{
+	return writeImplementation(buffers->data, buffers->size, timeout);
+}
+
+size_t AbstractIODevice::sendFileImplementation(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout)
+{
+	char buffer[ISL__IO_DEVICE_SEND_FILE_BUFFER_SIZE];
+	ssize_t bytesRead;
+	do {
+		bytesRead = pread(fileDescriptor, buffer, size < sizeof(buffer) ? size : sizeof(buffer), offset);
+	} while (bytesRead < 0 && errno == EINTR);
+	if (bytesRead < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PRead, errno));
+	} else if (bytesRead == 0) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Unexpected end of file while sending it to the I/O-device"));
+	}
+	return writeImplementation(buffer, bytesRead, timeout);
+}
+
+void AbstractIODevice::setCorkedImplementation(bool newValue)
+{}
+
+short AbstractIODevice::pollDescriptor(int descriptor, short events, const Timeout& timeout, Timestamp& limit)
+{
+	if (timeout.isZero()) {
+		return -1;
+	}
+	// Limit timestamp is calculated on the first wait only, so the fast path does not call clock_gettime(2)
+	Timeout timeLeft = timeout;
+	if (limit.isZero()) {
+		limit = Timestamp::limit(timeout);
+	} else {
+		timeLeft = limit.leftTo();
+		if (timeLeft.isZero()) {
+			return -1;
+		}
+	}
+	struct pollfd fds;
+	fds.fd = descriptor;
+	fds.events = events;
+	fds.revents = 0;
+	int descriptorsCount = poll(&fds, 1, timeLeft.milliSeconds());
+	if (descriptorsCount < 0) {
+		if (errno == EINTR) {
+			return 0;
+		}
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno));
+	}
+	return descriptorsCount > 0 ? fds.revents : -1;
+}
+
 } // namespace isl
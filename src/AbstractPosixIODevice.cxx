@@ -2,16 +2,18 @@
 #include <isl/Log.hxx>
 #include <isl/LogMessage.hxx>
 #include <isl/ErrorLogMessage.hxx>
+#include <isl/Timestamp.hxx>
+#include <isl/IoUring.hxx>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
 
 #include <isl/Exception.hxx>
 #include <isl/SystemCallError.hxx>
 #include <isl/Error.hxx>
-#include <iostream>
-#include <sys/socket.h>
 
 namespace isl
 {
@@ -26,7 +28,9 @@ AbstractPosixIODevice::AbstractPosixIODevice(int handle) :
 	AbstractIODevice_NEW(),
 	_handle(handle),
 	_isOpen(true)
-{}
+{
+	setNonBlocking();
+}
 
 AbstractPosixIODevice::~AbstractPosixIODevice()
 {
@@ -43,6 +47,7 @@ void AbstractPosixIODevice::open()
 	}
 	_handle = openImpl();
 	_isOpen = true;
+	setNonBlocking();
 }
 
 void AbstractPosixIODevice::close()
@@ -71,35 +76,46 @@ size_t AbstractPosixIODevice::read(char * buffer, size_t bufferSize, const Timeo
 	if (!_isOpen) {
 		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
-	// Awaiting for the data
-	timespec readTimeout = timeout.timeSpec();
-	fd_set readDescriptorsSet;
-	FD_ZERO(&readDescriptorsSet);
-	FD_SET(_handle, &readDescriptorsSet);
-	fd_set exceptDescriptorsSet;
-	FD_ZERO(&exceptDescriptorsSet);
-	FD_SET(_handle, &exceptDescriptorsSet);
-	int descriptorsCount = pselect(_handle + 1, &readDescriptorsSet, NULL, &exceptDescriptorsSet, &readTimeout, NULL);
-	if (descriptorsCount < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PSelect, errno));
-	} else if (descriptorsCount == 0) {
-		// Timeout expired
-		return 0;
-	}
-	// Inspecting for exception
-	if (FD_ISSET(_handle, &exceptDescriptorsSet)) {
-		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Exception occured on file descriptor while reading the data from the I/O device"));
-		onReadException();
-		return 0;
-	}
-	// Reading the data
-	ssize_t bytesReceived = ::read(_handle, buffer, bufferSize);
-	if (bytesReceived < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Read, errno));
-	} else if (bytesReceived == 0) {
-		onReadEndOfFile();
+	Timestamp limit;
+	while (true) {
+		// Trying to read the data first
+		ssize_t bytesReceived = ::read(_handle, buffer, bufferSize);
+		if (bytesReceived > 0) {
+			return bytesReceived;
+		} else if (bytesReceived == 0) {
+			onReadEndOfFile();
+			return 0;
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Read, errno));
+		}
+		IoUring * ioUringPtr = (timeout.isZero() || !limit.isZero()) ? 0 : IoUring::threadInstance();
+		if (ioUringPtr) {
+			// No data available -> reading the data with the timeout using one io_uring_enter(2) call
+			int result = ioUringPtr->read(_handle, buffer, bufferSize, timeout);
+			if (result > 0) {
+				return result;
+			} else if (result == 0) {
+				onReadEndOfFile();
+				return 0;
+			} else if (result == -ETIME || result == -EINTR) {
+				return 0;
+			}
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Read, -result));
+		}
+		// No data available -> awaiting for the data for the rest of the timeout
+		short revents = awaitHandle(POLLIN | POLLPRI, timeout, limit);
+		if (revents < 0) {
+			// Timeout expired
+			return 0;
+		} else if (revents & POLLPRI) {
+			Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Exception occured on file descriptor while reading the data from the I/O device"));
+			onReadException();
+			return 0;
+		}
 	}
-	return bytesReceived;
 }
 
 size_t AbstractPosixIODevice::write(const char * buffer, size_t bufferSize, const Timeout& timeout)
@@ -107,94 +123,91 @@ size_t AbstractPosixIODevice::write(const char * buffer, size_t bufferSize, cons
 	if (!_isOpen) {
 		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
-	timespec writeTimeout = timeout.timeSpec();
-	fd_set writeDescriptorsSet;
-	FD_ZERO(&writeDescriptorsSet);
-	FD_SET(_handle, &writeDescriptorsSet);
-	fd_set exceptDescriptorsSet;
-	FD_ZERO(&exceptDescriptorsSet);
-	FD_SET(_handle, &exceptDescriptorsSet);
-	int descriptorsCount = pselect(_handle + 1, NULL, &writeDescriptorsSet, &exceptDescriptorsSet, &writeTimeout, NULL);
-	if (descriptorsCount < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PSelect, errno));
-	} else if (descriptorsCount == 0) {
-		// Timeout expired
-		return 0;
-	}
-	// Inspecting for exception
-	if (FD_ISSET(_handle, &exceptDescriptorsSet)) {
-		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Exception occured on file descriptor while writing the data to the I/O device"));
-		onWriteException();
-		return 0;
-	}
-	// Writing the data
-	//ssize_t bytesSent = ::send(_handle, buffer, bufferSize, MSG_NOSIGNAL);
-	ssize_t bytesSent = ::write(_handle, buffer, bufferSize);
-	if (bytesSent < 0) {
-		if (errno == EPIPE) {
+	Timestamp limit;
+	while (true) {
+		// Trying to write the data first
+		ssize_t bytesSent = ::write(_handle, buffer, bufferSize);
+		if (bytesSent > 0) {
+			return bytesSent;
+		} else if (bytesSent == 0) {
+			// Connection has been aborted by the client.
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Connection aborted"));
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno == EPIPE) {
 			// Handled because send(2) man page says: "EPIPE: The local end has been shut down on a connection oriented socket.
 			// In this case the process will also receive a SIGPIPE unless MSG_NOSIGNAL is set."
-			//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
-
-			std::cout << "EPIPE has been returned by send()" << std::endl;
-
-			//throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
 			throw Exception(Error(SOURCE_LOCATION_ARGS, "Connection aborted"));
-		} else {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Send, errno));
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Write, errno));
+		}
+		IoUring * ioUringPtr = (timeout.isZero() || !limit.isZero()) ? 0 : IoUring::threadInstance();
+		if (ioUringPtr) {
+			// Device is not ready -> writing the data with the timeout using one io_uring_enter(2) call
+			int result = ioUringPtr->write(_handle, buffer, bufferSize, timeout);
+			if (result > 0) {
+				return result;
+			} else if (result == 0 || result == -EPIPE) {
+				throw Exception(Error(SOURCE_LOCATION_ARGS, "Connection aborted"));
+			} else if (result == -ETIME || result == -EINTR) {
+				return 0;
+			}
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Write, -result));
+		}
+		// Device is not ready -> awaiting for the device to become writable for the rest of the timeout
+		short revents = awaitHandle(POLLOUT | POLLPRI, timeout, limit);
+		if (revents < 0) {
+			// Timeout expired
+			return 0;
+		} else if (revents & POLLPRI) {
+			Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Exception occured on file descriptor while writing the data to the I/O device"));
+			onWriteException();
+			return 0;
 		}
-		//if (errno == EAGAIN || errno == EWOULDBLOCK) {
-		//	// No more data available
-		//	return totalBytesSent;
-		//} else {
-		//	throw Exception(SystemCallError(SystemCallError::Send, errno, SOURCE_LOCATION_ARGS));
-		//}
-	} else if (bytesSent == 0) {
-		// Connection has been aborted by the client.
-		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
-
-		std::cout << "Zero bytes has been sent by send()" << std::endl;
-
-		//throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
-		throw Exception(Error(SOURCE_LOCATION_ARGS, "Connection aborted"));
 	}
-	return bytesSent;
-
-
+}
 
-	/*timespec writeTimeout = timeout.timeSpec();
-	fd_set writeDescriptorsSet;
-	FD_ZERO(&writeDescriptorsSet);
-	FD_SET(_handle, &writeDescriptorsSet);
-	int descriptorsCount = pselect(_handle + 1, NULL, &writeDescriptorsSet, NULL, &writeTimeout, NULL);
+short AbstractPosixIODevice::awaitHandle(short events, const Timeout& timeout, Timestamp& limit)
+{
+	if (timeout.isZero()) {
+		return -1;
+	}
+	// Limit timestamp is calculated on the first wait only, so the fast path does not call clock_gettime(2)
+	Timeout timeLeft = timeout;
+	if (limit.isZero()) {
+		limit = Timestamp::limit(timeout);
+	} else {
+		timeLeft = limit.leftTo();
+		if (timeLeft.isZero()) {
+			return -1;
+		}
+	}
+	struct pollfd fds;
+	fds.fd = _handle;
+	fds.events = events;
+	fds.revents = 0;
+	int descriptorsCount = poll(&fds, 1, timeLeft.milliSeconds());
 	if (descriptorsCount < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PSelect, errno));
-	} else if (descriptorsCount == 0) {
-		// Timeout expired
-		return 0;
+		if (errno == EINTR) {
+			return 0;
+		}
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno));
 	}
-	ssize_t bytesSent = ::send(_handle, buffer, bufferSize, MSG_NOSIGNAL);
-	if (bytesSent < 0) {
-		if (errno == EPIPE) {
-			// Handled because send(2) man page says: "EPIPE: The local end has been shut down on a connection oriented socket.
-			// In this case the process will also receive a SIGPIPE unless MSG_NOSIGNAL is set."
-			//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
-			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
-		} else {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Send, errno));
+	return descriptorsCount > 0 ? fds.revents : -1;
+}
+
+void AbstractPosixIODevice::setNonBlocking()
+{
+	int flags = fcntl(_handle, F_GETFL, 0);
+	if (flags < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
+	}
+	if (!(flags & O_NONBLOCK)) {
+		if (fcntl(_handle, F_SETFL, flags | O_NONBLOCK) < 0) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
 		}
-		//if (errno == EAGAIN || errno == EWOULDBLOCK) {
-		//	// No more data available
-		//	return totalBytesSent;
-		//} else {
-		//	throw Exception(SystemCallError(SystemCallError::Send, errno, SOURCE_LOCATION_ARGS));
-		//}
-	} else if (bytesSent == 0) {
-		// Connection has been aborted by the client.
-		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
-		throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
 	}
-	return bytesSent;*/
 }
 
 } // namespace isl
@@ -0,0 +1,461 @@
+#include <isl/AbstractReactorTcpService.hxx>
+#include <isl/ListeningSocketRegistry.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <isl/SystemCallError.hxx>
+#include <errno.h>
+#include <unistd.h>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// AbstractReactorTcpService
+//------------------------------------------------------------------------------
+
+AbstractReactorTcpService::AbstractReactorTcpService(Subsystem * owner, size_t workersAmount, size_t reactorsAmount, const Timeout& clockTimeout) :
+	Subsystem(owner, clockTimeout),
+	_taskDispatcher(this, workersAmount),
+	_reactorsAmount(reactorsAmount),
+	_maxEvents(DefaultMaxEvents),
+	_timerResolution(0, TimingWheel::DefaultResolution),
+	_lastListenerConfigId(),
+	_listenerConfigs(),
+	_listeners(),
+	_reactors()
+{}
+
+AbstractReactorTcpService::~AbstractReactorTcpService()
+{
+	resetListenerThreads();
+	resetReactorThreads();
+}
+
+size_t AbstractReactorTcpService::connectionsAmount() const
+{
+	size_t result = 0;
+	for (ReactorsContainer::const_iterator i = _reactors.begin(); i != _reactors.end(); ++i) {
+		result += (*i)->connectionsAmount();
+	}
+	return result;
+}
+
+int AbstractReactorTcpService::addListener(const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options)
+{
+	ListenerConfig newListenerConf(addrInfo, backLog, shardsAmount, options);
+	_listenerConfigs.insert(ListenerConfigs::value_type(++_lastListenerConfigId, newListenerConf));
+	return _lastListenerConfigId;
+}
+
+void AbstractReactorTcpService::updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options)
+{
+	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
+	if (pos == _listenerConfigs.end()) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
+		return;
+	}
+	pos->second.addrInfo = addrInfo;
+	pos->second.backLog = backLog;
+	pos->second.shardsAmount = shardsAmount;
+	pos->second.options = options;
+}
+
+void AbstractReactorTcpService::removeListener(int id)
+{
+	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
+	if (pos == _listenerConfigs.end()) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
+		return;
+	}
+	_listenerConfigs.erase(pos);
+}
+
+void AbstractReactorTcpService::start()
+{
+	// Creating reactors
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating reactors"));
+	for (size_t i = 0; i < (_reactorsAmount > 0 ? _reactorsAmount : 1); ++i) {
+		std::auto_ptr<ReactorThread> newReactorAutoPtr(new ReactorThread(*this));
+		_reactors.push_back(newReactorAutoPtr.get());
+		newReactorAutoPtr.release();
+	}
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Reactors have been created"));
+	// Creating listeners
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating listeners"));
+	for (ListenerConfigs::const_iterator i = _listenerConfigs.begin(); i != _listenerConfigs.end(); ++i) {
+		size_t shardsAmount = (i->second.shardsAmount > 0) ? i->second.shardsAmount : 1;
+		for (size_t j = 0; j < shardsAmount; ++j) {
+			std::auto_ptr<ListenerThread> newListenerAutoPtr(new ListenerThread(*this, i->second.addrInfo, i->second.backLog, shardsAmount > 1, i->second.options));
+			_listeners.push_back(newListenerAutoPtr.get());
+			newListenerAutoPtr.release();
+		}
+	}
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listeners have been created"));
+	// Starting workers before the reactors, so the first I/O-events are not rejected
+	startChildren();
+	startThreads();
+}
+
+void AbstractReactorTcpService::stop()
+{
+	// Stopping listeners and reactors before the workers, so the I/O-events are not rejected and onOverload()
+	// is not called while the service is shutting down
+	stopThreads();
+	stopChildren();
+	// Diposing listeners
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Disposing listeners"));
+	resetListenerThreads();
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listeners have been disposed"));
+	// Diposing reactors with all client connections they are holding
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Disposing reactors"));
+	resetReactorThreads();
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Reactors have been disposed"));
+}
+
+void AbstractReactorTcpService::resetListenerThreads()
+{
+	for (ListenersContainer::iterator i = _listeners.begin(); i != _listeners.end(); ++i) {
+		delete (*i);
+	}
+	_listeners.clear();
+}
+
+void AbstractReactorTcpService::resetReactorThreads()
+{
+	for (ReactorsContainer::iterator i = _reactors.begin(); i != _reactors.end(); ++i) {
+		delete (*i);
+	}
+	_reactors.clear();
+}
+
+//------------------------------------------------------------------------------
+// AbstractReactorTcpService::AbstractTask::DeadlineTimer
+//------------------------------------------------------------------------------
+
+void AbstractReactorTcpService::AbstractTask::DeadlineTimer::onExpired()
+{
+	_task._reactorPtr->onTaskExpired(_task);
+}
+
+//------------------------------------------------------------------------------
+// AbstractReactorTcpService::Event
+//------------------------------------------------------------------------------
+
+void AbstractReactorTcpService::Event::execute(TaskDispatcher<Event>& taskDispatcher)
+{
+	ReactorThread& reactor = *_task._reactorPtr;
+	bool keepConnection = true;
+	try {
+		if (_isTimedOut) {
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Client connection I/O-readiness timeout has been expired"));
+			keepConnection = _task.onTimeout();
+		}
+		if (keepConnection && (_events & EPOLLERR)) {
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Error condition has been detected on client connection socket"));
+			keepConnection = false;
+		}
+		if (keepConnection && (_events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))) {
+			keepConnection = _task.onReadable();
+		}
+		if (keepConnection && (_events & EPOLLOUT)) {
+			keepConnection = _task.onWritable();
+		}
+		if (keepConnection) {
+			reactor.rearmTask(_task);
+		}
+	} catch (Exception& e) {
+		if (e.error().instanceOf<TcpSocket::ConnectionAbortedError>()) {
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Client connection has been aborted"));
+		} else {
+			Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Reactor TCP-service task execution error -> closing client connection"));
+		}
+		keepConnection = false;
+	} catch (std::exception& e) {
+		Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Reactor TCP-service task execution error -> closing client connection"));
+		keepConnection = false;
+	} catch (...) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Reactor TCP-service task unknown execution error -> closing client connection"));
+		keepConnection = false;
+	}
+	if (!keepConnection) {
+		reactor.removeTask(_task);
+	}
+}
+
+//------------------------------------------------------------------------------
+// AbstractReactorTcpService::ReactorThread
+//------------------------------------------------------------------------------
+
+AbstractReactorTcpService::ReactorThread::ReactorThread(AbstractReactorTcpService& service) :
+	OscillatorThread(service),
+	_service(service),
+	_epollDescriptor(epoll_create1(EPOLL_CLOEXEC)),
+	_tasksMutex(),
+	_timingWheel(service._timerResolution),
+	_tasks(),
+	_expiredTasks(),
+	_events(service._maxEvents > 0 ? service._maxEvents : 1)
+{
+	if (_epollDescriptor < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::EpollCreate, errno));
+	}
+}
+
+AbstractReactorTcpService::ReactorThread::~ReactorThread()
+{
+	for (TasksContainer::iterator i = _tasks.begin(); i != _tasks.end(); ++i) {
+		delete (*i);
+	}
+	if (::close(_epollDescriptor)) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Close, errno).message()));
+	}
+}
+
+size_t AbstractReactorTcpService::ReactorThread::connectionsAmount() const
+{
+	MutexLocker locker(_tasksMutex);
+	return _tasks.size();
+}
+
+void AbstractReactorTcpService::ReactorThread::addTask(std::auto_ptr<AbstractTask>& taskAutoPtr)
+{
+	AbstractTask * taskPtr = taskAutoPtr.get();
+	taskPtr->_reactorPtr = this;
+	MutexLocker locker(_tasksMutex);
+	struct epoll_event ev;
+	ev.events = eventsMask(*taskPtr);
+	ev.data.ptr = taskPtr;
+	if (epoll_ctl(_epollDescriptor, EPOLL_CTL_ADD, taskPtr->socket().descriptor(), &ev)) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::EpollCtl, errno));
+	}
+	taskPtr->_isRegistered = true;
+	if (!taskPtr->_timeout.isZero()) {
+		_timingWheel.schedule(taskPtr->_deadlineTimer, Timestamp::limit(taskPtr->_timeout));
+	}
+	_tasks.insert(taskPtr);
+	taskAutoPtr.release();
+}
+
+void AbstractReactorTcpService::ReactorThread::rearmTask(AbstractTask& task)
+{
+	struct epoll_event ev;
+	ev.events = eventsMask(task);
+	ev.data.ptr = &task;
+	// Deadline should be armed before the connection, which could be fetched by the reactor thread at once
+	MutexLocker locker(_tasksMutex);
+	if (!task._timeout.isZero()) {
+		_timingWheel.schedule(task._deadlineTimer, Timestamp::limit(task._timeout));
+	}
+	if (epoll_ctl(_epollDescriptor, task._isRegistered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, task.socket().descriptor(), &ev)) {
+		_timingWheel.cancel(task._deadlineTimer);
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::EpollCtl, errno));
+	}
+	task._isRegistered = true;
+}
+
+void AbstractReactorTcpService::ReactorThread::removeTask(AbstractTask& task)
+{
+	{
+		MutexLocker locker(_tasksMutex);
+		_timingWheel.cancel(task._deadlineTimer);
+		_tasks.erase(&task);
+	}
+	// Closing the socket removes it from the epoll set
+	delete &task;
+}
+
+void AbstractReactorTcpService::ReactorThread::onTaskExpired(AbstractTask& task)
+{
+	// Unregistering the connection, so the reactor would not fetch it while the worker is handling the timeout
+	if (epoll_ctl(_epollDescriptor, EPOLL_CTL_DEL, task.socket().descriptor(), 0)) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::EpollCtl, errno).message()));
+	}
+	task._isRegistered = false;
+	_expiredTasks.push_back(&task);
+}
+
+uint32_t AbstractReactorTcpService::ReactorThread::eventsMask(const AbstractTask& task)
+{
+	uint32_t result = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	if (task.awaitWritable()) {
+		result |= EPOLLOUT;
+	}
+	return result;
+}
+
+void AbstractReactorTcpService::ReactorThread::dispatch(AbstractTask& task, uint32_t events, bool isTimedOut)
+{
+	std::auto_ptr<Event> eventAutoPtr(new Event(task, events, isTimedOut));
+	if (!_service._taskDispatcher.perform(eventAutoPtr, &Event::execute)) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Too many I/O-events to handle -> closing client connection"));
+		_service.onOverload(task);
+		removeTask(task);
+	}
+}
+
+void AbstractReactorTcpService::ReactorThread::doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired)
+{
+	try {
+		while (true) {
+			Timestamp now = Timestamp::now();
+			if (now >= nextTickTimestamp) {
+				break;
+			}
+			// Waking up on each timing wheel tick if there are connection deadlines to watch for
+			Timeout waitTimeout = nextTickTimestamp - now;
+			{
+				MutexLocker locker(_tasksMutex);
+				if (!_timingWheel.isEmpty() && _timingWheel.resolution() < waitTimeout) {
+					waitTimeout = _timingWheel.resolution();
+				}
+			}
+			int eventsCount = epoll_wait(_epollDescriptor, &_events[0], _events.size(), waitTimeout.milliSeconds());
+			if (eventsCount < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::EpollWait, errno));
+			}
+			if (eventsCount > 0) {
+				// Cancelling deadlines of the connections which I/O-readiness events have been fetched
+				MutexLocker locker(_tasksMutex);
+				for (int i = 0; i < eventsCount; ++i) {
+					_timingWheel.cancel(static_cast<AbstractTask *>(_events[i].data.ptr)->_deadlineTimer);
+				}
+			}
+			for (int i = 0; i < eventsCount; ++i) {
+				dispatch(*static_cast<AbstractTask *>(_events[i].data.ptr), _events[i].events, false);
+			}
+			// Expiring connection deadlines
+			{
+				MutexLocker locker(_tasksMutex);
+				_timingWheel.advance();
+			}
+			for (ExpiredTasksContainer::iterator i = _expiredTasks.begin(); i != _expiredTasks.end(); ++i) {
+				dispatch(**i, 0, true);
+			}
+			_expiredTasks.clear();
+		}
+	} catch (std::exception& e) {
+		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Reactor TCP-service reactor execution error -> exiting from reactor thread"));
+		appointTermination();
+	} catch (...) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Reactor TCP-service reactor unknown execution error -> exiting from reactor thread"));
+		appointTermination();
+	}
+}
+
+//------------------------------------------------------------------------------
+// AbstractReactorTcpService::ListenerThread
+//------------------------------------------------------------------------------
+
+AbstractReactorTcpService::ListenerThread::ListenerThread(AbstractReactorTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog, bool reusePort, const TcpSocketOptions& options) :
+	OscillatorThread(service),
+	_service(service),
+	_addrInfo(addrInfo),
+	_backLog(backLog),
+	_reusePort(reusePort),
+	_options(options),
+	_serverSocket(),
+	_acceptorAutoPtr(),
+	_nextReactorIndex(0)
+{
+	// Taking over the listening socket which has been inherited or kept through the restart if any
+	if (ListeningSocketRegistry::instance().adopt(_serverSocket, addrInfo.addrinfo()->ai_addr, addrInfo.addrinfo()->ai_addrlen)) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listening socket bound to ") << addrInfo.firstEndpoint().host << ':' <<
+				addrInfo.firstEndpoint().port << " endpoint has been adopted");
+	}
+}
+
+AbstractReactorTcpService::ListenerThread::~ListenerThread()
+{
+	// Pending accept operations are cancelled before the listening socket is released
+	_acceptorAutoPtr.reset();
+	// Parking the listening socket in the registry if the restart is in progress
+	ListeningSocketRegistry::instance().release(_serverSocket);
+}
+
+void AbstractReactorTcpService::ListenerThread::onStart()
+{
+	try {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener thread has been started"));
+		if (_serverSocket.isOpen()) {
+			// Accepted connections profile should be saved in the adopted listening socket too
+			_serverSocket.applyListenerOptions(_options);
+		} else {
+			_serverSocket.open();
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been opened"));
+			_serverSocket.bind(_addrInfo, _reusePort);
+			_serverSocket.applyListenerOptions(_options);
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been binded to ") <<
+					_addrInfo.firstEndpoint().host << ':' << _addrInfo.firstEndpoint().port << " endpoint");
+			_serverSocket.listen(_backLog);
+			ListeningSocketRegistry::instance().add(_serverSocket);
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been switched to the listening state"));
+		}
+	} catch (std::exception& e) {
+		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Reactor TCP-service listener socket initialization error -> exiting from listener thread"));
+		appointTermination();
+		return;
+	} catch (...) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Reactor TCP-service listener unknown socket initialization error -> exiting from listener thread"));
+		appointTermination();
+		return;
+	}
+	if (!IoUring::isEnabled()) {
+		return;
+	}
+	try {
+		_acceptorAutoPtr.reset(new IoUringAcceptor(_serverSocket));
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Connections are accepted using io_uring(7) by ") <<
+				_acceptorAutoPtr->maxPendingAccepts() << " pending accept operations");
+	} catch (std::exception& e) {
+		Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "io_uring(7) acceptor creation error -> accepting connections by accept4(2)"));
+	}
+}
+
+void AbstractReactorTcpService::ListenerThread::doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired)
+{
+	try {
+		while (Timestamp::now() < nextTickTimestamp) {
+			std::auto_ptr<TcpSocket> socketAutoPtr(_acceptorAutoPtr.get() ? _acceptorAutoPtr->accept(nextTickTimestamp.leftTo()) :
+					_serverSocket.accept(nextTickTimestamp.leftTo()));
+			if (!socketAutoPtr.get()) {
+				// Accepting TCP-connection timeout expired
+				return;
+			}
+			if (!_service.onConnected(*socketAutoPtr.get())) {
+				Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS,
+							"New connection has been rejected by onConnected() event handler -> dropping the client"));
+				continue;
+			}
+			std::auto_ptr<AbstractTask> taskAutoPtr(_service.createTask(*socketAutoPtr.get()));
+			if (!taskAutoPtr.get()) {
+				throw Exception(Error(SOURCE_LOCATION_ARGS, "Task creation factory method returned zero pointer"));
+			}
+			socketAutoPtr.release();
+			// Registering client connection in the next reactor using round-robin
+			ReactorThread * reactorPtr = _service._reactors[_nextReactorIndex++ % _service._reactors.size()];
+			try {
+				reactorPtr->addTask(taskAutoPtr);
+			} catch (std::exception& e) {
+				Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Registering client connection in reactor error -> dropping the client"));
+				_service.onOverload(*taskAutoPtr.get());
+			}
+		}
+	} catch (std::exception& e) {
+		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Reactor TCP-service listener execution error -> exiting from listener thread"));
+		appointTermination();
+	} catch (...) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Reactor TCP-service listener unknown execution error -> exiting from listener thread"));
+		appointTermination();
+	}
+}
+
+void AbstractReactorTcpService::ListenerThread::onStop()
+{
+	// Acceptor's ring is used by the listener thread only
+	_acceptorAutoPtr.reset();
+}
+
+} // namespace isl
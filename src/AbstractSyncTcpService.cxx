@@ -1,4 +1,5 @@
 #include <isl/AbstractSyncTcpService.hxx>
+#include <isl/ListeningSocketRegistry.hxx>
 
 namespace isl
 {
@@ -10,24 +11,78 @@ namespace isl
 AbstractSyncTcpService::AbstractSyncTcpService(Subsystem * owner, size_t maxClients, const Timeout& clockTimeout) :
 	Subsystem(owner, clockTimeout),
 	_taskDispatcher(this, maxClients),
+	_maxClients(maxClients),
+	_maxPendingClients(0),
+	_overloadPolicy(TaskDispatcherType::RejectPolicy),
+	_overloadTimeout(Timeout::defaultTimeout()),
+	_maxQueueWait(),
+	_drainOnStop(false),
+	_workStealing(false),
+	_elasticWorkers(false),
+	_minClients(TaskDispatcherType::DefaultMinWorkers),
+	_growThreshold(static_cast<double>(TaskDispatcherType::DefaultGrowThreshold) / 1000.0),
+	_keepAlive(static_cast<double>(TaskDispatcherType::DefaultKeepAlive)),
+	_workersPlacementPolicy(ThreadPlacementPolicy::FloatMode, ThreadPlacement::CpusContainer(), "worker"),
+	_dispatcherShardsAmount(1),
+	_dispatcherShards(),
 	_lastListenerConfigId(),
 	_listenerConfigs(),
+	_unixListenerConfigs(),
 	_listeners()
-{}
+{
+	setThreadPlacementPolicy(ThreadPlacementPolicy(ThreadPlacementPolicy::FloatMode, ThreadPlacement::CpusContainer(), "listener"));
+}
 
 AbstractSyncTcpService::~AbstractSyncTcpService()
 {
 	resetListenerThreads();
+	resetDispatcherShards();
+}
+
+AbstractSyncTcpService::TaskDispatcherType::Counters AbstractSyncTcpService::counters() const
+{
+	if (_dispatcherShards.empty()) {
+		return _taskDispatcher.counters();
+	}
+	TaskDispatcherType::Counters result;
+	for (DispatcherShardsContainer::const_iterator i = _dispatcherShards.begin(); i != _dispatcherShards.end(); ++i) {
+		TaskDispatcherType::Counters shardCounters = (*i)->counters();
+		result.acceptedTasks += shardCounters.acceptedTasks;
+		result.rejectedTasks += shardCounters.rejectedTasks;
+		result.droppedTasks += shardCounters.droppedTasks;
+		result.executedTasks += shardCounters.executedTasks;
+		result.totalQueueTime += shardCounters.totalQueueTime;
+		if (shardCounters.maxQueueTime > result.maxQueueTime) {
+			result.maxQueueTime = shardCounters.maxQueueTime;
+		}
+		result.spawnedWorkers += shardCounters.spawnedWorkers;
+		result.retiredWorkers += shardCounters.retiredWorkers;
+		result.maxWorkers += shardCounters.maxWorkers;
+		result.expiredTasks += shardCounters.expiredTasks;
+	}
+	return result;
 }
 
-int AbstractSyncTcpService::addListener(const TcpAddrInfo& addrInfo, unsigned int backLog)
+size_t AbstractSyncTcpService::runningWorkersAmount() const
 {
-	ListenerConfig newListenerConf(addrInfo, backLog);
+	if (_dispatcherShards.empty()) {
+		return _taskDispatcher.runningWorkersAmount();
+	}
+	size_t result = 0;
+	for (DispatcherShardsContainer::const_iterator i = _dispatcherShards.begin(); i != _dispatcherShards.end(); ++i) {
+		result += (*i)->runningWorkersAmount();
+	}
+	return result;
+}
+
+int AbstractSyncTcpService::addListener(const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options)
+{
+	ListenerConfig newListenerConf(addrInfo, backLog, shardsAmount, options);
 	_listenerConfigs.insert(ListenerConfigs::value_type(++_lastListenerConfigId, newListenerConf));
 	return _lastListenerConfigId;
 }
 
-void AbstractSyncTcpService::updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog)
+void AbstractSyncTcpService::updateListener(int id, const TcpAddrInfo& addrInfo, unsigned int backLog, size_t shardsAmount, const TcpSocketOptions& options)
 {
 	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
 	if (pos == _listenerConfigs.end()) {
@@ -36,24 +91,91 @@ void AbstractSyncTcpService::updateListener(int id, const TcpAddrInfo& addrInfo,
 	}
 	pos->second.addrInfo = addrInfo;
 	pos->second.backLog = backLog;
+	pos->second.shardsAmount = shardsAmount;
+	pos->second.options = options;
+}
+
+int AbstractSyncTcpService::addListener(const UnixAddrInfo& addrInfo, unsigned int backLog)
+{
+	UnixListenerConfig newListenerConf(addrInfo, backLog);
+	_unixListenerConfigs.insert(UnixListenerConfigs::value_type(++_lastListenerConfigId, newListenerConf));
+	return _lastListenerConfigId;
+}
+
+void AbstractSyncTcpService::updateListener(int id, const UnixAddrInfo& addrInfo, unsigned int backLog)
+{
+	UnixListenerConfigs::iterator pos = _unixListenerConfigs.find(id);
+	if (pos == _unixListenerConfigs.end()) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Unix domain socket listener (id = ") << id << ") not found");
+		return;
+	}
+	pos->second.addrInfo = addrInfo;
+	pos->second.backLog = backLog;
 }
 
 void AbstractSyncTcpService::removeListener(int id)
 {
 	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
-	if (pos == _listenerConfigs.end()) {
-		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
+	if (pos != _listenerConfigs.end()) {
+		_listenerConfigs.erase(pos);
+		return;
+	}
+	UnixListenerConfigs::iterator unixPos = _unixListenerConfigs.find(id);
+	if (unixPos != _unixListenerConfigs.end()) {
+		_unixListenerConfigs.erase(unixPos);
 		return;
 	}
-	_listenerConfigs.erase(pos);
+	Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
 }
 
 void AbstractSyncTcpService::start()
 {
+	// Creating task dispatcher shards, the first shard is the service's own task dispatcher
+	size_t dispatcherShardsAmount = (_dispatcherShardsAmount > 0) ? _dispatcherShardsAmount : 1;
+	if (_maxClients > 0 && dispatcherShardsAmount > _maxClients) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Task dispatcher shards amount (") << dispatcherShardsAmount <<
+				") exceeds maximum clients amount -> reducing it to " << _maxClients);
+		dispatcherShardsAmount = _maxClients;
+	}
+	_taskDispatcher.setWorkersAmount(shardShare(_maxClients, dispatcherShardsAmount, 0));
+	_dispatcherShards.push_back(&_taskDispatcher);
+	for (size_t i = 1; i < dispatcherShardsAmount; ++i) {
+		std::auto_ptr<TaskDispatcherType> newDispatcherAutoPtr(new TaskDispatcherType(this, shardShare(_maxClients, dispatcherShardsAmount, i), clockTimeout()));
+		_dispatcherShards.push_back(newDispatcherAutoPtr.get());
+		newDispatcherAutoPtr.release();
+	}
+	size_t firstWorkerIndex = _workersPlacementPolicy.firstThreadIndex();
+	for (size_t i = 0; i < _dispatcherShards.size(); ++i) {
+		TaskDispatcherType& shard = *_dispatcherShards[i];
+		// Zero pending tasks limit means unlimited, so each shard of the limited service gets at least one room
+		size_t shardMaxPendingTasks = shardShare(_maxPendingClients, dispatcherShardsAmount, i);
+		shard.setMaxPendingTasks((_maxPendingClients > 0 && shardMaxPendingTasks <= 0) ? 1 : shardMaxPendingTasks);
+		shard.setOverloadPolicy(_overloadPolicy);
+		shard.setOverloadTimeout(_overloadTimeout);
+		shard.setDrainOnStop(_drainOnStop);
+		shard.setWorkStealing(_workStealing);
+		shard.setElastic(_elasticWorkers, shardShare(_minClients, dispatcherShardsAmount, i), _growThreshold, _keepAlive);
+		// Workers of the shards are numbered through, so they are not pinned to the same CPUs
+		ThreadPlacementPolicy shardWorkersPlacementPolicy(_workersPlacementPolicy);
+		shardWorkersPlacementPolicy.setFirstThreadIndex(firstWorkerIndex);
+		shard.setWorkersPlacementPolicy(shardWorkersPlacementPolicy);
+		firstWorkerIndex += shard.workersAmount();
+	}
 	// Creating listeners
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating listeners"));
+	size_t listenerIndex = 0;
 	for (ListenerConfigs::const_iterator i = _listenerConfigs.begin(); i != _listenerConfigs.end(); ++i) {
-		std::auto_ptr<ListenerThread> newListenerAutoPtr(createListener(i->second.addrInfo, i->second.backLog));
+		size_t shardsAmount = (i->second.shardsAmount > 0) ? i->second.shardsAmount : 1;
+		for (size_t j = 0; j < shardsAmount; ++j) {
+			std::auto_ptr<ListenerThread> newListenerAutoPtr(createListener(i->second.addrInfo, i->second.backLog, shardsAmount > 1, i->second.options,
+						*_dispatcherShards[listenerIndex++ % _dispatcherShards.size()]));
+			_listeners.push_back(newListenerAutoPtr.get());
+			newListenerAutoPtr.release();
+		}
+	}
+	for (UnixListenerConfigs::const_iterator i = _unixListenerConfigs.begin(); i != _unixListenerConfigs.end(); ++i) {
+		std::auto_ptr<ListenerThread> newListenerAutoPtr(createListener(i->second.addrInfo, i->second.backLog,
+					*_dispatcherShards[listenerIndex++ % _dispatcherShards.size()]));
 		_listeners.push_back(newListenerAutoPtr.get());
 		newListenerAutoPtr.release();
 	}
@@ -64,12 +186,15 @@ void AbstractSyncTcpService::start()
 
 void AbstractSyncTcpService::stop()
 {
-	// Calling base class method
-	Subsystem::stop();
+	// Stopping listeners before the task dispatchers, so the accepted connections are not dropped
+	stopThreads();
+	stopChildren();
 	// Diposing listeners
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Disposing listeners"));
 	resetListenerThreads();
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listeners have been disposed"));
+	// Disposing task dispatcher shards
+	resetDispatcherShards();
 }
 
 void AbstractSyncTcpService::resetListenerThreads()
@@ -80,28 +205,96 @@ void AbstractSyncTcpService::resetListenerThreads()
 	_listeners.clear();
 }
 
+void AbstractSyncTcpService::resetDispatcherShards()
+{
+	for (DispatcherShardsContainer::iterator i = _dispatcherShards.begin(); i != _dispatcherShards.end(); ++i) {
+		if ((*i) != &_taskDispatcher) {
+			delete (*i);
+		}
+	}
+	_dispatcherShards.clear();
+}
+
 //------------------------------------------------------------------------------
 // AbstractSyncTcpService::ListenerThread
 //------------------------------------------------------------------------------
 
-AbstractSyncTcpService::ListenerThread::ListenerThread(AbstractSyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog) :
+AbstractSyncTcpService::ListenerThread::ListenerThread(AbstractSyncTcpService& service, const TcpAddrInfo& addrInfo, unsigned int backLog, bool reusePort, const TcpSocketOptions& options,
+		TaskDispatcherType& taskDispatcher) :
+	OscillatorThread(service),
+	_service(service),
+	_addrInfoAutoPtr(new TcpAddrInfo(addrInfo)),
+	_unixAddrInfoAutoPtr(),
+	_backLog(backLog),
+	_reusePort(reusePort),
+	_options(options),
+	_taskDispatcher(taskDispatcher),
+	_serverSocket(),
+	_unixServerSocket()
+{
+	// Taking over the listening socket which has been inherited or kept through the restart if any
+	if (ListeningSocketRegistry::instance().adopt(_serverSocket, addrInfo.addrinfo()->ai_addr, addrInfo.addrinfo()->ai_addrlen)) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listening socket bound to ") << addrInfo.firstEndpoint().host << ':' <<
+				addrInfo.firstEndpoint().port << " endpoint has been adopted");
+	}
+}
+
+AbstractSyncTcpService::ListenerThread::ListenerThread(AbstractSyncTcpService& service, const UnixAddrInfo& addrInfo, unsigned int backLog,
+		TaskDispatcherType& taskDispatcher) :
 	OscillatorThread(service),
 	_service(service),
-	_addrInfo(addrInfo),
+	_addrInfoAutoPtr(),
+	_unixAddrInfoAutoPtr(new UnixAddrInfo(addrInfo)),
 	_backLog(backLog),
-	_serverSocket()
-{}
+	_reusePort(false),
+	_options(),
+	_taskDispatcher(taskDispatcher),
+	_serverSocket(),
+	_unixServerSocket()
+{
+	if (ListeningSocketRegistry::instance().adopt(_unixServerSocket, addrInfo.sockAddr(), addrInfo.sockAddrLen())) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listening socket bound to \"") << addrInfo.str() <<
+				"\" Unix domain socket address has been adopted");
+	}
+}
+
+AbstractSyncTcpService::ListenerThread::~ListenerThread()
+{
+	// Parking the listening socket in the registry if the restart is in progress
+	ListeningSocketRegistry::instance().release(_serverSocket);
+	ListeningSocketRegistry::instance().release(_unixServerSocket);
+}
 
 void AbstractSyncTcpService::ListenerThread::onStart()
 {
 	try {
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener thread has been started"));
-		_serverSocket.open();
-		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been opened"));
-		_serverSocket.bind(_addrInfo);
-		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been binded to ") <<
-                                _addrInfo.firstEndpoint().host << ':' << _addrInfo.firstEndpoint().port << " endpoint");
-		_serverSocket.listen(_backLog);
+		if (_unixServerSocket.isOpen()) {
+			// Listening socket has been adopted in the listening state already
+			return;
+		} else if (_serverSocket.isOpen()) {
+			// Accepted connections profile should be saved in the adopted listening socket too
+			_serverSocket.applyListenerOptions(_options);
+			return;
+		}
+		if (_unixAddrInfoAutoPtr.get()) {
+			_unixServerSocket.open();
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been opened"));
+			_unixServerSocket.bind(*_unixAddrInfoAutoPtr.get());
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been binded to \"") <<
+					_unixAddrInfoAutoPtr->str() << "\" Unix domain socket address");
+			_unixServerSocket.listen(_backLog);
+			ListeningSocketRegistry::instance().add(_unixServerSocket);
+		} else {
+			_serverSocket.open();
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been opened"));
+			_serverSocket.bind(*_addrInfoAutoPtr.get(), _reusePort);
+			_serverSocket.applyListenerOptions(_options);
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been binded to ") <<
+					_addrInfoAutoPtr->firstEndpoint().host << ':' << _addrInfoAutoPtr->firstEndpoint().port << " endpoint");
+			_serverSocket.listen(_backLog);
+			ListeningSocketRegistry::instance().add(_serverSocket);
+		}
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server socket has been switched to the listening state"));
 	} catch (std::exception& e) {
 		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Synchronous TCP-service listener socket initialization error -> exiting from listener thread"));
@@ -114,9 +307,15 @@ void AbstractSyncTcpService::ListenerThread::onStart()
 
 void AbstractSyncTcpService::ListenerThread::doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired)
 {
+	TcpSocket& serverSocket = _unixAddrInfoAutoPtr.get() ? _unixServerSocket : _serverSocket;
 	try {
 		while (Timestamp::now() < nextTickTimestamp) {
-			std::auto_ptr<TcpSocket> socketAutoPtr(_serverSocket.accept(nextTickTimestamp.leftTo()));
+			if (!_service._maxQueueWait.isZero() && _taskDispatcher.queueWaitEstimate() > _service._maxQueueWait) {
+				// Leaving new connections in the listen backlog until the workers catch up
+				Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Queue waiting time estimate exceeds the limit -> deferring accepting connections"));
+				return;
+			}
+			std::auto_ptr<TcpSocket> socketAutoPtr(serverSocket.accept(nextTickTimestamp.leftTo()));
 			if (!socketAutoPtr.get()) {
 				// Accepting TCP-connection timeout expired
 				return;
@@ -126,15 +325,15 @@ void AbstractSyncTcpService::ListenerThread::doLoad(const Timestamp& prevTickTim
                                                         "New connection has been rejected by onConnected() event handler -> dropping the client"));
                                 continue;
                         }
+			TcpAddrInfo::Endpoint remoteEndpoint = socketAutoPtr.get()->remoteEndpoint();
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "TCP-connection has been received from ") <<
-					socketAutoPtr.get()->remoteAddr().firstEndpoint().host << ':' <<
-					socketAutoPtr.get()->remoteAddr().firstEndpoint().port);
+					remoteEndpoint.host << ':' << remoteEndpoint.port);
 			std::auto_ptr<AbstractTask> taskAutoPtr(_service.createTask(*socketAutoPtr.get()));
 			if (!taskAutoPtr.get()) {
 				throw Exception(Error(SOURCE_LOCATION_ARGS, "Task creation factory method returned zero pointer"));
 			}
 			socketAutoPtr.release();
-			if (!_service._taskDispatcher.perform(taskAutoPtr, &AbstractTask::execute)) {
+			if (!_taskDispatcher.perform(taskAutoPtr, &AbstractTask::execute)) {
 				Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Too many TCP-connection requests"));
 				_service.onOverload(*taskAutoPtr.get());
 			}
@@ -0,0 +1,160 @@
+#include <isl/AbstractUdpService.hxx>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// AbstractUdpService
+//------------------------------------------------------------------------------
+
+AbstractUdpService::AbstractUdpService(Subsystem * owner, const Timeout& clockTimeout) :
+	Subsystem(owner, clockTimeout),
+	_batchSize(DefaultBatchSize),
+	_maxDatagramSize(DefaultMaxDatagramSize),
+	_receiveBufferSize(-1),
+	_lastListenerConfigId(),
+	_listenerConfigs(),
+	_receivers()
+{}
+
+AbstractUdpService::~AbstractUdpService()
+{
+	resetReceiverThreads();
+}
+
+int AbstractUdpService::addListener(const TcpAddrInfo& addrInfo, size_t shardsAmount)
+{
+	ListenerConfig newListenerConf(addrInfo, shardsAmount);
+	_listenerConfigs.insert(ListenerConfigs::value_type(++_lastListenerConfigId, newListenerConf));
+	return _lastListenerConfigId;
+}
+
+void AbstractUdpService::updateListener(int id, const TcpAddrInfo& addrInfo, size_t shardsAmount)
+{
+	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
+	if (pos == _listenerConfigs.end()) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
+		return;
+	}
+	pos->second.addrInfo = addrInfo;
+	pos->second.shardsAmount = shardsAmount;
+}
+
+void AbstractUdpService::removeListener(int id)
+{
+	ListenerConfigs::iterator pos = _listenerConfigs.find(id);
+	if (pos == _listenerConfigs.end()) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Listener (id = ") << id << ") not found");
+		return;
+	}
+	_listenerConfigs.erase(pos);
+}
+
+void AbstractUdpService::start()
+{
+	// Creating receivers
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Creating receivers"));
+	for (ListenerConfigs::const_iterator i = _listenerConfigs.begin(); i != _listenerConfigs.end(); ++i) {
+		size_t shardsAmount = (i->second.shardsAmount > 0) ? i->second.shardsAmount : 1;
+		for (size_t j = 0; j < shardsAmount; ++j) {
+			std::auto_ptr<ReceiverThread> newReceiverAutoPtr(createReceiver(i->second.addrInfo, shardsAmount > 1));
+			_receivers.push_back(newReceiverAutoPtr.get());
+			newReceiverAutoPtr.release();
+		}
+	}
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Receivers have been created"));
+	// Calling base class method
+	Subsystem::start();
+}
+
+void AbstractUdpService::stop()
+{
+	// Calling base class method
+	Subsystem::stop();
+	// Diposing receivers
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Disposing receivers"));
+	resetReceiverThreads();
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Receivers have been disposed"));
+}
+
+void AbstractUdpService::resetReceiverThreads()
+{
+	for (ReceiversContainer::iterator i = _receivers.begin(); i != _receivers.end(); ++i) {
+		delete (*i);
+	}
+	_receivers.clear();
+}
+
+//------------------------------------------------------------------------------
+// AbstractUdpService::ReceiverThread
+//------------------------------------------------------------------------------
+
+AbstractUdpService::ReceiverThread::ReceiverThread(AbstractUdpService& service, const TcpAddrInfo& addrInfo, bool reusePort) :
+	OscillatorThread(service),
+	_service(service),
+	_addrInfo(addrInfo),
+	_reusePort(reusePort),
+	_socket(addrInfo.family()),
+	_datagrams(service._batchSize, service._maxDatagramSize),
+	_replies(service._batchSize, service._maxDatagramSize)
+{}
+
+void AbstractUdpService::ReceiverThread::onStart()
+{
+	try {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Receiver thread has been started"));
+		_socket.open();
+		if (_service._receiveBufferSize >= 0) {
+			_socket.setReceiveBufferSize(_service._receiveBufferSize);
+		}
+		_socket.bind(_addrInfo, _reusePort);
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "UDP-socket has been binded to ") <<
+				_addrInfo.firstEndpoint().host << ':' << _addrInfo.firstEndpoint().port << " endpoint");
+	} catch (std::exception& e) {
+		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "UDP-service receiver socket initialization error -> exiting from receiver thread"));
+		appointTermination();
+	} catch (...) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "UDP-service receiver unknown socket initialization error -> exiting from receiver thread"));
+		appointTermination();
+	}
+}
+
+void AbstractUdpService::ReceiverThread::doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired)
+{
+	try {
+		while (Timestamp::now() < nextTickTimestamp) {
+			if (_socket.receiveBatch(_datagrams, nextTickTimestamp.leftTo()) <= 0) {
+				// Receiving datagrams timeout expired
+				return;
+			}
+			for (size_t i = 0; i < _datagrams.size(); ++i) {
+				if (_datagrams.isTruncated(i)) {
+					Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Datagram from ") << _datagrams.endpoint(i).host << ':' <<
+							_datagrams.endpoint(i).port << " has been truncated to " << _datagrams.maxDatagramSize() << " bytes");
+				}
+			}
+			_replies.clear();
+			_service.onReceive(_datagrams, _replies);
+			if (_replies.isEmpty()) {
+				continue;
+			}
+			try {
+				size_t repliesSent = _socket.sendBatch(_replies, nextTickTimestamp.leftTo());
+				if (repliesSent < _replies.size()) {
+					Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Only ") << repliesSent << " of " << _replies.size() <<
+							" replies have been sent");
+				}
+			} catch (std::exception& e) {
+				Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Sending replies error -> dropping the replies"));
+			}
+		}
+	} catch (std::exception& e) {
+		Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "UDP-service receiver execution error -> exiting from receiver thread"));
+		appointTermination();
+	} catch (...) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "UDP-service receiver unknown execution error -> exiting from receiver thread"));
+		appointTermination();
+	}
+}
+
+} // namespace isl
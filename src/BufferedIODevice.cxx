@@ -0,0 +1,226 @@
+#include <isl/BufferedIODevice.hxx>
+#include <isl/Timestamp.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <string.h>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// BufferedIODevice
+//------------------------------------------------------------------------------
+
+BufferedIODevice::BufferedIODevice(AbstractIODevice& device, size_t readBufferSize, size_t writeBufferSize) :
+	AbstractIODevice(),
+	_device(device),
+	_readBuffer(readBufferSize),
+	_writeBuffer(writeBufferSize)
+{
+	setIsOpen(device.isOpen());
+}
+
+void BufferedIODevice::consume(size_t bytes)
+{
+	if (bytes > _readBuffer.size()) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Could not consume more data than has been buffered"));
+	}
+	_readBuffer.consume(bytes);
+}
+
+size_t BufferedIODevice::fill(const Timeout& timeout)
+{
+	if (!_device.isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	size_t spanSize;
+	char * spanPtr = _readBuffer.freeSpan(spanSize);
+	if (spanSize <= 0) {
+		return 0;
+	}
+	size_t bytesRead = _device.read(spanPtr, spanSize, timeout);
+	_readBuffer.produce(bytesRead);
+	return bytesRead;
+}
+
+bool BufferedIODevice::flush(const Timeout& timeout)
+{
+	if (!_device.isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	Timestamp limit = Timestamp::limit(timeout);
+	while (_writeBuffer.size() > 0) {
+		ConstBuffer buffers[2] = {_writeBuffer.firstDataSpan(), _writeBuffer.secondDataSpan()};
+		size_t bytesSent = _device.writeVector(buffers, buffers[1].size > 0 ? 2 : 1, limit.leftTo());
+		if (bytesSent <= 0) {
+			// Write timeout expired
+			return false;
+		}
+		_writeBuffer.consume(bytesSent);
+		if (_writeBuffer.size() > 0 && Timestamp::now() >= limit) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void BufferedIODevice::openImplementation()
+{
+	_readBuffer.clear();
+	_writeBuffer.clear();
+	if (!_device.isOpen()) {
+		_device.open();
+	}
+}
+
+void BufferedIODevice::closeImplementation()
+{
+	_readBuffer.clear();
+	_writeBuffer.clear();
+	if (_device.isOpen()) {
+		_device.close();
+	}
+}
+
+size_t BufferedIODevice::readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	if (_readBuffer.size() > 0) {
+		return _readBuffer.extract(buffer, bufferSize);
+	}
+	if (bufferSize >= _readBuffer.capacity()) {
+		// Reading big portion of data directly to the caller's buffer
+		return _device.read(buffer, bufferSize, timeout);
+	}
+	if (fill(timeout) <= 0) {
+		return 0;
+	}
+	return _readBuffer.extract(buffer, bufferSize);
+}
+
+size_t BufferedIODevice::writeImplementation(const char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	ConstBuffer data(buffer, bufferSize);
+	return writeVectorImplementation(&data, 1, timeout);
+}
+
+size_t BufferedIODevice::writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout)
+{
+	size_t totalSize = 0;
+	for (size_t i = 0; i < buffersAmount; ++i) {
+		totalSize += buffers[i].size;
+	}
+	if (totalSize <= _writeBuffer.freeSize()) {
+		// Batching the data in the write buffer
+		for (size_t i = 0; i < buffersAmount; ++i) {
+			_writeBuffer.append(buffers[i].data, buffers[i].size);
+		}
+		return totalSize;
+	}
+	// Sending buffered data followed by the new one using one vectored write
+	std::vector<ConstBuffer> allBuffers;
+	allBuffers.reserve(buffersAmount + 2);
+	if (_writeBuffer.size() > 0) {
+		allBuffers.push_back(_writeBuffer.firstDataSpan());
+		if (_writeBuffer.secondDataSpan().size > 0) {
+			allBuffers.push_back(_writeBuffer.secondDataSpan());
+		}
+	}
+	allBuffers.insert(allBuffers.end(), buffers, buffers + buffersAmount);
+	size_t bytesSent = _device.writeVector(&allBuffers[0], allBuffers.size(), timeout);
+	size_t bufferedBytesSent = (bytesSent < _writeBuffer.size()) ? bytesSent : _writeBuffer.size();
+	_writeBuffer.consume(bufferedBytesSent);
+	// Batching the unsent rest of the new data if it fits the write buffer
+	size_t bytesAccepted = bytesSent - bufferedBytesSent;
+	size_t offset = bytesAccepted;
+	for (size_t i = 0; i < buffersAmount && _writeBuffer.freeSize() > 0; ++i) {
+		if (offset >= buffers[i].size) {
+			offset -= buffers[i].size;
+			continue;
+		}
+		size_t bytesAppended = _writeBuffer.append(buffers[i].data + offset, buffers[i].size - offset);
+		bytesAccepted += bytesAppended;
+		if (bytesAppended < buffers[i].size - offset) {
+			break;
+		}
+		offset = 0;
+	}
+	return bytesAccepted;
+}
+
+size_t BufferedIODevice::sendFileImplementation(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout)
+{
+	// Buffered data should precede the file data
+	Timestamp limit = Timestamp::limit(timeout);
+	if (!flush(timeout)) {
+		return 0;
+	}
+	return _device.sendFile(fileDescriptor, offset, size, limit.leftTo());
+}
+
+void BufferedIODevice::setCorkedImplementation(bool newValue)
+{
+	_device.setCorked(newValue);
+}
+
+//------------------------------------------------------------------------------
+// BufferedIODevice::RingBuffer
+//------------------------------------------------------------------------------
+
+char * BufferedIODevice::RingBuffer::freeSpan(size_t& spanSize)
+{
+	if (_size <= 0) {
+		// Rewinding the empty buffer, so the whole buffer is contiguous
+		_head = 0;
+	}
+	size_t tail = _head + _size;
+	if (tail < _data.size()) {
+		spanSize = _data.size() - tail;
+	} else {
+		tail -= _data.size();
+		spanSize = _head - tail;
+	}
+	return spanSize > 0 ? &_data[tail] : 0;
+}
+
+void BufferedIODevice::RingBuffer::produce(size_t bytes)
+{
+	_size += bytes;
+}
+
+size_t BufferedIODevice::RingBuffer::append(const char * buffer, size_t bufferSize)
+{
+	size_t bytesAppended = 0;
+	while (bytesAppended < bufferSize) {
+		size_t spanSize;
+		char * spanPtr = freeSpan(spanSize);
+		if (spanSize <= 0) {
+			break;
+		}
+		size_t bytesToCopy = (bufferSize - bytesAppended < spanSize) ? bufferSize - bytesAppended : spanSize;
+		memcpy(spanPtr, buffer + bytesAppended, bytesToCopy);
+		produce(bytesToCopy);
+		bytesAppended += bytesToCopy;
+	}
+	return bytesAppended;
+}
+
+size_t BufferedIODevice::RingBuffer::extract(char * buffer, size_t bufferSize)
+{
+	size_t bytesExtracted = 0;
+	while (bytesExtracted < bufferSize && _size > 0) {
+		ConstBuffer span = firstDataSpan();
+		size_t bytesToCopy = (bufferSize - bytesExtracted < span.size) ? bufferSize - bytesExtracted : span.size;
+		memcpy(buffer + bytesExtracted, span.data, bytesToCopy);
+		consume(bytesToCopy);
+		bytesExtracted += bytesToCopy;
+	}
+	return bytesExtracted;
+}
+
+void BufferedIODevice::RingBuffer::consume(size_t bytes)
+{
+	_size -= bytes;
+	_head = (_size > 0) ? (_head + bytes) % _data.size() : 0;
+}
+
+} // namespace isl
@@ -0,0 +1,341 @@
+#include <isl/DnsResolver.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// DnsResolver::FutureState
+//------------------------------------------------------------------------------
+
+struct DnsResolver::FutureState
+{
+	FutureState() :
+		cond(),
+		refsCount(1),
+		ready(false),
+		addrInfoAutoPtr(),
+		errorMessage()
+	{}
+
+	WaitCondition cond;
+	int refsCount;
+	bool ready;
+	std::auto_ptr<TcpAddrInfo> addrInfoAutoPtr;
+	std::string errorMessage;
+};
+
+//------------------------------------------------------------------------------
+// DnsResolver::Future
+//------------------------------------------------------------------------------
+
+DnsResolver::Future::Future() :
+	_statePtr(0)
+{}
+
+DnsResolver::Future::Future(FutureState * statePtr) :
+	_statePtr(statePtr)
+{}
+
+DnsResolver::Future::Future(const Future& other) :
+	_statePtr(other._statePtr)
+{
+	if (_statePtr) {
+		__sync_add_and_fetch(&_statePtr->refsCount, 1);
+	}
+}
+
+DnsResolver::Future::~Future()
+{
+	release();
+}
+
+DnsResolver::Future& DnsResolver::Future::operator=(const Future& other)
+{
+	if (other._statePtr == _statePtr) {
+		return *this;
+	}
+	if (other._statePtr) {
+		__sync_add_and_fetch(&other._statePtr->refsCount, 1);
+	}
+	release();
+	_statePtr = other._statePtr;
+	return *this;
+}
+
+bool DnsResolver::Future::isReady() const
+{
+	if (!_statePtr) {
+		return false;
+	}
+	MutexLocker locker(_statePtr->cond.mutex());
+	return _statePtr->ready;
+}
+
+bool DnsResolver::Future::await(const Timestamp& limit) const
+{
+	if (!_statePtr) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Future is not bound to the resolution"));
+	}
+	MutexLocker locker(_statePtr->cond.mutex());
+	while (!_statePtr->ready) {
+		if (!_statePtr->cond.wait(limit)) {
+			return _statePtr->ready;
+		}
+	}
+	return true;
+}
+
+void DnsResolver::Future::await() const
+{
+	if (!_statePtr) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Future is not bound to the resolution"));
+	}
+	MutexLocker locker(_statePtr->cond.mutex());
+	while (!_statePtr->ready) {
+		_statePtr->cond.wait();
+	}
+}
+
+bool DnsResolver::Future::succeeded() const
+{
+	if (!_statePtr) {
+		return false;
+	}
+	MutexLocker locker(_statePtr->cond.mutex());
+	return _statePtr->ready && _statePtr->addrInfoAutoPtr.get();
+}
+
+std::string DnsResolver::Future::errorMessage() const
+{
+	if (!_statePtr) {
+		return std::string();
+	}
+	MutexLocker locker(_statePtr->cond.mutex());
+	return _statePtr->errorMessage;
+}
+
+TcpAddrInfo DnsResolver::Future::addrInfo() const
+{
+	if (!_statePtr) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Future is not bound to the resolution"));
+	}
+	MutexLocker locker(_statePtr->cond.mutex());
+	if (!_statePtr->ready) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Resolution has not been completed yet"));
+	}
+	if (!_statePtr->addrInfoAutoPtr.get()) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, _statePtr->errorMessage));
+	}
+	return *_statePtr->addrInfoAutoPtr.get();
+}
+
+void DnsResolver::Future::release()
+{
+	if (_statePtr && __sync_sub_and_fetch(&_statePtr->refsCount, 1) <= 0) {
+		delete _statePtr;
+	}
+	_statePtr = 0;
+}
+
+//------------------------------------------------------------------------------
+// DnsResolver::ResolveTask
+//------------------------------------------------------------------------------
+
+DnsResolver::ResolveTask::~ResolveTask()
+{
+	if (!_completed) {
+		// Task has been discarded by the task dispatcher without execution
+		_resolver.complete(_key, 0, "Name resolution has been cancelled");
+	}
+}
+
+void DnsResolver::ResolveTask::execute(TaskDispatcher<ResolveTask>& taskDispatcher)
+{
+	std::auto_ptr<TcpAddrInfo> addrInfoAutoPtr;
+	std::string errorMessage;
+	try {
+		addrInfoAutoPtr.reset(new TcpAddrInfo(_key.family, _key.host.c_str(), _key.port));
+	} catch (std::exception& e) {
+		errorMessage = e.what();
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Resolution of '") << _key.host << ':' << _key.port << "' failed: " << errorMessage);
+	}
+	_completed = true;
+	if (addrInfoAutoPtr.get()) {
+		_resolver.putToCache(_key, *addrInfoAutoPtr.get());
+	}
+	_resolver.complete(_key, addrInfoAutoPtr.get(), errorMessage);
+}
+
+//------------------------------------------------------------------------------
+// DnsResolver
+//------------------------------------------------------------------------------
+
+DnsResolver::DnsResolver(Subsystem * owner, size_t workersAmount, const Timeout& cacheTtl, size_t maxCacheSize, const Timeout& clockTimeout) :
+	Subsystem(owner, clockTimeout),
+	_cacheTtl(cacheTtl),
+	_maxCacheSize(maxCacheSize),
+	_mutex(),
+	_cache(),
+	_pendingResolutions(),
+	_taskDispatcher(this, workersAmount)
+{}
+
+DnsResolver::~DnsResolver()
+{}
+
+size_t DnsResolver::cacheSize() const
+{
+	MutexLocker locker(_mutex);
+	return _cache.size();
+}
+
+void DnsResolver::clearCache()
+{
+	MutexLocker locker(_mutex);
+	_cache.clear();
+}
+
+void DnsResolver::resolve(TcpAddrInfo::Family family, const std::string& host, unsigned int port, AbstractCallback& callback)
+{
+	CacheKey key(family, host, port);
+	std::auto_ptr<TcpAddrInfo> addrInfoAutoPtr;
+	if (fetchFromCache(key, addrInfoAutoPtr)) {
+		callback.onResolved(*addrInfoAutoPtr.get());
+		return;
+	}
+	enqueue(key, Waiter(&callback, Future()));
+}
+
+DnsResolver::Future DnsResolver::resolveAsync(TcpAddrInfo::Family family, const std::string& host, unsigned int port)
+{
+	CacheKey key(family, host, port);
+	Future future(new FutureState());
+	std::auto_ptr<TcpAddrInfo> addrInfoAutoPtr;
+	if (fetchFromCache(key, addrInfoAutoPtr)) {
+		future._statePtr->addrInfoAutoPtr = addrInfoAutoPtr;
+		future._statePtr->ready = true;
+		return future;
+	}
+	enqueue(key, Waiter(0, future));
+	return future;
+}
+
+TcpAddrInfo DnsResolver::resolve(TcpAddrInfo::Family family, const std::string& host, unsigned int port)
+{
+	CacheKey key(family, host, port);
+	std::auto_ptr<TcpAddrInfo> addrInfoAutoPtr;
+	if (fetchFromCache(key, addrInfoAutoPtr)) {
+		return *addrInfoAutoPtr.get();
+	}
+	TcpAddrInfo addrInfo(family, host.c_str(), port);
+	putToCache(key, addrInfo);
+	return addrInfo;
+}
+
+bool DnsResolver::fetchFromCache(const CacheKey& key, std::auto_ptr<TcpAddrInfo>& addrInfoAutoPtr)
+{
+	MutexLocker locker(_mutex);
+	Cache::iterator pos = _cache.find(key);
+	if (pos == _cache.end()) {
+		return false;
+	}
+	if (pos->second.expiration <= Timestamp::now()) {
+		_cache.erase(pos);
+		return false;
+	}
+	addrInfoAutoPtr.reset(new TcpAddrInfo(pos->second.addrInfo));
+	return true;
+}
+
+void DnsResolver::putToCache(const CacheKey& key, const TcpAddrInfo& addrInfo)
+{
+	if (_maxCacheSize <= 0 || _cacheTtl.isZero()) {
+		return;
+	}
+	Timestamp now = Timestamp::now();
+	MutexLocker locker(_mutex);
+	Cache::iterator pos = _cache.find(key);
+	if (pos != _cache.end()) {
+		pos->second = CacheEntry(addrInfo, now + _cacheTtl);
+		return;
+	}
+	if (_cache.size() >= _maxCacheSize) {
+		// Evicting expired entries first and the entry which is expiring soonest if the cache is still full
+		Cache::iterator soonestPos = _cache.end();
+		for (Cache::iterator i = _cache.begin(); i != _cache.end();) {
+			if (i->second.expiration <= now) {
+				_cache.erase(i++);
+			} else {
+				if (soonestPos == _cache.end() || i->second.expiration < soonestPos->second.expiration) {
+					soonestPos = i;
+				}
+				++i;
+			}
+		}
+		if (_cache.size() >= _maxCacheSize && soonestPos != _cache.end()) {
+			_cache.erase(soonestPos);
+		}
+	}
+	_cache.insert(Cache::value_type(key, CacheEntry(addrInfo, now + _cacheTtl)));
+}
+
+void DnsResolver::enqueue(const CacheKey& key, const Waiter& waiter)
+{
+	{
+		MutexLocker locker(_mutex);
+		PendingResolutions::iterator pos = _pendingResolutions.find(key);
+		if (pos != _pendingResolutions.end()) {
+			// Resolution of the same key is in progress - waiting for it's result
+			pos->second.push_back(waiter);
+			return;
+		}
+		_pendingResolutions.insert(PendingResolutions::value_type(key, WaitersContainer(1, waiter)));
+	}
+	std::auto_ptr<ResolveTask> taskAutoPtr(new ResolveTask(*this, key));
+	_taskDispatcher.perform(taskAutoPtr, &ResolveTask::execute);
+}
+
+void DnsResolver::complete(const CacheKey& key, const TcpAddrInfo * addrInfoPtr, const std::string& errorMessage)
+{
+	WaitersContainer waiters;
+	{
+		MutexLocker locker(_mutex);
+		PendingResolutions::iterator pos = _pendingResolutions.find(key);
+		if (pos == _pendingResolutions.end()) {
+			return;
+		}
+		waiters.swap(pos->second);
+		_pendingResolutions.erase(pos);
+	}
+	for (WaitersContainer::iterator i = waiters.begin(); i != waiters.end(); ++i) {
+		if (i->callbackPtr) {
+			try {
+				if (addrInfoPtr) {
+					i->callbackPtr->onResolved(*addrInfoPtr);
+				} else {
+					i->callbackPtr->onError(errorMessage);
+				}
+			} catch (std::exception& e) {
+				Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Resolution callback execution error"));
+			} catch (...) {
+				Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Resolution callback execution unknown error"));
+			}
+		} else {
+			FutureState * statePtr = i->future._statePtr;
+			MutexLocker locker(statePtr->cond.mutex());
+			if (addrInfoPtr) {
+				statePtr->addrInfoAutoPtr.reset(new TcpAddrInfo(*addrInfoPtr));
+			} else {
+				statePtr->errorMessage = errorMessage;
+			}
+			statePtr->ready = true;
+			statePtr->cond.wakeAll();
+		}
+	}
+}
+
+} // namespace isl
@@ -9,9 +9,7 @@ HttpMessageReader::HttpMessageReader(HttpMessageParser& parser, size_t maxBodySi
 	_parser(parser),
 	_maxBodySize(maxBodySize),
 	_bufferSize(bufferSize),
-	_readBuffer(bufferSize),
-	_bytesRead(0),
-	_bytesParsed(0),
+	_bufferedDeviceAutoPtr(),
 	_bodyBuffer(bufferSize),
 	_body()
 {}
@@ -24,15 +22,17 @@ bool HttpMessageReader::read(AbstractIODevice& device, const Timestamp& limit, s
 	if (bytesReadFromDevice) {
 		*bytesReadFromDevice = 0;
 	}
+	BufferedIODevice& bufDevice = bufferedDevice(device);
 	while (true) {
-		if (_bytesParsed < _bytesRead) {
+		AbstractIODevice::ConstBuffer span = bufDevice.peek();
+		if (span.size > 0) {
 			if (_parser.isCompleted()) {
 				_body.clear();
 				onNewMessage();
 			}
-			// Parsing the rest of the unparsed data in the read buffer
-			std::pair<size_t, size_t> res = _parser.parse(&_readBuffer[0] + _bytesParsed, _bytesRead - _bytesParsed, &_bodyBuffer[0], _bufferSize);
-			_bytesParsed += res.first;
+			// Parsing the buffered data in place
+			std::pair<size_t, size_t> res = _parser.parse(span.data, span.size, &_bodyBuffer[0], _bufferSize);
+			bufDevice.consume(res.first);
 			if ((_body.size() + res.second) > _maxBodySize) {
 				throw Exception(Error(SOURCE_LOCATION_ARGS, "Request entity is too long"));	// Maybe an own error class?
 			}
@@ -47,14 +47,13 @@ bool HttpMessageReader::read(AbstractIODevice& device, const Timestamp& limit, s
 			}
 		} else {
 			// Reading next portion of data from the device into the read buffer
-			_bytesRead = device.read(&_readBuffer[0], _bufferSize, limit.leftTo());
-			if (_bytesRead <= 0) {
+			size_t bytesRead = bufDevice.fill(limit.leftTo());
+			if (bytesRead <= 0) {
 				// Data read timeout has been expired
 				return false;
 			}
-			_bytesParsed = 0;
 			if (bytesReadFromDevice) {
-				(*bytesReadFromDevice) += _bytesRead;
+				(*bytesReadFromDevice) += bytesRead;
 			}
 		}
 	}
@@ -63,9 +62,20 @@ bool HttpMessageReader::read(AbstractIODevice& device, const Timestamp& limit, s
 void HttpMessageReader::reset()
 {
 	_parser.reset();
-	_bytesRead = 0;
-	_bytesParsed = 0;
+	_bufferedDeviceAutoPtr.reset();
 	_body.clear();
 }
 
+BufferedIODevice& HttpMessageReader::bufferedDevice(AbstractIODevice& device)
+{
+	BufferedIODevice * bufferedDevicePtr = dynamic_cast<BufferedIODevice *>(&device);
+	if (bufferedDevicePtr) {
+		return *bufferedDevicePtr;
+	}
+	if (!_bufferedDeviceAutoPtr.get() || (&_bufferedDeviceAutoPtr->device() != &device)) {
+		_bufferedDeviceAutoPtr.reset(new BufferedIODevice(device, _bufferSize, 0));
+	}
+	return *_bufferedDeviceAutoPtr.get();
+}
+
 } // namespace isl
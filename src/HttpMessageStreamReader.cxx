@@ -8,9 +8,7 @@ namespace isl
 HttpMessageStreamReader::HttpMessageStreamReader(HttpMessageParser& parser, size_t bufferSize) :
 	_parser(parser),
 	_bufferSize(bufferSize),
-	_readBuffer(bufferSize),
-	_bytesRead(0),
-	_bytesParsed(0)
+	_bufferedDeviceAutoPtr()
 {}
 
 HttpMessageStreamReader::~HttpMessageStreamReader()
@@ -19,8 +17,7 @@ HttpMessageStreamReader::~HttpMessageStreamReader()
 void HttpMessageStreamReader::reset()
 {
 	_parser.reset();
-	_bytesRead = 0;
-	_bytesParsed = 0;
+	_bufferedDeviceAutoPtr.reset();
 }
 
 std::pair<bool, size_t> HttpMessageStreamReader::read(AbstractIODevice& device, const Timestamp& limit, char * bodyBuffer, size_t bodyBufferSize, size_t * bytesReadFromDevice)
@@ -28,11 +25,14 @@ std::pair<bool, size_t> HttpMessageStreamReader::read(AbstractIODevice& device,
 	if (bytesReadFromDevice) {
 		*bytesReadFromDevice = 0;
 	}
+	BufferedIODevice& bufDevice = bufferedDevice(device);
 	size_t bodyBytes = 0;
 	while (true) {
-		if (_bytesParsed < _bytesRead) {
-			std::pair<size_t, size_t> res = _parser.parse(&_readBuffer[0] + _bytesParsed, _bytesRead - _bytesParsed, bodyBuffer + bodyBytes, bodyBufferSize - bodyBytes);
-			_bytesParsed += res.first;
+		AbstractIODevice::ConstBuffer span = bufDevice.peek();
+		if (span.size > 0) {
+			// Parsing the data in place
+			std::pair<size_t, size_t> res = _parser.parse(span.data, span.size, bodyBuffer + bodyBytes, bodyBufferSize - bodyBytes);
+			bufDevice.consume(res.first);
 			bodyBytes += res.second;
 			if (_parser.isCompleted()) {
 				return std::pair<bool, size_t>(true, bodyBytes);
@@ -47,17 +47,28 @@ std::pair<bool, size_t> HttpMessageStreamReader::read(AbstractIODevice& device,
 				// Time limit has been reached
 				return std::pair<bool, size_t>(false, bodyBytes);
 			}
-			_bytesRead = device.read(&_readBuffer[0], _bufferSize, limit - now);
-			if (_bytesRead <= 0) {
+			size_t bytesRead = bufDevice.fill(limit - now);
+			if (bytesRead <= 0) {
 				// Data read timeout has been expired
 				return std::pair<bool, size_t>(false, bodyBytes);
 			}
-			_bytesParsed = 0;
 			if (bytesReadFromDevice) {
-				(*bytesReadFromDevice) += _bytesRead;
+				(*bytesReadFromDevice) += bytesRead;
 			}
 		}
 	}
 }
 
+BufferedIODevice& HttpMessageStreamReader::bufferedDevice(AbstractIODevice& device)
+{
+	BufferedIODevice * bufferedDevicePtr = dynamic_cast<BufferedIODevice *>(&device);
+	if (bufferedDevicePtr) {
+		return *bufferedDevicePtr;
+	}
+	if (!_bufferedDeviceAutoPtr.get() || (&_bufferedDeviceAutoPtr->device() != &device)) {
+		_bufferedDeviceAutoPtr.reset(new BufferedIODevice(device, _bufferSize, 0));
+	}
+	return *_bufferedDeviceAutoPtr.get();
+}
+
 } // namespace isl
@@ -0,0 +1,522 @@
+#include <isl/IoUring.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <isl/SystemCallError.hxx>
+#include <errno.h>
+
+#ifdef ISL__USE_IO_URING
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <string.h>
+#endif
+
+namespace isl
+{
+
+#ifdef ISL__USE_IO_URING
+
+// User data values of the synchronous operation and it's linked timeout
+#define ISL__IO_URING_OPERATION_USER_DATA 1
+#define ISL__IO_URING_TIMEOUT_USER_DATA 2
+
+IoUring::IoUring(unsigned int entries) :
+	_entries(entries),
+	_isWaitTimeoutSupported(false),
+	_ringDescriptor(-1),
+	_sqRingPtr(MAP_FAILED),
+	_sqRingSize(0),
+	_cqRingPtr(MAP_FAILED),
+	_cqRingSize(0),
+	_sqesPtr(MAP_FAILED),
+	_sqesSize(0),
+	_sqHeadPtr(0),
+	_sqTailPtr(0),
+	_sqMask(0),
+	_sqArrayPtr(0),
+	_cqHeadPtr(0),
+	_cqTailPtr(0),
+	_cqMask(0),
+	_cqesPtr(0),
+	_sqeTail(0),
+	_sqeSubmitted(0),
+	_timeSpecs()
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	_ringDescriptor = syscall(__NR_io_uring_setup, entries, &params);
+	if (_ringDescriptor < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::IoUringSetup, errno));
+	}
+	_entries = params.sq_entries;
+	_isWaitTimeoutSupported = (params.features & IORING_FEAT_EXT_ARG) != 0;
+	// Mapping the rings to the user space
+	_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (_cqRingSize > _sqRingSize) {
+			_sqRingSize = _cqRingSize;
+		}
+		_cqRingSize = 0;
+	}
+	_sqRingPtr = mmap(0, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringDescriptor, IORING_OFF_SQ_RING);
+	if (_sqRingPtr == MAP_FAILED) {
+		int errnum = errno;
+		close(_ringDescriptor);
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::MMap, errnum));
+	}
+	if (_cqRingSize > 0) {
+		_cqRingPtr = mmap(0, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringDescriptor, IORING_OFF_CQ_RING);
+		if (_cqRingPtr == MAP_FAILED) {
+			int errnum = errno;
+			munmap(_sqRingPtr, _sqRingSize);
+			close(_ringDescriptor);
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::MMap, errnum));
+		}
+	}
+	_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	_sqesPtr = mmap(0, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringDescriptor, IORING_OFF_SQES);
+	if (_sqesPtr == MAP_FAILED) {
+		int errnum = errno;
+		if (_cqRingSize > 0) {
+			munmap(_cqRingPtr, _cqRingSize);
+		}
+		munmap(_sqRingPtr, _sqRingSize);
+		close(_ringDescriptor);
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::MMap, errnum));
+	}
+	char * sqRing = static_cast<char *>(_sqRingPtr);
+	char * cqRing = _cqRingSize > 0 ? static_cast<char *>(_cqRingPtr) : sqRing;
+	_sqHeadPtr = reinterpret_cast<unsigned int *>(sqRing + params.sq_off.head);
+	_sqTailPtr = reinterpret_cast<unsigned int *>(sqRing + params.sq_off.tail);
+	_sqMask = *reinterpret_cast<unsigned int *>(sqRing + params.sq_off.ring_mask);
+	_sqArrayPtr = reinterpret_cast<unsigned int *>(sqRing + params.sq_off.array);
+	_cqHeadPtr = reinterpret_cast<unsigned int *>(cqRing + params.cq_off.head);
+	_cqTailPtr = reinterpret_cast<unsigned int *>(cqRing + params.cq_off.tail);
+	_cqMask = *reinterpret_cast<unsigned int *>(cqRing + params.cq_off.ring_mask);
+	_cqesPtr = cqRing + params.cq_off.cqes;
+	_sqeTail = *_sqTailPtr;
+	_sqeSubmitted = _sqeTail;
+	// Linked timeouts are read by the kernel on submission, so one timespec per submission queue entry is enough
+	_timeSpecs.resize(_entries * sizeof(struct __kernel_timespec));
+}
+
+IoUring::~IoUring()
+{
+	munmap(_sqesPtr, _sqesSize);
+	if (_cqRingSize > 0) {
+		munmap(_cqRingPtr, _cqRingSize);
+	}
+	munmap(_sqRingPtr, _sqRingSize);
+	close(_ringDescriptor);
+}
+
+bool IoUring::prepareRead(int fd, char * buffer, size_t bufferSize, uint64_t userData)
+{
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(nextSqe());
+	if (!sqe) {
+		return false;
+	}
+	sqe->opcode = IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+	sqe->len = bufferSize;
+	sqe->off = static_cast<uint64_t>(-1);					// Current file position
+	sqe->user_data = userData;
+	return true;
+}
+
+bool IoUring::prepareWrite(int fd, const char * buffer, size_t bufferSize, uint64_t userData)
+{
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(nextSqe());
+	if (!sqe) {
+		return false;
+	}
+	sqe->opcode = IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+	sqe->len = bufferSize;
+	sqe->off = static_cast<uint64_t>(-1);					// Current file position
+	sqe->user_data = userData;
+	return true;
+}
+
+bool IoUring::prepareRecv(int fd, char * buffer, size_t bufferSize, int flags, uint64_t userData)
+{
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(nextSqe());
+	if (!sqe) {
+		return false;
+	}
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+	sqe->len = bufferSize;
+	sqe->msg_flags = flags;
+	sqe->user_data = userData;
+	return true;
+}
+
+bool IoUring::prepareSend(int fd, const char * buffer, size_t bufferSize, int flags, uint64_t userData)
+{
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(nextSqe());
+	if (!sqe) {
+		return false;
+	}
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+	sqe->len = bufferSize;
+	sqe->msg_flags = flags;
+	sqe->user_data = userData;
+	return true;
+}
+
+bool IoUring::prepareAccept(int fd, struct sockaddr * addr, socklen_t * addrLen, int flags, uint64_t userData)
+{
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(nextSqe());
+	if (!sqe) {
+		return false;
+	}
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<uintptr_t>(addr);
+	sqe->addr2 = reinterpret_cast<uintptr_t>(addrLen);
+	sqe->accept_flags = flags;
+	sqe->user_data = userData;
+	return true;
+}
+
+bool IoUring::prepareCancel(uint64_t targetUserData, uint64_t userData)
+{
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(nextSqe());
+	if (!sqe) {
+		return false;
+	}
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = targetUserData;
+	sqe->user_data = userData;
+	return true;
+}
+
+bool IoUring::prepareLinkTimeout(const Timeout& timeout, uint64_t userData)
+{
+	if (_sqeTail == _sqeSubmitted) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "No operation to link timeout to"));
+	}
+	struct io_uring_sqe * prevSqe = static_cast<struct io_uring_sqe *>(_sqesPtr) + ((_sqeTail - 1) & _sqMask);
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(nextSqe());
+	if (!sqe) {
+		return false;
+	}
+	struct __kernel_timespec * ts = reinterpret_cast<struct __kernel_timespec *>(&_timeSpecs[0]) + ((_sqeTail - 1) & _sqMask);
+	ts->tv_sec = timeout.seconds();
+	ts->tv_nsec = timeout.nanoSeconds();
+	prevSqe->flags |= IOSQE_IO_LINK;
+	sqe->opcode = IORING_OP_LINK_TIMEOUT;
+	sqe->fd = -1;
+	sqe->addr = reinterpret_cast<uintptr_t>(ts);
+	sqe->len = 1;
+	sqe->user_data = userData;
+	return true;
+}
+
+size_t IoUring::reapCompletions(Completion * completions, size_t maxCompletions)
+{
+	unsigned int head = *_cqHeadPtr;
+	unsigned int tail = __atomic_load_n(_cqTailPtr, __ATOMIC_ACQUIRE);
+	size_t completionsReaped = 0;
+	while (head != tail && completionsReaped < maxCompletions) {
+		const struct io_uring_cqe * cqe = static_cast<const struct io_uring_cqe *>(_cqesPtr) + (head & _cqMask);
+		completions[completionsReaped].userData = cqe->user_data;
+		completions[completionsReaped].result = cqe->res;
+		++completionsReaped;
+		++head;
+	}
+	__atomic_store_n(_cqHeadPtr, head, __ATOMIC_RELEASE);
+	return completionsReaped;
+}
+
+int IoUring::read(int fd, char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	prepareRead(fd, buffer, bufferSize, ISL__IO_URING_OPERATION_USER_DATA);
+	prepareLinkTimeout(timeout, ISL__IO_URING_TIMEOUT_USER_DATA);
+	return perform(2);
+}
+
+int IoUring::write(int fd, const char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	prepareWrite(fd, buffer, bufferSize, ISL__IO_URING_OPERATION_USER_DATA);
+	prepareLinkTimeout(timeout, ISL__IO_URING_TIMEOUT_USER_DATA);
+	return perform(2);
+}
+
+int IoUring::recv(int fd, char * buffer, size_t bufferSize, int flags, const Timeout& timeout)
+{
+	prepareRecv(fd, buffer, bufferSize, flags, ISL__IO_URING_OPERATION_USER_DATA);
+	prepareLinkTimeout(timeout, ISL__IO_URING_TIMEOUT_USER_DATA);
+	return perform(2);
+}
+
+int IoUring::send(int fd, const char * buffer, size_t bufferSize, int flags, const Timeout& timeout)
+{
+	prepareSend(fd, buffer, bufferSize, flags, ISL__IO_URING_OPERATION_USER_DATA);
+	prepareLinkTimeout(timeout, ISL__IO_URING_TIMEOUT_USER_DATA);
+	return perform(2);
+}
+
+int IoUring::accept(int fd, struct sockaddr * addr, socklen_t * addrLen, int flags, const Timeout& timeout)
+{
+	prepareAccept(fd, addr, addrLen, flags, ISL__IO_URING_OPERATION_USER_DATA);
+	prepareLinkTimeout(timeout, ISL__IO_URING_TIMEOUT_USER_DATA);
+	return perform(2);
+}
+
+size_t IoUring::submitAndWait(size_t minCompletions, const Timeout& timeout)
+{
+	if (minCompletions <= 0 || timeout.isZero()) {
+		return enter(_sqeTail - _sqeSubmitted, 0);
+	}
+	if (!_isWaitTimeoutSupported) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::IoUringEnter, EINVAL,
+					"Timeout of the wait for the completions is not supported by the kernel"));
+	}
+	return enter(_sqeTail - _sqeSubmitted, minCompletions, &timeout);
+}
+
+void * IoUring::nextSqe()
+{
+	unsigned int head = __atomic_load_n(_sqHeadPtr, __ATOMIC_ACQUIRE);
+	if (_sqeTail - head >= _entries) {
+		return 0;
+	}
+	unsigned int index = _sqeTail & _sqMask;
+	struct io_uring_sqe * sqe = static_cast<struct io_uring_sqe *>(_sqesPtr) + index;
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	_sqArrayPtr[index] = index;
+	++_sqeTail;
+	return sqe;
+}
+
+size_t IoUring::enter(size_t submitAmount, size_t completionsAmount, const Timeout * timeoutPtr)
+{
+	// Publishing queued submissions to the kernel
+	__atomic_store_n(_sqTailPtr, _sqeTail, __ATOMIC_RELEASE);
+	unsigned int flags = completionsAmount > 0 ? IORING_ENTER_GETEVENTS : 0;
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+	const void * argPtr = NULL;
+	size_t argSize = 0;
+	if (timeoutPtr) {
+		ts.tv_sec = timeoutPtr->seconds();
+		ts.tv_nsec = timeoutPtr->nanoSeconds();
+		memset(&arg, 0, sizeof(arg));
+		arg.ts = reinterpret_cast<uintptr_t>(&ts);
+		flags |= IORING_ENTER_EXT_ARG;
+		argPtr = &arg;
+		argSize = sizeof(arg);
+	}
+	while (true) {
+		int result = syscall(__NR_io_uring_enter, _ringDescriptor, submitAmount, completionsAmount, flags, argPtr, argSize);
+		if (result >= 0) {
+			_sqeSubmitted += result;
+			return result;
+		} else if (errno == EINTR) {
+			// Nothing has been submitted if the call has been interrupted
+			continue;
+		} else if (errno == ETIME && timeoutPtr) {
+			// Nothing has been submitted and no completion has arrived in time
+			return 0;
+		}
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::IoUringEnter, errno));
+	}
+}
+
+int IoUring::perform(size_t completionsAmount)
+{
+	size_t completionsLeft = completionsAmount;
+	int operationResult = -ECANCELED;
+	int timeoutResult = 0;
+	enter(_sqeTail - _sqeSubmitted, completionsLeft);
+	while (true) {
+		Completion completions[2];
+		size_t completionsReaped = reapCompletions(completions, completionsLeft < 2 ? completionsLeft : 2);
+		for (size_t i = 0; i < completionsReaped; ++i) {
+			if (completions[i].userData == ISL__IO_URING_OPERATION_USER_DATA) {
+				operationResult = completions[i].result;
+			} else {
+				timeoutResult = completions[i].result;
+			}
+		}
+		completionsLeft -= completionsReaped;
+		if (completionsLeft <= 0) {
+			break;
+		}
+		enter(0, completionsLeft);
+	}
+	// Operation is cancelled by the linked timeout on it's expiration
+	return (operationResult == -ECANCELED && timeoutResult == -ETIME) ? -ETIME : operationResult;
+}
+
+// Engine enabled flag, accessed atomically
+static int ioUringEnabled = 1;
+// Thread-specific engine instance key
+static pthread_key_t ioUringThreadInstanceKey;
+static pthread_once_t ioUringThreadInstanceKeyOnce = PTHREAD_ONCE_INIT;
+// Kernel support probe result
+static bool ioUringSupported = false;
+static pthread_once_t ioUringSupportedOnce = PTHREAD_ONCE_INIT;
+
+static void deleteIoUringThreadInstance(void * ptr)
+{
+	delete static_cast<IoUring *>(ptr);
+}
+
+static void createIoUringThreadInstanceKey()
+{
+	pthread_key_create(&ioUringThreadInstanceKey, deleteIoUringThreadInstance);
+}
+
+static void probeIoUringSupport()
+{
+	// io_uring_setup(2) could be absent or disabled by administrator
+	try {
+		IoUring probe(2);
+		ioUringSupported = true;
+	} catch (std::exception& e) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "io_uring(7) is not supported by the kernel -> falling back to poll(2) I/O-engine: ") << e.what());
+	}
+}
+
+bool IoUring::isSupported()
+{
+	// Probing the kernel once, concurrent callers are waiting for the probe to complete
+	pthread_once(&ioUringSupportedOnce, probeIoUringSupport);
+	return ioUringSupported;
+}
+
+bool IoUring::isEnabled()
+{
+	return __atomic_load_n(&ioUringEnabled, __ATOMIC_RELAXED) && isSupported();
+}
+
+void IoUring::setEnabled(bool newValue)
+{
+	__atomic_store_n(&ioUringEnabled, newValue ? 1 : 0, __ATOMIC_RELAXED);
+}
+
+IoUring * IoUring::threadInstance()
+{
+	if (!isEnabled()) {
+		return 0;
+	}
+	pthread_once(&ioUringThreadInstanceKeyOnce, createIoUringThreadInstanceKey);
+	IoUring * instancePtr = static_cast<IoUring *>(pthread_getspecific(ioUringThreadInstanceKey));
+	if (!instancePtr) {
+		instancePtr = new IoUring();
+		pthread_setspecific(ioUringThreadInstanceKey, instancePtr);
+	}
+	return instancePtr;
+}
+
+#else
+
+IoUring::IoUring(unsigned int entries) :
+	_entries(entries),
+	_isWaitTimeoutSupported(false),
+	_ringDescriptor(-1),
+	_sqRingPtr(0),
+	_sqRingSize(0),
+	_cqRingPtr(0),
+	_cqRingSize(0),
+	_sqesPtr(0),
+	_sqesSize(0),
+	_sqHeadPtr(0),
+	_sqTailPtr(0),
+	_sqMask(0),
+	_sqArrayPtr(0),
+	_cqHeadPtr(0),
+	_cqTailPtr(0),
+	_cqMask(0),
+	_cqesPtr(0),
+	_sqeTail(0),
+	_sqeSubmitted(0),
+	_timeSpecs()
+{
+	throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::IoUringSetup, ENOSYS, "ISL is built without io_uring(7) support"));
+}
+
+IoUring::~IoUring()
+{}
+
+bool IoUring::prepareAccept(int fd, struct sockaddr * addr, socklen_t * addrLen, int flags, uint64_t userData)
+{
+	return false;
+}
+
+bool IoUring::prepareCancel(uint64_t targetUserData, uint64_t userData)
+{
+	return false;
+}
+
+size_t IoUring::submitAndWait(size_t minCompletions, const Timeout& timeout)
+{
+	return 0;
+}
+
+size_t IoUring::reapCompletions(Completion * completions, size_t maxCompletions)
+{
+	return 0;
+}
+
+int IoUring::read(int fd, char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	return -ENOSYS;
+}
+
+int IoUring::write(int fd, const char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	return -ENOSYS;
+}
+
+int IoUring::recv(int fd, char * buffer, size_t bufferSize, int flags, const Timeout& timeout)
+{
+	return -ENOSYS;
+}
+
+int IoUring::send(int fd, const char * buffer, size_t bufferSize, int flags, const Timeout& timeout)
+{
+	return -ENOSYS;
+}
+
+int IoUring::accept(int fd, struct sockaddr * addr, socklen_t * addrLen, int flags, const Timeout& timeout)
+{
+	return -ENOSYS;
+}
+
+bool IoUring::isSupported()
+{
+	return false;
+}
+
+bool IoUring::isEnabled()
+{
+	return false;
+}
+
+void IoUring::setEnabled(bool newValue)
+{}
+
+IoUring * IoUring::threadInstance()
+{
+	return 0;
+}
+
+#endif
+
+} // namespace isl
@@ -0,0 +1,131 @@
+#include <isl/IoUringAcceptor.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <isl/SystemCallError.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <isl/ExceptionLogMessage.hxx>
+#include <isl/Timestamp.hxx>
+#include <errno.h>
+
+// User data of the cancellation operations, accept operations are identified by the slot indexes
+#define ISL__IO_URING_ACCEPTOR_CANCEL_USER_DATA static_cast<uint64_t>(-1)
+// Amount of the completions to reap at once
+#define ISL__IO_URING_ACCEPTOR_REAP_BATCH 16
+
+namespace isl
+{
+
+IoUringAcceptor::IoUringAcceptor(TcpSocket& serverSocket, size_t maxPendingAccepts) :
+	_serverSocket(serverSocket),
+	// Each pending accept operation could be cancelled on destruction
+	_ioUring(maxPendingAccepts * 2),
+	_slots(maxPendingAccepts),
+	_pendingAcceptsCount(0),
+	_acceptedSockets()
+{
+	if (maxPendingAccepts <= 0) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Maximum amount of the pending accept operations should be positive"));
+	}
+	if (!_ioUring.isWaitTimeoutSupported()) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::IoUringEnter, EINVAL,
+					"Timeout of the wait for the completions is not supported by the kernel"));
+	}
+}
+
+IoUringAcceptor::~IoUringAcceptor()
+{
+	try {
+		for (size_t i = 0; i < _slots.size(); ++i) {
+			if (_slots[i].isPending) {
+				_ioUring.prepareCancel(i, ISL__IO_URING_ACCEPTOR_CANCEL_USER_DATA);
+			}
+		}
+		Timestamp limit = Timestamp::limit(Timeout::defaultTimeout());
+		while (_pendingAcceptsCount > 0 && Timestamp::now() < limit) {
+			_ioUring.submitAndWait(1, limit.leftTo());
+			reapCompletions();
+		}
+		if (_pendingAcceptsCount > 0) {
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Pending accept operations have not been cancelled in time: ") << _pendingAcceptsCount);
+		}
+	} catch (std::exception& e) {
+		Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Cancelling pending accept operations error"));
+	} catch (...) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Cancelling pending accept operations unknown error"));
+	}
+	if (!_acceptedSockets.empty()) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Accepted connections have been dropped by the acceptor: ") << _acceptedSockets.size());
+	}
+	for (AcceptedSocketsContainer::iterator i = _acceptedSockets.begin(); i != _acceptedSockets.end(); ++i) {
+		delete (*i);
+	}
+}
+
+std::auto_ptr<TcpSocket> IoUringAcceptor::accept(const Timeout& timeout)
+{
+	if (!_serverSocket.isOpen()) {
+		throw Exception(TcpSocket::NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	Timestamp limit = Timestamp::limit(timeout);
+	while (_acceptedSockets.empty()) {
+		// Completed accept operations are re-armed together with the wait for the completions
+		for (size_t i = 0; i < _slots.size(); ++i) {
+			Slot& slot = _slots[i];
+			if (slot.isPending) {
+				continue;
+			}
+			slot.remoteSockAddrLen = sizeof(slot.remoteSockAddr);
+			if (!_ioUring.prepareAccept(_serverSocket.descriptor(), reinterpret_cast<struct sockaddr *>(&slot.remoteSockAddr),
+						&slot.remoteSockAddrLen, SOCK_NONBLOCK | SOCK_CLOEXEC, i)) {
+				break;
+			}
+			slot.isPending = true;
+			++_pendingAcceptsCount;
+		}
+		_ioUring.submitAndWait(1, limit.leftTo());
+		reapCompletions();
+		if (_acceptedSockets.empty() && Timestamp::now() >= limit) {
+			// Timeout expired
+			return std::auto_ptr<TcpSocket>();
+		}
+	}
+	std::auto_ptr<TcpSocket> socketAutoPtr(_acceptedSockets.front());
+	_acceptedSockets.pop_front();
+	return socketAutoPtr;
+}
+
+size_t IoUringAcceptor::reapCompletions()
+{
+	size_t acceptsCompleted = 0;
+	int errnum = 0;
+	IoUring::Completion completions[ISL__IO_URING_ACCEPTOR_REAP_BATCH];
+	while (size_t completionsReaped = _ioUring.reapCompletions(completions, ISL__IO_URING_ACCEPTOR_REAP_BATCH)) {
+		for (size_t i = 0; i < completionsReaped; ++i) {
+			if (completions[i].userData >= _slots.size()) {
+				// Cancellation's completion
+				continue;
+			}
+			Slot& slot = _slots[completions[i].userData];
+			slot.isPending = false;
+			--_pendingAcceptsCount;
+			++acceptsCompleted;
+			int result = completions[i].result;
+			if (result >= 0) {
+				std::auto_ptr<TcpSocket> socketAutoPtr(new TcpSocket(result, slot.remoteSockAddr, slot.remoteSockAddrLen));
+				_serverSocket.setAcceptedOptions(*socketAutoPtr.get());
+				_acceptedSockets.push_back(socketAutoPtr.get());
+				socketAutoPtr.release();
+			} else if (result != -ECANCELED && result != -EINTR && result != -ECONNABORTED && errnum == 0) {
+				// Error is reported after all completions have been reaped, so no accepted connection is lost
+				errnum = -result;
+			}
+		}
+	}
+	if (errnum != 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Accept, errnum));
+	}
+	return acceptsCompleted;
+}
+
+} // namespace isl
@@ -0,0 +1,206 @@
+#include <isl/ListeningSocketRegistry.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <isl/SystemCallError.hxx>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sstream>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// ListeningSocketRegistry
+//------------------------------------------------------------------------------
+
+ListeningSocketRegistry::ListeningSocketRegistry() :
+	_mutex(),
+	_availableDescriptors(),
+	_descriptors(),
+	_isRetaining(false)
+{
+	loadInherited();
+}
+
+ListeningSocketRegistry& ListeningSocketRegistry::instance()
+{
+	static ListeningSocketRegistry registry;
+	return registry;
+}
+
+bool ListeningSocketRegistry::adopt(TcpSocket& socket, const struct sockaddr * addr, socklen_t addrLen)
+{
+	MutexLocker locker(_mutex);
+	for (AvailableDescriptorsContainer::iterator i = _availableDescriptors.begin(); i != _availableDescriptors.end(); ++i) {
+		if (!isBoundTo(*i, addr, addrLen)) {
+			continue;
+		}
+		socket.adopt(*i);
+		_descriptors.insert(*i);
+		_availableDescriptors.erase(i);
+		return true;
+	}
+	return false;
+}
+
+void ListeningSocketRegistry::add(const TcpSocket& socket)
+{
+	MutexLocker locker(_mutex);
+	_descriptors.insert(socket.descriptor());
+}
+
+void ListeningSocketRegistry::release(TcpSocket& socket)
+{
+	if (!socket.isOpen()) {
+		return;
+	}
+	{
+		MutexLocker locker(_mutex);
+		_descriptors.erase(socket.descriptor());
+		if (_isRetaining) {
+			_availableDescriptors.push_back(socket.detach());
+			return;
+		}
+	}
+	socket.close();
+}
+
+bool ListeningSocketRegistry::isRetaining() const
+{
+	MutexLocker locker(_mutex);
+	return _isRetaining;
+}
+
+void ListeningSocketRegistry::setRetaining(bool newValue)
+{
+	MutexLocker locker(_mutex);
+	_isRetaining = newValue;
+}
+
+size_t ListeningSocketRegistry::availableAmount() const
+{
+	MutexLocker locker(_mutex);
+	return _availableDescriptors.size();
+}
+
+size_t ListeningSocketRegistry::closeAvailable()
+{
+	MutexLocker locker(_mutex);
+	size_t result = _availableDescriptors.size();
+	for (AvailableDescriptorsContainer::iterator i = _availableDescriptors.begin(); i != _availableDescriptors.end(); ++i) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Closing listening socket #") << *i << " nobody has adopted");
+		if (::close(*i)) {
+			Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Close, errno).message()));
+		}
+	}
+	_availableDescriptors.clear();
+	return result;
+}
+
+std::vector<int> ListeningSocketRegistry::descriptors() const
+{
+	MutexLocker locker(_mutex);
+	return std::vector<int>(_descriptors.begin(), _descriptors.end());
+}
+
+std::string ListeningSocketRegistry::composeEnvironment(const std::vector<int>& descriptors)
+{
+	std::ostringstream oss;
+	oss << environmentVariable() << '=';
+	for (std::vector<int>::const_iterator i = descriptors.begin(); i != descriptors.end(); ++i) {
+		if (i != descriptors.begin()) {
+			oss << ',';
+		}
+		oss << *i;
+	}
+	return oss.str();
+}
+
+void ListeningSocketRegistry::loadInherited()
+{
+	const char * value = getenv(environmentVariable());
+	if (!value) {
+		return;
+	}
+	std::istringstream iss(value);
+	std::string token;
+	while (std::getline(iss, token, ',')) {
+		char * endPtr;
+		long descriptor = strtol(token.c_str(), &endPtr, 10);
+		if (token.empty() || *endPtr != '\0' || descriptor < 0) {
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Invalid inherited listening socket descriptor: \"") << token << '"');
+			continue;
+		}
+		if (!isListeningSocket(descriptor)) {
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Inherited descriptor #") << descriptor << " is not a listening socket -> skipping it");
+			continue;
+		}
+		// Inherited descriptor should not leak to the processes spawned by this one
+		if (fcntl(descriptor, F_SETFD, FD_CLOEXEC) < 0) {
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno).message()));
+		}
+		_availableDescriptors.push_back(descriptor);
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Listening socket #") << descriptor << " has been inherited");
+	}
+	unsetenv(environmentVariable());
+}
+
+bool ListeningSocketRegistry::isListeningSocket(int descriptor)
+{
+	int acceptConn = 0;
+	socklen_t optLen = sizeof(acceptConn);
+	return getsockopt(descriptor, SOL_SOCKET, SO_ACCEPTCONN, &acceptConn, &optLen) == 0 && acceptConn;
+}
+
+bool ListeningSocketRegistry::isBoundTo(int descriptor, const struct sockaddr * addr, socklen_t addrLen)
+{
+	struct sockaddr_storage boundAddr;
+	socklen_t boundAddrLen = sizeof(boundAddr);
+	if (getsockname(descriptor, reinterpret_cast<struct sockaddr *>(&boundAddr), &boundAddrLen) != 0) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetSockName, errno).message()));
+		return false;
+	}
+	if (boundAddr.ss_family != addr->sa_family) {
+		return false;
+	}
+	switch (addr->sa_family) {
+		case AF_INET:
+		{
+			const struct sockaddr_in * lhs = reinterpret_cast<const struct sockaddr_in *>(&boundAddr);
+			const struct sockaddr_in * rhs = reinterpret_cast<const struct sockaddr_in *>(addr);
+			return lhs->sin_port == rhs->sin_port && lhs->sin_addr.s_addr == rhs->sin_addr.s_addr;
+		}
+		case AF_INET6:
+		{
+			const struct sockaddr_in6 * lhs = reinterpret_cast<const struct sockaddr_in6 *>(&boundAddr);
+			const struct sockaddr_in6 * rhs = reinterpret_cast<const struct sockaddr_in6 *>(addr);
+			return lhs->sin6_port == rhs->sin6_port && memcmp(&lhs->sin6_addr, &rhs->sin6_addr, sizeof(lhs->sin6_addr)) == 0;
+		}
+		case AF_UNIX:
+		{
+			// Comparing filesystem paths without the trailing zeros or abstract names byte by byte
+			const char * lhsPath = reinterpret_cast<const struct sockaddr_un *>(&boundAddr)->sun_path;
+			const char * rhsPath = reinterpret_cast<const struct sockaddr_un *>(addr)->sun_path;
+			size_t lhsLen = boundAddrLen - offsetof(struct sockaddr_un, sun_path);
+			size_t rhsLen = addrLen - offsetof(struct sockaddr_un, sun_path);
+			if (lhsLen > 0 && lhsPath[0] != '\0') {
+				lhsLen = strnlen(lhsPath, lhsLen);
+			}
+			if (rhsLen > 0 && rhsPath[0] != '\0') {
+				rhsLen = strnlen(rhsPath, rhsLen);
+			}
+			return lhsLen == rhsLen && memcmp(lhsPath, rhsPath, lhsLen) == 0;
+		}
+		default:
+			return false;
+	}
+}
+
+} // namespace isl
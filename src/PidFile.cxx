@@ -26,6 +26,12 @@ PidFile::PidFile(const std::string& fileName) :
 
 PidFile::~PidFile()
 {
+	// The file could have been rewritten by the new server process on upgrade
+	pid_t filePid = 0;
+	std::ifstream ifs(_fileName.c_str());
+	if (ifs >> filePid && filePid != ::getpid()) {
+		return;
+	}
 	if (::remove(_fileName.c_str())) {
 		Log::error().log(ErrorLogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Remove, errno)));
 	}
@@ -3,9 +3,19 @@
 #include <isl/Log.hxx>
 #include <isl/LogMessage.hxx>
 #include <isl/ErrorLogMessage.hxx>
+#include <isl/ExceptionLogMessage.hxx>
+#include <isl/ListeningSocketRegistry.hxx>
 #include <cstdlib>
+#include <sstream>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <errno.h>
+
+extern char ** environ;
 
 namespace isl
 {
@@ -18,7 +28,9 @@ Server::Server(int argc, char * argv[], const SignalSet& trackSignals, const Tim
 	_trackSignals(trackSignals),
 	_initialSignalMask(),
 	_shouldRestart(false),
-	_shouldTerminate(false)
+	_shouldUpgrade(false),
+	_shouldTerminate(false),
+	_upgradeTimeout(DefaultUpgradeTimeout)
 {
 	_argv.reserve(argc);
 	for (int i = 0; i < argc; ++i) {
@@ -30,6 +42,7 @@ void Server::run()
 {
 	_threadHandle = Thread::self();
 	_shouldRestart = false;
+	_shouldUpgrade = false;
 	_shouldTerminate = false;
 	// Blocking UNIX-signals to be tracked
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Blocking UNIX-signals"));
@@ -44,8 +57,12 @@ void Server::run()
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Starting server"));
 	start();
 	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server has been started"));
+	// Closing inherited listening sockets nobody listens to anymore
+	ListeningSocketRegistry::instance().closeAvailable();
 	// Firing on start event
 	onStart();
+	// Reporting readiness to the old server process on upgrade
+	notifyUpgradeReadiness();
 	// Init clock
 	Ticker ticker(clockTimeout());
 	bool firstTick = true;
@@ -56,16 +73,38 @@ void Server::run()
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server termination has been detected -> terminating server"));
 			break;
 		}
+		// Handling upgrade flag
+		if (_shouldUpgrade) {
+			// Upgrade has been detected
+			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server upgrade has been detected -> executing new server process"));
+			_shouldUpgrade = false;
+			bool isUpgraded = false;
+			try {
+				isUpgraded = upgrade();
+			} catch (std::exception& e) {
+				Log::error().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Server upgrade error"));
+			} catch (...) {
+				Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Server upgrade unknown error"));
+			}
+			if (isUpgraded) {
+				Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "New server process is ready -> terminating server"));
+				break;
+			}
+		}
 		// Handling restart flag
 		if (_shouldRestart) {
 			// Restart has been detected
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server restart has been detected -> restarting the server"));
+			// Keeping listening sockets open while the services are restarting
+			ListeningSocketRegistry::instance().setRetaining(true);
 			stop();
+			ListeningSocketRegistry::instance().setRetaining(false);
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server has been stopped"));
 			// Firing on stop event
 			onStop();
 			start();
 			Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Server has been started"));
+			ListeningSocketRegistry::instance().closeAvailable();
 			_shouldRestart = false;
 			// Firing on start event
 			onStart();
@@ -134,6 +173,35 @@ void Server::appointRestart()
 	}
 }
 
+void Server::appointUpgrade()
+{
+	if (_threadHandle == Thread::self()) {
+		_shouldUpgrade = true;
+		return;
+	}
+	// Sending upgrade request
+	size_t requestId = _requester.sendRequest(UpgradeRequest());
+	if (requestId <= 0) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "Could not send upgrade request to the thread requester thread"));
+	} else {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Upgrade request has been sent to the thread requester thread"));
+	}
+	// Fetching the response
+	Timestamp limit = Timestamp::limit(awaitResponseTimeout());
+	std::auto_ptr<AbstractThreadMessage> responseAutoPtr = _requester.awaitResponse(requestId, limit);
+	if (!responseAutoPtr.get()) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS,
+					"No response to upgrade request have been received from the thread requester thread"));
+	} else if (responseAutoPtr->instanceOf<OkResponse>()) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS,
+					"OK response to the upgrade request has been received from the thread requester thread"));
+	} else {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS,
+					"Invalid response to upgrade request has been received from the thread requester thread: \"") <<
+				responseAutoPtr->name() << '"');
+	}
+}
+
 void Server::appointTermination()
 {
 	if (_threadHandle == Thread::self()) {
@@ -188,6 +256,11 @@ void Server::onSignal(int signo)
 			Log::debug().log(msg);
 			appointRestart();
 			break;
+		case SIGUSR2:
+			msg << "appointing a server upgrade";
+			Log::debug().log(msg);
+			appointUpgrade();
+			break;
 		case SIGINT:
 		case SIGTERM:
 			msg << "appointing a server termination";
@@ -200,6 +273,153 @@ void Server::onSignal(int signo)
 	}
 }
 
+bool Server::upgrade()
+{
+	// Resolving the executable before fork(2) like execvp(3) does, so the new binary installed to the same path is executed
+	std::string executable = executablePath(_argv.at(0));
+	std::vector<int> descriptors = ListeningSocketRegistry::instance().descriptors();
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Executing new server process \"") << executable << "\" with " <<
+			descriptors.size() << " listening socket(s) passed");
+	int readyPipe[2];
+	if (pipe2(readyPipe, O_CLOEXEC) != 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Pipe, errno));
+	}
+	// Composing the new process environment and command-line before fork(2), because memory allocation is unsafe after it
+	std::vector<std::string> environment;
+	environment.push_back(ListeningSocketRegistry::composeEnvironment(descriptors));
+	std::ostringstream readyOss;
+	readyOss << ISL__SERVER_UPGRADE_READY_ENVIRONMENT_VARIABLE << '=' << readyPipe[1];
+	environment.push_back(readyOss.str());
+	std::string listenFdsPrefix = std::string(ListeningSocketRegistry::environmentVariable()) + '=';
+	std::string readyFdPrefix = std::string(ISL__SERVER_UPGRADE_READY_ENVIRONMENT_VARIABLE) + '=';
+	for (char ** i = environ; *i; ++i) {
+		if (strncmp(*i, listenFdsPrefix.c_str(), listenFdsPrefix.size()) != 0 && strncmp(*i, readyFdPrefix.c_str(), readyFdPrefix.size()) != 0) {
+			environment.push_back(*i);
+		}
+	}
+	std::vector<char *> envp;
+	for (std::vector<std::string>::iterator i = environment.begin(); i != environment.end(); ++i) {
+		envp.push_back(const_cast<char *>(i->c_str()));
+	}
+	envp.push_back(0);
+	std::vector<char *> argv;
+	for (std::vector<std::string>::iterator i = _argv.begin(); i != _argv.end(); ++i) {
+		argv.push_back(const_cast<char *>(i->c_str()));
+	}
+	argv.push_back(0);
+	pid_t childPid = ::fork();
+	if (childPid < 0) {
+		int errorNumber = errno;
+		::close(readyPipe[0]);
+		::close(readyPipe[1]);
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fork, errorNumber));
+	}
+	if (childPid == 0) {
+		// Child process: passing the descriptors through execve(2) using async-signal-safe calls only
+		for (std::vector<int>::const_iterator i = descriptors.begin(); i != descriptors.end(); ++i) {
+			fcntl(*i, F_SETFD, 0);
+		}
+		fcntl(readyPipe[1], F_SETFD, 0);
+		pthread_sigmask(SIG_SETMASK, &_initialSignalMask, 0);
+		execve(executable.c_str(), &argv[0], &envp[0]);
+		_exit(127);
+	}
+	::close(readyPipe[1]);
+	// Awaiting for the new process readiness, it's listeners are accepting connections together with ours meanwhile
+	bool isReady = false;
+	Timestamp limit = Timestamp::limit(_upgradeTimeout);
+	while (!isReady) {
+		Timestamp now = Timestamp::now();
+		if (now >= limit) {
+			Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "New server process has not become ready for the upgrade timeout"));
+			break;
+		}
+		struct pollfd fds;
+		fds.fd = readyPipe[0];
+		fds.events = POLLIN;
+		fds.revents = 0;
+		int result = poll(&fds, 1, (limit - now).milliSeconds());
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno).message()));
+			break;
+		} else if (result == 0) {
+			continue;
+		}
+		char readyByte;
+		ssize_t bytesRead = ::read(readyPipe[0], &readyByte, sizeof(readyByte));
+		if (bytesRead < 0 && errno == EINTR) {
+			continue;
+		} else if (bytesRead <= 0) {
+			// Pipe has been closed by the new process which has exited before becoming ready
+			Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, "New server process has exited before becoming ready"));
+			break;
+		}
+		isReady = true;
+	}
+	::close(readyPipe[0]);
+	if (isReady) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "New server process (pid = ") << childPid << ") has become ready");
+		return true;
+	}
+	// Upgrade has failed -> continuing to serve the clients
+	if (::kill(childPid, SIGKILL) != 0 && errno != ESRCH) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Kill, errno).message()));
+	}
+	if (::waitpid(childPid, 0, 0) < 0) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::WaitPid, errno).message()));
+	}
+	Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Server upgrade has failed -> continuing to serve the clients"));
+	return false;
+}
+
+std::string Server::executablePath(const std::string& command)
+{
+	if (command.find('/') != std::string::npos) {
+		return command;
+	}
+	const char * pathValue = getenv("PATH");
+	std::string path(pathValue ? pathValue : "/bin:/usr/bin");
+	size_t pos = 0;
+	while (pos <= path.size()) {
+		size_t delimiterPos = path.find(':', pos);
+		if (delimiterPos == std::string::npos) {
+			delimiterPos = path.size();
+		}
+		// Empty PATH element means current directory
+		std::string directory = delimiterPos > pos ? path.substr(pos, delimiterPos - pos) : std::string(".");
+		std::string executable = directory + '/' + command;
+		if (access(executable.c_str(), X_OK) == 0) {
+			return executable;
+		}
+		pos = delimiterPos + 1;
+	}
+	throw Exception(Error(SOURCE_LOCATION_ARGS, "Server executable has not been found in PATH"));
+}
+
+void Server::notifyUpgradeReadiness()
+{
+	const char * value = getenv(ISL__SERVER_UPGRADE_READY_ENVIRONMENT_VARIABLE);
+	if (!value) {
+		return;
+	}
+	int readyDescriptor = atoi(value);
+	unsetenv(ISL__SERVER_UPGRADE_READY_ENVIRONMENT_VARIABLE);
+	char readyByte = 1;
+	ssize_t bytesWritten;
+	do {
+		bytesWritten = ::write(readyDescriptor, &readyByte, sizeof(readyByte));
+	} while (bytesWritten < 0 && errno == EINTR);
+	if (bytesWritten < 0) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Write, errno).message()));
+	} else {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Readiness has been reported to the old server process"));
+	}
+	::close(readyDescriptor);
+}
+
 bool Server::hasPendingSignals() const
 {
 	sigset_t pendingSignals;
@@ -258,6 +478,16 @@ std::auto_ptr<Subsystem::ThreadRequesterType::MessageType> Server::processReques
 					"Termination request has been received by the thread requester thread -> setting the termination flag to TRUE"));
 		_shouldTerminate = true;
 		return std::auto_ptr<ThreadRequesterType::MessageType>(responseRequired ? new OkResponse() : 0);
+	} else if (request.instanceOf<RestartRequest>()) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS,
+					"Restart request has been received by the thread requester thread -> setting the restart flag to TRUE"));
+		_shouldRestart = true;
+		return std::auto_ptr<ThreadRequesterType::MessageType>(responseRequired ? new OkResponse() : 0);
+	} else if (request.instanceOf<UpgradeRequest>()) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS,
+					"Upgrade request has been received by the thread requester thread -> setting the upgrade flag to TRUE"));
+		_shouldUpgrade = true;
+		return std::auto_ptr<ThreadRequesterType::MessageType>(responseRequired ? new OkResponse() : 0);
 	} else if (request.instanceOf<PingRequest>()) {
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS,
 					"Ping request has been received by the thread requester thread -> responding with the pong response"));
@@ -0,0 +1,85 @@
+#include <isl/SharedBuffer.hxx>
+#include <string.h>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// SharedBuffer::State
+//------------------------------------------------------------------------------
+
+SharedBuffer::State::State(const char * data, size_t size) :
+	data(new char[size]),
+	size(size),
+	refsCount(1)
+{
+	memcpy(this->data, data, size);
+}
+
+SharedBuffer::State::~State()
+{
+	delete [] data;
+}
+
+//------------------------------------------------------------------------------
+// SharedBuffer
+//------------------------------------------------------------------------------
+
+SharedBuffer::SharedBuffer() :
+	_statePtr(0)
+{}
+
+SharedBuffer::SharedBuffer(const char * data, size_t size) :
+	_statePtr(0)
+{
+	init(data, size);
+}
+
+SharedBuffer::SharedBuffer(const std::string& str) :
+	_statePtr(0)
+{
+	init(str.data(), str.size());
+}
+
+SharedBuffer::SharedBuffer(const SharedBuffer& other) :
+	_statePtr(other._statePtr)
+{
+	if (_statePtr) {
+		__sync_add_and_fetch(&_statePtr->refsCount, 1);
+	}
+}
+
+SharedBuffer::~SharedBuffer()
+{
+	release();
+}
+
+SharedBuffer& SharedBuffer::operator=(const SharedBuffer& other)
+{
+	if (other._statePtr == _statePtr) {
+		return *this;
+	}
+	if (other._statePtr) {
+		__sync_add_and_fetch(&other._statePtr->refsCount, 1);
+	}
+	release();
+	_statePtr = other._statePtr;
+	return *this;
+}
+
+void SharedBuffer::init(const char * data, size_t size)
+{
+	if (size > 0) {
+		_statePtr = new State(data, size);
+	}
+}
+
+void SharedBuffer::release()
+{
+	if (_statePtr && __sync_sub_and_fetch(&_statePtr->refsCount, 1) <= 0) {
+		delete _statePtr;
+	}
+	_statePtr = 0;
+}
+
+} // namespace isl
@@ -18,7 +18,8 @@ Subsystem::Subsystem(Subsystem * owner, const Timeout& clockTimeout, size_t awai
 	_clockTimeout(clockTimeout),
 	_awaitResponseTicksAmount(awaitResponseTicksAmount),
 	_children(),
-	_threads()
+	_threads(),
+	_threadPlacementPolicy()
 {
 	if (_owner) {
 		_owner->registerChild(this);
@@ -64,7 +65,9 @@ void Subsystem::stop()
 
 void Subsystem::startThreads()
 {
+	size_t threadIndex = 0;
 	for (Threads::iterator i = _threads.begin(); i != _threads.end(); ++i) {
+		(*i)->_thread.setPlacement(_threadPlacementPolicy.placement(threadIndex++));
 		(*i)->start();
 		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Subsystem's thread has been started"));
 	}
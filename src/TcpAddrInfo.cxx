@@ -6,4 +6,42 @@ namespace isl
 const char TcpAddrInfo::LoopbackAddress[] = "localhost";
 const char TcpAddrInfo::WildcardAddress[] = "*";
 
+struct addrinfo * TcpAddrInfo::copyAddrInfo(const struct addrinfo * addrInfo)
+{
+	struct addrinfo * result = 0;
+	struct addrinfo ** nextPtr = &result;
+	try {
+		for (const struct addrinfo * cur = addrInfo; cur; cur = cur->ai_next) {
+			// Socket address is placed in the same memory block just after the addrinfo structure
+			char * block = new char[sizeof(struct addrinfo) + cur->ai_addrlen];
+			struct addrinfo * newAddrInfo = reinterpret_cast<struct addrinfo *>(block);
+			memcpy(newAddrInfo, cur, sizeof(struct addrinfo));
+			newAddrInfo->ai_addr = reinterpret_cast<struct sockaddr *>(block + sizeof(struct addrinfo));
+			memcpy(newAddrInfo->ai_addr, cur->ai_addr, cur->ai_addrlen);
+			newAddrInfo->ai_canonname = 0;
+			newAddrInfo->ai_next = 0;
+			*nextPtr = newAddrInfo;
+			nextPtr = &newAddrInfo->ai_next;
+			if (cur->ai_canonname) {
+				newAddrInfo->ai_canonname = new char[strlen(cur->ai_canonname) + 1];
+				strcpy(newAddrInfo->ai_canonname, cur->ai_canonname);
+			}
+		}
+	} catch (...) {
+		freeAddrInfoCopy(result);
+		throw;
+	}
+	return result;
+}
+
+void TcpAddrInfo::freeAddrInfoCopy(struct addrinfo * addrInfo)
+{
+	while (addrInfo) {
+		struct addrinfo * next = addrInfo->ai_next;
+		delete [] addrInfo->ai_canonname;
+		delete [] reinterpret_cast<char *>(addrInfo);
+		addrInfo = next;
+	}
+}
+
 } // namespace isl
@@ -0,0 +1,328 @@
+#include <isl/TcpConnectionPool.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <isl/ExceptionLogMessage.hxx>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <ctype.h>
+#include <sstream>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// TcpConnectionPool::Lease
+//------------------------------------------------------------------------------
+
+TcpConnectionPool::Lease::Lease(TcpConnectionPool& pool, const TcpAddrInfo& addrInfo, const Timeout& timeout) :
+	_pool(pool),
+	_addrInfo(addrInfo),
+	_socketAutoPtr(pool.borrow(addrInfo, timeout))
+{}
+
+TcpConnectionPool::Lease::~Lease()
+{
+	if (_socketAutoPtr.get()) {
+		_pool.giveBack(_addrInfo, _socketAutoPtr, false);
+	}
+}
+
+TcpSocket& TcpConnectionPool::Lease::socket()
+{
+	if (!_socketAutoPtr.get()) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Connection has not been borrowed or has been given back already"));
+	}
+	return *_socketAutoPtr.get();
+}
+
+void TcpConnectionPool::Lease::giveBack(bool reusable)
+{
+	if (_socketAutoPtr.get()) {
+		_pool.giveBack(_addrInfo, _socketAutoPtr, reusable);
+	}
+}
+
+//------------------------------------------------------------------------------
+// TcpConnectionPool
+//------------------------------------------------------------------------------
+
+TcpConnectionPool::TcpConnectionPool(Subsystem * owner, const Timeout& clockTimeout) :
+	Subsystem(owner, clockTimeout),
+	_minIdleConnections(DefaultMinIdleConnections),
+	_maxIdleConnections(DefaultMaxIdleConnections),
+	_maxConnections(DefaultMaxConnections),
+	_idleTimeout(static_cast<double>(DefaultIdleTimeout)),
+	_connectTimeout(static_cast<double>(DefaultConnectTimeout)),
+	_socketOptions(),
+	_cond(),
+	_slots(),
+	_evictorThread(*this)
+{}
+
+TcpConnectionPool::~TcpConnectionPool()
+{
+	closeIdle();
+}
+
+std::auto_ptr<TcpSocket> TcpConnectionPool::borrow(const TcpAddrInfo& addrInfo, const Timeout& timeout)
+{
+	std::string key = composeKey(addrInfo);
+	Timestamp limit = Timestamp::limit(timeout);
+	while (true) {
+		// Most recently given back idle connection is taken out under the lock and is checked out of it
+		IdleConnection candidate(0, Timestamp());
+		{
+			MutexLocker locker(_cond.mutex());
+			SlotsContainer::iterator pos = _slots.find(key);
+			if (pos == _slots.end()) {
+				pos = _slots.insert(SlotsContainer::value_type(key, Slot(addrInfo))).first;
+			}
+			Slot& slot = pos->second;
+			while (true) {
+				if (!slot.idleConnections.empty()) {
+					candidate = slot.idleConnections.front();
+					slot.idleConnections.pop_front();
+					++slot.borrowedAmount;
+					break;
+				}
+				if (slot.borrowedAmount < _maxConnections) {
+					// Reserving a room for the new connection
+					++slot.borrowedAmount;
+					break;
+				}
+				if (!_cond.wait(limit)) {
+					Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Connection pool to ") << key << " has been exhausted for " <<
+							timeout.secondsDouble() << " seconds");
+					return std::auto_ptr<TcpSocket>();
+				}
+			}
+		}
+		if (!candidate.socketPtr) {
+			break;
+		}
+		std::auto_ptr<TcpSocket> socketAutoPtr(candidate.socketPtr);
+		if (!isExpired(candidate, Timestamp::now()) && isAlive(*candidate.socketPtr)) {
+			return socketAutoPtr;
+		}
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Idle connection to ") << key << " has been discarded on checkout");
+		// Releasing the room of the discarded connection, which is closed out of the lock
+		giveBack(addrInfo, std::auto_ptr<TcpSocket>(), false);
+	}
+	// Establishing a new connection out of the lock
+	try {
+		return connect(addrInfo);
+	} catch (...) {
+		giveBack(addrInfo, std::auto_ptr<TcpSocket>(), false);
+		throw;
+	}
+}
+
+void TcpConnectionPool::giveBack(const TcpAddrInfo& addrInfo, std::auto_ptr<TcpSocket> socketAutoPtr, bool reusable)
+{
+	std::string key = composeKey(addrInfo);
+	MutexLocker locker(_cond.mutex());
+	SlotsContainer::iterator pos = _slots.find(key);
+	if (pos == _slots.end() || pos->second.borrowedAmount <= 0) {
+		Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Connection to ") << key << " has not been borrowed from the pool -> closing it");
+		return;
+	}
+	Slot& slot = pos->second;
+	--slot.borrowedAmount;
+	if (reusable && socketAutoPtr.get() && socketAutoPtr->isOpen() && slot.idleConnections.size() < _maxIdleConnections) {
+		slot.idleConnections.push_front(IdleConnection(socketAutoPtr.get(), Timestamp::now()));
+		socketAutoPtr.release();
+	}
+	// Waiters of all endpoints are sharing the condition variable
+	_cond.wakeAll();
+}
+
+size_t TcpConnectionPool::idleAmount(const TcpAddrInfo& addrInfo) const
+{
+	std::string key = composeKey(addrInfo);
+	MutexLocker locker(_cond.mutex());
+	SlotsContainer::const_iterator pos = _slots.find(key);
+	return pos == _slots.end() ? 0 : pos->second.idleConnections.size();
+}
+
+size_t TcpConnectionPool::borrowedAmount(const TcpAddrInfo& addrInfo) const
+{
+	std::string key = composeKey(addrInfo);
+	MutexLocker locker(_cond.mutex());
+	SlotsContainer::const_iterator pos = _slots.find(key);
+	return pos == _slots.end() ? 0 : pos->second.borrowedAmount;
+}
+
+void TcpConnectionPool::closeIdle()
+{
+	SocketsContainer socketsToClose;
+	{
+		MutexLocker locker(_cond.mutex());
+		for (SlotsContainer::iterator i = _slots.begin(); i != _slots.end(); ++i) {
+			for (IdleConnectionsContainer::iterator j = i->second.idleConnections.begin(); j != i->second.idleConnections.end(); ++j) {
+				socketsToClose.push_back(j->socketPtr);
+			}
+			i->second.idleConnections.clear();
+		}
+	}
+	for (SocketsContainer::iterator i = socketsToClose.begin(); i != socketsToClose.end(); ++i) {
+		delete (*i);
+	}
+}
+
+bool TcpConnectionPool::isReusable(const HttpResponseParser& parser)
+{
+	if (!parser.isCompleted() || parser.version() != "HTTP/1.1") {
+		return false;
+	}
+	std::pair<Http::Headers::const_iterator, Http::Headers::const_iterator> range = parser.headers().equal_range("Connection");
+	for (Http::Headers::const_iterator i = range.first; i != range.second; ++i) {
+		std::string value(i->second);
+		for (std::string::iterator j = value.begin(); j != value.end(); ++j) {
+			*j = tolower(*j);
+		}
+		if (value.find("close") != std::string::npos) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void TcpConnectionPool::stop()
+{
+	// Calling base class method
+	Subsystem::stop();
+	closeIdle();
+}
+
+std::auto_ptr<TcpSocket> TcpConnectionPool::connect(const TcpAddrInfo& addrInfo)
+{
+	std::auto_ptr<TcpSocket> socketAutoPtr(new TcpSocket());
+	socketAutoPtr->open();
+	socketAutoPtr->applyOptions(_socketOptions);
+	if (!socketAutoPtr->connectRacing(addrInfo, _connectTimeout)) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Upstream connection timeout expired"));
+	}
+	Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Connection to ") << composeKey(addrInfo) << " has been established");
+	return socketAutoPtr;
+}
+
+bool TcpConnectionPool::isExpired(const IdleConnection& connection, const Timestamp& now) const
+{
+	return now >= connection.since + _idleTimeout;
+}
+
+void TcpConnectionPool::evict()
+{
+	SocketsContainer socketsToClose;
+	KeyedIdleConnectionsContainer connectionsToCheck;
+	{
+		// Taking the idle connections out of the pool, so they are peeked without holding the lock
+		MutexLocker locker(_cond.mutex());
+		Timestamp now = Timestamp::now();
+		for (SlotsContainer::iterator i = _slots.begin(); i != _slots.end(); ++i) {
+			Slot& slot = i->second;
+			for (IdleConnectionsContainer::iterator j = slot.idleConnections.begin(); j != slot.idleConnections.end(); ++j) {
+				if (isExpired(*j, now)) {
+					socketsToClose.push_back(j->socketPtr);
+				} else {
+					// Connection being checked is counted as a borrowed one
+					connectionsToCheck.push_back(KeyedIdleConnectionsContainer::value_type(i->first, *j));
+					++slot.borrowedAmount;
+				}
+			}
+			slot.idleConnections.clear();
+		}
+	}
+	AddrInfosContainer addrInfosToConnect;
+	{
+		for (KeyedIdleConnectionsContainer::iterator i = connectionsToCheck.begin(); i != connectionsToCheck.end(); ++i) {
+			if (!isAlive(*i->second.socketPtr)) {
+				socketsToClose.push_back(i->second.socketPtr);
+				i->second.socketPtr = 0;
+			}
+		}
+		MutexLocker locker(_cond.mutex());
+		// Alive connections are put behind the ones given back meanwhile, so the most recently used ones are still first
+		for (KeyedIdleConnectionsContainer::iterator i = connectionsToCheck.begin(); i != connectionsToCheck.end(); ++i) {
+			Slot& slot = _slots.find(i->first)->second;
+			--slot.borrowedAmount;
+			if (!i->second.socketPtr) {
+				continue;
+			} else if (slot.idleConnections.size() < _maxIdleConnections) {
+				slot.idleConnections.push_back(i->second);
+			} else {
+				socketsToClose.push_back(i->second.socketPtr);
+			}
+		}
+		for (SlotsContainer::iterator i = _slots.begin(); i != _slots.end(); ++i) {
+			Slot& slot = i->second;
+			// Reserving rooms for the connections up to the minimum idle amount
+			for (size_t idleAmount = slot.idleConnections.size(); idleAmount < _minIdleConnections &&
+					slot.idleConnections.size() + slot.borrowedAmount < _maxConnections; ++idleAmount) {
+				++slot.borrowedAmount;
+				addrInfosToConnect.push_back(slot.addrInfo);
+			}
+		}
+		if (!connectionsToCheck.empty() || !socketsToClose.empty()) {
+			_cond.wakeAll();
+		}
+	}
+	for (SocketsContainer::iterator i = socketsToClose.begin(); i != socketsToClose.end(); ++i) {
+		delete (*i);
+	}
+	if (!socketsToClose.empty()) {
+		Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "") << socketsToClose.size() << " idle connection(s) have been evicted");
+	}
+	for (AddrInfosContainer::iterator i = addrInfosToConnect.begin(); i != addrInfosToConnect.end(); ++i) {
+		std::auto_ptr<TcpSocket> socketAutoPtr;
+		try {
+			socketAutoPtr = connect(*i);
+		} catch (std::exception& e) {
+			Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Establishing idle connection error"));
+		} catch (...) {
+			Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Establishing idle connection unknown error"));
+		}
+		giveBack(*i, socketAutoPtr, true);
+	}
+}
+
+std::string TcpConnectionPool::composeKey(const TcpAddrInfo& addrInfo)
+{
+	TcpAddrInfo::Endpoint endpoint = addrInfo.firstEndpoint();
+	std::ostringstream oss;
+	oss << endpoint.host << ':' << endpoint.port;
+	return oss.str();
+}
+
+bool TcpConnectionPool::isAlive(const TcpSocket& socket)
+{
+	char ch;
+	ssize_t bytesPeeked = recv(socket.descriptor(), &ch, sizeof(ch), MSG_PEEK | MSG_DONTWAIT);
+	if (bytesPeeked == 0) {
+		// Connection has been closed by the peer
+		return false;
+	} else if (bytesPeeked > 0) {
+		// Unsolicited data, e.g. a stale response or "408 Request Timeout"
+		return false;
+	}
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+//------------------------------------------------------------------------------
+// TcpConnectionPool::EvictorThread
+//------------------------------------------------------------------------------
+
+TcpConnectionPool::EvictorThread::EvictorThread(TcpConnectionPool& pool) :
+	OscillatorThread(pool),
+	_pool(pool)
+{}
+
+void TcpConnectionPool::EvictorThread::doLoad(const Timestamp& prevTickTimestamp, const Timestamp& nextTickTimestamp, size_t ticksExpired)
+{
+	_pool.evict();
+}
+
+} // namespace isl
@@ -5,14 +5,44 @@
 #include <isl/IOError.hxx>
 #include <isl/Log.hxx>
 #include <isl/LogMessage.hxx>
+#include <isl/ExceptionLogMessage.hxx>
+#include <isl/IoUring.hxx>
+#include <isl/UnixAddrInfo.hxx>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <pthread.h>
 #include <arpa/inet.h>
 #include <errno.h>
 #include <time.h>
 #include <strings.h>
+#include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <vector>
+
+#ifndef ISL__TCP_SOCKET_MAX_IOV
+#define ISL__TCP_SOCKET_MAX_IOV 64						// Maximum amount of the buffers to pass to sendmsg(2) at once
+#endif
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60							// Linux 4.14+, could be missing in the older libc headers
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
 
 #if defined (__SVR4) && defined (__sun)					// See http://www.bolthole.com/solaris/
 #define MSG_NOSIGNAL 0							// TODO See http://track.sipfoundry.org/browse/XPL-111
@@ -27,18 +57,66 @@ namespace isl
 
 TcpSocket::TcpSocket() :
 	AbstractIODevice(),
+	_domain(PF_INET),
 	_descriptor(-1),
+	_acceptedOptions(),
+	_connectionOptions(),
+	_corkWrites(false),
+	_peersDataMutex(),
+	_localSockAddr(),
+	_localSockAddrLen(0),
+	_remoteSockAddr(),
+	_remoteSockAddrLen(0),
 	_localAddrAutoPtr(),
-	_remoteAddrAutoPtr()
+	_remoteAddrAutoPtr(),
+	_zeroCopyMutex(),
+	_zeroCopyThreshold(-1),
+	_zeroCopyFallback(false),
+	_zeroCopySequence(0),
+	_pendingZeroCopySends()
 {}
 
-TcpSocket::TcpSocket(int descriptor) :
+TcpSocket::TcpSocket(int domain) :
 	AbstractIODevice(),
+	_domain(domain),
+	_descriptor(-1),
+	_acceptedOptions(),
+	_connectionOptions(),
+	_corkWrites(false),
+	_peersDataMutex(),
+	_localSockAddr(),
+	_localSockAddrLen(0),
+	_remoteSockAddr(),
+	_remoteSockAddrLen(0),
+	_localAddrAutoPtr(),
+	_remoteAddrAutoPtr(),
+	_zeroCopyMutex(),
+	_zeroCopyThreshold(-1),
+	_zeroCopyFallback(false),
+	_zeroCopySequence(0),
+	_pendingZeroCopySends()
+{}
+
+TcpSocket::TcpSocket(int descriptor, const struct sockaddr_storage& remoteSockAddr, socklen_t remoteSockAddrLen) :
+	AbstractIODevice(),
+	_domain(remoteSockAddr.ss_family),
 	_descriptor(descriptor),
+	_acceptedOptions(),
+	_connectionOptions(),
+	_corkWrites(false),
+	_peersDataMutex(),
+	_localSockAddr(),
+	_localSockAddrLen(0),
+	_remoteSockAddr(remoteSockAddr),
+	_remoteSockAddrLen(remoteSockAddrLen),
 	_localAddrAutoPtr(),
-	_remoteAddrAutoPtr()
+	_remoteAddrAutoPtr(),
+	_zeroCopyMutex(),
+	_zeroCopyThreshold(-1),
+	_zeroCopyFallback(false),
+	_zeroCopySequence(0),
+	_pendingZeroCopySends()
 {
-	fetchPeersData();
 	setIsOpen(true);
 }
 
@@ -49,33 +127,73 @@ TcpSocket::~TcpSocket()
 	}
 }
 
-const TcpAddrInfo& TcpSocket::localAddr() const
+TcpAddrInfo TcpSocket::localAddr() const
 {
+	MutexLocker locker(_peersDataMutex);
 	if (!_localAddrAutoPtr.get()) {
-		throw Exception(Error(SOURCE_LOCATION_ARGS, "Local address info have not been initialized"));
+		const struct sockaddr * addr = localSockAddr();
+		if (addr->sa_family == AF_UNIX) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Unix domain socket address could not be represented by TCP address info, use localEndpoint() instead"));
+		}
+		_localAddrAutoPtr.reset(new TcpAddrInfo(addr));
 	}
 	return *_localAddrAutoPtr.get();
 }
 
-const TcpAddrInfo& TcpSocket::remoteAddr() const
+TcpAddrInfo TcpSocket::remoteAddr() const
 {
+	MutexLocker locker(_peersDataMutex);
 	if (!_remoteAddrAutoPtr.get()) {
-		throw Exception(Error(SOURCE_LOCATION_ARGS, "Remote address info have not been initialized"));
+		const struct sockaddr * addr = remoteSockAddr();
+		if (addr->sa_family == AF_UNIX) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Unix domain socket address could not be represented by TCP address info, use remoteEndpoint() instead"));
+		}
+		_remoteAddrAutoPtr.reset(new TcpAddrInfo(addr));
 	}
 	return *_remoteAddrAutoPtr.get();
 }
 
-void TcpSocket::bind(const TcpAddrInfo& addrInfo)
+TcpAddrInfo::Endpoint TcpSocket::localEndpoint() const
+{
+	MutexLocker locker(_peersDataMutex);
+	const struct sockaddr * addr = localSockAddr();
+	if (addr->sa_family == AF_UNIX) {
+		return TcpAddrInfo::Endpoint(UnixAddrInfo::str(addr, _localSockAddrLen), 0);
+	}
+	return TcpAddrInfo::endpoint(addr);
+}
+
+TcpAddrInfo::Endpoint TcpSocket::remoteEndpoint() const
+{
+	MutexLocker locker(_peersDataMutex);
+	const struct sockaddr * addr = remoteSockAddr();
+	if (addr->sa_family == AF_UNIX) {
+		return TcpAddrInfo::Endpoint(UnixAddrInfo::str(addr, _remoteSockAddrLen), 0);
+	}
+	return TcpAddrInfo::endpoint(addr);
+}
+
+void TcpSocket::bind(const TcpAddrInfo& addrInfo, bool reusePort)
 {
 	if (!isOpen()) {
 		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::DeviceIsNotOpen));
 		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
+	if (_domain == PF_UNIX) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "TCP address could not be bound to the Unix domain socket"));
+	}
 	// Setting SO_REUSEADDR to true
 	int reuseAddr = 1;
 	if (setsockopt(_descriptor, SOL_SOCKET, SO_REUSEADDR, &reuseAddr, sizeof(reuseAddr)) < 0) {
 		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::SetSockOpt, errno));
 	}
+	if (reusePort) {
+		// Setting SO_REUSEPORT to true
+		int reusePortValue = 1;
+		if (setsockopt(_descriptor, SOL_SOCKET, SO_REUSEPORT, &reusePortValue, sizeof(reusePortValue)) < 0) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::SetSockOpt, errno));
+		}
+	}
 	// Binding to all endpoints
 	const struct addrinfo * ai = addrInfo.addrinfo();
 	while (ai) {
@@ -86,6 +204,32 @@ void TcpSocket::bind(const TcpAddrInfo& addrInfo)
 	}
 }
 
+void TcpSocket::applyOptions(const TcpSocketOptions& options)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	setConnectionOptions(options, true);
+	_connectionOptions = options;
+}
+
+void TcpSocket::applyListenerOptions(const TcpSocketOptions& options)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	// Buffer sizes are inherited by the accepted sockets
+	setSocketOption(SOL_SOCKET, SO_SNDBUF, options.sendBufferSize());
+	setSocketOption(SOL_SOCKET, SO_RCVBUF, options.receiveBufferSize());
+	if (_domain != PF_UNIX) {
+		setSocketOption(IPPROTO_TCP, TCP_DEFER_ACCEPT, options.deferAccept());
+#ifdef TCP_FASTOPEN
+		setSocketOption(IPPROTO_TCP, TCP_FASTOPEN, options.fastOpen());
+#endif
+	}
+	_acceptedOptions = options;
+}
+
 void TcpSocket::listen(unsigned int backLog)
 {
 	if (!isOpen()) {
@@ -97,127 +241,559 @@ void TcpSocket::listen(unsigned int backLog)
 	}
 }
 
+void TcpSocket::adopt(int descriptor)
+{
+	if (isOpen()) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Could not adopt socket descriptor to the open socket"));
+	}
+	int flags = fcntl(descriptor, F_GETFL);
+	if (flags < 0 || fcntl(descriptor, F_SETFL, flags | O_NONBLOCK) < 0 || fcntl(descriptor, F_SETFD, FD_CLOEXEC) < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
+	}
+	resetPeersData();
+	_descriptor = descriptor;
+	setIsOpen(true);
+}
+
+int TcpSocket::detach()
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	int descriptor = _descriptor;
+	_descriptor = -1;
+	resetPeersData();
+	setIsOpen(false);
+	return descriptor;
+}
+
 std::auto_ptr<TcpSocket> TcpSocket::accept(const Timeout& timeout)
 {
 	if (!isOpen()) {
 		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::DeviceIsNotOpen));
 		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
-	// Waiting for incoming connection
-	timespec selectTimeout = timeout.timeSpec();
-	fd_set descriptorsSet;
-	FD_ZERO(&descriptorsSet);
-	FD_SET(_descriptor, &descriptorsSet);
-	int descriptorsCount = pselect(_descriptor + 1, &descriptorsSet, NULL, NULL, &selectTimeout, NULL);
-	if (descriptorsCount == 0) {
-		// Timeout expired
-		return std::auto_ptr<TcpSocket>();
-	} else if (descriptorsCount < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PSelect, errno));
-	}
-	// Extracting and returning pending connection
-	int pendingSocketDescriptor = ::accept(_descriptor, NULL, NULL);
-	if (pendingSocketDescriptor < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Accept, errno));
+	Timestamp limit;
+	while (true) {
+		// Trying to extract pending connection first, the peer's address is saved for the lazy address info creation
+		struct sockaddr_storage remoteSockAddr;
+		socklen_t remoteSockAddrLen = sizeof(remoteSockAddr);
+		int pendingSocketDescriptor = accept4(_descriptor, reinterpret_cast<struct sockaddr *>(&remoteSockAddr), &remoteSockAddrLen,
+				SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (pendingSocketDescriptor >= 0) {
+			std::auto_ptr<TcpSocket> socketAutoPtr(new TcpSocket(pendingSocketDescriptor, remoteSockAddr, remoteSockAddrLen));
+			setAcceptedOptions(*socketAutoPtr.get());
+			return socketAutoPtr;
+		}
+		if (errno == EINTR || errno == ECONNABORTED) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Accept, errno));
+		}
+		IoUring * ioUringPtr = (timeout.isZero() || !limit.isZero()) ? 0 : IoUring::threadInstance();
+		if (ioUringPtr) {
+			// No pending connections -> accepting the connection with the timeout using one io_uring_enter(2) call
+			int result = ioUringPtr->accept(_descriptor, reinterpret_cast<struct sockaddr *>(&remoteSockAddr), &remoteSockAddrLen,
+					SOCK_NONBLOCK | SOCK_CLOEXEC, timeout);
+			if (result >= 0) {
+				std::auto_ptr<TcpSocket> socketAutoPtr(new TcpSocket(result, remoteSockAddr, remoteSockAddrLen));
+				setAcceptedOptions(*socketAutoPtr.get());
+				return socketAutoPtr;
+			} else if (result == -ETIME || result == -EINTR || result == -ECONNABORTED) {
+				return std::auto_ptr<TcpSocket>();
+			}
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Accept, -result));
+		}
+		// No pending connections -> waiting for incoming connection for the rest of the timeout
+		if (!awaitDescriptor(POLLIN, timeout, limit)) {
+			// Timeout expired
+			return std::auto_ptr<TcpSocket>();
+		}
 	}
-	// Making the socket non-blocking
-	int pendingSocketFlags = fcntl(pendingSocketDescriptor, F_GETFL, 0);
-	if (pendingSocketFlags < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
+}
+
+void TcpSocket::connect(const TcpAddrInfo& addrInfo)
+{
+	ensureInetDomain();
+	connectSockAddr(addrInfo.addrinfo()->ai_addr, addrInfo.addrinfo()->ai_addrlen, 0);
+}
+
+bool TcpSocket::connect(const TcpAddrInfo& addrInfo, const Timeout& timeout)
+{
+	ensureInetDomain();
+	return connectSockAddr(addrInfo.addrinfo()->ai_addr, addrInfo.addrinfo()->ai_addrlen, &timeout);
+}
+
+bool TcpSocket::connectRacing(const TcpAddrInfo& addrInfo, const Timeout& timeout, const Timeout& stagger)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
-	if (!(pendingSocketFlags | O_NONBLOCK)) {
-		pendingSocketFlags |= O_NONBLOCK;
-		if (fcntl(pendingSocketDescriptor, F_SETFL, pendingSocketFlags) < 0) {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
+	ensureInetDomain();
+	resetPeersData();
+	Timestamp limit = Timestamp::limit(timeout);
+	// Connection attempts in progress
+	std::vector<struct pollfd> fds;
+	std::vector<const struct addrinfo *> attemptAddrs;
+	const struct addrinfo * nextAddr = addrInfo.addrinfo();
+	Timestamp nextAttemptTimestamp;
+	int winnerDescriptor = -1;
+	const struct addrinfo * winnerAddr = 0;
+	int lastError = 0;
+	try {
+		while (winnerDescriptor < 0) {
+			Timestamp now = Timestamp::now();
+			if (nextAddr && (fds.empty() || now >= nextAttemptTimestamp)) {
+				// Starting the next connection attempt
+				const struct addrinfo * curAddr = nextAddr;
+				nextAddr = nextAddr->ai_next;
+				int descriptor = socket(curAddr->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+				if (descriptor < 0) {
+					throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Socket, errno));
+				}
+				// Buffer sizes should be set before the connection is established to affect the TCP window scale
+				try {
+					setSocketOption(descriptor, SOL_SOCKET, SO_SNDBUF, _connectionOptions.sendBufferSize());
+					setSocketOption(descriptor, SOL_SOCKET, SO_RCVBUF, _connectionOptions.receiveBufferSize());
+				} catch (...) {
+					::close(descriptor);
+					throw;
+				}
+				if (::connect(descriptor, curAddr->ai_addr, curAddr->ai_addrlen) == 0) {
+					winnerDescriptor = descriptor;
+					winnerAddr = curAddr;
+					break;
+				} else if (errno != EINPROGRESS) {
+					lastError = errno;
+					::close(descriptor);
+					continue;
+				}
+				struct pollfd attemptFds;
+				attemptFds.fd = descriptor;
+				attemptFds.events = POLLOUT;
+				attemptFds.revents = 0;
+				fds.push_back(attemptFds);
+				attemptAddrs.push_back(curAddr);
+				nextAttemptTimestamp = now + stagger;
+				continue;
+			}
+			if (fds.empty() || now >= limit) {
+				// All attempts have failed or the timeout has been expired
+				break;
+			}
+			Timestamp waitLimit = (nextAddr && nextAttemptTimestamp < limit) ? nextAttemptTimestamp : limit;
+			int descriptorsCount = poll(&fds[0], fds.size(), pollTimeout(now, waitLimit));
+			if (descriptorsCount < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno));
+			}
+			for (size_t i = 0; i < fds.size() && descriptorsCount > 0;) {
+				if (!fds[i].revents) {
+					++i;
+					continue;
+				}
+				--descriptorsCount;
+				int connectError = socketError(fds[i].fd);
+				if (connectError == 0) {
+					winnerDescriptor = fds[i].fd;
+					winnerAddr = attemptAddrs[i];
+					fds.erase(fds.begin() + i);
+					attemptAddrs.erase(attemptAddrs.begin() + i);
+					break;
+				}
+				// Failed attempt is starting the next one immediately
+				lastError = connectError;
+				::close(fds[i].fd);
+				fds.erase(fds.begin() + i);
+				attemptAddrs.erase(attemptAddrs.begin() + i);
+				nextAttemptTimestamp = now;
+			}
+		}
+	} catch (...) {
+		for (size_t i = 0; i < fds.size(); ++i) {
+			::close(fds[i].fd);
+		}
+		if (winnerDescriptor >= 0) {
+			::close(winnerDescriptor);
+		}
+		throw;
+	}
+	// Closing connection attempts which have lost the race
+	bool attemptsInProgress = !fds.empty();
+	for (size_t i = 0; i < fds.size(); ++i) {
+		::close(fds[i].fd);
+	}
+	if (winnerDescriptor < 0) {
+		if (attemptsInProgress || nextAddr || lastError == 0) {
+			return false;
 		}
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, lastError));
 	}
-	return std::auto_ptr<TcpSocket>(new TcpSocket(pendingSocketDescriptor));
+	// Replacing socket's descriptor with the winner's one, which could be of another protocol family
+	int zeroCopyThreshold;
+	{
+		MutexLocker locker(_zeroCopyMutex);
+		zeroCopyThreshold = _zeroCopyThreshold;
+	}
+	closeSocket();
+	_domain = winnerAddr->ai_family;
+	_descriptor = winnerDescriptor;
+	memcpy(&_remoteSockAddr, winnerAddr->ai_addr, winnerAddr->ai_addrlen);
+	_remoteSockAddrLen = winnerAddr->ai_addrlen;
+	// Restoring the socket's tuning on the winner's descriptor
+	if (!_connectionOptions.isEmpty()) {
+		setConnectionOptions(_connectionOptions, false);
+	}
+	if (zeroCopyThreshold >= 0 && !isZeroCopy()) {
+		try {
+			enableZeroCopy(zeroCopyThreshold);
+		} catch (std::exception& e) {
+			Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Enabling zero-copy send error -> falling back to copy send"));
+		}
+	}
+	return true;
 }
 
-void TcpSocket::connect(const TcpAddrInfo& addrInfo)
+void TcpSocket::enableZeroCopy(size_t threshold)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	int value = 1;
+	if (setsockopt(_descriptor, SOL_SOCKET, SO_ZEROCOPY, &value, sizeof(value)) < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::SetSockOpt, errno));
+	}
+	MutexLocker locker(_zeroCopyMutex);
+	_zeroCopyThreshold = threshold;
+	_zeroCopyFallback = false;
+}
+
+size_t TcpSocket::sendShared(const SharedBuffer& buffer, size_t offset, const Timeout& timeout)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	if (offset >= buffer.size()) {
+		return 0;
+	}
+	const char * data = buffer.data() + offset;
+	size_t size = buffer.size() - offset;
+	bool zeroCopySend = false;
+	{
+		MutexLocker locker(_zeroCopyMutex);
+		if (!_pendingZeroCopySends.empty()) {
+			reapZeroCopyCompletionsUnlocked();
+		}
+		zeroCopySend = _zeroCopyThreshold >= 0 && !_zeroCopyFallback && size >= static_cast<size_t>(_zeroCopyThreshold);
+	}
+	if (!zeroCopySend) {
+		return write(data, size, timeout);
+	}
+	Timestamp limit;
+	while (true) {
+		int sendErrno = 0;
+		{
+			// Trying to send the data first, the zero-copy mutex is held, so the completion could not be reaped by
+			// the reading thread before the buffer is registered as pending
+			MutexLocker locker(_zeroCopyMutex);
+			ssize_t bytesSent = ::send(_descriptor, data, size, MSG_NOSIGNAL | MSG_ZEROCOPY);
+			if (bytesSent > 0) {
+				// Each successful MSG_ZEROCOPY send is numbered by the kernel sequentially
+				_pendingZeroCopySends.push_back(PendingZeroCopySend(_zeroCopySequence++, buffer));
+				return bytesSent;
+			} else if (bytesSent == 0) {
+				throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+			}
+			sendErrno = errno;
+			if (sendErrno == ENOBUFS) {
+				// Socket's optmem limit is exhausted by the pending completions
+				reapZeroCopyCompletionsUnlocked();
+			}
+		}
+		if (sendErrno == EINTR) {
+			continue;
+		} else if (sendErrno == EPIPE) {
+			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+		} else if (sendErrno == ENOBUFS) {
+			// Copying the data
+			return write(data, size, timeout);
+		} else if (sendErrno != EAGAIN && sendErrno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Send, sendErrno));
+		}
+		// Socket send buffer is full -> waiting for the socket to become writable for the rest of the timeout
+		if (!awaitDescriptor(POLLOUT, timeout, limit)) {
+			// Timeout expired
+			return 0;
+		}
+	}
+}
+
+size_t TcpSocket::reapZeroCopyCompletions()
+{
+	MutexLocker locker(_zeroCopyMutex);
+	return reapZeroCopyCompletionsUnlocked();
+}
+
+size_t TcpSocket::reapZeroCopyCompletionsUnlocked()
+{
+	// Draining the whole error queue, because the socket is reporting POLLERR until it is empty
+	size_t buffersReleased = 0;
+	while (true) {
+		char control[128];
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if (recvmsg(_descriptor, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+			if (errno == EINTR) {
+				continue;
+			} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, "recvmsg(2)", errno));
+		}
+		for (struct cmsghdr * cmsgPtr = CMSG_FIRSTHDR(&msg); cmsgPtr; cmsgPtr = CMSG_NXTHDR(&msg, cmsgPtr)) {
+			if (!(cmsgPtr->cmsg_level == SOL_IP && cmsgPtr->cmsg_type == IP_RECVERR) &&
+					!(cmsgPtr->cmsg_level == SOL_IPV6 && cmsgPtr->cmsg_type == IPV6_RECVERR)) {
+				continue;
+			}
+			const struct sock_extended_err * errPtr = reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cmsgPtr));
+			if (errPtr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || errPtr->ee_errno != 0) {
+				continue;
+			}
+			if ((errPtr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) && !_zeroCopyFallback) {
+				// Kernel has copied the data anyway, so the zero-copy send costs more than the plain one
+				Log::debug().log(LogMessage(SOURCE_LOCATION_ARGS, "Zero-copy send has been deferred to copy by the kernel -> falling back to copy send"));
+				_zeroCopyFallback = true;
+			}
+			// Completion notification reports an inclusive range of the send sequence numbers
+			buffersReleased += releaseZeroCopySends(errPtr->ee_info, errPtr->ee_data);
+		}
+	}
+	return buffersReleased;
+}
+
+bool TcpSocket::awaitZeroCopyCompletions(const Timeout& timeout)
+{
+	Timestamp limit = Timestamp::limit(timeout);
+	while (true) {
+		{
+			MutexLocker locker(_zeroCopyMutex);
+			reapZeroCopyCompletionsUnlocked();
+			if (_pendingZeroCopySends.empty()) {
+				return true;
+			}
+		}
+		Timestamp now = Timestamp::now();
+		if (now >= limit) {
+			return false;
+		}
+		// Completions are signalled by POLLERR event, which is polled implicitly
+		struct pollfd fds;
+		fds.fd = _descriptor;
+		fds.events = 0;
+		fds.revents = 0;
+		int descriptorsCount = poll(&fds, 1, pollTimeout(now, limit));
+		if (descriptorsCount < 0 && errno != EINTR) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno));
+		} else if (descriptorsCount > 0 && !(fds.revents & POLLERR)) {
+			// Peer has hung up, but completions are still pending -> avoiding busy loop
+			struct timespec delay = {0, 1000000};
+			nanosleep(&delay, 0);
+		}
+	}
+}
+
+bool TcpSocket::connectSockAddr(const struct sockaddr * addr, socklen_t addrLen, const Timeout * timeoutPtr)
 {
 	if (!isOpen()) {
 		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::DeviceIsNotOpen));
 		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
-	if (::connect(_descriptor, addrInfo.addrinfo()->ai_addr, addrInfo.addrinfo()->ai_addrlen)) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, errno));
+	resetPeersData();
+	if (::connect(_descriptor, addr, addrLen)) {
+		if (errno != EINPROGRESS) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, errno));
+		}
+		// Socket is non-blocking -> waiting for the socket to become writable for the timeout
+		Timestamp limit = timeoutPtr ? Timestamp::limit(*timeoutPtr) : Timestamp();
+		while (true) {
+			Timestamp now = Timestamp::now();
+			if (timeoutPtr && now >= limit) {
+				return false;
+			}
+			struct pollfd fds;
+			fds.fd = _descriptor;
+			fds.events = POLLOUT;
+			int descriptorsCount = poll(&fds, 1, timeoutPtr ? pollTimeout(now, limit) : -1);
+			if (descriptorsCount < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno));
+			} else if (descriptorsCount > 0) {
+				break;
+			}
+		}
+		int connectError = socketError(_descriptor);
+		if (connectError != 0) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, connectError));
+		}
 	}
-	fetchPeersData();
+	// Saving the peer's address for the lazy address info creation
+	memcpy(&_remoteSockAddr, addr, addrLen);
+	_remoteSockAddrLen = addrLen;
+	return true;
 }
 
-void TcpSocket::closeSocket()
+void TcpSocket::ensureInetDomain() const
 {
-	if (::close(_descriptor)) {
-		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Close, errno).message()));
+	if (_domain == PF_UNIX) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Unix domain socket could not be connected to the TCP address"));
 	}
-	_descriptor = -1;
 }
 
-void TcpSocket::fetchPeersData()
+void TcpSocket::setAcceptedOptions(TcpSocket& socket) const
 {
-	// Fetching local address info
-	struct sockaddr la;
-	socklen_t las = sizeof(la);
-	if (getsockname(_descriptor, &la, &las)) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetSockName, errno));
+	if (_acceptedOptions.isEmpty()) {
+		return;
 	}
-	if (la.sa_family == AF_INET6) {
-		struct sockaddr_in6 * addrPtr = reinterpret_cast<struct sockaddr_in6 *>(&la);
-		char buf[INET6_ADDRSTRLEN];
-		if (!inet_ntop(AF_INET6, &(addrPtr->sin6_addr), buf, INET6_ADDRSTRLEN)) {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::InetNToP, errno));
+	try {
+		socket.setConnectionOptions(_acceptedOptions, false);
+	} catch (std::exception& e) {
+		Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Error applying socket options to the accepted connection"));
+	}
+}
+
+void TcpSocket::setConnectionOptions(const TcpSocketOptions& options, bool setBufferSizes)
+{
+	if (setBufferSizes) {
+		setSocketOption(SOL_SOCKET, SO_SNDBUF, options.sendBufferSize());
+		setSocketOption(SOL_SOCKET, SO_RCVBUF, options.receiveBufferSize());
+	}
+#ifdef SO_BUSY_POLL
+	setSocketOption(SOL_SOCKET, SO_BUSY_POLL, options.busyPoll());
+#endif
+	if (_domain != PF_UNIX) {
+		setSocketOption(IPPROTO_TCP, TCP_NODELAY, options.noDelay());
+#ifdef TCP_USER_TIMEOUT
+		setSocketOption(IPPROTO_TCP, TCP_USER_TIMEOUT, options.userTimeout());
+#endif
+		_corkWrites = options.cork();
+		if (options.zeroCopyThreshold() >= 0) {
+			try {
+				enableZeroCopy(options.zeroCopyThreshold());
+			} catch (std::exception& e) {
+				Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Enabling zero-copy send error -> falling back to copy send"));
+			}
 		}
-		_localAddrAutoPtr.reset(new TcpAddrInfo(TcpAddrInfo::IpV6, buf, ntohs(addrPtr->sin6_port)));
-	} else {
-		struct sockaddr_in * addrPtr = reinterpret_cast<struct sockaddr_in *>(&la);
-		char buf[INET_ADDRSTRLEN];
-		if (!inet_ntop(AF_INET, &(addrPtr->sin_addr), buf, INET_ADDRSTRLEN)) {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::InetNToP, errno));
+	}
+}
+
+void TcpSocket::setSocketOption(int level, int optionName, int value)
+{
+	setSocketOption(_descriptor, level, optionName, value);
+}
+
+void TcpSocket::setSocketOption(int descriptor, int level, int optionName, int value)
+{
+	if (value < 0) {
+		return;
+	}
+	if (setsockopt(descriptor, level, optionName, &value, sizeof(value)) < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::SetSockOpt, errno));
+	}
+}
+
+int TcpSocket::socketError(int descriptor)
+{
+	int error = 0;
+	socklen_t errorSize = sizeof(error);
+	if (getsockopt(descriptor, SOL_SOCKET, SO_ERROR, &error, &errorSize)) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetSockOpt, errno));
+	}
+	return error;
+}
+
+int TcpSocket::pollTimeout(const Timestamp& now, const Timestamp& limit)
+{
+	if (limit <= now) {
+		return 0;
+	}
+	// Rounding up, so the poll(2) is not returning just before the limit
+	Timeout timeLeft = limit - now;
+	return timeLeft.seconds() * 1000 + (timeLeft.nanoSeconds() + 999999) / 1000000;
+}
+
+void TcpSocket::closeSocket()
+{
+	if (pendingZeroCopySends() > 0) {
+		// Kernel could still transmit the data from the pending buffers after the socket has been closed
+		try {
+			if (!awaitZeroCopyCompletions(Timeout(0, DefaultZeroCopyLinger * 1000000L))) {
+				Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "") << pendingZeroCopySends() <<
+						" zero-copy send(s) have not been completed before closing the socket");
+			}
+		} catch (std::exception& e) {
+			Log::warning().log(ExceptionLogMessage(SOURCE_LOCATION_ARGS, e, "Awaiting zero-copy send completions error"));
 		}
-		_localAddrAutoPtr.reset(new TcpAddrInfo(TcpAddrInfo::IpV4, buf, ntohs(addrPtr->sin_port)));
 	}
-	// Fetching remote address info
-	struct sockaddr ra;
-	socklen_t ras = sizeof(ra);
-	if (getpeername(_descriptor, &ra, &ras)) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetPeerName, errno));
+	{
+		MutexLocker locker(_zeroCopyMutex);
+		_pendingZeroCopySends.clear();
+		_zeroCopyThreshold = -1;
+		_zeroCopyFallback = false;
+		_zeroCopySequence = 0;
 	}
-	if (ra.sa_family == AF_INET6) {
-		struct sockaddr_in6 * addrPtr = reinterpret_cast<struct sockaddr_in6 *>(&ra);
-		char buf[INET6_ADDRSTRLEN];
-		if (!inet_ntop(AF_INET6, &(addrPtr->sin6_addr), buf, INET6_ADDRSTRLEN)) {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::InetNToP, errno));
+	if (::close(_descriptor)) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Close, errno).message()));
+	}
+	_descriptor = -1;
+	resetPeersData();
+}
+
+void TcpSocket::resetPeersData()
+{
+	MutexLocker locker(_peersDataMutex);
+	_localSockAddrLen = 0;
+	_remoteSockAddrLen = 0;
+	_localAddrAutoPtr.reset();
+	_remoteAddrAutoPtr.reset();
+}
+
+const struct sockaddr * TcpSocket::localSockAddr() const
+{
+	if (_localSockAddrLen <= 0) {
+		if (!isOpen()) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Local address info have not been initialized"));
 		}
-		_remoteAddrAutoPtr.reset(new TcpAddrInfo(TcpAddrInfo::IpV6, buf, ntohs(addrPtr->sin6_port)));
-	} else {
-		struct sockaddr_in * addrPtr = reinterpret_cast<struct sockaddr_in *>(&ra);
-		char buf[INET_ADDRSTRLEN];
-		if (!inet_ntop(AF_INET, &(addrPtr->sin_addr), buf, INET_ADDRSTRLEN)) {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::InetNToP, errno));
+		// Fetching local address on demand
+		socklen_t localSockAddrLen = sizeof(_localSockAddr);
+		if (getsockname(_descriptor, reinterpret_cast<struct sockaddr *>(&_localSockAddr), &localSockAddrLen)) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetSockName, errno));
 		}
-		_remoteAddrAutoPtr.reset(new TcpAddrInfo(TcpAddrInfo::IpV4, buf, ntohs(addrPtr->sin_port)));
+		_localSockAddrLen = localSockAddrLen;
+	}
+	return reinterpret_cast<const struct sockaddr *>(&_localSockAddr);
+}
+
+const struct sockaddr * TcpSocket::remoteSockAddr() const
+{
+	if (_remoteSockAddrLen <= 0) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Remote address info have not been initialized"));
 	}
+	return reinterpret_cast<const struct sockaddr *>(&_remoteSockAddr);
 }
 
 void TcpSocket::openImplementation()
 {
 	// Creating the socket
-	_descriptor = socket(PF_INET, SOCK_STREAM, 0);
+	_descriptor = socket(_domain, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
 	if (_descriptor < 0) {
 		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Socket, errno));
 	}
-	// Making the socket non-blocking
-	int socketFlags = fcntl(_descriptor, F_GETFL, 0);
-	if (socketFlags < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
-	}
-	if (!(socketFlags | O_NONBLOCK)) {
-		socketFlags |= O_NONBLOCK;
-		if (fcntl(_descriptor, F_SETFL, socketFlags) < 0) {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
-		}
-	}
 }
 
 void TcpSocket::closeImplementation()
@@ -225,73 +801,228 @@ void TcpSocket::closeImplementation()
 	closeSocket();
 }
 
-size_t TcpSocket::readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout)
+void TcpSocket::setCorkedImplementation(bool newValue)
 {
-	timespec readTimeout = timeout.timeSpec();
-	fd_set readDescriptorsSet;
-	FD_ZERO(&readDescriptorsSet);
-	FD_SET(_descriptor, &readDescriptorsSet);
-	int descriptorsCount = pselect(_descriptor + 1, &readDescriptorsSet, NULL, NULL, &readTimeout, NULL);
-	if (descriptorsCount < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PSelect, errno));
-	} else if (descriptorsCount == 0) {
-		// Timeout expired
-		return 0;
+	if (_corkWrites) {
+		setSocketOption(IPPROTO_TCP, TCP_CORK, newValue ? 1 : 0);
 	}
-	ssize_t bytesReceived = recv(_descriptor, buffer, bufferSize, 0);
-	if (bytesReceived < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Recv, errno));
-		//if (errno == EAGAIN || errno == EWOULDBLOCK) {
-		//	// No more data available
-		//	return 0;
-		//} else {
-		//	throw Exception(SystemCallError(SystemCallError::Recv, errno, SOURCE_LOCATION_ARGS));
-		//}
-	} else if (bytesReceived == 0) {
-		// Connection has been aborted by the client.
-		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
-		throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+}
+
+size_t TcpSocket::readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	Timestamp limit;
+	while (true) {
+		// Trying to read the data first
+		ssize_t bytesReceived = recv(_descriptor, buffer, bufferSize, 0);
+		if (bytesReceived > 0) {
+			return bytesReceived;
+		} else if (bytesReceived == 0) {
+			// Connection has been aborted by the client.
+			//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
+			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Recv, errno));
+		}
+		IoUring * ioUringPtr = (timeout.isZero() || !limit.isZero()) ? 0 : IoUring::threadInstance();
+		if (ioUringPtr) {
+			if (isZeroCopy()) {
+				// io_uring(7) wait is not reporting POLLERR, so the queued zero-copy completions are reaped here
+				reapZeroCopyCompletions();
+			}
+			// No data available -> receiving the data with the timeout using one io_uring_enter(2) call
+			int result = ioUringPtr->recv(_descriptor, buffer, bufferSize, 0, timeout);
+			if (result > 0) {
+				return result;
+			} else if (result == 0) {
+				throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+			} else if (result == -ETIME || result == -EINTR) {
+				return 0;
+			}
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Recv, -result));
+		}
+		// No data available -> waiting for the data for the rest of the timeout
+		if (!awaitDescriptor(POLLIN, timeout, limit)) {
+			// Timeout expired
+			return 0;
+		}
 	}
-	return bytesReceived;
 }
 
 size_t TcpSocket::writeImplementation(const char * buffer, size_t bufferSize, const Timeout& timeout)
 {
-	timespec writeTimeout = timeout.timeSpec();
-	fd_set writeDescriptorsSet;
-	FD_ZERO(&writeDescriptorsSet);
-	FD_SET(_descriptor, &writeDescriptorsSet);
-	int descriptorsCount = pselect(_descriptor + 1, NULL, &writeDescriptorsSet, NULL, &writeTimeout, NULL);
-	if (descriptorsCount < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PSelect, errno));
-	} else if (descriptorsCount == 0) {
-		// Timeout expired
-		return 0;
-	}
-	ssize_t bytesSent = ::send(_descriptor, buffer, bufferSize, MSG_NOSIGNAL);
-	if (bytesSent < 0) {
-		if (errno == EPIPE) {
+	Timestamp limit;
+	while (true) {
+		// Trying to send the data first
+		ssize_t bytesSent = ::send(_descriptor, buffer, bufferSize, MSG_NOSIGNAL);
+		if (bytesSent > 0) {
+			return bytesSent;
+		} else if (bytesSent == 0) {
+			// Connection has been aborted by the client.
+			//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
+			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno == EPIPE) {
 			// Handled because send(2) man page says: "EPIPE: The local end has been shut down on a connection oriented socket.
 			// In this case the process will also receive a SIGPIPE unless MSG_NOSIGNAL is set."
 			//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
 			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
-		} else {
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Send, errno));
 		}
-		//if (errno == EAGAIN || errno == EWOULDBLOCK) {
-		//	// No more data available
-		//	return totalBytesSent;
-		//} else {
-		//	throw Exception(SystemCallError(SystemCallError::Send, errno, SOURCE_LOCATION_ARGS));
-		//}
-	} else if (bytesSent == 0) {
-		// Connection has been aborted by the client.
-		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::ConnectionAborted));
-		throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+		IoUring * ioUringPtr = (timeout.isZero() || !limit.isZero()) ? 0 : IoUring::threadInstance();
+		if (ioUringPtr) {
+			if (isZeroCopy()) {
+				// io_uring(7) wait is not reporting POLLERR, so the queued zero-copy completions are reaped here
+				reapZeroCopyCompletions();
+			}
+			// Socket send buffer is full -> sending the data with the timeout using one io_uring_enter(2) call
+			int result = ioUringPtr->send(_descriptor, buffer, bufferSize, MSG_NOSIGNAL, timeout);
+			if (result > 0) {
+				return result;
+			} else if (result == 0 || result == -EPIPE) {
+				throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+			} else if (result == -ETIME || result == -EINTR) {
+				return 0;
+			}
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Send, -result));
+		}
+		// Socket send buffer is full -> waiting for the socket to become writable for the rest of the timeout
+		if (!awaitDescriptor(POLLOUT, timeout, limit)) {
+			// Timeout expired
+			return 0;
+		}
+	}
+}
+
+size_t TcpSocket::writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const Timeout& timeout)
+{
+	// Composing I/O-vector, sendmsg(2) is used instead of writev(2) to pass MSG_NOSIGNAL flag
+	struct iovec iov[ISL__TCP_SOCKET_MAX_IOV];
+	size_t iovAmount = 0;
+	for (size_t i = 0; i < buffersAmount && iovAmount < ISL__TCP_SOCKET_MAX_IOV; ++i) {
+		if (buffers[i].size <= 0) {
+			continue;
+		}
+		iov[iovAmount].iov_base = const_cast<char *>(buffers[i].data);
+		iov[iovAmount].iov_len = buffers[i].size;
+		++iovAmount;
+	}
+	if (iovAmount <= 0) {
+		return 0;
+	}
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovAmount;
+	Timestamp limit;
+	while (true) {
+		// Trying to send the data first
+		ssize_t bytesSent = sendmsg(_descriptor, &msg, MSG_NOSIGNAL);
+		if (bytesSent > 0) {
+			return bytesSent;
+		} else if (bytesSent == 0) {
+			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno == EPIPE) {
+			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::SendMsg, errno));
+		}
+		// Socket send buffer is full -> waiting for the socket to become writable for the rest of the timeout
+		if (!awaitDescriptor(POLLOUT, timeout, limit)) {
+			// Timeout expired
+			return 0;
+		}
 	}
+}
+
+size_t TcpSocket::sendFileImplementation(int fileDescriptor, off_t offset, size_t size, const Timeout& timeout)
+{
+	Timestamp limit;
+	while (true) {
+		// Trying to send the file data first, the data is copied by the kernel without passing it through the user space
+		ssize_t bytesSent = sendFileNoSignal(fileDescriptor, offset, size);
+		if (bytesSent > 0) {
+			return bytesSent;
+		} else if (bytesSent == 0) {
+			throw Exception(Error(SOURCE_LOCATION_ARGS, "Unexpected end of file while sending it to the TCP-socket"));
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno == EPIPE || errno == ECONNRESET) {
+			throw Exception(ConnectionAbortedError(SOURCE_LOCATION_ARGS));
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::SendFile, errno));
+		}
+		// Socket send buffer is full -> waiting for the socket to become writable for the rest of the timeout
+		if (!awaitDescriptor(POLLOUT, timeout, limit)) {
+			// Timeout expired
+			return 0;
+		}
+	}
+}
+
+ssize_t TcpSocket::sendFileNoSignal(int fileDescriptor, off_t offset, size_t size)
+{
+	// sendfile(2) has no MSG_NOSIGNAL analogue -> blocking SIGPIPE during the call and consuming it on EPIPE
+	sigset_t sigPipeMask;
+	sigemptyset(&sigPipeMask);
+	sigaddset(&sigPipeMask, SIGPIPE);
+	sigset_t initialSignalMask;
+	if (pthread_sigmask(SIG_BLOCK, &sigPipeMask, &initialSignalMask)) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PThreadSigMask, errno));
+	}
+	off_t fileOffset = offset;
+	ssize_t bytesSent = sendfile(_descriptor, fileDescriptor, &fileOffset, size);
+	int sendFileErrno = errno;
+	if (bytesSent < 0 && sendFileErrno == EPIPE && !sigismember(&initialSignalMask, SIGPIPE)) {
+		struct timespec zeroTimeout = {0, 0};
+		sigtimedwait(&sigPipeMask, 0, &zeroTimeout);
+	}
+	if (pthread_sigmask(SIG_SETMASK, &initialSignalMask, 0)) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PThreadSigMask, errno));
+	}
+	errno = sendFileErrno;
 	return bytesSent;
 }
 
+size_t TcpSocket::releaseZeroCopySends(uint32_t first, uint32_t last)
+{
+	size_t buffersReleased = 0;
+	for (PendingZeroCopySendsContainer::iterator i = _pendingZeroCopySends.begin(); i != _pendingZeroCopySends.end();) {
+		// Unsigned arithmetic handles the sequence number wrap-around
+		if (i->sequence - first <= last - first) {
+			i = _pendingZeroCopySends.erase(i);
+			++buffersReleased;
+		} else {
+			++i;
+		}
+	}
+	return buffersReleased;
+}
+
+bool TcpSocket::awaitDescriptor(short events, const Timeout& timeout, Timestamp& limit)
+{
+	short revents = pollDescriptor(_descriptor, events, timeout, limit);
+	if (revents < 0) {
+		return false;
+	}
+	if ((revents & POLLERR) && isZeroCopy()) {
+		// POLLERR is reported while the zero-copy completions are queued on the socket error queue, which is not
+		// drained by the I/O-operation's retry -> reaping them to avoid the busy loop. Other socket errors are
+		// reported by the retried system call.
+		reapZeroCopyCompletions();
+	}
+	return true;
+}
+
 //------------------------------------------------------------------------------
 
 TcpSocket_NEW::TcpSocket_NEW() :
@@ -362,35 +1093,25 @@ std::auto_ptr<TcpSocket_NEW> TcpSocket_NEW::accept(const Timeout& timeout)
 		//throw Exception(IOError(SOURCE_LOCATION_ARGS, IOError::DeviceIsNotOpen));
 		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
-	// Waiting for incoming connection
-	timespec selectTimeout = timeout.timeSpec();
-	fd_set descriptorsSet;
-	FD_ZERO(&descriptorsSet);
-	FD_SET(handle(), &descriptorsSet);
-	int descriptorsCount = pselect(handle() + 1, &descriptorsSet, NULL, NULL, &selectTimeout, NULL);
-	if (descriptorsCount == 0) {
-		// Timeout expired
-		return std::auto_ptr<TcpSocket_NEW>();
-	} else if (descriptorsCount < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::PSelect, errno));
-	}
-	// Extracting and returning pending connection
-	int pendingSocketDescriptor = ::accept(handle(), NULL, NULL);
-	if (pendingSocketDescriptor < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Accept, errno));
-	}
-	// Making the socket non-blocking
-	int pendingSocketFlags = fcntl(pendingSocketDescriptor, F_GETFL, 0);
-	if (pendingSocketFlags < 0) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
-	}
-	if (!(pendingSocketFlags | O_NONBLOCK)) {
-		pendingSocketFlags |= O_NONBLOCK;
-		if (fcntl(pendingSocketDescriptor, F_SETFL, pendingSocketFlags) < 0) {
-			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Fcntl, errno));
+	Timestamp limit;
+	while (true) {
+		// Trying to extract pending connection first
+		int pendingSocketDescriptor = ::accept(handle(), NULL, NULL);
+		if (pendingSocketDescriptor >= 0) {
+			// Socket is made non-blocking by the AbstractPosixIODevice constructor
+			return std::auto_ptr<TcpSocket_NEW>(new TcpSocket_NEW(pendingSocketDescriptor));
+		}
+		if (errno == EINTR || errno == ECONNABORTED) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Accept, errno));
+		}
+		// No pending connections -> waiting for incoming connection for the rest of the timeout
+		if (awaitHandle(POLLIN, timeout, limit) < 0) {
+			// Timeout expired
+			return std::auto_ptr<TcpSocket_NEW>();
 		}
 	}
-	return std::auto_ptr<TcpSocket_NEW>(new TcpSocket_NEW(pendingSocketDescriptor));
 }
 
 void TcpSocket_NEW::connect(const TcpAddrInfo& addrInfo)
@@ -399,7 +1120,26 @@ void TcpSocket_NEW::connect(const TcpAddrInfo& addrInfo)
 		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
 	}
 	if (::connect(handle(), addrInfo.addrinfo()->ai_addr, addrInfo.addrinfo()->ai_addrlen)) {
-		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, errno));
+		if (errno != EINPROGRESS) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, errno));
+		}
+		// Socket is non-blocking -> waiting for the connection to be established
+		struct pollfd fds;
+		fds.fd = handle();
+		fds.events = POLLOUT;
+		while (poll(&fds, 1, -1) < 0) {
+			if (errno != EINTR) {
+				throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Poll, errno));
+			}
+		}
+		int connectError = 0;
+		socklen_t connectErrorSize = sizeof(connectError);
+		if (getsockopt(handle(), SOL_SOCKET, SO_ERROR, &connectError, &connectErrorSize)) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetSockOpt, errno));
+		}
+		if (connectError != 0) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, connectError));
+		}
 	}
 	fetchPeersData();
 }
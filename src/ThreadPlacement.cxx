@@ -0,0 +1,217 @@
+#include <isl/ThreadPlacement.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <isl/ErrorLogMessage.hxx>
+#include <isl/SystemCallError.hxx>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+#define ISL__THREAD_PLACEMENT_MAX_NUMA_NODES 1024
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// ThreadPlacement
+//------------------------------------------------------------------------------
+
+ThreadPlacement::ThreadPlacement() :
+	_name(),
+	_cpus(),
+	_numaNode(-1),
+	_schedulingPolicy(InheritedPolicy),
+	_schedulingPriority(0)
+{}
+
+void ThreadPlacement::apply() const
+{
+	if (!_name.empty()) {
+		// Kernel limits thread name to 16 bytes including the terminating zero
+		std::string name = _name.substr(0, 15);
+#ifdef __FreeBSD__
+		pthread_set_name_np(pthread_self(), name.c_str());
+#else
+		if (int errorCode = pthread_setname_np(pthread_self(), name.c_str())) {
+			Log::warning().log(ErrorLogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, "pthread_setname_np(3)", errorCode)));
+		}
+#endif
+	}
+#ifdef __linux__
+	if (_numaNode >= 0) {
+		// Preferring the memory of the NUMA node for the allocations of the thread
+		unsigned long nodeMask[ISL__THREAD_PLACEMENT_MAX_NUMA_NODES / (sizeof(unsigned long) * 8)] = {};
+		if (_numaNode < ISL__THREAD_PLACEMENT_MAX_NUMA_NODES) {
+			nodeMask[_numaNode / (sizeof(unsigned long) * 8)] |= 1UL << (_numaNode % (sizeof(unsigned long) * 8));
+		}
+		if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodeMask, sizeof(nodeMask) * 8 + 1) != 0) {
+			Log::warning().log(ErrorLogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, "set_mempolicy(2)", errno)));
+		}
+	}
+	CpusContainer cpus = (_cpus.empty() && _numaNode >= 0) ? numaNodeCpus(_numaNode) : _cpus;
+	if (!cpus.empty()) {
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		for (CpusContainer::const_iterator i = cpus.begin(); i != cpus.end(); ++i) {
+			if (*i >= 0 && *i < CPU_SETSIZE) {
+				CPU_SET(*i, &cpuSet);
+			}
+		}
+		if (int errorCode = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet)) {
+			Log::warning().log(ErrorLogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, "pthread_setaffinity_np(3)", errorCode)));
+		}
+	}
+#endif
+	if (_schedulingPolicy != InheritedPolicy) {
+		int policy = SCHED_OTHER;
+		switch (_schedulingPolicy) {
+#ifdef SCHED_BATCH
+			case BatchPolicy:
+				policy = SCHED_BATCH;
+				break;
+#endif
+#ifdef SCHED_IDLE
+			case IdlePolicy:
+				policy = SCHED_IDLE;
+				break;
+#endif
+			case FifoPolicy:
+				policy = SCHED_FIFO;
+				break;
+			case RoundRobinPolicy:
+				policy = SCHED_RR;
+				break;
+			default:
+				policy = SCHED_OTHER;
+		}
+		struct sched_param param;
+		param.sched_priority = (policy == SCHED_FIFO || policy == SCHED_RR) ? _schedulingPriority : 0;
+		if (int errorCode = pthread_setschedparam(pthread_self(), policy, &param)) {
+			Log::warning().log(ErrorLogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, "pthread_setschedparam(3)", errorCode)));
+		}
+	}
+}
+
+ThreadPlacement::CpusContainer ThreadPlacement::onlineCpus()
+{
+	CpusContainer result = parseList(readSysFile("/sys/devices/system/cpu/online"));
+	if (result.empty()) {
+		long cpusAmount = sysconf(_SC_NPROCESSORS_ONLN);
+		for (long i = 0; i < cpusAmount; ++i) {
+			result.push_back(i);
+		}
+	}
+	return result;
+}
+
+ThreadPlacement::NumaNodesContainer ThreadPlacement::onlineNumaNodes()
+{
+	return parseList(readSysFile("/sys/devices/system/node/online"));
+}
+
+ThreadPlacement::CpusContainer ThreadPlacement::numaNodeCpus(int node)
+{
+	std::ostringstream path;
+	path << "/sys/devices/system/node/node" << node << "/cpulist";
+	return parseList(readSysFile(path.str()));
+}
+
+int ThreadPlacement::currentNumaNode()
+{
+#ifdef SYS_getcpu
+	unsigned int cpu;
+	unsigned int node;
+	if (syscall(SYS_getcpu, &cpu, &node, 0) == 0) {
+		return node;
+	}
+#endif
+	return -1;
+}
+
+std::vector<int> ThreadPlacement::parseList(const std::string& list)
+{
+	// List format is "0-3,8,10-11"
+	std::vector<int> result;
+	std::istringstream iss(list);
+	std::string range;
+	while (std::getline(iss, range, ',')) {
+		if (range.empty() || range[0] < '0' || range[0] > '9') {
+			continue;
+		}
+		char * endPtr;
+		long first = strtol(range.c_str(), &endPtr, 10);
+		long last = (*endPtr == '-') ? strtol(endPtr + 1, 0, 10) : first;
+		for (long i = first; i <= last; ++i) {
+			result.push_back(i);
+		}
+	}
+	return result;
+}
+
+std::string ThreadPlacement::readSysFile(const std::string& path)
+{
+	std::ifstream file(path.c_str());
+	std::string result;
+	std::getline(file, result);
+	return result;
+}
+
+//------------------------------------------------------------------------------
+// ThreadPlacementPolicy
+//------------------------------------------------------------------------------
+
+ThreadPlacementPolicy::ThreadPlacementPolicy(Mode mode, const ThreadPlacement::CpusContainer& cpus, const std::string& namePrefix) :
+	_mode(mode),
+	_cpus(cpus),
+	_namePrefix(namePrefix),
+	_schedulingPolicy(ThreadPlacement::InheritedPolicy),
+	_schedulingPriority(0),
+	_firstThreadIndex(0)
+{}
+
+ThreadPlacement ThreadPlacementPolicy::placement(size_t threadIndex) const
+{
+	ThreadPlacement result;
+	threadIndex += _firstThreadIndex;
+	if (!_namePrefix.empty()) {
+		std::ostringstream name;
+		name << _namePrefix << '-' << threadIndex;
+		result.setName(name.str());
+	}
+	result.setSchedulingPolicy(_schedulingPolicy, _schedulingPriority);
+	switch (_mode) {
+		case SpreadMode:
+			result.setCpus(_cpus.empty() ? ThreadPlacement::onlineCpus() : _cpus);
+			break;
+		case PinMode:
+			{
+				ThreadPlacement::CpusContainer cpus = _cpus.empty() ? ThreadPlacement::onlineCpus() : _cpus;
+				if (!cpus.empty()) {
+					result.setCpus(ThreadPlacement::CpusContainer(1, cpus[threadIndex % cpus.size()]));
+				}
+			}
+			break;
+		case NumaMode:
+			{
+				ThreadPlacement::NumaNodesContainer nodes = ThreadPlacement::onlineNumaNodes();
+				if (!nodes.empty()) {
+					result.setNumaNode(nodes[threadIndex % nodes.size()]);
+				}
+			}
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+} // namespace isl
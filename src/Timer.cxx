@@ -17,7 +17,9 @@ Timer::Timer(Subsystem * owner, const Timeout& clockTimeout, size_t maxScheduled
 	_lastPeriodicTaskId(0),
 	_periodicTasksMap(),
 	_threadAutoPtr()
-{}
+{
+	setThreadPlacementPolicy(ThreadPlacementPolicy(ThreadPlacementPolicy::FloatMode, ThreadPlacement::CpusContainer(), "timer"));
+}
 
 Timer::~Timer()
 {}
@@ -0,0 +1,137 @@
+#include <isl/TimingWheel.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// TimingWheel::AbstractTimer
+//------------------------------------------------------------------------------
+
+TimingWheel::AbstractTimer::~AbstractTimer()
+{
+	if (_wheelPtr) {
+		_wheelPtr->cancel(*this);
+	}
+}
+
+//------------------------------------------------------------------------------
+// TimingWheel
+//------------------------------------------------------------------------------
+
+TimingWheel::TimingWheel(const Timeout& resolution, size_t slotsAmount) :
+	_resolution(resolution),
+	_resolutionNanoSeconds(static_cast<uint64_t>(resolution.seconds()) * 1000000000 + resolution.nanoSeconds()),
+	_startTimestamp(Timestamp::now()),
+	_slots(slotsAmount > 0 ? slotsAmount : 1, static_cast<AbstractTimer *>(0)),
+	_currentTick(0),
+	_size(0)
+{
+	if (_resolutionNanoSeconds <= 0) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Timing wheel resolution should be greater than zero"));
+	}
+}
+
+TimingWheel::~TimingWheel()
+{
+	for (SlotsContainer::iterator i = _slots.begin(); i != _slots.end(); ++i) {
+		for (AbstractTimer * timerPtr = *i; timerPtr; timerPtr = timerPtr->_nextPtr) {
+			timerPtr->_wheelPtr = 0;
+		}
+	}
+}
+
+void TimingWheel::schedule(AbstractTimer& timer, const Timestamp& limit)
+{
+	if (timer._wheelPtr) {
+		timer._wheelPtr->cancel(timer);
+	}
+	// Rounding the deadline up to the tick boundary, so the timer is never expired earlier
+	uint64_t expirationTick = tick(limit, true);
+	if (expirationTick <= _currentTick) {
+		// Deadline has been reached already - expiring on the next tick
+		expirationTick = _currentTick + 1;
+	}
+	timer._expirationTick = expirationTick;
+	timer._limit = limit;
+	timer._wheelPtr = this;
+	link(timer);
+	++_size;
+}
+
+void TimingWheel::cancel(AbstractTimer& timer)
+{
+	if (timer._wheelPtr != this) {
+		return;
+	}
+	unlink(timer);
+	timer._wheelPtr = 0;
+	--_size;
+}
+
+size_t TimingWheel::advance(const Timestamp& now)
+{
+	uint64_t newTick = tick(now);
+	if (newTick <= _currentTick) {
+		return 0;
+	}
+	// Visiting the slots of the passed ticks, but each slot at most once
+	uint64_t ticksPassed = newTick - _currentTick;
+	size_t slotsToVisit = (ticksPassed < _slots.size()) ? static_cast<size_t>(ticksPassed) : _slots.size();
+	std::vector<AbstractTimer *> expiredTimers;
+	for (size_t i = 1; i <= slotsToVisit; ++i) {
+		AbstractTimer * timerPtr = _slots[(_currentTick + i) % _slots.size()];
+		while (timerPtr) {
+			AbstractTimer * nextTimerPtr = timerPtr->_nextPtr;
+			if (timerPtr->_expirationTick <= newTick) {
+				cancel(*timerPtr);
+				expiredTimers.push_back(timerPtr);
+			}
+			timerPtr = nextTimerPtr;
+		}
+	}
+	_currentTick = newTick;
+	// Calling handlers after all expired timers have been unlinked, so they could re-schedule the timers
+	for (std::vector<AbstractTimer *>::iterator i = expiredTimers.begin(); i != expiredTimers.end(); ++i) {
+		(*i)->onExpired();
+	}
+	return expiredTimers.size();
+}
+
+uint64_t TimingWheel::tick(const Timestamp& timestamp, bool roundUp) const
+{
+	if (timestamp <= _startTimestamp) {
+		return 0;
+	}
+	Timeout sinceStart = timestamp - _startTimestamp;
+	uint64_t nanoSeconds = static_cast<uint64_t>(sinceStart.seconds()) * 1000000000 + sinceStart.nanoSeconds();
+	return nanoSeconds / _resolutionNanoSeconds + ((roundUp && (nanoSeconds % _resolutionNanoSeconds > 0)) ? 1 : 0);
+}
+
+void TimingWheel::link(AbstractTimer& timer)
+{
+	AbstractTimer *& headPtr = _slots[timer._expirationTick % _slots.size()];
+	timer._prevPtr = 0;
+	timer._nextPtr = headPtr;
+	if (headPtr) {
+		headPtr->_prevPtr = &timer;
+	}
+	headPtr = &timer;
+}
+
+void TimingWheel::unlink(AbstractTimer& timer)
+{
+	if (timer._prevPtr) {
+		timer._prevPtr->_nextPtr = timer._nextPtr;
+	} else {
+		_slots[timer._expirationTick % _slots.size()] = timer._nextPtr;
+	}
+	if (timer._nextPtr) {
+		timer._nextPtr->_prevPtr = timer._prevPtr;
+	}
+	timer._prevPtr = 0;
+	timer._nextPtr = 0;
+}
+
+} // namespace isl
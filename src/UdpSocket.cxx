@@ -0,0 +1,255 @@
+#include <isl/UdpSocket.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <isl/SystemCallError.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+
+namespace isl
+{
+
+//------------------------------------------------------------------------------
+// UdpSocket::Batch
+//------------------------------------------------------------------------------
+
+UdpSocket::Batch::Batch(size_t capacity, size_t maxDatagramSize) :
+	_maxDatagramSize(maxDatagramSize),
+	_buffer(capacity * maxDatagramSize),
+	_addrs(capacity),
+	_iovecs(capacity),
+	_headers(capacity),
+	_sizes(capacity),
+	_size(0)
+{
+	if (capacity <= 0 || maxDatagramSize <= 0) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Datagram batch capacity and datagram size should be greater than zero"));
+	}
+	for (size_t i = 0; i < capacity; ++i) {
+		_iovecs[i].iov_base = &_buffer[i * _maxDatagramSize];
+		_iovecs[i].iov_len = _maxDatagramSize;
+		memset(&_headers[i], 0, sizeof(struct mmsghdr));
+		_headers[i].msg_hdr.msg_name = &_addrs[i];
+		_headers[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+		_headers[i].msg_hdr.msg_iov = &_iovecs[i];
+		_headers[i].msg_hdr.msg_iovlen = 1;
+	}
+}
+
+bool UdpSocket::Batch::append(const char * data, size_t dataSize, const struct sockaddr * addr, socklen_t addrLen)
+{
+	if (isFull()) {
+		return false;
+	}
+	if (dataSize > _maxDatagramSize) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Datagram is longer than the batch's datagram buffer"));
+	}
+	memcpy(&_buffer[_size * _maxDatagramSize], data, dataSize);
+	_sizes[_size] = dataSize;
+	_iovecs[_size].iov_len = dataSize;
+	struct msghdr& header = _headers[_size].msg_hdr;
+	if (addr) {
+		memcpy(&_addrs[_size], addr, addrLen);
+		header.msg_name = &_addrs[_size];
+		header.msg_namelen = addrLen;
+	} else {
+		header.msg_name = 0;
+		header.msg_namelen = 0;
+	}
+	header.msg_flags = 0;
+	++_size;
+	return true;
+}
+
+void UdpSocket::Batch::prepareReceive()
+{
+	for (size_t i = 0; i < _headers.size(); ++i) {
+		_iovecs[i].iov_len = _maxDatagramSize;
+		_headers[i].msg_hdr.msg_name = &_addrs[i];
+		_headers[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+		_headers[i].msg_hdr.msg_flags = 0;
+	}
+	_size = 0;
+}
+
+//------------------------------------------------------------------------------
+// UdpSocket
+//------------------------------------------------------------------------------
+
+UdpSocket::UdpSocket(TcpAddrInfo::Family family) :
+	AbstractIODevice(),
+	_family(family),
+	_descriptor(-1)
+{}
+
+UdpSocket::~UdpSocket()
+{
+	if (isOpen()) {
+		closeImplementation();
+	}
+}
+
+void UdpSocket::bind(const TcpAddrInfo& addrInfo, bool reusePort)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	if (reusePort) {
+		setSocketOption(SOL_SOCKET, SO_REUSEPORT, 1);
+	}
+	const struct addrinfo * ai = addrInfo.addrinfo();
+	if (::bind(_descriptor, ai->ai_addr, ai->ai_addrlen) != 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Bind, errno));
+	}
+}
+
+void UdpSocket::connect(const TcpAddrInfo& addrInfo)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	const struct addrinfo * ai = addrInfo.addrinfo();
+	if (::connect(_descriptor, ai->ai_addr, ai->ai_addrlen) != 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Connect, errno));
+	}
+}
+
+void UdpSocket::setReceiveBufferSize(int newValue)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	setSocketOption(SOL_SOCKET, SO_RCVBUF, newValue);
+}
+
+void UdpSocket::setSendBufferSize(int newValue)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	setSocketOption(SOL_SOCKET, SO_SNDBUF, newValue);
+}
+
+size_t UdpSocket::receiveBatch(Batch& batch, const Timeout& timeout)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	batch.prepareReceive();
+	Timestamp limit;
+	while (true) {
+		int datagramsReceived = recvmmsg(_descriptor, &batch._headers[0], batch._headers.size(), 0, 0);
+		if (datagramsReceived > 0) {
+			for (int i = 0; i < datagramsReceived; ++i) {
+				batch._sizes[i] = batch._headers[i].msg_len;
+			}
+			batch._size = datagramsReceived;
+			return datagramsReceived;
+		} else if (datagramsReceived == 0) {
+			return 0;
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, "recvmmsg(2)", errno));
+		}
+		// No datagrams -> waiting for the socket to become readable for the rest of the timeout
+		if (pollDescriptor(_descriptor, POLLIN, timeout, limit) < 0) {
+			return 0;
+		}
+	}
+}
+
+size_t UdpSocket::sendBatch(Batch& batch, const Timeout& timeout)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	size_t datagramsSent = 0;
+	Timestamp limit;
+	while (datagramsSent < batch._size) {
+		int result = sendmmsg(_descriptor, &batch._headers[datagramsSent], batch._size - datagramsSent, MSG_NOSIGNAL);
+		if (result > 0) {
+			datagramsSent += result;
+			continue;
+		}
+		if (result < 0 && errno == EINTR) {
+			continue;
+		} else if (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, "sendmmsg(2)", errno));
+		}
+		// Send buffer is full -> waiting for the room for the rest of the timeout
+		if (pollDescriptor(_descriptor, POLLOUT, timeout, limit) < 0) {
+			break;
+		}
+	}
+	return datagramsSent;
+}
+
+void UdpSocket::setSocketOption(int level, int optionName, int value)
+{
+	if (setsockopt(_descriptor, level, optionName, &value, sizeof(value)) < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::SetSockOpt, errno));
+	}
+}
+
+void UdpSocket::openImplementation()
+{
+	_descriptor = socket(_family == TcpAddrInfo::IpV6 ? PF_INET6 : PF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (_descriptor < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Socket, errno));
+	}
+}
+
+void UdpSocket::closeImplementation()
+{
+	if (::close(_descriptor)) {
+		Log::error().log(LogMessage(SOURCE_LOCATION_ARGS, SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Close, errno).message()));
+	}
+	_descriptor = -1;
+}
+
+size_t UdpSocket::readImplementation(char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	Timestamp limit;
+	while (true) {
+		ssize_t bytesRead = recv(_descriptor, buffer, bufferSize, 0);
+		if (bytesRead >= 0) {
+			return bytesRead;
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Recv, errno));
+		}
+		if (pollDescriptor(_descriptor, POLLIN, timeout, limit) < 0) {
+			return 0;
+		}
+	}
+}
+
+size_t UdpSocket::writeImplementation(const char * buffer, size_t bufferSize, const Timeout& timeout)
+{
+	Timestamp limit;
+	while (true) {
+		ssize_t bytesSent = send(_descriptor, buffer, bufferSize, MSG_NOSIGNAL);
+		if (bytesSent >= 0) {
+			return bytesSent;
+		}
+		if (errno == EINTR) {
+			continue;
+		} else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Send, errno));
+		}
+		if (pollDescriptor(_descriptor, POLLOUT, timeout, limit) < 0) {
+			return 0;
+		}
+	}
+}
+
+} // namespace isl
@@ -0,0 +1,65 @@
+#include <isl/UnixAddrInfo.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Error.hxx>
+#include <stddef.h>
+#include <string.h>
+
+namespace isl
+{
+
+UnixAddrInfo::UnixAddrInfo(const std::string& path, bool abstractNamespace) :
+	_path(path),
+	_abstractNamespace(abstractNamespace),
+	_sockAddr(),
+	_sockAddrLen(0)
+{
+	// Abstract namespace socket name is prepended with the null byte and is not null-terminated
+	size_t pathOffset = abstractNamespace ? 1 : 0;
+	size_t maxPathSize = sizeof(_sockAddr.sun_path) - 1;
+	if (path.empty()) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Empty Unix domain socket path"));
+	}
+	if (path.size() > maxPathSize) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Unix domain socket path is too long"));
+	}
+	memset(&_sockAddr, 0, sizeof(_sockAddr));
+	_sockAddr.sun_family = AF_UNIX;
+	memcpy(_sockAddr.sun_path + pathOffset, path.data(), path.size());
+	_sockAddrLen = offsetof(struct sockaddr_un, sun_path) + pathOffset + path.size() + (abstractNamespace ? 0 : 1);
+}
+
+UnixAddrInfo::UnixAddrInfo(const struct sockaddr * addr, socklen_t addrLen) :
+	_path(),
+	_abstractNamespace(false),
+	_sockAddr(),
+	_sockAddrLen(0)
+{
+	if (addr->sa_family != AF_UNIX) {
+		throw Exception(Error(SOURCE_LOCATION_ARGS, "Invalid address family"));
+	}
+	memset(&_sockAddr, 0, sizeof(_sockAddr));
+	_sockAddrLen = addrLen < sizeof(_sockAddr) ? addrLen : sizeof(_sockAddr);
+	memcpy(&_sockAddr, addr, _sockAddrLen);
+	size_t pathSize = _sockAddrLen > offsetof(struct sockaddr_un, sun_path) ? _sockAddrLen - offsetof(struct sockaddr_un, sun_path) : 0;
+	if (pathSize > 0 && _sockAddr.sun_path[0] == '\0') {
+		_abstractNamespace = true;
+		_path.assign(_sockAddr.sun_path + 1, pathSize - 1);
+	} else {
+		_path.assign(_sockAddr.sun_path, strnlen(_sockAddr.sun_path, pathSize));
+	}
+}
+
+std::string UnixAddrInfo::str() const
+{
+	if (_path.empty()) {
+		return "unnamed";
+	}
+	return _abstractNamespace ? '@' + _path : _path;
+}
+
+std::string UnixAddrInfo::str(const struct sockaddr * addr, socklen_t addrLen)
+{
+	return UnixAddrInfo(addr, addrLen).str();
+}
+
+} // namespace isl
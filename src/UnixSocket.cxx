@@ -0,0 +1,84 @@
+#include <isl/UnixSocket.hxx>
+#include <isl/Exception.hxx>
+#include <isl/SystemCallError.hxx>
+#include <isl/Log.hxx>
+#include <isl/LogMessage.hxx>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <unistd.h>
+
+namespace isl
+{
+
+UnixSocket::UnixSocket() :
+	TcpSocket(PF_UNIX)
+{}
+
+UnixAddrInfo UnixSocket::localAddr() const
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	struct sockaddr_un addr;
+	socklen_t addrLen = sizeof(addr);
+	if (getsockname(descriptor(), reinterpret_cast<struct sockaddr *>(&addr), &addrLen) != 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetSockName, errno));
+	}
+	return UnixAddrInfo(reinterpret_cast<const struct sockaddr *>(&addr), addrLen);
+}
+
+UnixAddrInfo UnixSocket::remoteAddr() const
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	struct sockaddr_un addr;
+	socklen_t addrLen = sizeof(addr);
+	if (getpeername(descriptor(), reinterpret_cast<struct sockaddr *>(&addr), &addrLen) != 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::GetPeerName, errno));
+	}
+	return UnixAddrInfo(reinterpret_cast<const struct sockaddr *>(&addr), addrLen);
+}
+
+void UnixSocket::bind(const UnixAddrInfo& addrInfo)
+{
+	if (!isOpen()) {
+		throw Exception(NotOpenError(SOURCE_LOCATION_ARGS));
+	}
+	if (::bind(descriptor(), addrInfo.sockAddr(), addrInfo.sockAddrLen()) == 0) {
+		return;
+	}
+	if (errno != EADDRINUSE || addrInfo.isAbstract()) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Bind, errno));
+	}
+	// Probing the existing socket file: it is stale if nobody listens on it
+	int probeDescriptor = socket(PF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (probeDescriptor < 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Socket, errno));
+	}
+	bool isStale = (::connect(probeDescriptor, addrInfo.sockAddr(), addrInfo.sockAddrLen()) != 0) && (errno == ECONNREFUSED);
+	::close(probeDescriptor);
+	if (!isStale) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Bind, EADDRINUSE));
+	}
+	Log::warning().log(LogMessage(SOURCE_LOCATION_ARGS, "Removing stale Unix domain socket file \"") << addrInfo.path() << '"');
+	if (unlink(addrInfo.path().c_str()) != 0 && errno != ENOENT) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Unlink, errno));
+	}
+	if (::bind(descriptor(), addrInfo.sockAddr(), addrInfo.sockAddrLen()) != 0) {
+		throw Exception(SystemCallError(SOURCE_LOCATION_ARGS, SystemCallError::Bind, errno));
+	}
+}
+
+void UnixSocket::connect(const UnixAddrInfo& addrInfo)
+{
+	connectSockAddr(addrInfo.sockAddr(), addrInfo.sockAddrLen(), 0);
+}
+
+bool UnixSocket::connect(const UnixAddrInfo& addrInfo, const Timeout& timeout)
+{
+	return connectSockAddr(addrInfo.sockAddr(), addrInfo.sockAddrLen(), &timeout);
+}
+
+} // namespace isl
@@ -0,0 +1,241 @@
+#include <gtest/gtest.h>
+#include <isl/FutureTaskDispatcher.hxx>
+#include <isl/Mutex.hxx>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+class FutureTest : public ::testing::Test
+{
+protected:
+	// Continuation which appends it's id to the shared execution order
+	class RecordingContinuation : public isl::AbstractFutureContinuation
+	{
+	public:
+		RecordingContinuation(isl::Mutex& mutex, std::vector<int>& order, int id) :
+			_mutex(mutex),
+			_order(order),
+			_id(id)
+		{}
+
+		virtual void execute()
+		{
+			isl::MutexLocker locker(_mutex);
+			_order.push_back(_id);
+		}
+	private:
+		isl::Mutex& _mutex;
+		std::vector<int>& _order;
+		const int _id;
+	};
+
+	class Calculator
+	{
+	public:
+		Calculator(int base) :
+			_base(base)
+		{}
+
+		int add(int value)
+		{
+			return _base + value;
+		}
+	private:
+		const int _base;
+	};
+
+	class Multiplier
+	{
+	public:
+		Multiplier(int factor) :
+			_factor(factor)
+		{}
+
+		int operator()()
+		{
+			return _factor * 2;
+		}
+	private:
+		const int _factor;
+	};
+
+	static int sum(int a, int b)
+	{
+		return a + b;
+	}
+	static int fail(int value)
+	{
+		throw std::runtime_error("Calculation error");
+	}
+	static std::string describe(const isl::Future<int>& future)
+	{
+		return future.succeeded() ? "value" : future.errorMessage();
+	}
+	static isl::Timestamp limit()
+	{
+		return isl::Timestamp::limit(isl::Timeout(1.0));
+	}
+	static void addRecordingContinuation(const isl::Future<int>& future, isl::Mutex& mutex, std::vector<int>& order, int id)
+	{
+		future.addContinuation(std::auto_ptr<isl::AbstractFutureContinuation>(new RecordingContinuation(mutex, order, id)));
+	}
+};
+
+TEST_F(FutureTest, ValueIsSetOnce)
+{
+	isl::Promise<int> promise;
+	isl::Future<int> future = promise.future();
+	EXPECT_TRUE(future.isValid());
+	EXPECT_FALSE(future.isReady());
+	EXPECT_THROW(future.value(), isl::Exception);
+	EXPECT_TRUE(promise.setValue(1));
+	EXPECT_FALSE(promise.setValue(2));
+	EXPECT_FALSE(promise.setError("Too late"));
+	ASSERT_TRUE(future.await(limit()));
+	EXPECT_TRUE(future.succeeded());
+	EXPECT_EQ(1, future.value());
+}
+
+TEST_F(FutureTest, ErrorFailsFuture)
+{
+	isl::Promise<int> promise;
+	isl::Future<int> future = promise.future();
+	EXPECT_TRUE(promise.setError("Failure"));
+	EXPECT_TRUE(future.isReady());
+	EXPECT_FALSE(future.succeeded());
+	EXPECT_EQ("Failure", future.errorMessage());
+	EXPECT_THROW(future.value(), isl::Exception);
+}
+
+TEST_F(FutureTest, LastDestroyedPromiseBreaksFuture)
+{
+	isl::Future<int> future;
+	EXPECT_FALSE(future.isValid());
+	EXPECT_THROW(future.await(limit()), isl::Exception);
+	{
+		isl::Promise<int> promise;
+		future = promise.future();
+		{
+			isl::Promise<int> promiseCopy(promise);
+		}
+		EXPECT_FALSE(future.isReady());
+	}
+	ASSERT_TRUE(future.isReady());
+	EXPECT_FALSE(future.succeeded());
+	EXPECT_EQ("Broken promise", future.errorMessage());
+}
+
+TEST_F(FutureTest, ContinuationsAreExecutedInOrder)
+{
+	isl::Mutex mutex;
+	std::vector<int> order;
+	isl::Promise<int> promise;
+	isl::Future<int> future = promise.future();
+	addRecordingContinuation(future, mutex, order, 1);
+	addRecordingContinuation(future, mutex, order, 2);
+	EXPECT_TRUE(order.empty());
+	promise.setValue(0);
+	ASSERT_EQ(2U, order.size());
+	// Continuation of the completed future is executed at once
+	addRecordingContinuation(future, mutex, order, 3);
+	ASSERT_EQ(3U, order.size());
+	EXPECT_EQ(1, order[0]);
+	EXPECT_EQ(2, order[1]);
+	EXPECT_EQ(3, order[2]);
+}
+
+TEST_F(FutureTest, WhenAllSucceedsWithValuesInOrder)
+{
+	std::vector<isl::Promise<int> > promises(3);
+	std::vector<isl::Future<int> > futures;
+	for (size_t i = 0; i < promises.size(); ++i) {
+		futures.push_back(promises[i].future());
+	}
+	isl::Future<std::vector<int> > all = isl::Future<int>::whenAll(futures);
+	promises[2].setValue(2);
+	promises[0].setValue(0);
+	EXPECT_FALSE(all.isReady());
+	promises[1].setValue(1);
+	ASSERT_TRUE(all.succeeded());
+	ASSERT_EQ(3U, all.value().size());
+	for (int i = 0; i < 3; ++i) {
+		EXPECT_EQ(i, all.value()[i]);
+	}
+	EXPECT_TRUE(isl::Future<int>::whenAll(std::vector<isl::Future<int> >()).succeeded());
+}
+
+TEST_F(FutureTest, WhenAllFailsOnFirstError)
+{
+	std::vector<isl::Promise<int> > promises(2);
+	std::vector<isl::Future<int> > futures;
+	for (size_t i = 0; i < promises.size(); ++i) {
+		futures.push_back(promises[i].future());
+	}
+	isl::Future<std::vector<int> > all = isl::Future<int>::whenAll(futures);
+	promises[1].setError("Failure");
+	ASSERT_TRUE(all.isReady());
+	EXPECT_FALSE(all.succeeded());
+	EXPECT_EQ("Failure", all.errorMessage());
+	promises[0].setValue(0);
+	EXPECT_EQ("Failure", all.errorMessage());
+}
+
+TEST_F(FutureTest, WhenAnySucceedsWithFirstCompletedIndex)
+{
+	std::vector<isl::Promise<int> > promises(3);
+	std::vector<isl::Future<int> > futures;
+	for (size_t i = 0; i < promises.size(); ++i) {
+		futures.push_back(promises[i].future());
+	}
+	isl::Future<size_t> any = isl::Future<int>::whenAny(futures);
+	EXPECT_FALSE(any.isReady());
+	promises[1].setError("Failure");
+	promises[0].setValue(0);
+	ASSERT_TRUE(any.succeeded());
+	EXPECT_EQ(1U, any.value());
+	EXPECT_FALSE(isl::Future<int>::whenAny(std::vector<isl::Future<int> >()).succeeded());
+}
+
+TEST_F(FutureTest, DispatcherSubmitsFunctionsMethodsAndFunctors)
+{
+	isl::FutureTaskDispatcher dispatcher(0, 2, isl::Timeout(0.02));
+	dispatcher.start();
+	Calculator calculator(10);
+	isl::Future<int> sumFuture = dispatcher.submit(&sum, 1, 2);
+	isl::Future<int> methodFuture = dispatcher.submit(calculator, &Calculator::add, 5);
+	isl::Future<int> functorFuture = dispatcher.submit<int>(Multiplier(4));
+	isl::Future<int> failedFuture = dispatcher.submit(&fail, 0);
+	ASSERT_TRUE(sumFuture.await(limit()));
+	ASSERT_TRUE(methodFuture.await(limit()));
+	ASSERT_TRUE(functorFuture.await(limit()));
+	ASSERT_TRUE(failedFuture.await(limit()));
+	EXPECT_EQ(3, sumFuture.value());
+	EXPECT_EQ(15, methodFuture.value());
+	EXPECT_EQ(8, functorFuture.value());
+	EXPECT_FALSE(failedFuture.succeeded());
+	EXPECT_EQ("Calculation error", failedFuture.errorMessage());
+	dispatcher.stop();
+}
+
+TEST_F(FutureTest, DispatcherContinuationIsExecutedAfterFuture)
+{
+	isl::FutureTaskDispatcher dispatcher(0, 2, isl::Timeout(0.02));
+	dispatcher.start();
+	isl::Promise<int> promise;
+	isl::Future<std::string> succeededContinuation = dispatcher.then(promise.future(), &describe);
+	isl::Future<std::string> failedContinuation = dispatcher.then(dispatcher.submit(&fail, 0), &describe);
+	EXPECT_FALSE(succeededContinuation.await(isl::Timestamp::limit(isl::Timeout(0.05))));
+	promise.setValue(1);
+	ASSERT_TRUE(succeededContinuation.await(limit()));
+	ASSERT_TRUE(failedContinuation.await(limit()));
+	EXPECT_EQ("value", succeededContinuation.value());
+	EXPECT_EQ("Calculation error", failedContinuation.value());
+	dispatcher.stop();
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+#include <isl/LockFreeQueue.hxx>
+#include <isl/Thread.hxx>
+#include <vector>
+
+class LockFreeQueueTest : public ::testing::Test
+{
+protected:
+	class Item;
+	typedef isl::LockFreeQueue<Item> Queue;
+
+	class Item : public Queue::Node
+	{
+	public:
+		Item(size_t index = 0) :
+			Queue::Node(),
+			index(index)
+		{}
+
+		size_t index;
+	};
+
+	// Pushes the items of the range to the queue
+	class Producer
+	{
+	public:
+		Producer(Queue& queue, std::vector<Item>& items, size_t first, size_t amount) :
+			_queue(queue),
+			_items(items),
+			_first(first),
+			_amount(amount)
+		{}
+
+		void run()
+		{
+			for (size_t i = _first; i < _first + _amount; ++i) {
+				_queue.push(&_items[i]);
+			}
+		}
+	private:
+		Queue& _queue;
+		std::vector<Item>& _items;
+		const size_t _first;
+		const size_t _amount;
+	};
+
+	// Pops the items until the expected amount of the items has been popped by all consumers, checks the order of
+	// the items of each producer
+	class Consumer
+	{
+	public:
+		Consumer(Queue& queue, std::vector<int>& poppedCounts, size_t& poppedAmount, size_t producerItemsAmount) :
+			misorderedAmount(0),
+			_queue(queue),
+			_poppedCounts(poppedCounts),
+			_poppedAmount(poppedAmount),
+			_producerItemsAmount(producerItemsAmount),
+			_minNextIndexes()
+		{}
+
+		void run()
+		{
+			Item * items[16];
+			while (__atomic_load_n(&_poppedAmount, __ATOMIC_ACQUIRE) < _poppedCounts.size()) {
+				size_t amount = _queue.pop(items, sizeof(items) / sizeof(items[0]));
+				for (size_t i = 0; i < amount; ++i) {
+					size_t producerIndex = items[i]->index / _producerItemsAmount;
+					if (_minNextIndexes.size() <= producerIndex) {
+						_minNextIndexes.resize(producerIndex + 1, 0);
+					}
+					// Items of each producer are popped in the order of their indexes
+					if (items[i]->index < _minNextIndexes[producerIndex]) {
+						++misorderedAmount;
+					}
+					_minNextIndexes[producerIndex] = items[i]->index + 1;
+					__sync_add_and_fetch(&_poppedCounts[items[i]->index], 1);
+				}
+				__atomic_add_fetch(&_poppedAmount, amount, __ATOMIC_RELEASE);
+			}
+		}
+
+		size_t misorderedAmount;
+	private:
+		Queue& _queue;
+		std::vector<int>& _poppedCounts;
+		size_t& _poppedAmount;
+		const size_t _producerItemsAmount;
+		std::vector<size_t> _minNextIndexes;
+	};
+};
+
+TEST_F(LockFreeQueueTest, ItemsArePoppedInPushOrder)
+{
+	Queue queue;
+	Item * items[4];
+	EXPECT_TRUE(queue.isEmpty());
+	EXPECT_EQ(0U, queue.pop(items, 4));
+	Item first(0), second(1), third(2);
+	queue.push(&first);
+	queue.push(&second);
+	EXPECT_FALSE(queue.isEmpty());
+	EXPECT_EQ(1U, queue.pop(items, 1));
+	EXPECT_EQ(&first, items[0]);
+	// Popped item could be pushed again
+	queue.push(&third);
+	queue.push(&first);
+	EXPECT_EQ(3U, queue.pop(items, 4));
+	EXPECT_EQ(&second, items[0]);
+	EXPECT_EQ(&third, items[1]);
+	EXPECT_EQ(&first, items[2]);
+	EXPECT_TRUE(queue.isEmpty());
+	EXPECT_EQ(0U, queue.pop(items, 4));
+}
+
+TEST_F(LockFreeQueueTest, EachItemIsPoppedOnceWhileProducersArePushing)
+{
+	const size_t producersAmount = 3;
+	const size_t consumersAmount = 2;
+	const size_t producerItemsAmount = 100000;
+	Queue queue;
+	std::vector<Item> items;
+	for (size_t i = 0; i < producersAmount * producerItemsAmount; ++i) {
+		items.push_back(Item(i));
+	}
+	std::vector<int> poppedCounts(items.size(), 0);
+	size_t poppedAmount = 0;
+	std::vector<Consumer *> consumers;
+	std::vector<Producer *> producers;
+	std::vector<isl::Thread *> threads;
+	for (size_t i = 0; i < consumersAmount; ++i) {
+		consumers.push_back(new Consumer(queue, poppedCounts, poppedAmount, producerItemsAmount));
+		threads.push_back(new isl::Thread());
+		threads.back()->start(*consumers.back(), &Consumer::run);
+	}
+	for (size_t i = 0; i < producersAmount; ++i) {
+		producers.push_back(new Producer(queue, items, i * producerItemsAmount, producerItemsAmount));
+		threads.push_back(new isl::Thread());
+		threads.back()->start(*producers.back(), &Producer::run);
+	}
+	for (size_t i = 0; i < threads.size(); ++i) {
+		threads[i]->join();
+		delete threads[i];
+	}
+	size_t misorderedAmount = 0;
+	for (size_t i = 0; i < consumersAmount; ++i) {
+		misorderedAmount += consumers[i]->misorderedAmount;
+		delete consumers[i];
+	}
+	for (size_t i = 0; i < producersAmount; ++i) {
+		delete producers[i];
+	}
+	EXPECT_EQ(items.size(), poppedAmount);
+	size_t poppedOnceAmount = 0;
+	for (size_t i = 0; i < poppedCounts.size(); ++i) {
+		if (poppedCounts[i] == 1) {
+			++poppedOnceAmount;
+		}
+	}
+	EXPECT_EQ(items.size(), poppedOnceAmount);
+	EXPECT_EQ(0U, misorderedAmount);
+	EXPECT_TRUE(queue.isEmpty());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <isl/MultiTaskDispatcher.hxx>
+#include <isl/Mutex.hxx>
+#include <unistd.h>
+#include <memory>
+
+class MultiTaskDispatcherTest : public ::testing::Test
+{
+protected:
+	// Task which methods are sleeping for the duration and which counts the calls
+	class SleepingTask
+	{
+	public:
+		SleepingTask(isl::Mutex& mutex, int& executedCount, int& expiredCount, useconds_t duration) :
+			_mutex(mutex),
+			_executedCount(executedCount),
+			_expiredCount(expiredCount),
+			_duration(duration)
+		{}
+
+		void execute(isl::MultiTaskDispatcher<SleepingTask>& dispatcher)
+		{
+			{
+				isl::MutexLocker locker(_mutex);
+				++_executedCount;
+			}
+			usleep(_duration);
+		}
+		void onAdmissionExpired(isl::MultiTaskDispatcher<SleepingTask>& dispatcher)
+		{
+			isl::MutexLocker locker(_mutex);
+			++_expiredCount;
+		}
+	private:
+		isl::Mutex& _mutex;
+		int& _executedCount;
+		int& _expiredCount;
+		const useconds_t _duration;
+	};
+};
+
+TEST_F(MultiTaskDispatcherTest, AdmissionExpiresWhileAllWorkersAreBusy)
+{
+	isl::MultiTaskDispatcher<SleepingTask> dispatcher(0, 2, isl::Timeout(0.02));
+	dispatcher.setMaxAdmissionQueueSize(4);
+	dispatcher.setAdmissionTimeout(isl::Timeout(0.1));
+	dispatcher.setAdmissionExpiredMethod(&SleepingTask::onAdmissionExpired);
+	dispatcher.start();
+	usleep(50000);
+	isl::Mutex mutex;
+	int executedCount = 0;
+	int expiredCount = 0;
+	// Session-long gang is occupying both workers
+	std::auto_ptr<SleepingTask> sessionTaskAutoPtr(new SleepingTask(mutex, executedCount, expiredCount, 1000000));
+	ASSERT_TRUE(dispatcher.perform(sessionTaskAutoPtr, &SleepingTask::execute, &SleepingTask::execute));
+	usleep(50000);
+	std::auto_ptr<SleepingTask> queuedTaskAutoPtr(new SleepingTask(mutex, executedCount, expiredCount, 0));
+	ASSERT_TRUE(dispatcher.perform(queuedTaskAutoPtr, &SleepingTask::execute));
+	EXPECT_EQ(1U, dispatcher.admissionQueueSize());
+	// Nobody is performing tasks or releasing workers, but the expiration is detected on the clock tick
+	usleep(300000);
+	EXPECT_EQ(0U, dispatcher.admissionQueueSize());
+	EXPECT_EQ(1U, dispatcher.counters().expiredTasks);
+	{
+		isl::MutexLocker locker(mutex);
+		EXPECT_EQ(2, executedCount);
+		EXPECT_EQ(1, expiredCount);
+	}
+	dispatcher.stop();
+}
+
+TEST_F(MultiTaskDispatcherTest, QueuedGangIsAdmittedWhenWorkersAreReleased)
+{
+	isl::MultiTaskDispatcher<SleepingTask> dispatcher(0, 2, isl::Timeout(0.02));
+	dispatcher.setMaxAdmissionQueueSize(4);
+	dispatcher.setAdmissionTimeout(isl::Timeout(1.0));
+	dispatcher.start();
+	usleep(50000);
+	isl::Mutex mutex;
+	int executedCount = 0;
+	int expiredCount = 0;
+	std::auto_ptr<SleepingTask> firstTaskAutoPtr(new SleepingTask(mutex, executedCount, expiredCount, 100000));
+	ASSERT_TRUE(dispatcher.perform(firstTaskAutoPtr, &SleepingTask::execute, &SleepingTask::execute));
+	std::auto_ptr<SleepingTask> secondTaskAutoPtr(new SleepingTask(mutex, executedCount, expiredCount, 0));
+	ASSERT_TRUE(dispatcher.perform(secondTaskAutoPtr, &SleepingTask::execute, &SleepingTask::execute));
+	EXPECT_EQ(1U, dispatcher.admissionQueueSize());
+	usleep(300000);
+	EXPECT_EQ(0U, dispatcher.admissionQueueSize());
+	EXPECT_EQ(2U, dispatcher.counters().acceptedTasks);
+	EXPECT_EQ(0U, dispatcher.counters().expiredTasks);
+	{
+		isl::MutexLocker locker(mutex);
+		EXPECT_EQ(4, executedCount);
+		EXPECT_EQ(0, expiredCount);
+	}
+	dispatcher.stop();
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
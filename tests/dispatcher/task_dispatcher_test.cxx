@@ -0,0 +1,500 @@
+#include <gtest/gtest.h>
+#include <isl/TaskDispatcher.hxx>
+#include <isl/Mutex.hxx>
+#include <isl/Timestamp.hxx>
+#include <isl/Thread.hxx>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+
+class TaskDispatcherTest : public ::testing::Test
+{
+protected:
+	// Task which records it's start timestamp and sleeps for the duration
+	class SleepingTask
+	{
+	public:
+		SleepingTask(isl::Mutex& mutex, isl::Timestamp& started, useconds_t duration) :
+			_mutex(mutex),
+			_started(started),
+			_duration(duration)
+		{}
+
+		void execute(isl::TaskDispatcher<SleepingTask>& dispatcher)
+		{
+			{
+				isl::MutexLocker locker(_mutex);
+				_started = isl::Timestamp::now();
+			}
+			usleep(_duration);
+		}
+	private:
+		isl::Mutex& _mutex;
+		isl::Timestamp& _started;
+		const useconds_t _duration;
+	};
+
+	// Task which appends it's id to the shared execution order and sleeps for the duration
+	class RecordingTask
+	{
+	public:
+		RecordingTask(isl::Mutex& mutex, std::vector<int>& order, int id, useconds_t duration = 0) :
+			_mutex(mutex),
+			_order(order),
+			_id(id),
+			_duration(duration)
+		{}
+
+		inline int id() const
+		{
+			return _id;
+		}
+		void execute(isl::TaskDispatcher<RecordingTask>& dispatcher)
+		{
+			{
+				isl::MutexLocker locker(_mutex);
+				_order.push_back(_id);
+			}
+			usleep(_duration);
+		}
+	private:
+		isl::Mutex& _mutex;
+		std::vector<int>& _order;
+		const int _id;
+		const useconds_t _duration;
+	};
+
+	// Task dispatcher which records the ids of the expired tasks
+	class RecordingTaskDispatcher : public isl::TaskDispatcher<RecordingTask>
+	{
+	public:
+		RecordingTaskDispatcher(isl::Mutex& mutex) :
+			isl::TaskDispatcher<RecordingTask>(0, 1, isl::Timeout(0.02)),
+			expiredIds(),
+			_mutex(mutex)
+		{}
+
+		std::vector<int> expiredIds;
+	protected:
+		virtual void onTaskExpired(RecordingTask& task, const isl::Timestamp& deadline)
+		{
+			isl::MutexLocker locker(_mutex);
+			expiredIds.push_back(task.id());
+		}
+	private:
+		isl::Mutex& _mutex;
+	};
+
+	// Stops the task dispatcher in a separate thread
+	class Stopper
+	{
+	public:
+		Stopper(isl::TaskDispatcher<SleepingTask>& dispatcher) :
+			_dispatcher(dispatcher)
+		{}
+
+		void run()
+		{
+			_dispatcher.stop();
+		}
+	private:
+		isl::TaskDispatcher<SleepingTask>& _dispatcher;
+	};
+
+	// Performs the recording tasks of the ids range
+	class Producer
+	{
+	public:
+		Producer(isl::TaskDispatcher<RecordingTask>& dispatcher, isl::Mutex& mutex, std::vector<int>& order, int firstId, int amount) :
+			rejectedAmount(0),
+			_dispatcher(dispatcher),
+			_mutex(mutex),
+			_order(order),
+			_firstId(firstId),
+			_amount(amount)
+		{}
+
+		void run()
+		{
+			for (int i = _firstId; i < _firstId + _amount; ++i) {
+				if (!perform(_dispatcher, _mutex, _order, i, isl::TaskDispatcher<RecordingTask>::NormalPriority)) {
+					++rejectedAmount;
+				}
+			}
+		}
+
+		size_t rejectedAmount;
+	private:
+		isl::TaskDispatcher<RecordingTask>& _dispatcher;
+		isl::Mutex& _mutex;
+		std::vector<int>& _order;
+		const int _firstId;
+		const int _amount;
+	};
+
+	static bool perform(isl::TaskDispatcher<SleepingTask>& dispatcher, isl::Mutex& mutex, isl::Timestamp& started, useconds_t duration)
+	{
+		std::auto_ptr<SleepingTask> taskAutoPtr(new SleepingTask(mutex, started, duration));
+		return dispatcher.perform(taskAutoPtr, &SleepingTask::execute);
+	}
+	static bool perform(isl::TaskDispatcher<RecordingTask>& dispatcher, isl::Mutex& mutex, std::vector<int>& order, int id,
+			isl::TaskDispatcher<RecordingTask>::Priority priority, const isl::Timestamp& deadline = isl::Timestamp(), useconds_t duration = 0)
+	{
+		std::auto_ptr<RecordingTask> taskAutoPtr(new RecordingTask(mutex, order, id, duration));
+		return dispatcher.perform(taskAutoPtr, &RecordingTask::execute, priority, deadline);
+	}
+	static bool isStarted(isl::Mutex& mutex, const isl::Timestamp& started)
+	{
+		isl::MutexLocker locker(mutex);
+		return !started.isZero();
+	}
+};
+
+TEST_F(TaskDispatcherTest, ElasticDispatcherGrowsWhileAllWorkersAreBusy)
+{
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 4, isl::Timeout(0.02));
+	dispatcher.setElastic(true, 1, isl::Timeout(0.01));
+	dispatcher.start();
+	EXPECT_EQ(1U, dispatcher.runningWorkersAmount());
+	isl::Mutex mutex;
+	isl::Timestamp longTaskStarted;
+	isl::Timestamp shortTaskStarted;
+	ASSERT_TRUE(perform(dispatcher, mutex, longTaskStarted, 1000000));
+	usleep(100000);
+	// The only worker is busy with the long task, so nobody is performing or fetching tasks
+	isl::Timestamp shortTaskPerformed = isl::Timestamp::now();
+	ASSERT_TRUE(perform(dispatcher, mutex, shortTaskStarted, 0));
+	usleep(300000);
+	{
+		isl::MutexLocker locker(mutex);
+		ASSERT_FALSE(shortTaskStarted.isZero());
+		EXPECT_LT(shortTaskStarted - shortTaskPerformed, isl::Timeout(0.2));
+	}
+	EXPECT_EQ(2U, dispatcher.runningWorkersAmount());
+	EXPECT_EQ(2U, dispatcher.counters().spawnedWorkers);
+	dispatcher.stop();
+}
+
+TEST_F(TaskDispatcherTest, FixedDispatcherDoesNotGrow)
+{
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 1, isl::Timeout(0.02));
+	dispatcher.start();
+	isl::Mutex mutex;
+	isl::Timestamp longTaskStarted;
+	isl::Timestamp shortTaskStarted;
+	ASSERT_TRUE(perform(dispatcher, mutex, longTaskStarted, 300000));
+	usleep(50000);
+	ASSERT_TRUE(perform(dispatcher, mutex, shortTaskStarted, 0));
+	usleep(100000);
+	{
+		isl::MutexLocker locker(mutex);
+		EXPECT_TRUE(shortTaskStarted.isZero());
+	}
+	EXPECT_EQ(1U, dispatcher.runningWorkersAmount());
+	usleep(300000);
+	{
+		isl::MutexLocker locker(mutex);
+		EXPECT_FALSE(shortTaskStarted.isZero());
+	}
+	dispatcher.stop();
+}
+
+TEST_F(TaskDispatcherTest, WorkStealingDispatcherPerformsAllTasks)
+{
+	const size_t tasksAmount = 1000;
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 4, isl::Timeout(0.02));
+	dispatcher.setWorkStealing(true);
+	dispatcher.start();
+	isl::Mutex mutex;
+	isl::Timestamp longTaskStarted;
+	std::vector<isl::Timestamp> shortTasksStarted(tasksAmount);
+	ASSERT_TRUE(perform(dispatcher, mutex, longTaskStarted, 1000000));
+	// Short tasks which have been fetched by the busy worker are to be stolen by the others
+	for (size_t i = 0; i < tasksAmount; ++i) {
+		ASSERT_TRUE(perform(dispatcher, mutex, shortTasksStarted[i], 0));
+	}
+	usleep(300000);
+	{
+		isl::MutexLocker locker(mutex);
+		for (size_t i = 0; i < tasksAmount; ++i) {
+			EXPECT_FALSE(shortTasksStarted[i].isZero());
+		}
+	}
+	EXPECT_EQ(tasksAmount + 1, dispatcher.counters().executedTasks);
+	dispatcher.stop();
+}
+
+TEST_F(TaskDispatcherTest, RejectPolicyRejectsNewTaskWhenQueueIsFull)
+{
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 1, isl::Timeout(0.02));
+	dispatcher.setMaxPendingTasks(1);
+	dispatcher.start();
+	isl::Mutex mutex;
+	isl::Timestamp longTaskStarted;
+	isl::Timestamp queuedTaskStarted;
+	isl::Timestamp rejectedTaskStarted;
+	ASSERT_TRUE(perform(dispatcher, mutex, longTaskStarted, 200000));
+	usleep(50000);
+	EXPECT_TRUE(perform(dispatcher, mutex, queuedTaskStarted, 0));
+	EXPECT_FALSE(perform(dispatcher, mutex, rejectedTaskStarted, 0));
+	usleep(300000);
+	EXPECT_TRUE(isStarted(mutex, queuedTaskStarted));
+	EXPECT_FALSE(isStarted(mutex, rejectedTaskStarted));
+	isl::TaskDispatcher<SleepingTask>::Counters counters = dispatcher.counters();
+	EXPECT_EQ(2U, counters.acceptedTasks);
+	EXPECT_EQ(1U, counters.rejectedTasks);
+	EXPECT_EQ(0U, counters.droppedTasks);
+	EXPECT_EQ(2U, counters.executedTasks);
+	dispatcher.stop();
+}
+
+TEST_F(TaskDispatcherTest, DropOldestPolicyDiscardsOldestPendingTask)
+{
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 1, isl::Timeout(0.02));
+	dispatcher.setMaxPendingTasks(1);
+	dispatcher.setOverloadPolicy(isl::TaskDispatcher<SleepingTask>::DropOldestPolicy);
+	dispatcher.start();
+	isl::Mutex mutex;
+	isl::Timestamp longTaskStarted;
+	isl::Timestamp droppedTaskStarted;
+	isl::Timestamp newTaskStarted;
+	ASSERT_TRUE(perform(dispatcher, mutex, longTaskStarted, 200000));
+	usleep(50000);
+	EXPECT_TRUE(perform(dispatcher, mutex, droppedTaskStarted, 0));
+	EXPECT_TRUE(perform(dispatcher, mutex, newTaskStarted, 0));
+	usleep(300000);
+	EXPECT_FALSE(isStarted(mutex, droppedTaskStarted));
+	EXPECT_TRUE(isStarted(mutex, newTaskStarted));
+	isl::TaskDispatcher<SleepingTask>::Counters counters = dispatcher.counters();
+	EXPECT_EQ(3U, counters.acceptedTasks);
+	EXPECT_EQ(0U, counters.rejectedTasks);
+	EXPECT_EQ(1U, counters.droppedTasks);
+	EXPECT_EQ(2U, counters.executedTasks);
+	dispatcher.stop();
+}
+
+TEST_F(TaskDispatcherTest, DropOldestPolicyKeepsPendingTaskOnStop)
+{
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 1, isl::Timeout(0.02));
+	dispatcher.setMaxPendingTasks(1);
+	dispatcher.setOverloadPolicy(isl::TaskDispatcher<SleepingTask>::DropOldestPolicy);
+	dispatcher.setDrainOnStop(true);
+	dispatcher.start();
+	isl::Mutex mutex;
+	isl::Timestamp longTaskStarted;
+	isl::Timestamp queuedTaskStarted;
+	isl::Timestamp lateTaskStarted;
+	ASSERT_TRUE(perform(dispatcher, mutex, longTaskStarted, 300000));
+	usleep(50000);
+	ASSERT_TRUE(perform(dispatcher, mutex, queuedTaskStarted, 0));
+	// Dispatcher is stopping while the worker is busy with the long task
+	Stopper stopper(dispatcher);
+	isl::Thread stopperThread;
+	stopperThread.start(stopper, &Stopper::run);
+	usleep(50000);
+	EXPECT_FALSE(perform(dispatcher, mutex, lateTaskStarted, 0));
+	stopperThread.join();
+	EXPECT_TRUE(isStarted(mutex, queuedTaskStarted));
+	EXPECT_FALSE(isStarted(mutex, lateTaskStarted));
+	isl::TaskDispatcher<SleepingTask>::Counters counters = dispatcher.counters();
+	EXPECT_EQ(0U, counters.droppedTasks);
+	EXPECT_EQ(1U, counters.rejectedTasks);
+	EXPECT_EQ(2U, counters.executedTasks);
+}
+
+TEST_F(TaskDispatcherTest, BlockPolicyWaitsForRoomUntilOverloadTimeout)
+{
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 1, isl::Timeout(0.02));
+	dispatcher.setMaxPendingTasks(1);
+	dispatcher.setOverloadPolicy(isl::TaskDispatcher<SleepingTask>::BlockPolicy);
+	dispatcher.setOverloadTimeout(isl::Timeout(1.0));
+	dispatcher.start();
+	isl::Mutex mutex;
+	isl::Timestamp firstLongTaskStarted;
+	isl::Timestamp secondLongTaskStarted;
+	isl::Timestamp blockedTaskStarted;
+	isl::Timestamp timedOutTaskStarted;
+	ASSERT_TRUE(perform(dispatcher, mutex, firstLongTaskStarted, 200000));
+	usleep(50000);
+	ASSERT_TRUE(perform(dispatcher, mutex, secondLongTaskStarted, 300000));
+	// Producer is blocked until the worker fetches the second long task
+	isl::Timestamp blockStarted = isl::Timestamp::now();
+	EXPECT_TRUE(perform(dispatcher, mutex, blockedTaskStarted, 0));
+	EXPECT_GT(isl::Timestamp::now() - blockStarted, isl::Timeout(0.1));
+	EXPECT_TRUE(isStarted(mutex, secondLongTaskStarted));
+	// Producer gives up when the overload timeout expires
+	dispatcher.setOverloadTimeout(isl::Timeout(0.05));
+	blockStarted = isl::Timestamp::now();
+	EXPECT_FALSE(perform(dispatcher, mutex, timedOutTaskStarted, 0));
+	EXPECT_GE(isl::Timestamp::now() - blockStarted, isl::Timeout(0.05));
+	EXPECT_LT(isl::Timestamp::now() - blockStarted, isl::Timeout(0.2));
+	usleep(400000);
+	EXPECT_TRUE(isStarted(mutex, blockedTaskStarted));
+	EXPECT_FALSE(isStarted(mutex, timedOutTaskStarted));
+	isl::TaskDispatcher<SleepingTask>::Counters counters = dispatcher.counters();
+	EXPECT_EQ(3U, counters.acceptedTasks);
+	EXPECT_EQ(1U, counters.rejectedTasks);
+	EXPECT_EQ(3U, counters.executedTasks);
+	dispatcher.stop();
+}
+
+TEST_F(TaskDispatcherTest, QueueWaitEstimateGrowsWhileAllWorkersAreBusy)
+{
+	isl::TaskDispatcher<SleepingTask> dispatcher(0, 1, isl::Timeout(0.02));
+	dispatcher.start();
+	isl::Mutex mutex;
+	isl::Timestamp longTaskStarted;
+	isl::Timestamp queuedTaskStarted;
+	usleep(50000);
+	// Idling worker is to fetch the new task at once
+	EXPECT_TRUE(dispatcher.queueWaitEstimate().isZero());
+	ASSERT_TRUE(perform(dispatcher, mutex, longTaskStarted, 300000));
+	usleep(50000);
+	ASSERT_TRUE(perform(dispatcher, mutex, queuedTaskStarted, 0));
+	usleep(100000);
+	// Estimate is not less than the time the oldest pending task has been waiting
+	EXPECT_GE(dispatcher.queueWaitEstimate(), isl::Timeout(0.1));
+	usleep(300000);
+	ASSERT_TRUE(isStarted(mutex, queuedTaskStarted));
+	EXPECT_GT(dispatcher.counters().maxQueueTime, isl::Timeout(0.1));
+	dispatcher.stop();
+}
+
+TEST_F(TaskDispatcherTest, HigherPriorityClassIsExecutedFirst)
+{
+	typedef isl::TaskDispatcher<RecordingTask> Dispatcher;
+	isl::Mutex mutex;
+	std::vector<int> order;
+	RecordingTaskDispatcher dispatcher(mutex);
+	dispatcher.start();
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 0, Dispatcher::NormalPriority, isl::Timestamp(), 200000));
+	usleep(50000);
+	// Tasks are queued while the only worker is busy
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 1, Dispatcher::LowPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 2, Dispatcher::NormalPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 3, Dispatcher::HighPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 4, Dispatcher::LowPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 5, Dispatcher::HighPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 6, Dispatcher::NormalPriority));
+	usleep(300000);
+	dispatcher.stop();
+	const int expectedOrder[] = {0, 3, 5, 2, 6, 1, 4};
+	EXPECT_EQ(std::vector<int>(expectedOrder, expectedOrder + sizeof(expectedOrder) / sizeof(int)), order);
+}
+
+TEST_F(TaskDispatcherTest, EarliestDeadlineIsExecutedFirstWithinPriorityClass)
+{
+	typedef isl::TaskDispatcher<RecordingTask> Dispatcher;
+	isl::Mutex mutex;
+	std::vector<int> order;
+	RecordingTaskDispatcher dispatcher(mutex);
+	dispatcher.start();
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 0, Dispatcher::NormalPriority, isl::Timestamp(), 200000));
+	usleep(50000);
+	isl::Timestamp now = isl::Timestamp::now();
+	// Tasks without a deadline are executed after the deadline tasks in FIFO order
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 1, Dispatcher::NormalPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 2, Dispatcher::NormalPriority, now + isl::Timeout(30.0)));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 3, Dispatcher::NormalPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 4, Dispatcher::NormalPriority, now + isl::Timeout(10.0)));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 5, Dispatcher::NormalPriority, now + isl::Timeout(20.0)));
+	// Priority class precedes the deadline
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 6, Dispatcher::HighPriority, now + isl::Timeout(40.0)));
+	usleep(300000);
+	dispatcher.stop();
+	const int expectedOrder[] = {0, 6, 4, 5, 2, 1, 3};
+	EXPECT_EQ(std::vector<int>(expectedOrder, expectedOrder + sizeof(expectedOrder) / sizeof(int)), order);
+	EXPECT_TRUE(dispatcher.expiredIds.empty());
+}
+
+TEST_F(TaskDispatcherTest, ExpiredTaskIsNotExecuted)
+{
+	typedef isl::TaskDispatcher<RecordingTask> Dispatcher;
+	isl::Mutex mutex;
+	std::vector<int> order;
+	RecordingTaskDispatcher dispatcher(mutex);
+	dispatcher.start();
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 0, Dispatcher::NormalPriority, isl::Timestamp(), 200000));
+	usleep(50000);
+	isl::Timestamp now = isl::Timestamp::now();
+	// Deadline passes while the only worker is busy
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 1, Dispatcher::HighPriority, now + isl::Timeout(0.05)));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 2, Dispatcher::NormalPriority, now + isl::Timeout(10.0)));
+	usleep(300000);
+	dispatcher.stop();
+	const int expectedOrder[] = {0, 2};
+	EXPECT_EQ(std::vector<int>(expectedOrder, expectedOrder + sizeof(expectedOrder) / sizeof(int)), order);
+	ASSERT_EQ(1U, dispatcher.expiredIds.size());
+	EXPECT_EQ(1, dispatcher.expiredIds[0]);
+	Dispatcher::Counters counters = dispatcher.counters();
+	EXPECT_EQ(1U, counters.expiredTasks);
+	// Expired task has been fetched by the worker too
+	EXPECT_EQ(3U, counters.executedTasks);
+}
+
+TEST_F(TaskDispatcherTest, WorkStealingDispatcherDrainsInjectedTasksOnStop)
+{
+	const size_t producersAmount = 3;
+	const int producerTasksAmount = 20000;
+	isl::TaskDispatcher<RecordingTask> dispatcher(0, 4, isl::Timeout(0.02));
+	dispatcher.setWorkStealing(true);
+	dispatcher.setDrainOnStop(true);
+	dispatcher.start();
+	isl::Mutex mutex;
+	std::vector<int> order;
+	std::vector<Producer *> producers;
+	std::vector<isl::Thread *> threads;
+	for (size_t i = 0; i < producersAmount; ++i) {
+		producers.push_back(new Producer(dispatcher, mutex, order, i * producerTasksAmount, producerTasksAmount));
+		threads.push_back(new isl::Thread());
+		threads.back()->start(*producers.back(), &Producer::run);
+	}
+	for (size_t i = 0; i < producersAmount; ++i) {
+		threads[i]->join();
+		delete threads[i];
+		EXPECT_EQ(0U, producers[i]->rejectedAmount);
+		delete producers[i];
+	}
+	// Tasks which have been injected by the producers are executed on stop
+	dispatcher.stop();
+	ASSERT_EQ(producersAmount * producerTasksAmount, order.size());
+	std::vector<int> executedCounts(order.size(), 0);
+	for (size_t i = 0; i < order.size(); ++i) {
+		++executedCounts[order[i]];
+	}
+	EXPECT_EQ(std::vector<int>(order.size(), 1), executedCounts);
+	isl::TaskDispatcher<RecordingTask>::Counters counters = dispatcher.counters();
+	EXPECT_EQ(order.size(), counters.acceptedTasks);
+	EXPECT_EQ(order.size(), counters.executedTasks);
+	EXPECT_EQ(0U, dispatcher.pendingTasksAmount());
+}
+
+TEST_F(TaskDispatcherTest, InjectedTasksAreOrderedByPriorityClass)
+{
+	typedef isl::TaskDispatcher<RecordingTask> Dispatcher;
+	isl::Mutex mutex;
+	std::vector<int> order;
+	RecordingTaskDispatcher dispatcher(mutex);
+	dispatcher.setWorkStealing(true);
+	dispatcher.start();
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 0, Dispatcher::NormalPriority, isl::Timestamp(), 200000));
+	usleep(50000);
+	// Normal priority tasks without a deadline are injected, the rest are put to the pending tasks queue
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 1, Dispatcher::LowPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 2, Dispatcher::NormalPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 3, Dispatcher::NormalPriority, isl::Timestamp::now() + isl::Timeout(10.0)));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 4, Dispatcher::NormalPriority));
+	ASSERT_TRUE(perform(dispatcher, mutex, order, 5, Dispatcher::HighPriority));
+	EXPECT_EQ(5U, dispatcher.pendingTasksAmount());
+	usleep(300000);
+	dispatcher.stop();
+	const int expectedOrder[] = {0, 5, 3, 2, 4, 1};
+	EXPECT_EQ(std::vector<int>(expectedOrder, expectedOrder + sizeof(expectedOrder) / sizeof(int)), order);
+	EXPECT_EQ(6U, dispatcher.counters().acceptedTasks);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
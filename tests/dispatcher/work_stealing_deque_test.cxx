@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <isl/WorkStealingDeque.hxx>
+#include <isl/Thread.hxx>
+#include <isl/Exception.hxx>
+#include <vector>
+
+class WorkStealingDequeTest : public ::testing::Test
+{
+protected:
+	typedef isl::WorkStealingDeque<int> Deque;
+
+	// Items are marked as taken by their indexes, so each item should be taken exactly once
+	class Items
+	{
+	public:
+		Items(size_t amount) :
+			_items(amount),
+			_takenCounts(amount, 0)
+		{
+			for (size_t i = 0; i < amount; ++i) {
+				_items[i] = static_cast<int>(i);
+			}
+		}
+
+		int * item(size_t index)
+		{
+			return &_items[index];
+		}
+		void take(int * itemPtr)
+		{
+			__sync_add_and_fetch(&_takenCounts[*itemPtr], 1);
+		}
+		size_t takenOnceAmount() const
+		{
+			size_t result = 0;
+			for (size_t i = 0; i < _takenCounts.size(); ++i) {
+				if (_takenCounts[i] == 1) {
+					++result;
+				}
+			}
+			return result;
+		}
+	private:
+		std::vector<int> _items;
+		std::vector<int> _takenCounts;
+	};
+
+	// Steals the items until the owner has finished and the deque is empty
+	class Thief
+	{
+	public:
+		Thief(Deque& deque, Items& items, const bool& ownerFinished) :
+			stolenAmount(0),
+			_deque(deque),
+			_items(items),
+			_ownerFinished(ownerFinished)
+		{}
+
+		void run()
+		{
+			while (true) {
+				bool ownerFinished = __atomic_load_n(&_ownerFinished, __ATOMIC_ACQUIRE);
+				int * itemPtr = _deque.steal();
+				if (itemPtr) {
+					_items.take(itemPtr);
+					++stolenAmount;
+				} else if (ownerFinished && _deque.size() <= 0) {
+					break;
+				}
+			}
+		}
+
+		size_t stolenAmount;
+	private:
+		Deque& _deque;
+		Items& _items;
+		const bool& _ownerFinished;
+	};
+};
+
+TEST_F(WorkStealingDequeTest, OwnerPopsLifoAndThiefStealsFifo)
+{
+	Deque deque(4);
+	Items items(3);
+	deque.push(items.item(0));
+	deque.push(items.item(1));
+	deque.push(items.item(2));
+	EXPECT_EQ(3U, deque.size());
+	EXPECT_EQ(items.item(2), deque.pop());
+	EXPECT_EQ(items.item(0), deque.steal());
+	EXPECT_EQ(items.item(1), deque.pop());
+	EXPECT_EQ(0, deque.pop());
+	EXPECT_EQ(0, deque.steal());
+	EXPECT_EQ(0U, deque.size());
+}
+
+TEST_F(WorkStealingDequeTest, CapacityIsRoundedUpAndOverflowIsRejected)
+{
+	Deque deque(3);
+	EXPECT_EQ(4U, deque.capacity());
+	Items items(5);
+	for (size_t i = 0; i < 4; ++i) {
+		deque.push(items.item(i));
+	}
+	EXPECT_EQ(0U, deque.room());
+	EXPECT_THROW(deque.push(items.item(4)), isl::Exception);
+	// Stolen item's room is reused by the owner
+	EXPECT_EQ(items.item(0), deque.steal());
+	EXPECT_EQ(1U, deque.room());
+	deque.push(items.item(4));
+	EXPECT_EQ(items.item(4), deque.pop());
+}
+
+TEST_F(WorkStealingDequeTest, EachItemIsTakenOnceWhileThievesAreStealing)
+{
+	const size_t itemsAmount = 200000;
+	const size_t thievesAmount = 3;
+	Deque deque(64);
+	Items items(itemsAmount);
+	bool ownerFinished = false;
+	std::vector<Thief *> thieves;
+	std::vector<isl::Thread *> threads;
+	for (size_t i = 0; i < thievesAmount; ++i) {
+		thieves.push_back(new Thief(deque, items, ownerFinished));
+		threads.push_back(new isl::Thread());
+		threads.back()->start(*thieves.back(), &Thief::run);
+	}
+	// Owner is pushing the items and is popping every other one, so the last item is raced with the thieves
+	size_t poppedAmount = 0;
+	for (size_t i = 0; i < itemsAmount;) {
+		if (deque.room() > 0) {
+			deque.push(items.item(i++));
+		}
+		if (i % 2 == 0) {
+			if (int * itemPtr = deque.pop()) {
+				items.take(itemPtr);
+				++poppedAmount;
+			}
+		}
+	}
+	while (int * itemPtr = deque.pop()) {
+		items.take(itemPtr);
+		++poppedAmount;
+	}
+	__atomic_store_n(&ownerFinished, true, __ATOMIC_RELEASE);
+	size_t stolenAmount = 0;
+	for (size_t i = 0; i < thievesAmount; ++i) {
+		threads[i]->join();
+		stolenAmount += thieves[i]->stolenAmount;
+		delete threads[i];
+		delete thieves[i];
+	}
+	EXPECT_EQ(itemsAmount, poppedAmount + stolenAmount);
+	EXPECT_EQ(itemsAmount, items.takenOnceAmount());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+// Task dispatcher throughput benchmark: compares tasks per second of the shared pending tasks queue mode with the
+// work-stealing mode of the TaskDispatcher.
+//
+// Producer threads are performing short tasks as fast as possible, the benchmark ends when the task dispatcher
+// has drained all pending tasks on stop. Task body is a tiny busy loop, so the dispatching overhead dominates.
+#include <isl/TaskDispatcher.hxx>
+#include <isl/Thread.hxx>
+#include <isl/Timestamp.hxx>
+#include <isl/Exception.hxx>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#define PRODUCERS_AMOUNT 2			// Amount of producer threads
+#define TASKS_AMOUNT 400000			// Total amount of tasks to perform
+#define TASK_LOAD 100				// Busy loop iterations per task
+
+class Task
+{
+public:
+	typedef isl::TaskDispatcher<Task> Dispatcher;
+
+	Task(size_t& executedTasks) :
+		_executedTasks(executedTasks)
+	{}
+
+	void execute(Dispatcher& dispatcher)
+	{
+		volatile unsigned int acc = 0;
+		for (unsigned int i = 0; i < TASK_LOAD; ++i) {
+			acc += i;
+		}
+		__sync_add_and_fetch(&_executedTasks, 1);
+	}
+private:
+	size_t& _executedTasks;
+};
+
+class Producer
+{
+public:
+	Producer(Task::Dispatcher& dispatcher, size_t tasksAmount, size_t& executedTasks) :
+		_dispatcher(dispatcher),
+		_tasksAmount(tasksAmount),
+		_executedTasks(executedTasks),
+		_rejectedTasks(0)
+	{}
+
+	void run()
+	{
+		for (size_t i = 0; i < _tasksAmount; ++i) {
+			std::auto_ptr<Task> taskAutoPtr(new Task(_executedTasks));
+			if (!_dispatcher.perform(taskAutoPtr, &Task::execute)) {
+				++_rejectedTasks;
+			}
+		}
+	}
+	size_t rejectedTasks() const
+	{
+		return _rejectedTasks;
+	}
+private:
+	Task::Dispatcher& _dispatcher;
+	size_t _tasksAmount;
+	size_t& _executedTasks;
+	size_t _rejectedTasks;
+};
+
+static double measure(bool workStealing, size_t workersAmount)
+{
+	Task::Dispatcher dispatcher(0, workersAmount);
+	dispatcher.setWorkStealing(workStealing);
+	dispatcher.setDrainOnStop(true);
+	size_t executedTasks = 0;
+	std::vector<Producer *> producers;
+	std::vector<isl::Thread *> producerThreads;
+	for (size_t i = 0; i < PRODUCERS_AMOUNT; ++i) {
+		producers.push_back(new Producer(dispatcher, TASKS_AMOUNT / PRODUCERS_AMOUNT, executedTasks));
+		producerThreads.push_back(new isl::Thread());
+	}
+	dispatcher.start();
+	isl::Timestamp startTimestamp = isl::Timestamp::now();
+	for (size_t i = 0; i < PRODUCERS_AMOUNT; ++i) {
+		producerThreads[i]->start(*producers[i], &Producer::run);
+	}
+	for (size_t i = 0; i < PRODUCERS_AMOUNT; ++i) {
+		producerThreads[i]->join();
+	}
+	dispatcher.stop();
+	isl::Timeout elapsed = isl::Timestamp::now() - startTimestamp;
+	for (size_t i = 0; i < PRODUCERS_AMOUNT; ++i) {
+		delete producerThreads[i];
+		delete producers[i];
+	}
+	if (executedTasks != (TASKS_AMOUNT / PRODUCERS_AMOUNT) * PRODUCERS_AMOUNT) {
+		std::cerr << "  " << executedTasks << " tasks have been executed only" << std::endl;
+	}
+	return executedTasks / elapsed.secondsDouble();
+}
+
+int main(int argc, char *argv[])
+{
+	static const size_t workersAmounts[] = {1, 2, 4, 8, 16};
+	try {
+		std::cout << PRODUCERS_AMOUNT << " producer(s), " << TASKS_AMOUNT << " tasks" << std::endl;
+		for (size_t i = 0; i < sizeof(workersAmounts) / sizeof(workersAmounts[0]); ++i) {
+			double sharedQueueRate = measure(false, workersAmounts[i]);
+			double workStealingRate = measure(true, workersAmounts[i]);
+			std::cout << std::setw(3) << workersAmounts[i] << " worker(s): shared queue " << std::fixed << std::setprecision(0) <<
+				sharedQueueRate << " tasks/sec, work-stealing " << workStealingRate << " tasks/sec (x" << std::setprecision(2) <<
+				workStealingRate / sharedQueueRate << ")" << std::endl;
+		}
+	} catch (std::exception& e) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <isl/DnsResolver.hxx>
+#include <isl/Mutex.hxx>
+#include <unistd.h>
+
+// Name "localhost" is resolved using /etc/hosts, so no network access is needed
+
+class DnsResolverTest : public ::testing::Test
+{
+protected:
+	class Callback : public isl::DnsResolver::AbstractCallback
+	{
+	public:
+		Callback() :
+			mutex(),
+			resolvedCount(0),
+			errorsCount(0),
+			lastHost()
+		{}
+
+		virtual void onResolved(const isl::TcpAddrInfo& addrInfo)
+		{
+			isl::MutexLocker locker(mutex);
+			++resolvedCount;
+			lastHost = addrInfo.firstEndpoint().host;
+		}
+		virtual void onError(const std::string& errorMessage)
+		{
+			isl::MutexLocker locker(mutex);
+			++errorsCount;
+		}
+
+		isl::Mutex mutex;
+		int resolvedCount;
+		int errorsCount;
+		std::string lastHost;
+	};
+};
+
+TEST_F(DnsResolverTest, SyncResolveIsCached)
+{
+	isl::DnsResolver resolver(0);
+	EXPECT_EQ(0U, resolver.cacheSize());
+	isl::TcpAddrInfo addrInfo = resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	EXPECT_EQ("127.0.0.1", addrInfo.firstEndpoint().host);
+	EXPECT_EQ(8080U, addrInfo.firstEndpoint().port);
+	EXPECT_EQ(1U, resolver.cacheSize());
+	isl::TcpAddrInfo cachedAddrInfo = resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	EXPECT_EQ("127.0.0.1", cachedAddrInfo.firstEndpoint().host);
+	EXPECT_TRUE(cachedAddrInfo.addrinfo() != 0);
+	EXPECT_EQ(1U, resolver.cacheSize());
+	resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8081);
+	EXPECT_EQ(2U, resolver.cacheSize());
+	resolver.clearCache();
+	EXPECT_EQ(0U, resolver.cacheSize());
+}
+
+TEST_F(DnsResolverTest, CacheEntryExpires)
+{
+	isl::DnsResolver resolver(0, 1, isl::Timeout(0, 1000000));
+	resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	EXPECT_EQ(1U, resolver.cacheSize());
+	usleep(10000);
+	isl::DnsResolver::Future future = resolver.resolveAsync(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	// Expired entry is evicted and the resolution is queued to the (not running) workers
+	EXPECT_EQ(0U, resolver.cacheSize());
+	EXPECT_FALSE(future.isReady());
+}
+
+TEST_F(DnsResolverTest, CacheSizeIsLimited)
+{
+	isl::DnsResolver resolver(0, 1, isl::Timeout(60), 2);
+	resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8081);
+	resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8082);
+	EXPECT_EQ(2U, resolver.cacheSize());
+}
+
+TEST_F(DnsResolverTest, AsyncResolve)
+{
+	isl::DnsResolver resolver(0);
+	resolver.start();
+	isl::DnsResolver::Future future = resolver.resolveAsync(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	ASSERT_TRUE(future.isValid());
+	EXPECT_TRUE(future.await(isl::Timestamp::limit(isl::Timeout(5))));
+	EXPECT_TRUE(future.succeeded());
+	EXPECT_EQ("127.0.0.1", future.addrInfo().firstEndpoint().host);
+	// Second resolution is served from the cache
+	isl::DnsResolver::Future cachedFuture = resolver.resolveAsync(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	EXPECT_TRUE(cachedFuture.isReady());
+	EXPECT_EQ(8080U, cachedFuture.addrInfo().firstEndpoint().port);
+	resolver.stop();
+}
+
+TEST_F(DnsResolverTest, CallbacksAreCoalesced)
+{
+	isl::DnsResolver resolver(0);
+	Callback callbacks[4];
+	for (size_t i = 0; i < 4; ++i) {
+		resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8080, callbacks[i]);
+	}
+	// All callbacks are waiting for one resolution, which is completed by the worker after the start
+	isl::DnsResolver::Future future = resolver.resolveAsync(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	resolver.start();
+	future.await();
+	resolver.stop();
+	for (size_t i = 0; i < 4; ++i) {
+		isl::MutexLocker locker(callbacks[i].mutex);
+		EXPECT_EQ(1, callbacks[i].resolvedCount);
+		EXPECT_EQ(0, callbacks[i].errorsCount);
+		EXPECT_EQ("127.0.0.1", callbacks[i].lastHost);
+	}
+	// Callback is called immediately on cache hit
+	Callback callback;
+	resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8080, callback);
+	EXPECT_EQ(1, callback.resolvedCount);
+}
+
+TEST_F(DnsResolverTest, PendingResolutionIsCancelledOnStop)
+{
+	isl::DnsResolver resolver(0);
+	Callback callback;
+	resolver.resolve(isl::TcpAddrInfo::IpV4, "localhost", 8080, callback);
+	isl::DnsResolver::Future future = resolver.resolveAsync(isl::TcpAddrInfo::IpV4, "localhost", 8080);
+	resolver.stop();
+	EXPECT_TRUE(future.isReady());
+	EXPECT_FALSE(future.succeeded());
+	EXPECT_FALSE(future.errorMessage().empty());
+	EXPECT_THROW(future.addrInfo(), isl::Exception);
+	EXPECT_EQ(1, callback.errorsCount);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,291 @@
+#include <gtest/gtest.h>
+#include <isl/HttpResponseStreamWriter.hxx>
+#include <isl/AbstractIODevice.hxx>
+#include <isl/TcpSocket.hxx>
+#include <isl/Timestamp.hxx>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <memory>
+
+class HttpStreamWriterTest : public ::testing::Test
+{
+protected:
+	// I/O-device, which is collecting the written data and is recording the cork state changes
+	class RecordingDevice : public isl::AbstractIODevice
+	{
+	public:
+		RecordingDevice() :
+			AbstractIODevice(),
+			data(),
+			corkStates(),
+			isCorked(false),
+			isBlocked(false),
+			isFileBlocked(false),
+			maxBytesPerCall(0),
+			blockAfterBytes(0),
+			writeVectorCalls(0),
+			sendFileCalls(0)
+		{
+			open();
+		}
+
+		std::string data;
+		std::vector<bool> corkStates;
+		bool isCorked;
+		// Device is not accepting any data as if the timeout has been expired
+		bool isBlocked;
+		// Device is not accepting the file data only
+		bool isFileBlocked;
+		// Maximum amount of the bytes written by one call or 0 if not limited
+		size_t maxBytesPerCall;
+		// Amount of the collected bytes the device is blocked after or 0 if not limited
+		size_t blockAfterBytes;
+		size_t writeVectorCalls;
+		size_t sendFileCalls;
+	private:
+		size_t allowedBytes(size_t size) const
+		{
+			if (isBlocked) {
+				return 0;
+			}
+			size_t result = (maxBytesPerCall > 0 && size > maxBytesPerCall) ? maxBytesPerCall : size;
+			if (blockAfterBytes > 0 && data.size() + result > blockAfterBytes) {
+				result = data.size() < blockAfterBytes ? blockAfterBytes - data.size() : 0;
+			}
+			return result;
+		}
+
+		virtual void openImplementation()
+		{}
+		virtual void closeImplementation()
+		{}
+		virtual size_t readImplementation(char * buffer, size_t bufferSize, const isl::Timeout& timeout)
+		{
+			return 0;
+		}
+		virtual size_t writeImplementation(const char * buffer, size_t bufferSize, const isl::Timeout& timeout)
+		{
+			size_t bytesWritten = allowedBytes(bufferSize);
+			data.append(buffer, bytesWritten);
+			return bytesWritten;
+		}
+		virtual size_t writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const isl::Timeout& timeout)
+		{
+			++writeVectorCalls;
+			std::string concatenated;
+			for (size_t i = 0; i < buffersAmount; ++i) {
+				concatenated.append(buffers[i].data, buffers[i].size);
+			}
+			return writeImplementation(concatenated.data(), concatenated.size(), timeout);
+		}
+		virtual size_t sendFileImplementation(int fileDescriptor, off_t offset, size_t size, const isl::Timeout& timeout)
+		{
+			++sendFileCalls;
+			if (isFileBlocked) {
+				return 0;
+			}
+			// Default implementation is reading the file data and is writing it using writeImplementation()
+			return AbstractIODevice::sendFileImplementation(fileDescriptor, offset, size, timeout);
+		}
+		virtual void setCorkedImplementation(bool newValue)
+		{
+			isCorked = newValue;
+			corkStates.push_back(newValue);
+		}
+	};
+
+	// Temporary file with the content, which is removed on destruction
+	class TemporaryFile
+	{
+	public:
+		TemporaryFile(const std::string& content) :
+			descriptor(-1)
+		{
+			char path[] = "/tmp/isl_http_stream_writer_test.XXXXXX";
+			descriptor = mkstemp(path);
+			unlink(path);
+			if (write(descriptor, content.data(), content.size()) != static_cast<ssize_t>(content.size())) {
+				ADD_FAILURE() << "Temporary file write error";
+			}
+		}
+		~TemporaryFile()
+		{
+			close(descriptor);
+		}
+
+		int descriptor;
+	};
+
+	static isl::Timestamp limit()
+	{
+		return isl::Timestamp::limit(isl::Timeout(1.0));
+	}
+};
+
+TEST_F(HttpStreamWriterTest, PartialVectorWriteIsCompleted)
+{
+	RecordingDevice device;
+	device.maxBytesPerCall = 7;
+	isl::HttpResponseStreamWriter writer(200);
+	std::string body(100, 'b');
+	EXPECT_TRUE(writer.writeOnce(device, body, limit()));
+	EXPECT_FALSE(writer.needFlush());
+	// Header and body are sent by the vectored writes, each of them is resumed from the partially sent buffer
+	EXPECT_GT(device.writeVectorCalls, 1U);
+	size_t headerEnd = device.data.find("\r\n\r\n");
+	ASSERT_NE(std::string::npos, headerEnd);
+	EXPECT_EQ(0U, device.data.find("HTTP/1.1 200"));
+	EXPECT_NE(std::string::npos, device.data.find("Content-Length: 100\r\n"));
+	EXPECT_EQ(body, device.data.substr(headerEnd + 4));
+}
+
+TEST_F(HttpStreamWriterTest, UnsentBodyIsCopiedOnTimeout)
+{
+	RecordingDevice device;
+	device.maxBytesPerCall = 16;
+	device.blockAfterBytes = 64;
+	isl::HttpResponseStreamWriter writer(200);
+	std::string body(100, 'b');
+	EXPECT_FALSE(writer.writeOnce(device, body, isl::Timestamp::limit(isl::Timeout(0.05))));
+	EXPECT_TRUE(writer.needFlush());
+	EXPECT_EQ(64U, device.data.size());
+	// Caller's buffer is not needed by the flush() call
+	body.assign(body.size(), 'x');
+	device.blockAfterBytes = 0;
+	EXPECT_TRUE(writer.flush(device, limit()));
+	EXPECT_FALSE(writer.needFlush());
+	size_t headerEnd = device.data.find("\r\n\r\n");
+	ASSERT_NE(std::string::npos, headerEnd);
+	EXPECT_EQ(std::string(100, 'b'), device.data.substr(headerEnd + 4));
+}
+
+TEST_F(HttpStreamWriterTest, ChunksAreSentByVectoredWrites)
+{
+	RecordingDevice device;
+	device.maxBytesPerCall = 5;
+	isl::HttpResponseStreamWriter writer(200);
+	EXPECT_TRUE(writer.writeChunk(device, "1234567890", limit()));
+	EXPECT_TRUE(writer.writeChunk(device, "12345678901", limit()));
+	EXPECT_TRUE(writer.finalize(device, limit()));
+	size_t headerEnd = device.data.find("\r\n\r\n");
+	ASSERT_NE(std::string::npos, headerEnd);
+	EXPECT_NE(std::string::npos, device.data.find("Transfer-Encoding: chunked\r\n"));
+	EXPECT_EQ("a\r\n1234567890\r\nb\r\n12345678901\r\n0\r\n\r\n", device.data.substr(headerEnd + 4));
+}
+
+TEST_F(HttpStreamWriterTest, FileBodyIsResumedAfterPartialSends)
+{
+	RecordingDevice device;
+	device.maxBytesPerCall = 7;
+	std::string content;
+	for (size_t i = 0; i < 120; ++i) {
+		content += static_cast<char>('a' + i % 26);
+	}
+	TemporaryFile file(content);
+	isl::HttpResponseStreamWriter writer(200);
+	EXPECT_TRUE(writer.writeFile(device, file.descriptor, 10, 100, limit()));
+	EXPECT_GT(device.sendFileCalls, 1U);
+	size_t headerEnd = device.data.find("\r\n\r\n");
+	ASSERT_NE(std::string::npos, headerEnd);
+	EXPECT_NE(std::string::npos, device.data.find("Content-Length: 100\r\n"));
+	EXPECT_EQ(content.substr(10, 100), device.data.substr(headerEnd + 4));
+}
+
+TEST_F(HttpStreamWriterTest, FileChunksAreSentWithSuffix)
+{
+	RecordingDevice device;
+	device.maxBytesPerCall = 3;
+	TemporaryFile file("1234567890abcdefghijk");
+	isl::HttpResponseStreamWriter writer(200);
+	EXPECT_TRUE(writer.writeFileChunk(device, file.descriptor, 0, 10, limit()));
+	EXPECT_TRUE(writer.writeFileChunk(device, file.descriptor, 10, 11, limit()));
+	EXPECT_TRUE(writer.finalize(device, limit()));
+	size_t headerEnd = device.data.find("\r\n\r\n");
+	ASSERT_NE(std::string::npos, headerEnd);
+	EXPECT_EQ("a\r\n1234567890\r\nb\r\nabcdefghijk\r\n0\r\n\r\n", device.data.substr(headerEnd + 4));
+	EXPECT_FALSE(device.isCorked);
+}
+
+TEST_F(HttpStreamWriterTest, FileBodyIsSentOverTcpSocket)
+{
+	isl::TcpSocket listener;
+	listener.open();
+	listener.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+	listener.listen(16);
+	isl::TcpSocket client;
+	client.open();
+	client.connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", listener.localEndpoint().port));
+	std::auto_ptr<isl::TcpSocket> serverAutoPtr = listener.accept(isl::Timeout(1.0));
+	ASSERT_TRUE(serverAutoPtr.get() != 0);
+	// File is larger than the socket buffers, so sendfile(2) is sending it partially
+	std::string content(4 * 1024 * 1024, 'f');
+	TemporaryFile file(content);
+	isl::HttpResponseStreamWriter writer(200);
+	bool isSent = writer.writeFile(*serverAutoPtr.get(), file.descriptor, 0, content.size(), isl::Timestamp::limit(isl::Timeout(0.01)));
+	std::string received;
+	isl::Timestamp testLimit = isl::Timestamp::limit(isl::Timeout(5.0));
+	while ((!isSent || received.size() < content.size()) && isl::Timestamp::now() < testLimit) {
+		char buffer[65536];
+		received.append(buffer, client.read(buffer, sizeof(buffer), isl::Timeout(0.01)));
+		if (!isSent) {
+			isSent = writer.flush(*serverAutoPtr.get(), isl::Timestamp::limit(isl::Timeout(0.01)));
+		}
+		size_t headerEnd = received.find("\r\n\r\n");
+		if (headerEnd != std::string::npos && received.size() - headerEnd - 4 >= content.size()) {
+			break;
+		}
+	}
+	EXPECT_TRUE(isSent);
+	size_t headerEnd = received.find("\r\n\r\n");
+	ASSERT_NE(std::string::npos, headerEnd);
+	EXPECT_EQ(content.size(), received.size() - headerEnd - 4);
+	EXPECT_TRUE(received.compare(headerEnd + 4, std::string::npos, content) == 0);
+}
+
+TEST_F(HttpStreamWriterTest, DeviceIsUncorkedOnReset)
+{
+	RecordingDevice device;
+	TemporaryFile file(std::string(100, 'f'));
+	isl::HttpResponseStreamWriter writer(200);
+	// File data could not be sent, so the header's partial frame is held back by the corked device
+	device.isFileBlocked = true;
+	EXPECT_FALSE(writer.writeFile(device, file.descriptor, 0, 100, limit()));
+	EXPECT_TRUE(device.isCorked);
+	EXPECT_TRUE(writer.needFlush());
+	// Aborted transmission should not leave the device corked
+	writer.reset(200);
+	EXPECT_FALSE(device.isCorked);
+	EXPECT_FALSE(writer.needFlush());
+	// Next message is corked and uncorked by itself
+	device.isFileBlocked = false;
+	device.data.clear();
+	device.corkStates.clear();
+	EXPECT_TRUE(writer.writeFile(device, file.descriptor, 0, 100, limit()));
+	EXPECT_FALSE(device.isCorked);
+	ASSERT_EQ(2U, device.corkStates.size());
+	EXPECT_TRUE(device.corkStates[0]);
+	EXPECT_FALSE(device.corkStates[1]);
+	EXPECT_EQ(std::string(100, 'f'), device.data.substr(device.data.size() - 100));
+}
+
+TEST_F(HttpStreamWriterTest, ClosedDeviceIsNotUncorkedOnReset)
+{
+	RecordingDevice device;
+	TemporaryFile file(std::string(100, 'f'));
+	isl::HttpResponseStreamWriter writer(200);
+	device.isFileBlocked = true;
+	EXPECT_FALSE(writer.writeFile(device, file.descriptor, 0, 100, limit()));
+	EXPECT_TRUE(device.isCorked);
+	// Connection has been closed on the I/O-error
+	device.close();
+	EXPECT_NO_THROW(writer.reset(200));
+	EXPECT_EQ(1U, device.corkStates.size());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
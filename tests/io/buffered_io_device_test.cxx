@@ -0,0 +1,209 @@
+#include <gtest/gtest.h>
+#include <isl/BufferedIODevice.hxx>
+#include <isl/HttpRequestReader.hxx>
+#include <isl/HttpRequestParser.hxx>
+#include <isl/HttpMessageStreamReader.hxx>
+#include <isl/Exception.hxx>
+#include <isl/Timestamp.hxx>
+#include <string>
+
+class BufferedIODeviceTest : public ::testing::Test
+{
+protected:
+	// I/O-device, which is returning the scripted input and is collecting the written data
+	class ScriptedDevice : public isl::AbstractIODevice
+	{
+	public:
+		ScriptedDevice(const std::string& input = std::string()) :
+			AbstractIODevice(),
+			input(input),
+			data(),
+			isBlocked(false),
+			maxBytesPerRead(0),
+			maxBytesPerWrite(0),
+			readCalls(0),
+			writeCalls(0)
+		{
+			open();
+		}
+
+		// Data to return from the read calls
+		std::string input;
+		std::string data;
+		// Device is not accepting any data as if the timeout has been expired
+		bool isBlocked;
+		// Maximum amount of the bytes returned by one read call or 0 if not limited
+		size_t maxBytesPerRead;
+		// Maximum amount of the bytes written by one call or 0 if not limited
+		size_t maxBytesPerWrite;
+		size_t readCalls;
+		size_t writeCalls;
+	private:
+		virtual void openImplementation()
+		{}
+		virtual void closeImplementation()
+		{}
+		virtual size_t readImplementation(char * buffer, size_t bufferSize, const isl::Timeout& timeout)
+		{
+			++readCalls;
+			size_t bytesRead = (bufferSize < input.size()) ? bufferSize : input.size();
+			if (maxBytesPerRead > 0 && bytesRead > maxBytesPerRead) {
+				bytesRead = maxBytesPerRead;
+			}
+			input.copy(buffer, bytesRead);
+			input.erase(0, bytesRead);
+			return bytesRead;
+		}
+		virtual size_t writeImplementation(const char * buffer, size_t bufferSize, const isl::Timeout& timeout)
+		{
+			ConstBuffer data(buffer, bufferSize);
+			return writeVectorImplementation(&data, 1, timeout);
+		}
+		virtual size_t writeVectorImplementation(const ConstBuffer * buffers, size_t buffersAmount, const isl::Timeout& timeout)
+		{
+			++writeCalls;
+			if (isBlocked) {
+				return 0;
+			}
+			std::string concatenated;
+			for (size_t i = 0; i < buffersAmount; ++i) {
+				concatenated.append(buffers[i].data, buffers[i].size);
+			}
+			size_t bytesWritten = (maxBytesPerWrite > 0 && concatenated.size() > maxBytesPerWrite) ? maxBytesPerWrite : concatenated.size();
+			data.append(concatenated, 0, bytesWritten);
+			return bytesWritten;
+		}
+	};
+
+	static std::string peek(const isl::BufferedIODevice& device)
+	{
+		isl::AbstractIODevice::ConstBuffer span = device.peek();
+		return std::string(span.data ? span.data : "", span.size);
+	}
+	static isl::Timestamp limit()
+	{
+		return isl::Timestamp::limit(isl::Timeout(1.0));
+	}
+};
+
+TEST_F(BufferedIODeviceTest, WrappedDataIsPeekedInTwoSpans)
+{
+	ScriptedDevice device("abcdefghijkl");
+	device.maxBytesPerRead = 6;
+	isl::BufferedIODevice bufferedDevice(device, 8, 0);
+	EXPECT_EQ(6U, bufferedDevice.fill());
+	EXPECT_EQ("abcdef", peek(bufferedDevice));
+	bufferedDevice.consume(4);
+	EXPECT_EQ(2U, bufferedDevice.fill());
+	EXPECT_EQ(4U, bufferedDevice.fill());
+	EXPECT_EQ(8U, bufferedDevice.bytesAvailable());
+	// Data is wrapped around the end of the ring buffer
+	EXPECT_EQ("efgh", peek(bufferedDevice));
+	bufferedDevice.consume(3);
+	EXPECT_EQ("h", peek(bufferedDevice));
+	bufferedDevice.consume(1);
+	EXPECT_EQ("ijkl", peek(bufferedDevice));
+	EXPECT_THROW(bufferedDevice.consume(5), isl::Exception);
+	bufferedDevice.consume(4);
+	EXPECT_EQ(0U, bufferedDevice.bytesAvailable());
+	EXPECT_EQ("", peek(bufferedDevice));
+}
+
+TEST_F(BufferedIODeviceTest, FillUsesWrappedFreeSpan)
+{
+	ScriptedDevice device("abcdefghijkl");
+	isl::BufferedIODevice bufferedDevice(device, 8, 0);
+	EXPECT_EQ(8U, bufferedDevice.fill());
+	// Full buffer is not filled
+	EXPECT_EQ(0U, bufferedDevice.fill());
+	EXPECT_EQ(1U, device.readCalls);
+	bufferedDevice.consume(5);
+	// Free space after the data is exhausted, so the freed space at the beginning of the buffer is filled
+	EXPECT_EQ(4U, bufferedDevice.fill());
+	EXPECT_EQ(7U, bufferedDevice.bytesAvailable());
+	// Read data is copied across the end of the ring buffer
+	char buf[16];
+	size_t bytesRead = bufferedDevice.read(buf, sizeof(buf));
+	EXPECT_EQ("fghijkl", std::string(buf, bytesRead));
+	EXPECT_EQ(2U, device.readCalls);
+}
+
+TEST_F(BufferedIODeviceTest, PartialVectoredWriteIsResumedByFlush)
+{
+	ScriptedDevice device;
+	device.maxBytesPerWrite = 3;
+	isl::BufferedIODevice bufferedDevice(device, 0, 8);
+	EXPECT_EQ(5U, bufferedDevice.write("abcde", 5));
+	EXPECT_EQ(0U, device.writeCalls);
+	// Buffered data is sent together with the new one, the unsent rest is batched across the end of the ring buffer
+	EXPECT_EQ(6U, bufferedDevice.write("fghijk", 6));
+	EXPECT_EQ(1U, device.writeCalls);
+	EXPECT_EQ("abc", device.data);
+	EXPECT_EQ(8U, bufferedDevice.bytesPending());
+	device.isBlocked = true;
+	EXPECT_FALSE(bufferedDevice.flush());
+	EXPECT_EQ(8U, bufferedDevice.bytesPending());
+	device.isBlocked = false;
+	EXPECT_TRUE(bufferedDevice.flush(isl::Timeout(1.0)));
+	EXPECT_EQ(0U, bufferedDevice.bytesPending());
+	EXPECT_EQ("abcdefghijk", device.data);
+	// Data which does not fit the write buffer is accepted partially
+	isl::AbstractIODevice::ConstBuffer buffers[2] = {isl::AbstractIODevice::ConstBuffer("lmnop", 5), isl::AbstractIODevice::ConstBuffer("qrstuvw", 7)};
+	EXPECT_EQ(11U, bufferedDevice.writeVector(buffers, 2));
+	EXPECT_EQ("abcdefghijklmn", device.data);
+	EXPECT_EQ(8U, bufferedDevice.bytesPending());
+	EXPECT_TRUE(bufferedDevice.flush(isl::Timeout(1.0)));
+	EXPECT_EQ("abcdefghijklmnopqrstuv", device.data);
+}
+
+TEST_F(BufferedIODeviceTest, ZeroSizedBuffersPassThrough)
+{
+	ScriptedDevice device("abcdef");
+	device.maxBytesPerWrite = 2;
+	isl::BufferedIODevice bufferedDevice(device, 0, 0);
+	EXPECT_EQ(0U, bufferedDevice.fill());
+	EXPECT_EQ(0U, device.readCalls);
+	char buf[4];
+	EXPECT_EQ(4U, bufferedDevice.read(buf, sizeof(buf)));
+	EXPECT_EQ("abcd", std::string(buf, 4));
+	EXPECT_EQ(1U, device.readCalls);
+	EXPECT_EQ(0U, bufferedDevice.bytesAvailable());
+	EXPECT_EQ(2U, bufferedDevice.write("xyz", 3));
+	EXPECT_EQ("xy", device.data);
+	EXPECT_EQ(0U, bufferedDevice.bytesPending());
+	EXPECT_TRUE(bufferedDevice.flush());
+}
+
+TEST_F(BufferedIODeviceTest, PipelinedMessagesAreKeptBetweenReaders)
+{
+	ScriptedDevice device("POST /first HTTP/1.1\r\nHost: localhost\r\nContent-Length: 4\r\n\r\nbody"
+			"GET /second?a=1 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+	isl::BufferedIODevice bufferedDevice(device, 4096, 0);
+	// Stream reader fetches the first request
+	isl::HttpRequestParser firstParser;
+	isl::HttpMessageStreamReader streamReader(firstParser);
+	char body[16];
+	size_t bytesReadFromDevice = 0;
+	std::pair<bool, size_t> res = streamReader.read(bufferedDevice, limit(), body, sizeof(body), &bytesReadFromDevice);
+	ASSERT_TRUE(res.first);
+	EXPECT_EQ("/first", firstParser.uri());
+	EXPECT_EQ("body", std::string(body, res.second));
+	EXPECT_EQ(1U, device.readCalls);
+	EXPECT_GT(bufferedDevice.bytesAvailable(), 0U);
+	// Another reader fetches the pipelined request from the same buffered device without reading from the device
+	isl::HttpRequestParser secondParser;
+	isl::HttpRequestReader reader(secondParser);
+	ASSERT_TRUE(reader.read(bufferedDevice, limit(), &bytesReadFromDevice));
+	EXPECT_EQ(0U, bytesReadFromDevice);
+	EXPECT_EQ("GET", secondParser.method());
+	EXPECT_EQ("/second", reader.path());
+	EXPECT_EQ("a=1", reader.query());
+	EXPECT_EQ(1U, device.readCalls);
+	EXPECT_EQ(0U, bufferedDevice.bytesAvailable());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
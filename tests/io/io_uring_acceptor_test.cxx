@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <isl/IoUringAcceptor.hxx>
+#include <isl/TcpSocket.hxx>
+#include <isl/Exception.hxx>
+#include <unistd.h>
+#include <memory>
+#include <vector>
+
+// Sockets are connected over the loopback interface, so no network access is needed
+
+class IoUringAcceptorTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		listener.open();
+		listener.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+		listener.listen(64);
+	}
+	virtual void TearDown()
+	{
+		for (size_t i = 0; i < clients.size(); ++i) {
+			delete clients[i];
+		}
+	}
+
+	static bool isSupported()
+	{
+		if (isl::IoUring::isSupported()) {
+			return true;
+		}
+		std::cout << "io_uring(7) is not supported, skipping the test" << std::endl;
+		return false;
+	}
+	void connect(size_t amount)
+	{
+		for (size_t i = 0; i < amount; ++i) {
+			std::auto_ptr<isl::TcpSocket> socketAutoPtr(new isl::TcpSocket());
+			socketAutoPtr->open();
+			ASSERT_TRUE(socketAutoPtr->connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", listener.localEndpoint().port), isl::Timeout(1.0)));
+			clients.push_back(socketAutoPtr.release());
+		}
+	}
+
+	isl::TcpSocket listener;
+	std::vector<isl::TcpSocket *> clients;
+};
+
+TEST_F(IoUringAcceptorTest, BurstIsAcceptedInBatch)
+{
+	if (!isSupported()) {
+		return;
+	}
+	isl::IoUringAcceptor acceptor(listener, 8);
+	// Accept operations are armed by the first call
+	EXPECT_TRUE(acceptor.accept(isl::Timeout(0.01)).get() == 0);
+	connect(5);
+	usleep(50000);
+	std::auto_ptr<isl::TcpSocket> serverAutoPtr(acceptor.accept(isl::Timeout(1.0)));
+	ASSERT_TRUE(serverAutoPtr.get() != 0);
+	// All connections of the burst have been reaped by one wait
+	EXPECT_EQ(4U, acceptor.acceptedConnectionsAmount());
+	std::vector<isl::TcpSocket *> servers;
+	servers.push_back(serverAutoPtr.release());
+	while (acceptor.acceptedConnectionsAmount() > 0) {
+		servers.push_back(acceptor.accept(isl::Timeout(1.0)).release());
+	}
+	ASSERT_EQ(clients.size(), servers.size());
+	// Accepted sockets are usable and know their peers
+	for (size_t i = 0; i < servers.size(); ++i) {
+		EXPECT_TRUE(servers[i]->isOpen());
+		servers[i]->write("ping", 4, isl::Timeout(1.0));
+	}
+	for (size_t i = 0; i < clients.size(); ++i) {
+		char buf[16];
+		EXPECT_EQ(4U, clients[i]->read(buf, sizeof(buf), isl::Timeout(1.0)));
+		EXPECT_EQ(clients[i]->localEndpoint().port, servers[i]->remoteEndpoint().port);
+	}
+	for (size_t i = 0; i < servers.size(); ++i) {
+		delete servers[i];
+	}
+}
+
+TEST_F(IoUringAcceptorTest, BurstLargerThanPendingAcceptsIsAccepted)
+{
+	if (!isSupported()) {
+		return;
+	}
+	isl::IoUringAcceptor acceptor(listener, 2);
+	connect(7);
+	size_t acceptedAmount = 0;
+	while (acceptor.accept(isl::Timeout(0.2)).get()) {
+		++acceptedAmount;
+	}
+	EXPECT_EQ(clients.size(), acceptedAmount);
+}
+
+TEST_F(IoUringAcceptorTest, PendingAcceptsAreCancelledOnDestruction)
+{
+	if (!isSupported()) {
+		return;
+	}
+	{
+		isl::IoUringAcceptor acceptor(listener, 4);
+		EXPECT_TRUE(acceptor.accept(isl::Timeout(0.01)).get() == 0);
+	}
+	// Cancelled accept operations do not steal the connections from the listening socket
+	connect(1);
+	std::auto_ptr<isl::TcpSocket> serverAutoPtr(listener.accept(isl::Timeout(1.0)));
+	EXPECT_TRUE(serverAutoPtr.get() != 0);
+}
+
+TEST_F(IoUringAcceptorTest, ClosedListenerIsReported)
+{
+	if (!isSupported()) {
+		return;
+	}
+	isl::IoUringAcceptor acceptor(listener);
+	EXPECT_EQ(static_cast<size_t>(isl::IoUringAcceptor::DefaultMaxPendingAccepts), acceptor.maxPendingAccepts());
+	isl::TcpSocket closedSocket;
+	isl::IoUringAcceptor closedSocketAcceptor(closedSocket, 1);
+	EXPECT_THROW(closedSocketAcceptor.accept(isl::Timeout(0.01)), isl::Exception);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
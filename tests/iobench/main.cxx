@@ -0,0 +1,259 @@
+// TCP-socket I/O path benchmark: compares syscalls per message of the "wait for readiness then do I/O" approach
+// (pselect(2) before each recv(2)/send(2)) with the "try I/O first, poll(2) on EAGAIN only" approach of the TcpSocket
+// and with the io_uring(7) engine (if ISL is built with it and the kernel supports it).
+//
+// Two scenarios are measured:
+//  - streaming: messages are written to the loopback connection by the writer process as fast as possible;
+//  - ping-pong: the writer process is waiting for one byte acknowledgement from the reader after each message.
+// The syscalls of the reader process are counted using ptrace(2) between the two getppid(2) markers.
+#include <isl/TcpSocket.hxx>
+#include <isl/TcpAddrInfo.hxx>
+#include <isl/Timestamp.hxx>
+#include <isl/IoUring.hxx>
+#include <isl/Exception.hxx>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#if defined(__x86_64__)
+#include <sys/user.h>
+#include <stddef.h>
+#endif
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <iostream>
+#include <iomanip>
+
+#define LISTEN_PORT 8892			// Loopback TCP-port to use
+#define MESSAGE_SIZE 64				// Message size in bytes
+#define MESSAGES_AMOUNT 20000			// Amount of messages to transfer
+
+enum IOMode {
+	SelectThenIOMode,
+	TryIOFirstMode,
+	IoUringMode
+};
+
+enum Scenario {
+	StreamingScenario,
+	PingPongScenario
+};
+
+// Reads data using the previous approach: pselect(2) is called before each recv(2)
+size_t selectThenRead(isl::TcpSocket& socket, char * buffer, size_t bufferSize, const isl::Timeout& timeout)
+{
+	timespec readTimeout = timeout.timeSpec();
+	fd_set readDescriptorsSet;
+	FD_ZERO(&readDescriptorsSet);
+	FD_SET(socket.descriptor(), &readDescriptorsSet);
+	int descriptorsCount = pselect(socket.descriptor() + 1, &readDescriptorsSet, NULL, NULL, &readTimeout, NULL);
+	if (descriptorsCount <= 0) {
+		return 0;
+	}
+	ssize_t bytesReceived = recv(socket.descriptor(), buffer, bufferSize, 0);
+	return bytesReceived > 0 ? bytesReceived : 0;
+}
+
+// Writes data using the previous approach: pselect(2) is called before each send(2)
+size_t selectThenWrite(isl::TcpSocket& socket, const char * buffer, size_t bufferSize, const isl::Timeout& timeout)
+{
+	timespec writeTimeout = timeout.timeSpec();
+	fd_set writeDescriptorsSet;
+	FD_ZERO(&writeDescriptorsSet);
+	FD_SET(socket.descriptor(), &writeDescriptorsSet);
+	int descriptorsCount = pselect(socket.descriptor() + 1, NULL, &writeDescriptorsSet, NULL, &writeTimeout, NULL);
+	if (descriptorsCount <= 0) {
+		return 0;
+	}
+	ssize_t bytesSent = send(socket.descriptor(), buffer, bufferSize, MSG_NOSIGNAL);
+	return bytesSent > 0 ? bytesSent : 0;
+}
+
+// Reader process body
+void readMessages(IOMode mode, Scenario scenario, bool traced)
+{
+	isl::IoUring::setEnabled(mode == IoUringMode);
+	if (traced) {
+		ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+		raise(SIGSTOP);
+	}
+	isl::TcpSocket socket;
+	socket.open();
+	socket.connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", LISTEN_PORT));
+	if (mode == IoUringMode) {
+		// Creating thread's io_uring(7) instance outside of the measurement
+		isl::IoUring::threadInstance();
+	}
+	char buffer[MESSAGE_SIZE];
+	size_t totalBytesReceived = 0;
+	isl::Timestamp startTimestamp = isl::Timestamp::now();
+	getppid();						// Start marker
+	while (totalBytesReceived < MESSAGE_SIZE * MESSAGES_AMOUNT) {
+		size_t bytesReceived = (mode == SelectThenIOMode) ?
+			selectThenRead(socket, buffer, sizeof(buffer), isl::Timeout(1)) :
+			socket.read(buffer, sizeof(buffer), isl::Timeout(1));
+		if (bytesReceived <= 0) {
+			std::cerr << "Read timeout expired" << std::endl;
+			_exit(1);
+		}
+		totalBytesReceived += bytesReceived;
+		if (scenario == PingPongScenario && totalBytesReceived % MESSAGE_SIZE == 0) {
+			// Acknowledging the message
+			char ack = 'A';
+			size_t bytesSent = (mode == SelectThenIOMode) ?
+				selectThenWrite(socket, &ack, sizeof(ack), isl::Timeout(1)) :
+				socket.write(&ack, sizeof(ack), isl::Timeout(1));
+			if (bytesSent <= 0) {
+				std::cerr << "Write timeout expired" << std::endl;
+				_exit(1);
+			}
+		}
+	}
+	getppid();						// Stop marker
+	if (!traced) {
+		isl::Timeout elapsed = isl::Timestamp::now() - startTimestamp;
+		std::cout << "  Time per message: " << std::fixed << std::setprecision(3) <<
+			elapsed.secondsDouble() * 1000000.0 / MESSAGES_AMOUNT << " us" << std::endl;
+	}
+	_exit(0);
+}
+
+// Writer process body
+void writeMessages(isl::TcpSocket& serverSocket, Scenario scenario)
+{
+	isl::IoUring::setEnabled(false);
+	std::auto_ptr<isl::TcpSocket> socketAutoPtr = serverSocket.accept(isl::Timeout(5));
+	if (!socketAutoPtr.get()) {
+		_exit(1);
+	}
+	char message[MESSAGE_SIZE];
+	for (size_t i = 0; i < sizeof(message); ++i) {
+		message[i] = 'a' + i % 26;
+	}
+	for (size_t i = 0; i < MESSAGES_AMOUNT; ++i) {
+		size_t bytesSent = 0;
+		while (bytesSent < sizeof(message)) {
+			bytesSent += socketAutoPtr->write(message + bytesSent, sizeof(message) - bytesSent, isl::Timeout(1));
+		}
+		if (scenario == PingPongScenario) {
+			char ack;
+			if (socketAutoPtr->read(&ack, sizeof(ack), isl::Timeout(5)) <= 0) {
+				_exit(1);
+			}
+		}
+	}
+	// Waiting for the reader to close the connection
+	char c;
+	try {
+		socketAutoPtr->read(&c, sizeof(c), isl::Timeout(5));
+	} catch (...) {
+	}
+	_exit(0);
+}
+
+// Counts syscalls of the traced process between the markers, returns -1 if syscalls counting is not supported
+long countSyscalls(pid_t pid)
+{
+	int status;
+	if (waitpid(pid, &status, 0) < 0 || !WIFSTOPPED(status)) {
+		return -1;
+	}
+#if defined(__x86_64__)
+	ptrace(PTRACE_SETOPTIONS, pid, NULL, reinterpret_cast<void *>(PTRACE_O_TRACESYSGOOD));
+	long syscallsCount = 0;
+	bool isSyscallEntry = true;
+	int markersCount = 0;
+	while (true) {
+		if (ptrace(PTRACE_SYSCALL, pid, NULL, NULL) < 0) {
+			return -1;
+		}
+		if (waitpid(pid, &status, 0) < 0) {
+			return -1;
+		}
+		if (WIFEXITED(status) || WIFSIGNALED(status)) {
+			break;
+		}
+		if (!WIFSTOPPED(status) || WSTOPSIG(status) != (SIGTRAP | 0x80)) {
+			continue;
+		}
+		if (isSyscallEntry) {
+			long syscallNumber = ptrace(PTRACE_PEEKUSER, pid, reinterpret_cast<void *>(offsetof(struct user_regs_struct, orig_rax)), NULL);
+			if (syscallNumber == SYS_getppid) {
+				++markersCount;
+			} else if (markersCount == 1) {
+				++syscallsCount;
+			}
+		}
+		isSyscallEntry = !isSyscallEntry;
+	}
+	return markersCount >= 2 ? syscallsCount : -1;
+#else
+	ptrace(PTRACE_DETACH, pid, NULL, NULL);
+	waitpid(pid, &status, 0);
+	return -1;
+#endif
+}
+
+void runBenchmark(IOMode mode, Scenario scenario, bool traced)
+{
+	isl::TcpSocket serverSocket;
+	serverSocket.open();
+	serverSocket.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", LISTEN_PORT));
+	serverSocket.listen(1);
+	pid_t writerPid = fork();
+	if (writerPid == 0) {
+		writeMessages(serverSocket, scenario);
+	}
+	serverSocket.close();
+	pid_t readerPid = fork();
+	if (readerPid == 0) {
+		readMessages(mode, scenario, traced);
+	}
+	if (traced) {
+		long syscallsCount = countSyscalls(readerPid);
+		if (syscallsCount < 0) {
+			std::cout << "  Syscalls counting is not supported" << std::endl;
+		} else {
+			std::cout << "  Syscalls per message: " << std::fixed << std::setprecision(3) <<
+				static_cast<double>(syscallsCount) / MESSAGES_AMOUNT << std::endl;
+		}
+	}
+	int status;
+	waitpid(readerPid, &status, 0);
+	waitpid(writerPid, &status, 0);
+}
+
+int main(int argc, char *argv[])
+{
+	const char * modeNames[] = {
+		"pselect(2) before each I/O",
+		"I/O first, poll(2) on EAGAIN only",
+		"io_uring(7) engine"
+	};
+	const char * scenarioNames[] = {
+		"streaming",
+		"ping-pong"
+	};
+	try {
+		for (int scenario = StreamingScenario; scenario <= PingPongScenario; ++scenario) {
+			for (int mode = SelectThenIOMode; mode <= IoUringMode; ++mode) {
+				std::cout << modeNames[mode] << ", " << scenarioNames[scenario] << " (" << MESSAGES_AMOUNT << " messages of " <<
+					MESSAGE_SIZE << " bytes):" << std::endl;
+				if (mode == IoUringMode && !isl::IoUring::isSupported()) {
+					std::cout << "  io_uring(7) engine is not available" << std::endl;
+					continue;
+				}
+				runBenchmark(static_cast<IOMode>(mode), static_cast<Scenario>(scenario), true);
+				runBenchmark(static_cast<IOMode>(mode), static_cast<Scenario>(scenario), false);
+			}
+		}
+	} catch (std::exception& e) {
+		std::cerr << "Benchmark error: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
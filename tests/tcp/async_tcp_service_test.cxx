@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <isl/AbstractAsyncTcpService.hxx>
+#include <isl/TcpSocket.hxx>
+#include <isl/Exception.hxx>
+#include <unistd.h>
+#include <memory>
+#include <string>
+
+// Service is listening on the loopback interface, so no network access is needed
+
+class AsyncTcpServiceTest : public ::testing::Test
+{
+protected:
+	// Full-duplex echo service which counts I/O-events of it's tasks
+	class DuplexEchoService : public isl::AbstractAsyncTcpService
+	{
+	public:
+		DuplexEchoService(size_t maxClients) :
+			AbstractAsyncTcpService(0, maxClients, isl::Timeout(0.05)),
+			readableEventsCount(0),
+			writableEventsCount(0),
+			unexpectedWritableEventsCount(0),
+			finishedTasksCount(0)
+		{
+			setDuplexMode(true);
+		}
+
+		int readableEventsCount;
+		int writableEventsCount;
+		int unexpectedWritableEventsCount;
+		int finishedTasksCount;
+	private:
+		// Reads the data and writes it back when the socket becomes writable, finishes on "quit"
+		class EchoTask : public AbstractDuplexTask
+		{
+		public:
+			EchoTask(isl::TcpSocket& socket, DuplexEchoService& service) :
+				AbstractDuplexTask(socket),
+				_service(service),
+				_pendingData()
+			{}
+		private:
+			virtual bool onIOEvent(MultiTaskDispatcherType& taskDispatcher, bool isReadable, bool isWritable)
+			{
+				if (isWritable) {
+					__sync_add_and_fetch(&_service.writableEventsCount, 1);
+					if (_pendingData.empty()) {
+						// Writable event has been reported while the task is not awaiting it
+						__sync_add_and_fetch(&_service.unexpectedWritableEventsCount, 1);
+					} else {
+						socket().write(_pendingData.data(), _pendingData.size(), isl::Timeout(1.0));
+						_pendingData.clear();
+					}
+				}
+				if (isReadable) {
+					__sync_add_and_fetch(&_service.readableEventsCount, 1);
+					char buf[256];
+					size_t bytesRead = socket().read(buf, sizeof(buf), isl::Timeout());
+					if (std::string(buf, bytesRead) == "quit") {
+						__sync_add_and_fetch(&_service.finishedTasksCount, 1);
+						return false;
+					}
+					_pendingData.append(buf, bytesRead);
+				}
+				return true;
+			}
+			virtual bool awaitWritable() const
+			{
+				return !_pendingData.empty();
+			}
+
+			DuplexEchoService& _service;
+			std::string _pendingData;
+		};
+
+		virtual AbstractTask * createTask(isl::TcpSocket& socket)
+		{
+			return new EchoTask(socket, *this);
+		}
+	};
+
+	virtual void SetUp()
+	{
+		// Looking for the free port
+		isl::TcpSocket socket;
+		socket.open();
+		socket.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+		port = socket.localEndpoint().port;
+	}
+
+	isl::TcpSocket * connect() const
+	{
+		std::auto_ptr<isl::TcpSocket> socketAutoPtr(new isl::TcpSocket());
+		socketAutoPtr->open();
+		if (!socketAutoPtr->connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", port), isl::Timeout(1.0))) {
+			return 0;
+		}
+		return socketAutoPtr.release();
+	}
+	static std::string echo(isl::TcpSocket& socket, const std::string& data)
+	{
+		socket.write(data.data(), data.size(), isl::Timeout(1.0));
+		std::string result;
+		isl::Timestamp limit = isl::Timestamp::limit(isl::Timeout(1.0));
+		while (result.size() < data.size() && isl::Timestamp::now() < limit) {
+			char buf[256];
+			size_t bytesRead = socket.read(buf, sizeof(buf), limit.leftTo());
+			result.append(buf, bytesRead);
+		}
+		return result;
+	}
+
+	unsigned int port;
+};
+
+TEST_F(AsyncTcpServiceTest, DuplexModeStartsOneWorkerPerClient)
+{
+	DuplexEchoService service(3);
+	service.setDispatcherShardsAmount(2);
+	service.start();
+	EXPECT_EQ(service.maxClients(), service.workersAmount());
+	service.stop();
+	service.setDuplexMode(false);
+	service.start();
+	EXPECT_EQ(service.maxClients() * 2, service.workersAmount());
+	service.stop();
+}
+
+TEST_F(AsyncTcpServiceTest, DuplexTaskAwaitsWritableOnDemand)
+{
+	DuplexEchoService service(2);
+	service.addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", port));
+	service.start();
+	usleep(50000);
+	std::auto_ptr<isl::TcpSocket> clientAutoPtr(connect());
+	ASSERT_TRUE(clientAutoPtr.get() != 0);
+	EXPECT_EQ("ping", echo(*clientAutoPtr.get(), "ping"));
+	EXPECT_EQ("pong", echo(*clientAutoPtr.get(), "pong"));
+	EXPECT_EQ(2, __sync_add_and_fetch(&service.readableEventsCount, 0));
+	EXPECT_EQ(2, __sync_add_and_fetch(&service.writableEventsCount, 0));
+	// Task is not awaiting for the writable socket after the data has been sent, so it is not woken up by it
+	usleep(200000);
+	EXPECT_EQ(2, __sync_add_and_fetch(&service.writableEventsCount, 0));
+	EXPECT_EQ(0, __sync_add_and_fetch(&service.unexpectedWritableEventsCount, 0));
+	service.stop();
+}
+
+TEST_F(AsyncTcpServiceTest, DuplexTaskIsFinishedByIOEventHandler)
+{
+	DuplexEchoService service(1);
+	service.addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", port));
+	service.start();
+	usleep(50000);
+	std::auto_ptr<isl::TcpSocket> clientAutoPtr(connect());
+	ASSERT_TRUE(clientAutoPtr.get() != 0);
+	EXPECT_EQ("ping", echo(*clientAutoPtr.get(), "ping"));
+	clientAutoPtr->write("quit", 4, isl::Timeout(1.0));
+	// Connection is closed by the finished task
+	char buf[16];
+	EXPECT_THROW(clientAutoPtr->read(buf, sizeof(buf), isl::Timeout(1.0)), isl::Exception);
+	EXPECT_EQ(1, __sync_add_and_fetch(&service.finishedTasksCount, 0));
+	// Worker of the only client is released, so the next client is served
+	std::auto_ptr<isl::TcpSocket> nextClientAutoPtr(connect());
+	ASSERT_TRUE(nextClientAutoPtr.get() != 0);
+	EXPECT_EQ("pong", echo(*nextClientAutoPtr.get(), "pong"));
+	service.stop();
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include <isl/AbstractReactorTcpService.hxx>
+#include <isl/TcpSocket.hxx>
+#include <isl/Thread.hxx>
+#include <isl/IoUring.hxx>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+// Services are listening on the loopback interface, so no network access is needed
+
+class ReactorTcpServiceTest : public ::testing::Test
+{
+protected:
+	// Echo service which counts overload events
+	class EchoService : public isl::AbstractReactorTcpService
+	{
+	public:
+		EchoService(size_t workersAmount, const isl::Timeout& idleTimeout = isl::Timeout(), const isl::Timeout& clockTimeout = isl::Timeout::defaultTimeout()) :
+			AbstractReactorTcpService(0, workersAmount, 1, clockTimeout),
+			overloadsCount(0),
+			_idleTimeout(idleTimeout)
+		{}
+
+		int overloadsCount;
+	private:
+		class EchoTask : public AbstractTask
+		{
+		public:
+			EchoTask(isl::TcpSocket& socket, const isl::Timeout& idleTimeout) :
+				AbstractTask(socket)
+			{
+				setTimeout(idleTimeout);
+			}
+
+			virtual bool onReadable()
+			{
+				char buf[4096];
+				size_t bytesRead = socket().read(buf, sizeof(buf), isl::Timeout());
+				if (bytesRead > 0) {
+					socket().write(buf, bytesRead, isl::Timeout(1.0));
+				}
+				return true;
+			}
+		};
+
+		virtual AbstractTask * createTask(isl::TcpSocket& socket)
+		{
+			return new EchoTask(socket, _idleTimeout);
+		}
+		virtual void onOverload(AbstractTask& task)
+		{
+			__sync_add_and_fetch(&overloadsCount, 1);
+		}
+
+		const isl::Timeout _idleTimeout;
+	};
+
+	// Keeps sending to the connection until stopped
+	class Sender
+	{
+	public:
+		Sender(isl::TcpSocket& socket) :
+			_socket(socket),
+			_shouldStop(false)
+		{}
+
+		void run()
+		{
+			while (!__atomic_load_n(&_shouldStop, __ATOMIC_ACQUIRE)) {
+				try {
+					_socket.write("x", 1, isl::Timeout(0.01));
+				} catch (...) {
+					return;
+				}
+				usleep(1000);
+			}
+		}
+		void stop()
+		{
+			__atomic_store_n(&_shouldStop, true, __ATOMIC_RELEASE);
+		}
+	private:
+		isl::TcpSocket& _socket;
+		bool _shouldStop;
+	};
+
+	virtual void SetUp()
+	{
+		// Looking for the free port
+		isl::TcpSocket socket;
+		socket.open();
+		socket.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+		port = socket.localEndpoint().port;
+	}
+
+	isl::TcpAddrInfo serviceAddr() const
+	{
+		return isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", port);
+	}
+	isl::TcpSocket * connect() const
+	{
+		std::auto_ptr<isl::TcpSocket> socketAutoPtr(new isl::TcpSocket());
+		socketAutoPtr->open();
+		if (!socketAutoPtr->connect(serviceAddr(), isl::Timeout(1.0))) {
+			return 0;
+		}
+		return socketAutoPtr.release();
+	}
+	static std::string echo(isl::TcpSocket& socket, const std::string& data)
+	{
+		socket.write(data.data(), data.size(), isl::Timeout(1.0));
+		std::string result;
+		isl::Timestamp limit = isl::Timestamp::limit(isl::Timeout(1.0));
+		while (result.size() < data.size() && isl::Timestamp::now() < limit) {
+			char buf[256];
+			size_t bytesRead = socket.read(buf, sizeof(buf), limit.leftTo());
+			result.append(buf, bytesRead);
+		}
+		return result;
+	}
+
+	unsigned int port;
+};
+
+TEST_F(ReactorTcpServiceTest, ConnectionsOutnumberWorkers)
+{
+	const size_t connectionsAmount = 64;
+	EchoService service(2);
+	service.addListener(serviceAddr(), 128);
+	service.start();
+	usleep(50000);
+	std::vector<isl::TcpSocket *> clients;
+	for (size_t i = 0; i < connectionsAmount; ++i) {
+		isl::TcpSocket * clientPtr = connect();
+		ASSERT_TRUE(clientPtr != 0);
+		clients.push_back(clientPtr);
+	}
+	for (size_t i = 0; i < connectionsAmount; ++i) {
+		EXPECT_EQ("ping", echo(*clients[i], "ping"));
+	}
+	EXPECT_EQ(connectionsAmount, service.connectionsAmount());
+	// Connection closed by the client is removed from the reactor
+	delete clients.back();
+	clients.pop_back();
+	usleep(100000);
+	EXPECT_EQ(connectionsAmount - 1, service.connectionsAmount());
+	service.stop();
+	for (size_t i = 0; i < clients.size(); ++i) {
+		delete clients[i];
+	}
+	EXPECT_EQ(0, service.overloadsCount);
+}
+
+TEST_F(ReactorTcpServiceTest, IdleConnectionIsClosedOnTimeout)
+{
+	EchoService service(1, isl::Timeout(0.1));
+	service.addListener(serviceAddr());
+	service.start();
+	usleep(50000);
+	std::auto_ptr<isl::TcpSocket> clientAutoPtr(connect());
+	ASSERT_TRUE(clientAutoPtr.get() != 0);
+	EXPECT_EQ("ping", echo(*clientAutoPtr.get(), "ping"));
+	// Deadline is re-armed after each event
+	usleep(50000);
+	EXPECT_EQ("pong", echo(*clientAutoPtr.get(), "pong"));
+	usleep(300000);
+	EXPECT_EQ(0U, service.connectionsAmount());
+	char buf[16];
+	EXPECT_THROW(clientAutoPtr->read(buf, sizeof(buf), isl::Timeout(1.0)), isl::Exception);
+	service.stop();
+}
+
+TEST_F(ReactorTcpServiceTest, OverloadIsNotReportedOnStop)
+{
+	const size_t sendersAmount = 8;
+	EchoService service(2, isl::Timeout(), isl::Timeout(0.2));
+	service.addListener(serviceAddr());
+	service.start();
+	usleep(50000);
+	std::vector<isl::TcpSocket *> clients;
+	std::vector<Sender *> senders;
+	std::vector<isl::Thread *> threads;
+	for (size_t i = 0; i < sendersAmount; ++i) {
+		isl::TcpSocket * clientPtr = connect();
+		ASSERT_TRUE(clientPtr != 0);
+		clients.push_back(clientPtr);
+		senders.push_back(new Sender(*clientPtr));
+		threads.push_back(new isl::Thread());
+		threads.back()->start(*senders.back(), &Sender::run);
+	}
+	usleep(50000);
+	// I/O-events keep arriving while the service is stopping
+	service.stop();
+	for (size_t i = 0; i < sendersAmount; ++i) {
+		senders[i]->stop();
+		threads[i]->join();
+		delete threads[i];
+		delete senders[i];
+		delete clients[i];
+	}
+	EXPECT_EQ(0, service.overloadsCount);
+}
+
+TEST_F(ReactorTcpServiceTest, ListenerIsRestartedWithIoUringAcceptor)
+{
+	const size_t connectionsAmount = 16;
+	if (!isl::IoUring::isSupported()) {
+		std::cout << "io_uring(7) is not supported, skipping the test" << std::endl;
+		return;
+	}
+	isl::IoUring::setEnabled(true);
+	for (size_t run = 0; run < 2; ++run) {
+		EchoService service(1);
+		service.addListener(serviceAddr(), 64);
+		service.start();
+		usleep(50000);
+		std::vector<isl::TcpSocket *> clients;
+		for (size_t i = 0; i < connectionsAmount; ++i) {
+			isl::TcpSocket * clientPtr = connect();
+			ASSERT_TRUE(clientPtr != 0);
+			clients.push_back(clientPtr);
+		}
+		for (size_t i = 0; i < connectionsAmount; ++i) {
+			EXPECT_EQ("ping", echo(*clients[i], "ping"));
+		}
+		EXPECT_EQ(connectionsAmount, service.connectionsAmount());
+		// Pending accept operations are cancelled on stop, so the port is listened by the next run only
+		service.stop();
+		for (size_t i = 0; i < clients.size(); ++i) {
+			delete clients[i];
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <isl/AbstractSyncTcpService.hxx>
+#include <dirent.h>
+#include <unistd.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+
+class SyncTcpServiceTest : public ::testing::Test
+{
+protected:
+	// Service without listeners, so only it's task dispatcher shards are started
+	class IdleService : public isl::AbstractSyncTcpService
+	{
+	public:
+		IdleService(size_t maxClients) :
+			AbstractSyncTcpService(0, maxClients)
+		{}
+
+		// Creates the listener using the factory method of the previous versions
+		bool createPreviousListener()
+		{
+			std::auto_ptr<ListenerThread> listenerAutoPtr(createListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0), 16));
+			return listenerAutoPtr.get() != 0;
+		}
+	private:
+		virtual AbstractTask * createTask(isl::TcpSocket& socket)
+		{
+			return 0;
+		}
+	};
+
+	// Returns the amounts of the process' threads by their names
+	static std::map<std::string, size_t> threadNames()
+	{
+		std::map<std::string, size_t> result;
+		DIR * dir = opendir("/proc/self/task");
+		if (!dir) {
+			return result;
+		}
+		while (struct dirent * entry = readdir(dir)) {
+			if (entry->d_name[0] == '.') {
+				continue;
+			}
+			std::ifstream file((std::string("/proc/self/task/") + entry->d_name + "/comm").c_str());
+			std::string name;
+			if (std::getline(file, name)) {
+				++result[name];
+			}
+		}
+		closedir(dir);
+		return result;
+	}
+};
+
+TEST_F(SyncTcpServiceTest, WorkersAmountIsSplitBetweenShardsExactly)
+{
+	IdleService service(5);
+	service.setDispatcherShardsAmount(2);
+	service.start();
+	EXPECT_EQ(5U, service.runningWorkersAmount());
+	service.stop();
+}
+
+TEST_F(SyncTcpServiceTest, ShardsAmountIsReducedToMaxClients)
+{
+	IdleService service(3);
+	service.setDispatcherShardsAmount(4);
+	service.start();
+	EXPECT_EQ(3U, service.runningWorkersAmount());
+	service.stop();
+}
+
+TEST_F(SyncTcpServiceTest, WorkersOfShardsAreNumberedThrough)
+{
+	IdleService service(5);
+	service.setDispatcherShardsAmount(2);
+	service.start();
+	usleep(50000);
+	std::map<std::string, size_t> names = threadNames();
+	for (size_t i = 0; i < 5; ++i) {
+		std::ostringstream name;
+		name << "worker-" << i;
+		EXPECT_EQ(1U, names[name.str()]) << name.str();
+	}
+	EXPECT_EQ(0U, names["worker-5"]);
+	service.stop();
+}
+
+TEST_F(SyncTcpServiceTest, SupervisorsAreNotPlacedAsWorkers)
+{
+	IdleService service(6);
+	service.setDispatcherShardsAmount(2);
+	service.setElasticWorkers(true, 2);
+	service.start();
+	usleep(50000);
+	std::map<std::string, size_t> names = threadNames();
+	// Each shard starts with one of it's three workers
+	EXPECT_EQ(1U, names["worker-0"]);
+	EXPECT_EQ(1U, names["worker-3"]);
+	EXPECT_EQ(2U, names["supervisor-0"]);
+	service.stop();
+}
+
+TEST_F(SyncTcpServiceTest, PreviousListenerFactoryMethodIsForwarded)
+{
+	IdleService service(1);
+	EXPECT_TRUE(service.createPreviousListener());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <isl/TcpConnectionPool.hxx>
+#include <isl/TcpSocket.hxx>
+#include <unistd.h>
+#include <memory>
+
+// Upstream is listening on the loopback interface, so no network access is needed
+
+class TcpConnectionPoolTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		listener.open();
+		listener.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+		listener.listen(16);
+	}
+
+	isl::TcpAddrInfo upstreamAddr() const
+	{
+		return isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", listener.localEndpoint().port);
+	}
+
+	isl::TcpSocket listener;
+};
+
+TEST_F(TcpConnectionPoolTest, ConnectionIsReused)
+{
+	isl::TcpAddrInfo upstream = upstreamAddr();
+	isl::TcpConnectionPool pool(0);
+	std::auto_ptr<isl::TcpSocket> socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	ASSERT_TRUE(socketAutoPtr.get() != 0);
+	isl::TcpSocket * socketPtr = socketAutoPtr.get();
+	std::auto_ptr<isl::TcpSocket> peerAutoPtr = listener.accept(isl::Timeout(1.0));
+	ASSERT_TRUE(peerAutoPtr.get() != 0);
+	pool.giveBack(upstream, socketAutoPtr);
+	EXPECT_EQ(1U, pool.idleAmount(upstream));
+	EXPECT_EQ(0U, pool.borrowedAmount(upstream));
+	socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	EXPECT_EQ(socketPtr, socketAutoPtr.get());
+	EXPECT_EQ(0U, pool.idleAmount(upstream));
+	EXPECT_EQ(1U, pool.borrowedAmount(upstream));
+	// No new connection has been established
+	EXPECT_TRUE(listener.accept(isl::Timeout(0.05)).get() == 0);
+	pool.giveBack(upstream, socketAutoPtr);
+}
+
+TEST_F(TcpConnectionPoolTest, ClosedIdleConnectionIsDiscardedOnCheckout)
+{
+	isl::TcpAddrInfo upstream = upstreamAddr();
+	isl::TcpConnectionPool pool(0);
+	std::auto_ptr<isl::TcpSocket> socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	ASSERT_TRUE(socketAutoPtr.get() != 0);
+	std::auto_ptr<isl::TcpSocket> peerAutoPtr = listener.accept(isl::Timeout(1.0));
+	ASSERT_TRUE(peerAutoPtr.get() != 0);
+	pool.giveBack(upstream, socketAutoPtr);
+	// Peer is closing the idle connection
+	peerAutoPtr->close();
+	usleep(20000);
+	socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	ASSERT_TRUE(socketAutoPtr.get() != 0);
+	EXPECT_EQ(0U, pool.idleAmount(upstream));
+	EXPECT_EQ(1U, pool.borrowedAmount(upstream));
+	// New connection has been established instead of the closed one
+	peerAutoPtr = listener.accept(isl::Timeout(1.0));
+	ASSERT_TRUE(peerAutoPtr.get() != 0);
+	socketAutoPtr->write("ping", 4);
+	char buffer[16];
+	EXPECT_EQ(4U, peerAutoPtr->read(buffer, sizeof(buffer), isl::Timeout(1.0)));
+	pool.giveBack(upstream, socketAutoPtr);
+}
+
+TEST_F(TcpConnectionPoolTest, ExhaustedPoolWaitsForGiveBack)
+{
+	isl::TcpAddrInfo upstream = upstreamAddr();
+	isl::TcpConnectionPool pool(0);
+	pool.setMaxConnections(1);
+	std::auto_ptr<isl::TcpSocket> socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	ASSERT_TRUE(socketAutoPtr.get() != 0);
+	EXPECT_TRUE(pool.borrow(upstream, isl::Timeout(0.05)).get() == 0);
+	EXPECT_EQ(1U, pool.borrowedAmount(upstream));
+	pool.giveBack(upstream, socketAutoPtr, false);
+	EXPECT_EQ(0U, pool.borrowedAmount(upstream));
+	socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	EXPECT_TRUE(socketAutoPtr.get() != 0);
+	pool.giveBack(upstream, socketAutoPtr);
+}
+
+TEST_F(TcpConnectionPoolTest, EvictorClosesExpiredConnections)
+{
+	isl::TcpAddrInfo upstream = upstreamAddr();
+	isl::TcpConnectionPool pool(0, isl::Timeout(0.02));
+	pool.setIdleTimeout(isl::Timeout(0.05));
+	std::auto_ptr<isl::TcpSocket> socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	ASSERT_TRUE(socketAutoPtr.get() != 0);
+	pool.giveBack(upstream, socketAutoPtr);
+	ASSERT_EQ(1U, pool.idleAmount(upstream));
+	pool.start();
+	usleep(200000);
+	EXPECT_EQ(0U, pool.idleAmount(upstream));
+	EXPECT_EQ(0U, pool.borrowedAmount(upstream));
+	pool.stop();
+}
+
+TEST_F(TcpConnectionPoolTest, MinIdleConnectionsAreEstablished)
+{
+	isl::TcpAddrInfo upstream = upstreamAddr();
+	isl::TcpConnectionPool pool(0, isl::Timeout(0.02));
+	pool.setMinIdleConnections(2);
+	// Endpoint becomes known to the pool on the first borrowing
+	std::auto_ptr<isl::TcpSocket> socketAutoPtr = pool.borrow(upstream, isl::Timeout(1.0));
+	ASSERT_TRUE(socketAutoPtr.get() != 0);
+	pool.giveBack(upstream, socketAutoPtr);
+	pool.start();
+	usleep(200000);
+	EXPECT_EQ(2U, pool.idleAmount(upstream));
+	EXPECT_EQ(0U, pool.borrowedAmount(upstream));
+	pool.stop();
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
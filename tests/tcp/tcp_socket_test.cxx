@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <isl/TcpSocket.hxx>
+#include <isl/TcpSocketOptions.hxx>
+#include <isl/SharedBuffer.hxx>
+#include <isl/Exception.hxx>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <time.h>
+#include <string>
+#include <memory>
+
+// Sockets are connected over the loopback interface, so no network access is needed
+
+class TcpSocketTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		listener.open();
+		listener.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+		listener.listen(16);
+		client.open();
+		client.connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", listener.localEndpoint().port));
+		serverAutoPtr = listener.accept(isl::Timeout(1.0));
+		ASSERT_TRUE(serverAutoPtr.get() != 0);
+	}
+
+	static double threadCpuTime()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1000000000.0;
+	}
+
+	isl::TcpSocket listener;
+	isl::TcpSocket client;
+	std::auto_ptr<isl::TcpSocket> serverAutoPtr;
+};
+
+TEST_F(TcpSocketTest, ReadWhileZeroCopySendIsPending)
+{
+	isl::TcpSocket& server = *serverAutoPtr.get();
+	try {
+		server.enableZeroCopy(0);
+	} catch (isl::Exception& e) {
+		std::cout << "SO_ZEROCOPY is not supported by the kernel, skipping the test" << std::endl;
+		return;
+	}
+	isl::SharedBuffer buffer(std::string(65536, 'x'));
+	ASSERT_GT(server.sendShared(buffer, 0, isl::Timeout(1.0)), 0U);
+	EXPECT_EQ(1U, server.pendingZeroCopySends());
+	// Awaiting the completion to be queued on the error queue without reaping it
+	struct pollfd fds;
+	fds.fd = server.descriptor();
+	fds.events = 0;
+	fds.revents = 0;
+	ASSERT_EQ(1, poll(&fds, 1, 1000));
+	ASSERT_TRUE(fds.revents & POLLERR);
+	EXPECT_EQ(1U, server.pendingZeroCopySends());
+	// Read is waiting for the data instead of spinning on POLLERR and reaps the completion
+	char readBuffer[16];
+	double cpuTimeStarted = threadCpuTime();
+	EXPECT_EQ(0U, server.read(readBuffer, sizeof(readBuffer), isl::Timeout(0.5)));
+	EXPECT_LT(threadCpuTime() - cpuTimeStarted, 0.1);
+	EXPECT_EQ(0U, server.pendingZeroCopySends());
+	// Socket is still usable after the completion has been reaped
+	client.write("ping", 4);
+	EXPECT_EQ(4U, server.read(readBuffer, sizeof(readBuffer), isl::Timeout(1.0)));
+}
+
+TEST_F(TcpSocketTest, RacingConnectionKeepsSocketOptions)
+{
+	isl::TcpSocket socket;
+	socket.open();
+	isl::TcpSocketOptions options;
+	options.setNoDelay(true);
+	options.setReceiveBufferSize(65536);
+	socket.applyOptions(options);
+	bool zeroCopyEnabled = true;
+	try {
+		socket.enableZeroCopy(1024);
+	} catch (isl::Exception& e) {
+		zeroCopyEnabled = false;
+	}
+	ASSERT_TRUE(socket.connectRacing(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", listener.localEndpoint().port), isl::Timeout(1.0)));
+	int noDelay = 0;
+	socklen_t noDelaySize = sizeof(noDelay);
+	ASSERT_EQ(0, getsockopt(socket.descriptor(), IPPROTO_TCP, TCP_NODELAY, &noDelay, &noDelaySize));
+	EXPECT_NE(0, noDelay);
+	int receiveBufferSize = 0;
+	socklen_t receiveBufferSizeSize = sizeof(receiveBufferSize);
+	ASSERT_EQ(0, getsockopt(socket.descriptor(), SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, &receiveBufferSizeSize));
+	// Kernel is doubling the value set
+	EXPECT_GE(receiveBufferSize, 65536);
+	EXPECT_EQ(zeroCopyEnabled, socket.isZeroCopy());
+	std::auto_ptr<isl::TcpSocket> acceptedAutoPtr = listener.accept(isl::Timeout(1.0));
+	ASSERT_TRUE(acceptedAutoPtr.get() != 0);
+	EXPECT_EQ(socket.localEndpoint().port, acceptedAutoPtr->remoteEndpoint().port);
+}
+
+TEST_F(TcpSocketTest, AddressInfoSurvivesReconnection)
+{
+	isl::TcpSocket otherListener;
+	otherListener.open();
+	otherListener.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+	otherListener.listen(16);
+	isl::TcpSocket socket;
+	socket.open();
+	ASSERT_TRUE(socket.connectRacing(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", listener.localEndpoint().port), isl::Timeout(1.0)));
+	isl::TcpAddrInfo remoteAddr = socket.remoteAddr();
+	socket.close();
+	socket.open();
+	// Cached address info is discarded on reconnection
+	ASSERT_TRUE(socket.connectRacing(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", otherListener.localEndpoint().port), isl::Timeout(1.0)));
+	EXPECT_EQ(listener.localEndpoint().port, remoteAddr.firstEndpoint().port);
+	EXPECT_EQ(otherListener.localEndpoint().port, socket.remoteAddr().firstEndpoint().port);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
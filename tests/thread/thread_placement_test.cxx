@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <isl/ThreadPlacement.hxx>
+
+class ThreadPlacementTest : public ::testing::Test
+{
+protected:
+	static isl::ThreadPlacement::CpusContainer cpus(int first, int second, int third)
+	{
+		isl::ThreadPlacement::CpusContainer result;
+		result.push_back(first);
+		result.push_back(second);
+		result.push_back(third);
+		return result;
+	}
+};
+
+TEST_F(ThreadPlacementTest, ListIsParsed)
+{
+	std::vector<int> list = isl::ThreadPlacement::parseList("0-3,8,10-11");
+	const int expectedList[] = {0, 1, 2, 3, 8, 10, 11};
+	EXPECT_EQ(std::vector<int>(expectedList, expectedList + sizeof(expectedList) / sizeof(int)), list);
+	EXPECT_EQ(std::vector<int>(1, 5), isl::ThreadPlacement::parseList("5\n"));
+	EXPECT_TRUE(isl::ThreadPlacement::parseList("").empty());
+}
+
+TEST_F(ThreadPlacementTest, MalformedRangesAreSkipped)
+{
+	std::vector<int> list = isl::ThreadPlacement::parseList("x,1,,-2,3-4");
+	const int expectedList[] = {1, 3, 4};
+	EXPECT_EQ(std::vector<int>(expectedList, expectedList + sizeof(expectedList) / sizeof(int)), list);
+	// Reversed range is empty
+	EXPECT_TRUE(isl::ThreadPlacement::parseList("7-6").empty());
+}
+
+TEST_F(ThreadPlacementTest, PinModePlacesThreadsRoundRobin)
+{
+	isl::ThreadPlacementPolicy policy(isl::ThreadPlacementPolicy::PinMode, cpus(4, 6, 8), "worker");
+	policy.setSchedulingPolicy(isl::ThreadPlacement::BatchPolicy);
+	for (size_t i = 0; i < 4; ++i) {
+		isl::ThreadPlacement placement = policy.placement(i);
+		ASSERT_EQ(1U, placement.cpus().size());
+		EXPECT_EQ(cpus(4, 6, 8)[i % 3], placement.cpus()[0]);
+		EXPECT_EQ(isl::ThreadPlacement::BatchPolicy, placement.schedulingPolicy());
+		EXPECT_EQ(-1, placement.numaNode());
+	}
+	EXPECT_EQ("worker-0", policy.placement(0).name());
+	EXPECT_EQ("worker-3", policy.placement(3).name());
+}
+
+TEST_F(ThreadPlacementTest, FirstThreadIndexOffsetsPlacement)
+{
+	isl::ThreadPlacementPolicy policy(isl::ThreadPlacementPolicy::PinMode, cpus(4, 6, 8), "worker");
+	policy.setFirstThreadIndex(2);
+	EXPECT_EQ("worker-2", policy.placement(0).name());
+	EXPECT_EQ(8, policy.placement(0).cpus()[0]);
+	EXPECT_EQ("worker-3", policy.placement(1).name());
+	EXPECT_EQ(4, policy.placement(1).cpus()[0]);
+}
+
+TEST_F(ThreadPlacementTest, SpreadAndFloatModesDoNotPinThreads)
+{
+	isl::ThreadPlacementPolicy spreadPolicy(isl::ThreadPlacementPolicy::SpreadMode, cpus(4, 6, 8));
+	EXPECT_EQ(cpus(4, 6, 8), spreadPolicy.placement(0).cpus());
+	EXPECT_EQ(cpus(4, 6, 8), spreadPolicy.placement(5).cpus());
+	EXPECT_TRUE(spreadPolicy.placement(0).name().empty());
+	isl::ThreadPlacementPolicy floatPolicy;
+	EXPECT_TRUE(floatPolicy.placement(0).isEmpty());
+	EXPECT_TRUE(floatPolicy.placement(7).isEmpty());
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <isl/TimingWheel.hxx>
+#include <isl/Exception.hxx>
+
+class TimingWheelTest : public ::testing::Test
+{
+protected:
+	// Timer which counts it's expirations and re-schedules itself if requested
+	class CountingTimer : public isl::TimingWheel::AbstractTimer
+	{
+	public:
+		CountingTimer(isl::TimingWheel& wheel) :
+			expirationsCount(0),
+			rescheduleLimit(),
+			_wheel(wheel)
+		{}
+
+		virtual void onExpired()
+		{
+			++expirationsCount;
+			if (!rescheduleLimit.isZero()) {
+				_wheel.schedule(*this, rescheduleLimit);
+				rescheduleLimit = isl::Timestamp();
+			}
+		}
+
+		size_t expirationsCount;
+		isl::Timestamp rescheduleLimit;
+	private:
+		isl::TimingWheel& _wheel;
+	};
+};
+
+TEST_F(TimingWheelTest, TimerIsNotExpiredBeforeDeadline)
+{
+	isl::TimingWheel wheel(isl::Timeout(0.01), 16);
+	isl::Timestamp start = isl::Timestamp::now();
+	CountingTimer timer(wheel);
+	wheel.schedule(timer, start + isl::Timeout(0.05));
+	EXPECT_TRUE(timer.isScheduled());
+	EXPECT_EQ(1U, wheel.size());
+	EXPECT_EQ(0U, wheel.advance(start + isl::Timeout(0.04)));
+	EXPECT_EQ(0U, timer.expirationsCount);
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.07)));
+	EXPECT_EQ(1U, timer.expirationsCount);
+	EXPECT_FALSE(timer.isScheduled());
+	EXPECT_TRUE(wheel.isEmpty());
+	// Expired timer is not expired again
+	EXPECT_EQ(0U, wheel.advance(start + isl::Timeout(0.5)));
+	EXPECT_EQ(1U, timer.expirationsCount);
+}
+
+TEST_F(TimingWheelTest, ReachedDeadlineExpiresOnNextTick)
+{
+	isl::TimingWheel wheel(isl::Timeout(0.01), 16);
+	isl::Timestamp start = isl::Timestamp::now();
+	wheel.advance(start + isl::Timeout(0.1));
+	CountingTimer timer(wheel);
+	wheel.schedule(timer, start);
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.12)));
+	EXPECT_EQ(1U, timer.expirationsCount);
+}
+
+TEST_F(TimingWheelTest, CancelledTimerIsNotExpired)
+{
+	isl::TimingWheel wheel(isl::Timeout(0.01), 16);
+	isl::Timestamp start = isl::Timestamp::now();
+	CountingTimer cancelledTimer(wheel);
+	CountingTimer timer(wheel);
+	wheel.schedule(cancelledTimer, start + isl::Timeout(0.03));
+	wheel.schedule(timer, start + isl::Timeout(0.03));
+	{
+		// Destructor cancels the timer
+		CountingTimer destroyedTimer(wheel);
+		wheel.schedule(destroyedTimer, start + isl::Timeout(0.03));
+		EXPECT_EQ(3U, wheel.size());
+	}
+	wheel.cancel(cancelledTimer);
+	EXPECT_FALSE(cancelledTimer.isScheduled());
+	EXPECT_EQ(1U, wheel.size());
+	// Cancelling of the timer which is not scheduled does nothing
+	wheel.cancel(cancelledTimer);
+	EXPECT_EQ(1U, wheel.size());
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.1)));
+	EXPECT_EQ(0U, cancelledTimer.expirationsCount);
+	EXPECT_EQ(1U, timer.expirationsCount);
+}
+
+TEST_F(TimingWheelTest, RescheduledTimerExpiresOnNewDeadline)
+{
+	isl::TimingWheel wheel(isl::Timeout(0.01), 16);
+	isl::Timestamp start = isl::Timestamp::now();
+	CountingTimer timer(wheel);
+	wheel.schedule(timer, start + isl::Timeout(0.03));
+	wheel.schedule(timer, start + isl::Timeout(0.08));
+	EXPECT_EQ(1U, wheel.size());
+	EXPECT_EQ(0U, wheel.advance(start + isl::Timeout(0.06)));
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.1)));
+	EXPECT_EQ(timer.limit(), start + isl::Timeout(0.08));
+}
+
+TEST_F(TimingWheelTest, TimerIsRescheduledFromHandler)
+{
+	isl::TimingWheel wheel(isl::Timeout(0.01), 16);
+	isl::Timestamp start = isl::Timestamp::now();
+	CountingTimer timer(wheel);
+	wheel.schedule(timer, start + isl::Timeout(0.02));
+	timer.rescheduleLimit = start + isl::Timeout(0.06);
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.04)));
+	EXPECT_TRUE(timer.isScheduled());
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.08)));
+	EXPECT_EQ(2U, timer.expirationsCount);
+	EXPECT_TRUE(wheel.isEmpty());
+}
+
+TEST_F(TimingWheelTest, FarTimerSharingSlotIsExpiredOnItsRevolution)
+{
+	// Wheel revolution is 40 milliseconds, so the timers are sharing the slot
+	isl::TimingWheel wheel(isl::Timeout(0.01), 4);
+	isl::Timestamp start = isl::Timestamp::now();
+	CountingTimer nearTimer(wheel);
+	CountingTimer farTimer(wheel);
+	wheel.schedule(nearTimer, start + isl::Timeout(0.015));
+	wheel.schedule(farTimer, start + isl::Timeout(0.055));
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.035)));
+	EXPECT_EQ(1U, nearTimer.expirationsCount);
+	EXPECT_EQ(0U, farTimer.expirationsCount);
+	EXPECT_EQ(1U, wheel.advance(start + isl::Timeout(0.075)));
+	EXPECT_EQ(1U, farTimer.expirationsCount);
+}
+
+TEST_F(TimingWheelTest, AllTimersExpireWhenMoreThanRevolutionHasPassed)
+{
+	isl::TimingWheel wheel(isl::Timeout(0.01), 4);
+	isl::Timestamp start = isl::Timestamp::now();
+	CountingTimer firstTimer(wheel);
+	CountingTimer secondTimer(wheel);
+	CountingTimer thirdTimer(wheel);
+	wheel.schedule(firstTimer, start + isl::Timeout(0.01));
+	wheel.schedule(secondTimer, start + isl::Timeout(0.05));
+	wheel.schedule(thirdTimer, start + isl::Timeout(0.13));
+	EXPECT_EQ(3U, wheel.advance(start + isl::Timeout(1.0)));
+	EXPECT_TRUE(wheel.isEmpty());
+}
+
+TEST_F(TimingWheelTest, ZeroResolutionIsRejected)
+{
+	EXPECT_THROW(isl::TimingWheel(isl::Timeout(0.0)), isl::Exception);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
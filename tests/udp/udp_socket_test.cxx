@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <isl/UdpSocket.hxx>
+#include <isl/AbstractUdpService.hxx>
+#include <isl/Exception.hxx>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <string>
+#include <set>
+
+// Sockets are bound to the loopback interface, so no network access is needed
+
+#define SERVICE_PORT 18893			// UDP-port of the echo service
+
+class UdpSocketTest : public ::testing::Test
+{
+protected:
+	// Echo service, which replies with the upper-cased datagram
+	class EchoService : public isl::AbstractUdpService
+	{
+	public:
+		EchoService() :
+			AbstractUdpService(0, isl::Timeout(0.05))
+		{}
+	private:
+		virtual void onReceive(const isl::UdpSocket::Batch& datagrams, isl::UdpSocket::Batch& replies)
+		{
+			for (size_t i = 0; i < datagrams.size(); ++i) {
+				std::string reply(datagrams.data(i), datagrams.dataSize(i));
+				for (size_t j = 0; j < reply.size(); ++j) {
+					reply[j] = toupper(reply[j]);
+				}
+				replies.appendReply(reply.data(), reply.size(), datagrams, i);
+			}
+		}
+	};
+
+	static unsigned int localPort(const isl::UdpSocket& socket)
+	{
+		struct sockaddr_in addr;
+		socklen_t addrLen = sizeof(addr);
+		getsockname(socket.descriptor(), reinterpret_cast<struct sockaddr *>(&addr), &addrLen);
+		return ntohs(addr.sin_port);
+	}
+};
+
+TEST_F(UdpSocketTest, BatchIsSentAndReceivedAtOnce)
+{
+	isl::UdpSocket receiver;
+	receiver.open();
+	receiver.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+	isl::UdpSocket sender;
+	sender.open();
+	sender.connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", localPort(receiver)));
+	isl::UdpSocket::Batch outgoing(8, 64);
+	for (size_t i = 0; i < outgoing.capacity(); ++i) {
+		char datagram[16];
+		int datagramSize = snprintf(datagram, sizeof(datagram), "datagram %u", static_cast<unsigned int>(i));
+		EXPECT_TRUE(outgoing.append(datagram, datagramSize));
+	}
+	EXPECT_TRUE(outgoing.isFull());
+	EXPECT_FALSE(outgoing.append("extra", 5));
+	EXPECT_EQ(8U, sender.sendBatch(outgoing, isl::Timeout(1.0)));
+	isl::UdpSocket::Batch incoming(16, 64);
+	EXPECT_EQ(8U, receiver.receiveBatch(incoming, isl::Timeout(1.0)));
+	ASSERT_EQ(8U, incoming.size());
+	for (size_t i = 0; i < incoming.size(); ++i) {
+		EXPECT_EQ(std::string(outgoing.data(i), outgoing.dataSize(i)), std::string(incoming.data(i), incoming.dataSize(i)));
+		EXPECT_FALSE(incoming.isTruncated(i));
+		EXPECT_EQ(localPort(sender), incoming.endpoint(i).port);
+	}
+	// Nothing is left, so the next receive is waiting for the timeout
+	EXPECT_EQ(0U, receiver.receiveBatch(incoming, isl::Timeout(0.05)));
+	EXPECT_TRUE(incoming.isEmpty());
+}
+
+TEST_F(UdpSocketTest, LongDatagramIsTruncated)
+{
+	isl::UdpSocket receiver;
+	receiver.open();
+	receiver.bind(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 0));
+	isl::UdpSocket sender;
+	sender.open();
+	sender.connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", localPort(receiver)));
+	std::string datagram(32, 'x');
+	EXPECT_EQ(datagram.size(), sender.write(datagram.data(), datagram.size(), isl::Timeout(1.0)));
+	isl::UdpSocket::Batch incoming(4, 8);
+	EXPECT_EQ(1U, receiver.receiveBatch(incoming, isl::Timeout(1.0)));
+	EXPECT_TRUE(incoming.isTruncated(0));
+	EXPECT_EQ(8U, incoming.dataSize(0));
+}
+
+TEST_F(UdpSocketTest, ServiceRepliesToEachDatagram)
+{
+	EchoService service;
+	service.setBatchSize(4);
+	service.addListener(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", SERVICE_PORT), 2);
+	service.start();
+	isl::UdpSocket client;
+	client.open();
+	client.connect(isl::TcpAddrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", SERVICE_PORT));
+	// Receivers are binding their sockets asynchronously -> pinging the service until it replies
+	bool serviceIsReady = false;
+	for (size_t i = 0; i < 40 && !serviceIsReady; ++i) {
+		try {
+			client.write("ping", 4, isl::Timeout(0.05));
+			char reply[4];
+			serviceIsReady = client.read(reply, sizeof(reply), isl::Timeout(0.05)) == 4;
+		} catch (isl::Exception& e) {
+			// Port is not bound yet
+			usleep(50000);
+		}
+	}
+	ASSERT_TRUE(serviceIsReady);
+	// Batch is larger than the service's one, so the replies are collected from the several receive calls
+	isl::UdpSocket::Batch requests(10, 64);
+	for (size_t i = 0; i < requests.capacity(); ++i) {
+		char datagram[16];
+		int datagramSize = snprintf(datagram, sizeof(datagram), "request %u", static_cast<unsigned int>(i));
+		requests.append(datagram, datagramSize);
+	}
+	EXPECT_EQ(10U, client.sendBatch(requests, isl::Timeout(1.0)));
+	isl::UdpSocket::Batch replies(10, 64);
+	std::set<std::string> repliesReceived;
+	isl::Timestamp limit = isl::Timestamp::limit(isl::Timeout(2.0));
+	while (repliesReceived.size() < 10 && isl::Timestamp::now() < limit) {
+		client.receiveBatch(replies, limit.leftTo());
+		for (size_t i = 0; i < replies.size(); ++i) {
+			repliesReceived.insert(std::string(replies.data(i), replies.dataSize(i)));
+		}
+	}
+	service.stop();
+	ASSERT_EQ(10U, repliesReceived.size());
+	for (size_t i = 0; i < 10; ++i) {
+		char reply[16];
+		snprintf(reply, sizeof(reply), "REQUEST %u", static_cast<unsigned int>(i));
+		EXPECT_EQ(1U, repliesReceived.count(reply));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <isl/UnixSocket.hxx>
+#include <isl/Exception.hxx>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string>
+#include <memory>
+
+class UnixSocketTest : public ::testing::Test
+{
+protected:
+	static std::string socketPath()
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/tmp/isl_unix_socket_test.%d", static_cast<int>(getpid()));
+		return path;
+	}
+};
+
+TEST_F(UnixSocketTest, ConnectionIsEstablishedOnFileAddress)
+{
+	isl::UnixAddrInfo addrInfo(socketPath());
+	unlink(addrInfo.path().c_str());
+	isl::UnixSocket listener;
+	listener.open();
+	listener.bind(addrInfo);
+	listener.listen(16);
+	EXPECT_EQ(addrInfo.path(), listener.localAddr().path());
+	isl::UnixSocket client;
+	client.open();
+	ASSERT_TRUE(client.connect(addrInfo, isl::Timeout(1.0)));
+	EXPECT_EQ(addrInfo.path(), client.remoteAddr().path());
+	std::auto_ptr<isl::TcpSocket> serverAutoPtr = listener.accept(isl::Timeout(1.0));
+	ASSERT_TRUE(serverAutoPtr.get() != 0);
+	EXPECT_EQ(addrInfo.path(), serverAutoPtr->localEndpoint().host);
+	EXPECT_EQ(0U, serverAutoPtr->localEndpoint().port);
+	client.write("ping", 4);
+	char buffer[16];
+	EXPECT_EQ(4U, serverAutoPtr->read(buffer, sizeof(buffer), isl::Timeout(1.0)));
+	EXPECT_EQ("ping", std::string(buffer, 4));
+	listener.close();
+	unlink(addrInfo.path().c_str());
+}
+
+TEST_F(UnixSocketTest, ConnectionIsEstablishedOnAbstractAddress)
+{
+	isl::UnixAddrInfo addrInfo(socketPath(), true);
+	isl::UnixSocket listener;
+	listener.open();
+	listener.bind(addrInfo);
+	listener.listen(16);
+	isl::UnixSocket client;
+	client.open();
+	client.connect(addrInfo);
+	EXPECT_TRUE(client.remoteAddr().isAbstract());
+	EXPECT_EQ(addrInfo.str(), client.remoteAddr().str());
+	std::auto_ptr<isl::TcpSocket> serverAutoPtr = listener.accept(isl::Timeout(1.0));
+	ASSERT_TRUE(serverAutoPtr.get() != 0);
+	serverAutoPtr->write("pong", 4);
+	char buffer[16];
+	EXPECT_EQ(4U, client.read(buffer, sizeof(buffer), isl::Timeout(1.0)));
+}
+
+TEST_F(UnixSocketTest, StaleSocketFileIsRemovedOnBind)
+{
+	isl::UnixAddrInfo addrInfo(socketPath());
+	unlink(addrInfo.path().c_str());
+	{
+		// Socket file is left after the listener has been closed
+		isl::UnixSocket listener;
+		listener.open();
+		listener.bind(addrInfo);
+		listener.listen(16);
+	}
+	ASSERT_EQ(0, access(addrInfo.path().c_str(), F_OK));
+	isl::UnixSocket listener;
+	listener.open();
+	EXPECT_NO_THROW(listener.bind(addrInfo));
+	listener.close();
+	unlink(addrInfo.path().c_str());
+}
+
+TEST_F(UnixSocketTest, TcpAddressOverloadsAreRejected)
+{
+	isl::UnixSocket socket;
+	socket.open();
+	isl::TcpSocket& tcpSocket = socket;
+	isl::TcpAddrInfo addrInfo(isl::TcpAddrInfo::IpV4, "127.0.0.1", 80);
+	EXPECT_THROW(tcpSocket.bind(addrInfo), isl::Exception);
+	EXPECT_THROW(tcpSocket.connect(addrInfo), isl::Exception);
+	EXPECT_THROW(tcpSocket.connect(addrInfo, isl::Timeout(0.1)), isl::Exception);
+	EXPECT_THROW(tcpSocket.localAddr(), isl::Exception);
+}
+
+int main(int argc, char **argv)
+{
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}